@@ -29,6 +29,7 @@ AllOpsResolver::AllOpsResolver() {
   AddAssignVariable();
   AddAveragePool2D();
   AddBatchToSpaceNd();
+  AddBlockSparseFullyConnected();
   AddBroadcastArgs();
   AddBroadcastTo();
   AddCallOnce();
@@ -0,0 +1,100 @@
+/* Copyright 2026 The ml_model_attestation Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/*
+ * Block sparse fully connected weights, produced by
+ * ml_model/tools/tflm_block_sparse and run by the BLOCK_SPARSE_FULLY_CONNECTED
+ * custom operator (kernels/cmsis_nn/block_sparse_fully_connected.cc).
+ *
+ * The rows x cols filter (output depth x accumulation depth) is cut in blocks
+ * of block_rows x block_cols values, only the blocks with a non-zero value are
+ * stored (block sparse row format). The constant buffer of the weights tensor
+ * (INT8, one dimension, quantization of the original filter) starts with a
+ * BlockSparseWeightsHeader (little-endian) followed by:
+ *
+ *   uint16  block_row_ptr[block_row_count + 1]  first block of each block row
+ *   uint16  block_col[block_count]              padded to 4 bytes
+ *   int8    values[block_count][block_rows][block_cols]
+ *
+ * block_row_count = ceil(rows / block_rows). The blocks of a block row are in
+ * increasing block column order, the blocks of the last block row/column are
+ * zero padded.
+ *
+ * Operator inputs: input (INT8), weights, bias (INT32, optional). Custom
+ * options: flexbuffer map, "fused_activation_function" (TfLiteFusedActivation,
+ * kTfLiteActNone if missing).
+ */
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_BLOCK_SPARSE_FULLY_CONNECTED_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_BLOCK_SPARSE_FULLY_CONNECTED_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tflite {
+namespace micro {
+
+constexpr char kBlockSparseFullyConnectedName[] =
+    "BLOCK_SPARSE_FULLY_CONNECTED";
+constexpr uint32_t kBlockSparseWeightsMagic = 0x53425754;  // "TWBS"
+
+struct BlockSparseWeightsHeader {
+  uint32_t magic;
+  uint16_t rows;
+  uint16_t cols;
+  uint8_t block_rows;
+  uint8_t block_cols;
+  uint16_t block_count;
+};
+
+inline size_t BlockSparseRowCount(const BlockSparseWeightsHeader& header) {
+  return (header.rows + header.block_rows - 1) / header.block_rows;
+}
+
+inline size_t BlockSparseColCount(const BlockSparseWeightsHeader& header) {
+  return (header.cols + header.block_cols - 1) / header.block_cols;
+}
+
+// Offsets of the sections from the start of the buffer, and total size.
+inline size_t BlockSparseRowPtrOffset() {
+  return sizeof(BlockSparseWeightsHeader);
+}
+
+inline size_t BlockSparseColOffset(const BlockSparseWeightsHeader& header) {
+  return BlockSparseRowPtrOffset() +
+         (BlockSparseRowCount(header) + 1) * sizeof(uint16_t);
+}
+
+inline size_t BlockSparseValuesOffset(const BlockSparseWeightsHeader& header) {
+  const size_t end =
+      BlockSparseColOffset(header) + header.block_count * sizeof(uint16_t);
+  return (end + 3) & ~static_cast<size_t>(3);
+}
+
+inline size_t BlockSparseWeightsSize(const BlockSparseWeightsHeader& header) {
+  return BlockSparseValuesOffset(header) + static_cast<size_t>(
+                                               header.block_count) *
+                                               header.block_rows *
+                                               header.block_cols;
+}
+
+// Returns true if data (size bytes, 4-byte aligned) is a consistent block
+// sparse buffer: header, block row pointers and block columns in range.
+bool IsBlockSparseWeights(const void* data, size_t size);
+
+}  // namespace micro
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_BLOCK_SPARSE_FULLY_CONNECTED_H_
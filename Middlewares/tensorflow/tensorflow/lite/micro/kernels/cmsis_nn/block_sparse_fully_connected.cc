@@ -0,0 +1,264 @@
+/* Copyright 2026 The ml_model_attestation Authors. All Rights Reserved.
+Derived from tensorflow/lite/micro/kernels/cmsis_nn/fully_connected.cc,
+Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// BLOCK_SPARSE_FULLY_CONNECTED custom operator: int8 fully connected layer
+// whose filter only stores its non-zero blocks (see
+// kernels/block_sparse_fully_connected.h), run by
+// arm_fully_connected_block_sparse_s8().
+
+#include "tensorflow/lite/micro/kernels/block_sparse_fully_connected.h"
+
+#include "Include/arm_nnfunctions.h"
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+namespace micro {
+
+bool IsBlockSparseWeights(const void* data, size_t size) {
+  if (data == nullptr || size < sizeof(BlockSparseWeightsHeader) ||
+      reinterpret_cast<uintptr_t>(data) % 4 != 0) {
+    return false;
+  }
+  const auto* header = static_cast<const BlockSparseWeightsHeader*>(data);
+  if (header->magic != kBlockSparseWeightsMagic || header->rows == 0 ||
+      header->cols == 0 || header->block_rows == 0 ||
+      header->block_cols == 0 || BlockSparseWeightsSize(*header) != size) {
+    return false;
+  }
+  const uint8_t* base = static_cast<const uint8_t*>(data);
+  const uint16_t* row_ptr =
+      reinterpret_cast<const uint16_t*>(base + BlockSparseRowPtrOffset());
+  const uint16_t* block_col =
+      reinterpret_cast<const uint16_t*>(base + BlockSparseColOffset(*header));
+  const size_t row_count = BlockSparseRowCount(*header);
+  const size_t col_count = BlockSparseColCount(*header);
+  if (row_ptr[0] != 0 || row_ptr[row_count] != header->block_count) {
+    return false;
+  }
+  for (size_t r = 0; r < row_count; r++) {
+    if (row_ptr[r + 1] < row_ptr[r]) {
+      return false;
+    }
+    for (int b = row_ptr[r]; b < row_ptr[r + 1]; b++) {
+      if (block_col[b] >= col_count ||
+          (b > row_ptr[r] && block_col[b] <= block_col[b - 1])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace micro
+
+namespace {
+
+constexpr int kInputTensor = 0;
+constexpr int kWeightsTensor = 1;
+constexpr int kBiasTensor = 2;
+constexpr int kOutputTensor = 0;
+
+struct OpData {
+  TfLiteFusedActivation activation;
+
+  int32_t output_multiplier;
+  int output_shift;
+  int32_t input_zero_point;
+  int32_t output_zero_point;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+
+  int32_t batches;
+
+  // Points into the weights buffer (constant, in the model).
+  cmsis_nn_bsr_s8 filter;
+
+  int buffer_idx;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  OpData* data = static_cast<OpData*>(
+      context->AllocatePersistentBuffer(context, sizeof(OpData)));
+  if (data == nullptr) {
+    return nullptr;
+  }
+
+  data->activation = kTfLiteActNone;
+  if (buffer != nullptr && length > 0) {
+    const uint8_t* buffer_t = reinterpret_cast<const uint8_t*>(buffer);
+    const flexbuffers::Map& m = flexbuffers::GetRoot(buffer_t, length).AsMap();
+    const flexbuffers::Reference activation = m["fused_activation_function"];
+    if (!activation.IsNull()) {
+      data->activation =
+          static_cast<TfLiteFusedActivation>(activation.AsInt32());
+    }
+  }
+  return data;
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+
+  TF_LITE_ENSURE(context, NumInputs(node) == 2 || NumInputs(node) == 3);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  TfLiteTensor* weights =
+      micro_context->AllocateTempInputTensor(node, kWeightsTensor);
+  TF_LITE_ENSURE(context, weights != nullptr);
+  TfLiteTensor* bias =
+      micro_context->AllocateTempInputTensor(node, kBiasTensor);
+  TfLiteTensor* output =
+      micro_context->AllocateTempOutputTensor(node, kOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, weights->type, kTfLiteInt8);
+  TF_LITE_ENSURE(context, IsConstantTensor(weights));
+  if (!micro::IsBlockSparseWeights(weights->data.data, weights->bytes)) {
+    MicroPrintf("BLOCK_SPARSE_FULLY_CONNECTED: invalid weights buffer");
+    return kTfLiteError;
+  }
+  if (bias != nullptr) {
+    TF_LITE_ENSURE_TYPES_EQ(context, bias->type, kTfLiteInt32);
+  }
+
+  const auto* header =
+      reinterpret_cast<const micro::BlockSparseWeightsHeader*>(
+          weights->data.data);
+  const RuntimeShape output_shape = GetTensorShape(output);
+  const int output_dim_count = output_shape.DimensionsCount();
+  TF_LITE_ENSURE_EQ(context, output_shape.Dims(output_dim_count - 1),
+                    header->rows);
+  data->batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+  TF_LITE_ENSURE_EQ(context, NumElements(input),
+                    data->batches * header->cols);
+  if (bias != nullptr) {
+    TF_LITE_ENSURE_EQ(context, NumElements(bias), header->rows);
+  }
+
+  double real_multiplier = 0.0;
+  TF_LITE_ENSURE_STATUS(GetQuantizedConvolutionMultipler(
+      context, input, weights, bias, output, &real_multiplier));
+  QuantizeMultiplier(real_multiplier, &data->output_multiplier,
+                     &data->output_shift);
+  TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+      context, data->activation, output, &data->output_activation_min,
+      &data->output_activation_max));
+  data->input_zero_point = input->params.zero_point;
+  data->output_zero_point = output->params.zero_point;
+
+  const uint8_t* base = static_cast<const uint8_t*>(weights->data.data);
+  data->filter.rows = header->rows;
+  data->filter.cols = header->cols;
+  data->filter.block_rows = header->block_rows;
+  data->filter.block_cols = header->block_cols;
+  data->filter.block_row_ptr = reinterpret_cast<const uint16_t*>(
+      base + micro::BlockSparseRowPtrOffset());
+  data->filter.block_col = reinterpret_cast<const uint16_t*>(
+      base + micro::BlockSparseColOffset(*header));
+  data->filter.values = reinterpret_cast<const int8_t*>(
+      base + micro::BlockSparseValuesOffset(*header));
+
+  TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+      context, arm_fully_connected_block_sparse_s8_get_buffer_size(
+                   &data->filter),
+      &data->buffer_idx));
+
+  micro_context->DeallocateTempTfLiteTensor(output);
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(weights);
+  if (bias != nullptr) {
+    micro_context->DeallocateTempTfLiteTensor(bias);
+  }
+
+  return kTfLiteOk;
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *static_cast<const OpData*>(node->user_data);
+
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const TfLiteEvalTensor* bias =
+      (NumInputs(node) == 3)
+          ? tflite::micro::GetEvalInput(context, node, kBiasTensor)
+          : nullptr;
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  cmsis_nn_context ctx;
+  ctx.buf = context->GetScratchBuffer(context, data.buffer_idx);
+  ctx.size = 0;
+
+  cmsis_nn_fc_params fc_params;
+  fc_params.input_offset = -data.input_zero_point;
+  fc_params.output_offset = data.output_zero_point;
+  fc_params.filter_offset = 0;
+  fc_params.activation.min = data.output_activation_min;
+  fc_params.activation.max = data.output_activation_max;
+
+  cmsis_nn_per_tensor_quant_params quant_params;
+  quant_params.multiplier = data.output_multiplier;
+  quant_params.shift = data.output_shift;
+
+  cmsis_nn_dims input_dims;
+  input_dims.n = data.batches;
+  input_dims.h = 1;
+  input_dims.w = 1;
+  input_dims.c = data.filter.cols;
+
+  cmsis_nn_dims output_dims;
+  output_dims.n = data.batches;
+  output_dims.h = 1;
+  output_dims.w = 1;
+  output_dims.c = data.filter.rows;
+
+  TF_LITE_ENSURE_EQ(
+      context,
+      arm_fully_connected_block_sparse_s8(
+          &ctx, &fc_params, &quant_params, &input_dims,
+          tflite::micro::GetTensorData<int8_t>(input), &data.filter,
+          tflite::micro::GetOptionalTensorData<int32_t>(bias), &output_dims,
+          tflite::micro::GetTensorData<int8_t>(output)),
+      ARM_CMSIS_NN_SUCCESS);
+
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TfLiteRegistration_V1* Register_BLOCK_SPARSE_FULLY_CONNECTED() {
+  static TfLiteRegistration_V1 r =
+      tflite::micro::RegisterOp(Init, Prepare, Eval);
+  return &r;
+}
+
+}  // namespace tflite
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/kernels/conv.h"
 
+#include <algorithm>
+
 #include "Include/arm_nnfunctions.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
@@ -26,7 +28,16 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/weight_compression.h"
 #include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_op_fusion.h"
+
+// The filters rewritten at Prepare only speed up Eval: a rewritten filter
+// larger than this (bytes), or which does not fit in the arena, is not
+// allocated and the conv uses the filter as is (arm_convolve_wrapper_s8()).
+#if !defined(CMSIS_NN_CONV_MAX_PREPARED_FILTER_SIZE)
+#define CMSIS_NN_CONV_MAX_PREPARED_FILTER_SIZE (8192)
+#endif
 
 namespace tflite {
 namespace {
@@ -36,6 +47,31 @@ struct OpData {
 
   // Index to buffer for optimizations if applicable.
   int buffer_idx;
+
+  // Index to the buffer of the decompressed filter, -1 if not compressed.
+  int filter_decompress_idx;
+
+  // Fused MAX_POOL_2D (see micro_op_fusion.h): buffer of the conv rows of a
+  // pooling window, width of the conv output and pooling activation range.
+  int band_idx;
+  int conv_width;
+  int32_t pool_activation_min;
+  int32_t pool_activation_max;
+
+  // Filter written at Prepare in the layout of arm_convolve_s8_reordered()
+  // (persistent buffer), nullptr if the filter is used as is.
+  const int8_t* reordered_filter;
+
+  // Filter transformed at Prepare for arm_convolve_winograd_3x3_s8()
+  // (persistent buffer), nullptr if the conv does not take that path.
+  const int16_t* winograd_filter;
+
+  // Filter widened at Prepare for arm_convolve_direct_s8() (persistent
+  // buffer), nullptr if the conv does not take that path.
+  const int16_t* direct_filter;
+
+  // int4 filter, read packed (two values per byte) by arm_convolve_s4().
+  bool int4_filter;
 };
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
@@ -43,6 +79,224 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   return context->AllocatePersistentBuffer(context, sizeof(OpData));
 }
 
+// Size of the scratch buffer of ConvolveS8().
+int32_t ConvolveS8BufferSize(const OpData& data,
+                             const cmsis_nn_conv_params& conv_params,
+                             const cmsis_nn_dims& input_dims,
+                             const cmsis_nn_dims& filter_dims,
+                             const cmsis_nn_dims& output_dims) {
+  if (data.int4_filter) {
+    return arm_convolve_s4_get_buffer_size(&input_dims, &filter_dims);
+  }
+  if (data.winograd_filter != nullptr) {
+    return arm_convolve_winograd_3x3_s8_get_buffer_size(&input_dims);
+  }
+  if (data.direct_filter != nullptr) {
+    return arm_convolve_direct_s8_get_buffer_size(&conv_params, &filter_dims,
+                                                  &output_dims);
+  }
+  return arm_convolve_wrapper_s8_get_buffer_size(&conv_params, &input_dims,
+                                                 &filter_dims, &output_dims);
+}
+
+// The output of the node is the output of the fused MAX_POOL_2D, the conv
+// output dims are the ones of the (not allocated) conv output tensor. A band
+// of pool.filter_height conv rows is computed at a time.
+TfLiteStatus PrepareFusedMaxPool(TfLiteContext* context, TfLiteNode* node,
+                                 const FusedMaxPoolParams& fused,
+                                 const cmsis_nn_conv_params& conv_params,
+                                 const cmsis_nn_dims& input_dims,
+                                 const cmsis_nn_dims& filter_dims,
+                                 const cmsis_nn_dims& output_dims,
+                                 OpData* data, int32_t* buf_size) {
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* output =
+      micro_context->AllocateTempOutputTensor(node, kConvOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+
+  const TfLitePoolParams& pool = fused.pool;
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt8);
+  TF_LITE_ENSURE_EQ(context, pool.padding, kTfLitePaddingValid);
+  TF_LITE_ENSURE(context, pool.stride_height >= pool.filter_height);
+  TF_LITE_ENSURE(context, pool.filter_height <= output_dims.h &&
+                              pool.filter_width <= output_dims.w);
+  TF_LITE_ENSURE_EQ(
+      context, output->dims->data[1],
+      (output_dims.h - pool.filter_height) / pool.stride_height + 1);
+  TF_LITE_ENSURE_EQ(
+      context, output->dims->data[2],
+      (output_dims.w - pool.filter_width) / pool.stride_width + 1);
+  TF_LITE_ENSURE_EQ(context, output->dims->data[3], output_dims.c);
+  TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+      context, pool.activation, output, &data->pool_activation_min,
+      &data->pool_activation_max));
+  data->conv_width = output_dims.w;
+
+  cmsis_nn_dims band_input_dims = input_dims;
+  band_input_dims.n = 1;
+  band_input_dims.h =
+      std::min(input_dims.h, (pool.filter_height - 1) * conv_params.stride.h +
+                                 (filter_dims.h - 1) * conv_params.dilation.h +
+                                 1);
+  cmsis_nn_dims band_dims = output_dims;
+  band_dims.n = 1;
+  band_dims.h = pool.filter_height;
+  TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+      context, band_dims.h * band_dims.w * band_dims.c, &data->band_idx));
+
+  // Only the first bands of a padded conv have top padding rows.
+  cmsis_nn_conv_params band_params = conv_params;
+  band_params.padding.h = 0;
+  *buf_size =
+      std::max(ConvolveS8BufferSize(*data, conv_params, band_input_dims,
+                                    filter_dims, band_dims),
+               ConvolveS8BufferSize(*data, band_params, band_input_dims,
+                                    filter_dims, band_dims));
+
+  micro_context->DeallocateTempTfLiteTensor(output);
+  return kTfLiteOk;
+}
+
+// Persistent buffer of a filter rewritten at Prepare, nullptr if it exceeds
+// CMSIS_NN_CONV_MAX_PREPARED_FILTER_SIZE or the arena is full.
+void* AllocatePreparedFilter(TfLiteContext* context, int32_t size) {
+  if (size > CMSIS_NN_CONV_MAX_PREPARED_FILTER_SIZE) {
+    return nullptr;
+  }
+  return context->AllocatePersistentBuffer(context, size);
+}
+
+// On the DSP (non-MVE) targets, arm_convolve_s8() expands the weights with
+// read_and_pad() at each call. The weights are reordered once here for
+// read_and_pad_reordered(), so Eval does not rearrange them. Only constant
+// int8 filters stored as is (not int4 packed, not compressed) are reordered,
+// if the reordered copy fits (see AllocatePreparedFilter()).
+TfLiteStatus PrepareReorderedFilter(TfLiteContext* context,
+                                    const TfLiteTensor* filter,
+                                    const cmsis_nn_dims& filter_dims,
+                                    OpData* data) {
+  if (filter->type != kTfLiteInt8 || data->filter_decompress_idx >= 0 ||
+      !IsConstantTensor(filter) || data->winograd_filter != nullptr ||
+      data->direct_filter != nullptr) {
+    return kTfLiteOk;
+  }
+  const int32_t size = arm_convolve_s8_get_reordered_filter_size(&filter_dims);
+  if (size == 0) {
+    return kTfLiteOk;
+  }
+  int8_t* reordered =
+      static_cast<int8_t*>(AllocatePreparedFilter(context, size));
+  if (reordered == nullptr) {
+    return kTfLiteOk;
+  }
+  arm_convolve_s8_reorder_filter(&filter_dims, GetTensorData<int8_t>(filter),
+                                 reordered);
+  data->reordered_filter = reordered;
+  return kTfLiteOk;
+}
+
+// 3x3 stride 1 convs with enough input channels run in the Winograd
+// F(2x2, 3x3) domain, 2.25 times fewer multiplications than the direct
+// convolution and the same output (see arm_convolve_winograd_3x3_s8()). The
+// filter is transformed once here. The other convs, the filters which cannot
+// be transformed at Prepare (int4, compressed, not constant) and the
+// transformed filters which do not fit (16 int16 values per 9 int8 weights,
+// see AllocatePreparedFilter()) fall back to the other paths.
+TfLiteStatus PrepareWinogradFilter(TfLiteContext* context,
+                                   const TfLiteTensor* filter,
+                                   const cmsis_nn_conv_params& conv_params,
+                                   const cmsis_nn_dims& filter_dims,
+                                   OpData* data) {
+  if (filter->type != kTfLiteInt8 || data->filter_decompress_idx >= 0 ||
+      !IsConstantTensor(filter)) {
+    return kTfLiteOk;
+  }
+  const int32_t size =
+      arm_convolve_winograd_3x3_s8_get_filter_size(&conv_params, &filter_dims);
+  if (size == 0) {
+    return kTfLiteOk;
+  }
+  int16_t* transformed =
+      static_cast<int16_t*>(AllocatePreparedFilter(context, size));
+  if (transformed == nullptr) {
+    return kTfLiteOk;
+  }
+  arm_convolve_winograd_3x3_s8_transform_filter(
+      &filter_dims, GetTensorData<int8_t>(filter), transformed);
+  data->winograd_filter = transformed;
+  return kTfLiteOk;
+}
+
+// Convs with 1 to 4 input channels which do not take the Winograd path (faster
+// for 3x3 stride 1) run without im2col: the patches of such convs are too
+// short for the mat mult kernels (see arm_convolve_direct_s8()). The filter is
+// widened once here, same conditions on the filter as PrepareWinogradFilter();
+// if the int16 copy does not fit, the conv keeps the im2col path.
+TfLiteStatus PrepareDirectFilter(TfLiteContext* context,
+                                 const TfLiteTensor* filter,
+                                 const cmsis_nn_conv_params& conv_params,
+                                 const cmsis_nn_dims& filter_dims,
+                                 OpData* data) {
+  if (filter->type != kTfLiteInt8 || data->filter_decompress_idx >= 0 ||
+      !IsConstantTensor(filter) || data->winograd_filter != nullptr) {
+    return kTfLiteOk;
+  }
+  const int32_t size =
+      arm_convolve_direct_s8_get_filter_size(&conv_params, &filter_dims);
+  if (size == 0) {
+    return kTfLiteOk;
+  }
+  int16_t* transformed =
+      static_cast<int16_t*>(AllocatePreparedFilter(context, size));
+  if (transformed == nullptr) {
+    return kTfLiteOk;
+  }
+  arm_convolve_direct_s8_transform_filter(
+      &filter_dims, GetTensorData<int8_t>(filter), transformed);
+  data->direct_filter = transformed;
+  return kTfLiteOk;
+}
+
+// A reordered filter always takes the arm_convolve_s8() path of
+// arm_convolve_wrapper_s8() (see arm_convolve_s8_get_reordered_filter_size()).
+// An int4 filter is passed packed to arm_convolve_s4().
+arm_cmsis_nn_status ConvolveS8(
+    const OpData& data, const cmsis_nn_context* ctx,
+    const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const int8_t* filter_data,
+    const cmsis_nn_dims* bias_dims, const int32_t* bias_data,
+    const cmsis_nn_dims* output_dims, int8_t* output_data) {
+  if (data.int4_filter) {
+    return arm_convolve_s4(ctx, conv_params, quant_params, input_dims,
+                           input_data, filter_dims, filter_data, bias_dims,
+                           bias_data, output_dims, output_data);
+  }
+  if (data.winograd_filter != nullptr) {
+    return arm_convolve_winograd_3x3_s8(ctx, conv_params, quant_params,
+                                        input_dims, input_data, filter_dims,
+                                        data.winograd_filter, bias_dims,
+                                        bias_data, output_dims, output_data);
+  }
+  if (data.direct_filter != nullptr) {
+    return arm_convolve_direct_s8(ctx, conv_params, quant_params, input_dims,
+                                  input_data, filter_dims, data.direct_filter,
+                                  bias_dims, bias_data, output_dims,
+                                  output_data);
+  }
+  if (data.reordered_filter != nullptr) {
+    return arm_convolve_s8_reordered(ctx, conv_params, quant_params,
+                                     input_dims, input_data, filter_dims,
+                                     data.reordered_filter, bias_dims,
+                                     bias_data, output_dims, output_data);
+  }
+  return arm_convolve_wrapper_s8(ctx, conv_params, quant_params, input_dims,
+                                 input_data, filter_dims, filter_data,
+                                 bias_dims, bias_data, output_dims,
+                                 output_data);
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   TFLITE_DCHECK(node->builtin_data != nullptr);
@@ -51,6 +305,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const auto& params =
       *(static_cast<const TfLiteConvParams*>(node->builtin_data));
   OpData* data = static_cast<OpData*>(node->user_data);
+  const FusedMaxPoolParams* fused = GetFusedMaxPoolParams(node);
+  data->reordered_filter = nullptr;
+  data->winograd_filter = nullptr;
+  data->direct_filter = nullptr;
 
   MicroContext* micro_context = GetMicroContext(context);
 
@@ -61,8 +319,13 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       micro_context->AllocateTempInputTensor(node, kConvWeightsTensor);
   TF_LITE_ENSURE(context, filter != nullptr);
   TfLiteTensor* output =
-      micro_context->AllocateTempOutputTensor(node, kConvOutputTensor);
+      (fused != nullptr)
+          ? micro_context->AllocateTempTfLiteTensor(fused->conv_output)
+          : micro_context->AllocateTempOutputTensor(node, kConvOutputTensor);
   TF_LITE_ENSURE(context, output != nullptr);
+  TF_LITE_ENSURE(context, fused == nullptr || input->type == kTfLiteInt8);
+  data->int4_filter = filter->type == kTfLiteInt4;
+  TF_LITE_ENSURE(context, !data->int4_filter || input->type == kTfLiteInt8);
 
   RuntimeShape input_shape = GetTensorShape(input);
   RuntimeShape output_shape = GetTensorShape(output);
@@ -88,14 +351,9 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   output_dims.w = output->dims->data[2];
   output_dims.c = output_shape.Dims(3);
 
-  if (filter->type == kTfLiteInt4) {
-    int filter_size =
-        RuntimeShape(filter->dims->size,
-                     reinterpret_cast<const int32_t*>(filter->dims->data))
-            .FlatSize();
-    context->RequestScratchBufferInArena(
-        context, filter_size, &data->reference_op_data.filter_buffer_index);
-  }
+  // compressed weights (see weight_compression.h)
+  TF_LITE_ENSURE_STATUS(tflite::micro::RequestDecompressedTensor(
+      context, filter, &data->filter_decompress_idx));
 
   if (input->type == kTfLiteInt8 || input->type == kTfLiteInt16) {
     const int num_channels = filter->dims->data[kConvQuantizedDimension];
@@ -127,8 +385,19 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     conv_params.activation.max = data->reference_op_data.output_activation_max;
 
     if (input->type == kTfLiteInt8) {
-      buf_size = arm_convolve_wrapper_s8_get_buffer_size(
-          &conv_params, &input_dims, &filter_dims, &output_dims);
+      TF_LITE_ENSURE_STATUS(PrepareWinogradFilter(context, filter, conv_params,
+                                                  filter_dims, data));
+      TF_LITE_ENSURE_STATUS(PrepareDirectFilter(context, filter, conv_params,
+                                                filter_dims, data));
+    }
+
+    if (fused != nullptr) {
+      TF_LITE_ENSURE_STATUS(PrepareFusedMaxPool(
+          context, node, *fused, conv_params, input_dims, filter_dims,
+          output_dims, data, &buf_size));
+    } else if (input->type == kTfLiteInt8) {
+      buf_size = ConvolveS8BufferSize(*data, conv_params, input_dims,
+                                      filter_dims, output_dims);
     } else if (input->type == kTfLiteInt16) {
       TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
       TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
@@ -142,6 +411,11 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     } else {
       data->buffer_idx = -1;
     }
+
+    if (input->type == kTfLiteInt8) {
+      TF_LITE_ENSURE_STATUS(
+          PrepareReorderedFilter(context, filter, filter_dims, data));
+    }
   }
 
   micro_context->DeallocateTempTfLiteTensor(output);
@@ -240,17 +514,143 @@ TfLiteStatus EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
   // arm_convolve_wrapper_s8 dispatches the optimized kernel accordingly with
   // the parameters passed
   TFLITE_DCHECK_EQ(
-      arm_convolve_wrapper_s8(
-          &ctx, &conv_params, &quant_params, &input_dims,
-          tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
-          tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
-          tflite::micro::GetOptionalTensorData<int32_t>(bias), &output_dims,
-          tflite::micro::GetTensorData<int8_t>(output)),
+      ConvolveS8(data, &ctx, &conv_params, &quant_params, &input_dims,
+                 tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+                 tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
+                 tflite::micro::GetOptionalTensorData<int32_t>(bias),
+                 &output_dims, tflite::micro::GetTensorData<int8_t>(output)),
       ARM_CMSIS_NN_SUCCESS);
 
   return kTfLiteOk;
 }
 
+// Conv fused with the following MAX_POOL_2D: for each output row, the band of
+// conv rows of the pooling window is computed from the input rows it needs
+// (the rows outside the input are the padding of the conv), then pooled.
+TfLiteStatus EvalFusedMaxPool(TfLiteContext* context, TfLiteNode* node,
+                              const TfLiteConvParams& params,
+                              const FusedMaxPoolParams& fused,
+                              const OpData& data,
+                              const TfLiteEvalTensor* input,
+                              const TfLiteEvalTensor* filter,
+                              const TfLiteEvalTensor* bias,
+                              TfLiteEvalTensor* output) {
+  cmsis_nn_conv_params conv_params;
+  conv_params.dilation.h = params.dilation_height_factor;
+  conv_params.dilation.w = params.dilation_width_factor;
+  conv_params.input_offset = -data.reference_op_data.input_zero_point;
+  conv_params.output_offset = data.reference_op_data.output_zero_point;
+  conv_params.stride.h = params.stride_height;
+  conv_params.stride.w = params.stride_width;
+  conv_params.padding.h = data.reference_op_data.padding.height;
+  conv_params.padding.w = data.reference_op_data.padding.width;
+  conv_params.activation.min = data.reference_op_data.output_activation_min;
+  conv_params.activation.max = data.reference_op_data.output_activation_max;
+
+  cmsis_nn_per_channel_quant_params quant_params;
+  quant_params.multiplier = const_cast<int32_t*>(
+      data.reference_op_data.per_channel_output_multiplier);
+  quant_params.shift =
+      const_cast<int32_t*>(data.reference_op_data.per_channel_output_shift);
+
+  RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+  RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+  RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+  const int batch_size = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const TfLitePoolParams& pool = fused.pool;
+
+  cmsis_nn_dims input_dims;
+  input_dims.n = 1;
+  input_dims.w = input_width;
+  input_dims.c = input_depth;
+
+  cmsis_nn_dims filter_dims;
+  filter_dims.n = output_depth;
+  filter_dims.h = filter_shape.Dims(1);
+  filter_dims.w = filter_shape.Dims(2);
+  filter_dims.c = input_depth;
+
+  cmsis_nn_dims bias_dims;
+  bias_dims.n = 1;
+  bias_dims.h = 1;
+  bias_dims.w = 1;
+  bias_dims.c = output_depth;
+
+  cmsis_nn_dims band_dims;
+  band_dims.n = 1;
+  band_dims.h = pool.filter_height;
+  band_dims.w = data.conv_width;
+  band_dims.c = output_depth;
+
+  cmsis_nn_context ctx;
+  ctx.buf = nullptr;
+  ctx.size = 0;
+  if (data.buffer_idx > -1) {
+    ctx.buf = context->GetScratchBuffer(context, data.buffer_idx);
+  }
+  int8_t* band =
+      static_cast<int8_t*>(context->GetScratchBuffer(context, data.band_idx));
+
+  // Input rows used by a band, distance between the first input rows of two
+  // consecutive bands.
+  const int band_input_height =
+      (pool.filter_height - 1) * params.stride_height +
+      (filter_dims.h - 1) * params.dilation_height_factor + 1;
+  const int band_stride = pool.stride_height * params.stride_height;
+  const int input_row_size = input_width * input_depth;
+  const int band_row_size = data.conv_width * output_depth;
+  const int8_t activation_min =
+      static_cast<int8_t>(data.pool_activation_min);
+  const int8_t activation_max =
+      static_cast<int8_t>(data.pool_activation_max);
+
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  const int8_t* filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+  const int32_t* bias_data =
+      tflite::micro::GetOptionalTensorData<int32_t>(bias);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+
+  for (int b = 0; b < batch_size; ++b) {
+    for (int py = 0; py < output_height; ++py) {
+      const int top = py * band_stride - data.reference_op_data.padding.height;
+      const int first = std::max(top, 0);
+      input_dims.h = std::min(top + band_input_height, input_height) - first;
+      conv_params.padding.h = first - top;
+      TFLITE_DCHECK_EQ(
+          ConvolveS8(data, &ctx, &conv_params, &quant_params, &input_dims,
+                     input_data + first * input_row_size, &filter_dims,
+                     filter_data, &bias_dims, bias_data, &band_dims, band),
+          ARM_CMSIS_NN_SUCCESS);
+
+      for (int px = 0; px < output_width; ++px) {
+        const int8_t* window = band + px * pool.stride_width * output_depth;
+        std::fill(output_data, output_data + output_depth, activation_min);
+        for (int fy = 0; fy < pool.filter_height; ++fy) {
+          for (int fx = 0; fx < pool.filter_width; ++fx) {
+            const int8_t* src = window + fy * band_row_size + fx * output_depth;
+            for (int c = 0; c < output_depth; ++c) {
+              output_data[c] = std::max(output_data[c], src[c]);
+            }
+          }
+        }
+        for (int c = 0; c < output_depth; ++c) {
+          output_data[c] = std::min(output_data[c], activation_max);
+        }
+        output_data += output_depth;
+      }
+    }
+    input_data += input_height * input_row_size;
+  }
+
+  return kTfLiteOk;
+}
+
 TfLiteStatus EvalQuantizedPerChannel16x8(
     TfLiteContext* context, TfLiteNode* node, const TfLiteConvParams& params,
     const OpData& data, const TfLiteEvalTensor* input,
@@ -364,9 +764,15 @@ TfLiteStatus EvalInt8(TfLiteContext* context, TfLiteNode* node) {
       *(reinterpret_cast<TfLiteConvParams*>(node->builtin_data));
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData& data = *(static_cast<const OpData*>(node->user_data));
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
-
+  TfLiteEvalTensor filter_int8;
+  TF_LITE_ENSURE_STATUS(tflite::micro::MakeDecompressedTensor(
+      context, data.filter_decompress_idx, filter, &filter_int8));
+
+  const FusedMaxPoolParams* fused = GetFusedMaxPoolParams(node);
+  if (fused != nullptr) {
+    return EvalFusedMaxPool(context, node, params, *fused, data, input,
+                            &filter_int8, bias, output);
+  }
   return EvalQuantizedPerChannel(context, node, params, data, input,
                                  &filter_int8, bias, output);
 }
@@ -388,9 +794,12 @@ TfLiteStatus EvalInt16x8(TfLiteContext* context, TfLiteNode* node) {
       *(reinterpret_cast<TfLiteConvParams*>(node->builtin_data));
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData& data = *(static_cast<const OpData*>(node->user_data));
+  TfLiteEvalTensor filter_int8;
+  TF_LITE_ENSURE_STATUS(tflite::micro::MakeDecompressedTensor(
+      context, data.filter_decompress_idx, filter, &filter_int8));
 
-  return EvalQuantizedPerChannel16x8(context, node, params, data, input, filter,
-                                     bias, output);
+  return EvalQuantizedPerChannel16x8(context, node, params, data, input,
+                                     &filter_int8, bias, output);
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
@@ -419,8 +828,10 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           (input->type == kTfLiteInt8 && filter->type == kTfLiteInt4),
       "Hybrid models are not supported on TFLite Micro.");
 
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
+  // int4 filters stay packed (see ConvolveS8()).
+  TfLiteEvalTensor filter_int8;
+  TF_LITE_ENSURE_STATUS(tflite::micro::MakeDecompressedTensor(
+      context, data.filter_decompress_idx, filter, &filter_int8));
 
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
@@ -439,7 +850,13 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     }
     case kTfLiteInt8:
       switch (filter_int8.type) {
-        case kTfLiteInt8: {
+        case kTfLiteInt8:
+        case kTfLiteInt4: {
+          const FusedMaxPoolParams* fused = GetFusedMaxPoolParams(node);
+          if (fused != nullptr) {
+            return EvalFusedMaxPool(context, node, params, *fused, data, input,
+                                    &filter_int8, bias, output);
+          }
           return EvalQuantizedPerChannel(context, node, params, data, input,
                                          &filter_int8, bias, output);
         }
@@ -454,7 +871,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       break;
     case kTfLiteInt16:
       return EvalQuantizedPerChannel16x8(context, node, params, data, input,
-                                         filter, bias, output);
+                                         &filter_int8, bias, output);
       break;
     default:
       MicroPrintf("Type %s (%d) not supported.", TfLiteTypeGetName(input->type),
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/weight_compression.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -42,6 +43,9 @@ struct OpData {
   // Index to buffer for optimizations if applicable.
   int buffer_idx;
 
+  // Index to the buffer of the decompressed filter, -1 if not compressed.
+  int filter_decompress_idx;
+
   int32_t batches;
   int32_t accum_depth;
   int32_t output_depth;
@@ -107,7 +111,11 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     TFLITE_DCHECK_GE(output_dim_count, 2);
     TFLITE_DCHECK_LE(output_dim_count, 4);
 
-    if (output_dim_count > 2 && data->accum_depth % 4 == 0) {
+    if (filter->type == kTfLiteInt4) {
+      // Packed filter read as is by arm_fully_connected_s4(), the buffer
+      // holds the offset input.
+      buf_size = arm_fully_connected_s4_get_buffer_size(&filter_dims);
+    } else if (output_dim_count > 2 && data->accum_depth % 4 == 0) {
       data->per_channel_output_multiplier =
           static_cast<int32_t*>(context->AllocatePersistentBuffer(
               context, data->output_depth * sizeof(int32_t)));
@@ -127,7 +135,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     }
   }
 
-  if (filter->type == kTfLiteInt4) {
+  // The int16 kernels have no int4 variant, the filter is unpacked at Eval.
+  if (filter->type == kTfLiteInt4 && input->type != kTfLiteInt8) {
     int filter_size =
         RuntimeShape(filter->dims->size,
                      reinterpret_cast<const int32_t*>(filter->dims->data))
@@ -136,6 +145,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
         context, filter_size, &data->reference_op_data.filter_buffer_index);
   }
 
+  // compressed weights (see weight_compression.h)
+  TF_LITE_ENSURE_STATUS(tflite::micro::RequestDecompressedTensor(
+      context, filter, &data->filter_decompress_idx));
+
   if (buf_size > 0) {
     TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
         context, buf_size, &data->buffer_idx));
@@ -212,7 +225,8 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
   const int32_t* bias_data =
       tflite::micro::GetOptionalTensorData<int32_t>(bias);
 
-  if (output_dim_count > 2 && data.accum_depth % 4 == 0) {
+  if (filter->type == kTfLiteInt8 && output_dim_count > 2 &&
+      data.accum_depth % 4 == 0) {
     cmsis_nn_conv_params conv_params;
     conv_params.dilation.h = 1;
     conv_params.dilation.w = 1;
@@ -252,6 +266,19 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
     fc_params.activation.min = data.reference_op_data.output_activation_min;
     fc_params.activation.max = data.reference_op_data.output_activation_max;
 
+    if (filter->type == kTfLiteInt4) {
+      TF_LITE_ENSURE_EQ(
+          context,
+          arm_fully_connected_s4(
+              &ctx, &fc_params, &quant_params, &input_dims,
+              tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+              tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
+              bias_data, &output_dims,
+              tflite::micro::GetTensorData<int8_t>(output)),
+          ARM_CMSIS_NN_SUCCESS);
+      return kTfLiteOk;
+    }
+
     TF_LITE_ENSURE_EQ(
         context,
         arm_fully_connected_s8(
@@ -319,8 +346,14 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData& data = *(static_cast<const OpData*>(node->user_data));
 
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
+  // int4 filters of the int8 operators stay packed (arm_fully_connected_s4()).
+  TfLiteEvalTensor filter_int8 = *filter;
+  if (input->type != kTfLiteInt8) {
+    filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
+        context, data.reference_op_data.filter_buffer_index, filter);
+  }
+  TF_LITE_ENSURE_STATUS(tflite::micro::MakeDecompressedTensor(
+      context, data.filter_decompress_idx, &filter_int8, &filter_int8));
 
   // Checks in Prepare ensure input, output and filter types are all the same.
   switch (input->type) {
@@ -341,6 +374,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     case kTfLiteInt8: {
       switch (filter_int8.type) {
         case kTfLiteInt8:
+        case kTfLiteInt4:
           return EvalQuantizedInt8(context, node, data, input, &filter_int8,
                                    bias, output);
         default:
@@ -351,7 +385,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       break;
     }
     case kTfLiteInt16: {
-      return EvalQuantizedInt16(context, node, data, input, filter, bias,
+      return EvalQuantizedInt16(context, node, data, input, &filter_int8, bias,
                                 output);
     }
     default: {
@@ -389,8 +423,9 @@ TfLiteStatus EvalInt8(TfLiteContext* context, TfLiteNode* node) {
     return kTfLiteError;
   }
 
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
+  TfLiteEvalTensor filter_int8;
+  TF_LITE_ENSURE_STATUS(tflite::micro::MakeDecompressedTensor(
+      context, data.filter_decompress_idx, filter, &filter_int8));
 
   return EvalQuantizedInt8(context, node, data, input, &filter_int8, bias,
                            output);
@@ -416,7 +451,12 @@ TfLiteStatus EvalInt16(TfLiteContext* context, TfLiteNode* node) {
     return kTfLiteError;
   }
 
-  return EvalQuantizedInt16(context, node, data, input, filter, bias, output);
+  TfLiteEvalTensor filter_int8;
+  TF_LITE_ENSURE_STATUS(tflite::micro::MakeDecompressedTensor(
+      context, data.filter_decompress_idx, filter, &filter_int8));
+
+  return EvalQuantizedInt16(context, node, data, input, &filter_int8, bias,
+                            output);
 }
 
 }  // namespace
@@ -91,18 +91,28 @@ void AverageEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
   PopulateCommonParams(context, &input_dims, &output_dims, &pool_params, &ctx,
                        &filter_dims, data, input_shape, output_shape, params);
 
-  if (input->type == kTfLiteInt8) {
-    TFLITE_DCHECK_EQ(
-        arm_avgpool_s8(&ctx, &pool_params, &input_dims,
-                       micro::GetTensorData<int8_t>(input), &filter_dims,
-                       &output_dims, micro::GetTensorData<int8_t>(output)),
-        ARM_CMSIS_NN_SUCCESS);
-  } else {
-    TFLITE_DCHECK_EQ(
-        arm_avgpool_s16(&ctx, &pool_params, &input_dims,
-                        micro::GetTensorData<int16_t>(input), &filter_dims,
-                        &output_dims, micro::GetTensorData<int16_t>(output)),
-        ARM_CMSIS_NN_SUCCESS);
+  // The CMSIS-NN pooling functions process one batch per call.
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_size = input_dims.h * input_dims.w * input_dims.c;
+  const int output_size = output_dims.h * output_dims.w * output_dims.c;
+  for (int b = 0; b < batches; ++b) {
+    if (input->type == kTfLiteInt8) {
+      TFLITE_DCHECK_EQ(
+          arm_avgpool_s8(
+              &ctx, &pool_params, &input_dims,
+              micro::GetTensorData<int8_t>(input) + b * input_size,
+              &filter_dims, &output_dims,
+              micro::GetTensorData<int8_t>(output) + b * output_size),
+          ARM_CMSIS_NN_SUCCESS);
+    } else {
+      TFLITE_DCHECK_EQ(
+          arm_avgpool_s16(
+              &ctx, &pool_params, &input_dims,
+              micro::GetTensorData<int16_t>(input) + b * input_size,
+              &filter_dims, &output_dims,
+              micro::GetTensorData<int16_t>(output) + b * output_size),
+          ARM_CMSIS_NN_SUCCESS);
+    }
   }
 }
 
@@ -127,18 +137,28 @@ TfLiteStatus MaxEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
   PopulateCommonParams(context, &input_dims, &output_dims, &pool_params, &ctx,
                        &filter_dims, data, input_shape, output_shape, params);
 
-  if (input->type == kTfLiteInt8) {
-    TFLITE_DCHECK_EQ(
-        arm_max_pool_s8(&ctx, &pool_params, &input_dims,
-                        micro::GetTensorData<int8_t>(input), &filter_dims,
-                        &output_dims, micro::GetTensorData<int8_t>(output)),
-        ARM_CMSIS_NN_SUCCESS);
-  } else {
-    TFLITE_DCHECK_EQ(
-        arm_max_pool_s16(&ctx, &pool_params, &input_dims,
-                         micro::GetTensorData<int16_t>(input), &filter_dims,
-                         &output_dims, micro::GetTensorData<int16_t>(output)),
-        ARM_CMSIS_NN_SUCCESS);
+  // The CMSIS-NN pooling functions process one batch per call.
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_size = input_dims.h * input_dims.w * input_dims.c;
+  const int output_size = output_dims.h * output_dims.w * output_dims.c;
+  for (int b = 0; b < batches; ++b) {
+    if (input->type == kTfLiteInt8) {
+      TFLITE_DCHECK_EQ(
+          arm_max_pool_s8(
+              &ctx, &pool_params, &input_dims,
+              micro::GetTensorData<int8_t>(input) + b * input_size,
+              &filter_dims, &output_dims,
+              micro::GetTensorData<int8_t>(output) + b * output_size),
+          ARM_CMSIS_NN_SUCCESS);
+    } else {
+      TFLITE_DCHECK_EQ(
+          arm_max_pool_s16(
+              &ctx, &pool_params, &input_dims,
+              micro::GetTensorData<int16_t>(input) + b * input_size,
+              &filter_dims, &output_dims,
+              micro::GetTensorData<int16_t>(output) + b * output_size),
+          ARM_CMSIS_NN_SUCCESS);
+    }
   }
 
   return kTfLiteOk;
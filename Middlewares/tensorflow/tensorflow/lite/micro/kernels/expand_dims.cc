@@ -121,7 +121,10 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       tflite::micro::GetEvalInput(context, node, kInputTensor);
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kOutputTensor);
-  const int flat_size = ElementCount(*input->dims);
+  // Nothing to copy for in-place expand_dims (output sharing the input
+  // buffer).
+  const int flat_size =
+      (input->data.raw != output->data.raw) ? ElementCount(*input->dims) : 0;
 
   switch (input->type) {
     case kTfLiteFloat32: {
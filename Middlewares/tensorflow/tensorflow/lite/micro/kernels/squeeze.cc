@@ -105,7 +105,10 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                     TfLiteEvalTensorByteLength(output, &output_byte_size));
 
   TF_LITE_ENSURE_EQ(context, input_byte_size, output_byte_size);
-  memcpy(output->data.raw, input->data.raw, input_byte_size);
+  // Do nothing for in-place squeeze (output sharing the input buffer).
+  if (input->data.raw != output->data.raw) {
+    memcpy(output->data.raw, input->data.raw, input_byte_size);
+  }
   return kTfLiteOk;
 }
 
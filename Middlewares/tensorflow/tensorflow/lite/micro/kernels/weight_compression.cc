@@ -0,0 +1,260 @@
+/* Copyright 2026 The ml_model_attestation Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/*
+ * Compressed weight buffers, see weight_compression.h
+ */
+
+#include "tensorflow/lite/micro/kernels/weight_compression.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_utils.h"
+
+namespace tflite {
+namespace micro {
+namespace {
+
+size_t AlignSize4(size_t size) { return (size + 3) & ~static_cast<size_t>(3); }
+
+bool ReadHeader(const void* data, CompressedWeightsHeader* header) {
+  memcpy(header, data, sizeof(*header));
+  if (header->magic != kCompressedWeightsMagic ||
+      header->palette_size == 0 ||
+      header->palette_size > kCompressedWeightsMaxPalette) {
+    return false;
+  }
+  if (header->codec == kCompressedWeightsCodecPacked) {
+    return header->index_bits >= 1 && header->index_bits <= 8 &&
+           (1u << header->index_bits) >= header->palette_size;
+  }
+  return header->codec == kCompressedWeightsCodecHuffman;
+}
+
+void DecodePacked(const int8_t* palette, const uint8_t* payload, int bits,
+                  int8_t* output, size_t count) {
+  const uint32_t mask = (1u << bits) - 1;
+  uint32_t acc = 0;
+  int n_bits = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (n_bits < bits) {
+      acc |= static_cast<uint32_t>(*payload++) << n_bits;
+      n_bits += 8;
+    }
+    output[i] = palette[acc & mask];
+    acc >>= bits;
+    n_bits -= bits;
+  }
+}
+
+constexpr int kLookupBits = 8;
+
+// Canonical Huffman decoding: the codes of each length are consecutive
+// integers, symbols[] is ordered by (length, index). The codes up to
+// kLookupBits bits are decoded with a lookup table, the longer ones one bit
+// at a time.
+TfLiteStatus DecodeHuffman(const int8_t* palette, const uint8_t* lengths,
+                           int palette_size, const uint8_t* payload,
+                           size_t payload_size, int8_t* output, size_t count) {
+  uint16_t counts[kCompressedWeightsMaxCodeLength + 1] = {0};
+  int8_t symbols[kCompressedWeightsMaxPalette];
+  // length << 8 | symbol, 0 if the code is longer than kLookupBits
+  uint16_t lookup[1 << kLookupBits] = {0};
+
+  for (int i = 0; i < palette_size; i++) {
+    if (lengths[i] > kCompressedWeightsMaxCodeLength) {
+      return kTfLiteError;
+    }
+    counts[lengths[i]]++;
+  }
+  int n_symbols = 0;
+  int code = 0;
+  for (int len = 1; len <= kCompressedWeightsMaxCodeLength; len++) {
+    for (int i = 0; i < palette_size; i++) {
+      if (lengths[i] != len) {
+        continue;
+      }
+      symbols[n_symbols++] = palette[i];
+      if (len <= kLookupBits) {
+        const int shift = kLookupBits - len;
+        if (((code + 1) << shift) > (1 << kLookupBits)) {
+          return kTfLiteError;  // over-subscribed
+        }
+        for (int j = code << shift; j < (code + 1) << shift; j++) {
+          lookup[j] = static_cast<uint16_t>(
+              (len << 8) | static_cast<uint8_t>(palette[i]));
+        }
+      }
+      code++;
+    }
+    code <<= 1;
+  }
+  if (n_symbols == 0) {
+    return kTfLiteError;
+  }
+
+  // bit buffer, the next bit is the bit n_bits - 1 of acc
+  const uint8_t* end = payload + payload_size;
+  uint32_t acc = 0;
+  int n_bits = 0;
+  for (size_t i = 0; i < count; i++) {
+    while (n_bits <= 24 && payload != end) {
+      acc = (acc << 8) | *payload++;
+      n_bits += 8;
+    }
+    const uint32_t mask = (1u << kLookupBits) - 1;
+    const int peek = n_bits >= kLookupBits
+                         ? (acc >> (n_bits - kLookupBits)) & mask
+                         : (acc << (kLookupBits - n_bits)) & mask;
+    const int entry = lookup[peek];
+    if (entry != 0 && (entry >> 8) <= n_bits) {
+      output[i] = static_cast<int8_t>(entry & 0xFF);
+      n_bits -= entry >> 8;
+      continue;
+    }
+
+    int c = 0;
+    int first = 0;
+    int index = 0;
+    bool found = false;
+    for (int len = 1; len <= kCompressedWeightsMaxCodeLength; len++) {
+      if (n_bits == 0) {
+        return kTfLiteError;  // truncated
+      }
+      c |= (acc >> --n_bits) & 1;
+      const int n = counts[len];
+      if (c - first < n) {
+        output[i] = symbols[index + c - first];
+        found = true;
+        break;
+      }
+      index += n;
+      first = (first + n) << 1;
+      c <<= 1;
+    }
+    if (!found) {
+      return kTfLiteError;
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+size_t CompressedWeightsPaletteSize(const CompressedWeightsHeader& header) {
+  return AlignSize4(header.palette_size);
+}
+
+size_t CompressedWeightsTableSize(const CompressedWeightsHeader& header) {
+  return header.codec == kCompressedWeightsCodecHuffman
+             ? AlignSize4(header.palette_size)
+             : 0;
+}
+
+size_t CompressedWeightsSize(const CompressedWeightsHeader& header) {
+  return sizeof(CompressedWeightsHeader) + CompressedWeightsPaletteSize(header) +
+         CompressedWeightsTableSize(header) + header.payload_size;
+}
+
+uint32_t CompressedWeightsChecksum(const uint8_t* data, size_t size) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    h ^= data[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+bool IsCompressedWeights(const void* data, size_t available_size,
+                         size_t count) {
+  CompressedWeightsHeader header;
+  if (data == nullptr || available_size < sizeof(header) ||
+      !ReadHeader(data, &header) || header.count != count) {
+    return false;
+  }
+  const size_t size = CompressedWeightsSize(header);
+  if (size >= available_size) {
+    return false;
+  }
+  if (header.codec == kCompressedWeightsCodecPacked &&
+      header.payload_size < (count * header.index_bits + 7) / 8) {
+    return false;
+  }
+  const uint8_t* body = static_cast<const uint8_t*>(data) + sizeof(header);
+  return CompressedWeightsChecksum(body, size - sizeof(header)) ==
+         header.checksum;
+}
+
+TfLiteStatus DecompressWeights(const void* data, int8_t* output,
+                               size_t count) {
+  CompressedWeightsHeader header;
+  if (!ReadHeader(data, &header) || header.count != count) {
+    return kTfLiteError;
+  }
+  const int8_t* palette = reinterpret_cast<const int8_t*>(
+      static_cast<const uint8_t*>(data) + sizeof(header));
+  const uint8_t* table = reinterpret_cast<const uint8_t*>(palette) +
+                         CompressedWeightsPaletteSize(header);
+  const uint8_t* payload = table + CompressedWeightsTableSize(header);
+
+  if (header.codec == kCompressedWeightsCodecPacked) {
+    DecodePacked(palette, payload, header.index_bits, output, count);
+    return kTfLiteOk;
+  }
+  return DecodeHuffman(palette, table, header.palette_size, payload,
+                       header.payload_size, output, count);
+}
+
+TfLiteStatus RequestDecompressedTensor(TfLiteContext* context,
+                                       const TfLiteTensor* tensor,
+                                       int* scratch_buffer_index) {
+  *scratch_buffer_index = -1;
+  if (tensor->type != kTfLiteInt8 ||
+      tensor->allocation_type != kTfLiteMmapRo ||
+      !IsCompressedWeights(tensor->data.data, tensor->bytes, tensor->bytes)) {
+    return kTfLiteOk;
+  }
+  return context->RequestScratchBufferInArena(context, tensor->bytes,
+                                              scratch_buffer_index);
+}
+
+TfLiteStatus MakeDecompressedTensor(TfLiteContext* context,
+                                    int scratch_buffer_index,
+                                    const TfLiteEvalTensor* tensor,
+                                    TfLiteEvalTensor* decompressed) {
+  if (scratch_buffer_index < 0) {
+    *decompressed = *tensor;
+    return kTfLiteOk;
+  }
+
+  int8_t* data = static_cast<int8_t*>(
+      context->GetScratchBuffer(context, scratch_buffer_index));
+  // Prepare only verifies the header and the checksum, the stream itself is
+  // decoded here (a Huffman stream can still end early or run over).
+  if (DecompressWeights(tensor->data.data, data,
+                        ElementCount(*tensor->dims)) != kTfLiteOk) {
+    MicroPrintf("Invalid compressed weights");
+    return kTfLiteError;
+  }
+  // decompressed may be tensor: the compressed data is no longer read
+  decompressed->data.data = data;
+  decompressed->dims = tensor->dims;
+  decompressed->type = kTfLiteInt8;
+  return kTfLiteOk;
+}
+
+}  // namespace micro
+}  // namespace tflite
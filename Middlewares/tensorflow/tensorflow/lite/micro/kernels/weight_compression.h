@@ -0,0 +1,99 @@
+/* Copyright 2026 The ml_model_attestation Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/*
+ * Compressed weight buffers (palettised int8 + bit-packed or Huffman coded
+ * indices), produced by ml_model/tools/tflm_compress.
+ *
+ * The constant buffer of a compressed filter starts with a
+ * CompressedWeightsHeader (little-endian) followed by:
+ *
+ *   int8    palette[palette_size]     padded to 4 bytes
+ *   uint8   code_length[palette_size] kCodecHuffman only, padded to 4 bytes
+ *   payload                           payload_size bytes
+ *
+ * kCodecPacked:  index i is stored on index_bits bits at bit i * index_bits
+ *                (LSB first).
+ * kCodecHuffman: canonical Huffman codes (MSB first) of the indices, the codes
+ *                are rebuilt from code_length[] (0: entry not used).
+ *
+ * The checksum (FNV-1a) covers everything after the header, it is only
+ * verified in Prepare. The kernels request a scratch buffer of the size of
+ * the decompressed filter and decompress it before each use (see
+ * MakeUnpackedInt4Tensor() for the same pattern with INT4 filters).
+ */
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_WEIGHT_COMPRESSION_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_WEIGHT_COMPRESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+namespace micro {
+
+constexpr uint32_t kCompressedWeightsMagic = 0x5A435754;  // "TWCZ"
+constexpr uint8_t kCompressedWeightsCodecPacked = 0;
+constexpr uint8_t kCompressedWeightsCodecHuffman = 1;
+constexpr int kCompressedWeightsMaxCodeLength = 15;
+constexpr int kCompressedWeightsMaxPalette = 256;
+
+struct CompressedWeightsHeader {
+  uint32_t magic;
+  uint8_t codec;
+  uint8_t index_bits;     // kCodecPacked only
+  uint16_t palette_size;  // 1..256
+  uint32_t count;         // number of int8 values
+  uint32_t payload_size;
+  uint32_t checksum;
+};
+
+// Sizes of the sections following the header.
+size_t CompressedWeightsPaletteSize(const CompressedWeightsHeader& header);
+size_t CompressedWeightsTableSize(const CompressedWeightsHeader& header);
+size_t CompressedWeightsSize(const CompressedWeightsHeader& header);
+
+uint32_t CompressedWeightsChecksum(const uint8_t* data, size_t size);
+
+// Returns true if data (at least available_size bytes) is a valid compressed
+// buffer of count int8 values. The compressed size must be smaller than
+// available_size, so that an uncompressed buffer is never read out of bounds.
+bool IsCompressedWeights(const void* data, size_t available_size,
+                         size_t count);
+
+// Decompresses a buffer checked with IsCompressedWeights().
+TfLiteStatus DecompressWeights(const void* data, int8_t* output,
+                               size_t count);
+
+// Prepare: requests a scratch buffer for the decompressed filter if the
+// tensor is a compressed INT8 buffer, scratch_buffer_index is -1 otherwise.
+TfLiteStatus RequestDecompressedTensor(TfLiteContext* context,
+                                       const TfLiteTensor* tensor,
+                                       int* scratch_buffer_index);
+
+// Eval: sets decompressed (can be tensor) to a tensor with the weights
+// decompressed in the scratch buffer requested in Prepare, a shallow copy of
+// tensor if scratch_buffer_index is -1. Fails if the stream cannot be decoded.
+TfLiteStatus MakeDecompressedTensor(TfLiteContext* context,
+                                    int scratch_buffer_index,
+                                    const TfLiteEvalTensor* tensor,
+                                    TfLiteEvalTensor* decompressed);
+
+}  // namespace micro
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_WEIGHT_COMPRESSION_H_
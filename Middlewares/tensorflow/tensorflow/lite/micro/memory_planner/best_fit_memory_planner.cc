@@ -0,0 +1,266 @@
+/* Copyright 2026 The ml_model_attestation Authors. All Rights Reserved.
+Derived from tensorflow/lite/micro/memory_planner/greedy_memory_planner.cc,
+Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/*
+ * Interval-aware best-fit memory planner, see best_fit_memory_planner.h
+ */
+
+#include "tensorflow/lite/micro/memory_planner/best_fit_memory_planner.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+
+BestFitMemoryPlanner::BestFitMemoryPlanner(int orderings)
+    : orderings_(orderings < 1 ? 1 : orderings),
+      max_buffer_count_(0),
+      buffer_count_(0),
+      max_size_(0),
+      need_to_calculate_offsets_(true) {}
+
+BestFitMemoryPlanner::~BestFitMemoryPlanner() {
+  // We don't own the scratch buffer, so don't deallocate anything.
+}
+
+TfLiteStatus BestFitMemoryPlanner::Init(unsigned char* scratch_buffer,
+                                        int scratch_buffer_size) {
+  buffer_count_ = 0;
+  max_size_ = 0;
+  need_to_calculate_offsets_ = true;
+  max_buffer_count_ = scratch_buffer_size / per_buffer_size();
+
+  unsigned char* next_free = scratch_buffer;
+  requirements_ = reinterpret_cast<BufferRequirements*>(next_free);
+  next_free += sizeof(BufferRequirements) * max_buffer_count_;
+  order_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+  best_order_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+  offsets_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+  best_offsets_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+  by_offset_ = reinterpret_cast<int*>(next_free);
+  return kTfLiteOk;
+}
+
+TfLiteStatus BestFitMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                             int last_time_used) {
+  if (buffer_count_ >= max_buffer_count_) {
+    MicroPrintf("Too many buffers (max is %d)", max_buffer_count_);
+    return kTfLiteError;
+  }
+  BufferRequirements* current = &requirements_[buffer_count_];
+  current->size = size;
+  current->first_time_used = first_time_used;
+  current->last_time_used = last_time_used;
+  current->offline_offset = kOnlinePlannedBuffer;
+  ++buffer_count_;
+  need_to_calculate_offsets_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus BestFitMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                             int last_time_used,
+                                             int offline_offset) {
+  if (AddBuffer(size, first_time_used, last_time_used) != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  requirements_[buffer_count_ - 1].offline_offset = offline_offset;
+  return kTfLiteOk;
+}
+
+void BestFitMemoryPlanner::SortOrder(int heuristic, int* order) const {
+  for (int i = 0; i < buffer_count_; ++i) {
+    order[i] = i;
+  }
+  const BufferRequirements* r = requirements_;
+  auto lifetime = [r](int i) {
+    return r[i].last_time_used - r[i].first_time_used + 1;
+  };
+  // Ties: larger size, then lower index (stable plan).
+  auto by_size = [r](int a, int b) {
+    return r[a].size != r[b].size ? r[a].size > r[b].size : a < b;
+  };
+  switch (heuristic) {
+    case 1:
+      std::sort(order, order + buffer_count_, [&](int a, int b) {
+        const long long area_a = (long long)r[a].size * lifetime(a);
+        const long long area_b = (long long)r[b].size * lifetime(b);
+        return area_a != area_b ? area_a > area_b : by_size(a, b);
+      });
+      break;
+    case 2:
+      std::sort(order, order + buffer_count_, [&](int a, int b) {
+        return lifetime(a) != lifetime(b) ? lifetime(a) > lifetime(b)
+                                          : by_size(a, b);
+      });
+      break;
+    case 3:
+      std::sort(order, order + buffer_count_, [&](int a, int b) {
+        return r[a].first_time_used != r[b].first_time_used
+                   ? r[a].first_time_used < r[b].first_time_used
+                   : by_size(a, b);
+      });
+      break;
+    default:
+      std::sort(order, order + buffer_count_, by_size);
+      break;
+  }
+}
+
+int BestFitMemoryPlanner::Place(const int* order, int* offsets) {
+  int placed = 0;
+  int max_size = 0;
+
+  // Inserts buffer i in by_offset_ (increasing offsets).
+  auto insert = [&](int i) {
+    int pos = placed;
+    while ((pos > 0) && (offsets[by_offset_[pos - 1]] > offsets[i])) {
+      by_offset_[pos] = by_offset_[pos - 1];
+      --pos;
+    }
+    by_offset_[pos] = i;
+    ++placed;
+    max_size = std::max(max_size, offsets[i] + requirements_[i].size);
+  };
+
+  for (int i = 0; i < buffer_count_; ++i) {
+    if (requirements_[i].offline_offset != kOnlinePlannedBuffer) {
+      offsets[i] = requirements_[i].offline_offset;
+      insert(i);
+    }
+  }
+
+  for (int k = 0; k < buffer_count_; ++k) {
+    const int i = order[k];
+    const BufferRequirements& wanted = requirements_[i];
+    if (wanted.offline_offset != kOnlinePlannedBuffer) {
+      continue;
+    }
+    // Gaps between the buffers live at the same time, in offset order.
+    int cursor = 0;
+    int best_offset = -1;
+    int best_gap = INT_MAX;
+    for (int j = 0; j < placed; ++j) {
+      const int e = by_offset_[j];
+      const BufferRequirements& other = requirements_[e];
+      if ((other.first_time_used > wanted.last_time_used) ||
+          (wanted.first_time_used > other.last_time_used)) {
+        continue;
+      }
+      const int gap = offsets[e] - cursor;
+      if ((gap >= wanted.size) && (gap < best_gap)) {
+        best_gap = gap;
+        best_offset = cursor;
+      }
+      cursor = std::max(cursor, offsets[e] + other.size);
+    }
+    offsets[i] = (best_offset >= 0) ? best_offset : cursor;
+    insert(i);
+  }
+  return max_size;
+}
+
+void BestFitMemoryPlanner::CalculateOffsetsIfNeeded() {
+  if (!need_to_calculate_offsets_) {
+    return;
+  }
+  need_to_calculate_offsets_ = false;
+  max_size_ = 0;
+  if (buffer_count_ == 0) {
+    return;
+  }
+
+  int best_size = INT_MAX;
+  auto evaluate = [&]() {
+    const int size = Place(order_, offsets_);
+    if (size < best_size) {
+      best_size = size;
+      std::copy(order_, order_ + buffer_count_, best_order_);
+      std::copy(offsets_, offsets_ + buffer_count_, best_offsets_);
+    }
+  };
+
+  const int n_heuristics = std::min(orderings_, kHeuristicOrderings);
+  for (int h = 0; h < n_heuristics; ++h) {
+    SortOrder(h, order_);
+    evaluate();
+  }
+
+  // Random swaps of the best order found so far (LCG, fixed seed).
+  uint32_t seed = 1;
+  for (int n = n_heuristics; (n < orderings_) && (buffer_count_ > 1); ++n) {
+    std::copy(best_order_, best_order_ + buffer_count_, order_);
+    seed = seed * 1664525u + 1013904223u;
+    const int a = (seed >> 8) % buffer_count_;
+    seed = seed * 1664525u + 1013904223u;
+    const int b = (seed >> 8) % buffer_count_;
+    std::swap(order_[a], order_[b]);
+    evaluate();
+  }
+  max_size_ = best_size;
+}
+
+size_t BestFitMemoryPlanner::GetMaximumMemorySize() {
+  CalculateOffsetsIfNeeded();
+  return max_size_;
+}
+
+int BestFitMemoryPlanner::GetBufferCount() { return buffer_count_; }
+
+TfLiteStatus BestFitMemoryPlanner::GetOffsetForBuffer(int buffer_index,
+                                                      int* offset) {
+  CalculateOffsetsIfNeeded();
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    MicroPrintf("buffer index %d is outside range 0 to %d", buffer_index,
+                buffer_count_);
+    return kTfLiteError;
+  }
+  *offset = best_offsets_[buffer_index];
+  return kTfLiteOk;
+}
+
+bool BestFitMemoryPlanner::DoAnyBuffersOverlap() {
+  CalculateOffsetsIfNeeded();
+  for (int i = 0; i < buffer_count_; ++i) {
+    const BufferRequirements& a = requirements_[i];
+    for (int j = i + 1; j < buffer_count_; ++j) {
+      const BufferRequirements& b = requirements_[j];
+      if ((a.first_time_used > b.last_time_used) ||
+          (b.first_time_used > a.last_time_used)) {
+        continue;
+      }
+      if ((best_offsets_[i] >= best_offsets_[j] + b.size) ||
+          (best_offsets_[j] >= best_offsets_[i] + a.size)) {
+        continue;
+      }
+      MicroPrintf("Overlap: %d (%d->%d) vs %d (%d->%d)", i, best_offsets_[i],
+                  best_offsets_[i] + a.size, j, best_offsets_[j],
+                  best_offsets_[j] + b.size);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace tflite
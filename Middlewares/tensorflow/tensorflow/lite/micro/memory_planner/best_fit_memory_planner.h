@@ -0,0 +1,115 @@
+/* Copyright 2026 The ml_model_attestation Authors. All Rights Reserved.
+Derived from tensorflow/lite/micro/memory_planner/greedy_memory_planner.h,
+Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/*
+ * Interval-aware best-fit memory planner, alternative to the
+ * GreedyMemoryPlanner (selected with tflm_c_create_with_planner()).
+ *
+ * The buffers are placed one by one in a placement order (largest first by
+ * default). For a buffer, only the placed buffers which are live at the same
+ * time are considered: among the gaps between them which are large enough,
+ * the smallest one is used (best fit, the GreedyMemoryPlanner takes the
+ * first one), else the buffer is placed above them. Offline planned buffers
+ * keep their offset and are placed first.
+ *
+ * With orderings > 1, several placement orders are evaluated and the plan
+ * with the smallest arena size is kept: size, size x lifetime, lifetime and
+ * first use heuristics, then random swaps of the best order (fixed seed, the
+ * plan is deterministic). Each evaluation costs one placement pass.
+ *
+ * The scratch buffer provided by Init() holds the working arrays
+ * (per_buffer_size() bytes per buffer), the result is kept in it.
+ */
+
+#ifndef TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_BEST_FIT_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_BEST_FIT_MEMORY_PLANNER_H_
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+
+namespace tflite {
+
+class BestFitMemoryPlanner : public MicroMemoryPlanner {
+ public:
+  // Number of placement orders evaluated, see kHeuristicOrderings.
+  explicit BestFitMemoryPlanner(int orderings = 1);
+  ~BestFitMemoryPlanner() override;
+
+  static constexpr int kHeuristicOrderings = 4;
+
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override;
+
+  TfLiteStatus AddBuffer(int size, int first_time_used,
+                         int last_time_used) override;
+
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
+                         int offline_offset) override;
+
+  size_t GetMaximumMemorySize() override;
+
+  int GetBufferCount() override;
+
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override;
+
+  // Debug method, O(N^2), as GreedyMemoryPlanner::DoAnyBuffersOverlap().
+  bool DoAnyBuffersOverlap();
+
+  // Number of bytes required in order to plan a buffer.
+  static size_t per_buffer_size() {
+    return sizeof(BufferRequirements) +  // requirements_
+           sizeof(int) +                 // order_
+           sizeof(int) +                 // best_order_
+           sizeof(int) +                 // offsets_
+           sizeof(int) +                 // best_offsets_
+           sizeof(int);                  // by_offset_
+  }
+
+ private:
+  struct BufferRequirements {
+    int size;
+    int offline_offset;
+    int first_time_used;
+    int last_time_used;
+  };
+
+  // Initial placement order of the heuristic h.
+  void SortOrder(int heuristic, int* order) const;
+
+  // Places the buffers in the given order, returns the arena size.
+  int Place(const int* order, int* offsets);
+
+  void CalculateOffsetsIfNeeded();
+
+  int orderings_;
+  int max_buffer_count_;
+  int buffer_count_;
+  BufferRequirements* requirements_;
+  int* order_;
+  int* best_order_;
+  int* offsets_;
+  int* best_offsets_;
+  int* by_offset_;  // placed buffers, increasing offsets
+  int max_size_;
+  bool need_to_calculate_offsets_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_BEST_FIT_MEMORY_PLANNER_H_
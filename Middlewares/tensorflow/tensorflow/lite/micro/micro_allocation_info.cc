@@ -22,7 +22,9 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
 #include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/schema/schema_utils.h"
 
 namespace tflite {
 
@@ -199,6 +201,8 @@ TfLiteStatus AllocationInfoBuilder::InitializeAllocationInfo(
 
       current->first_created = kUninitializedLifetime;
       current->last_used = kUninitializedLifetime;
+      current->alias_of = -1;
+      current->scratch_pool_offset = -1;
       current->needs_allocating =
           (eval_tensors[i].data.data == nullptr) &&
           (!subgraph->tensors()->Get(i)->is_variable()) &&
@@ -226,6 +230,8 @@ TfLiteStatus AllocationInfoBuilder::InitializeAllocationInfo(
     current->last_used = kUninitializedLifetime;
     current->needs_allocating = true;
     current->offline_offset = kOnlinePlannedBuffer;
+    current->alias_of = -1;
+    current->scratch_pool_offset = -1;
   }
   return kTfLiteOk;
 }
@@ -258,10 +264,13 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
     // Each operator has a new allocation scope.
     allocation_scope_count_++;
     const auto* op = subgraph->operators()->Get(i);
+    // The tensors of the node are used rather than the ones of the flatbuffer
+    // operator: a node can be rewritten before Prepare (see micro_op_fusion.h).
+    const TfLiteNode& node =
+        allocations[subgraph_idx].node_and_registrations[i].node;
     // Figure out when the first creation and use of each tensor is.
-    for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
-         ++n) {
-      const int tensor_index = op->outputs()->Get(n);
+    for (int n = 0; node.outputs != nullptr && n < node.outputs->size; ++n) {
+      const int tensor_index = node.outputs->data[n];
       AllocationInfo* current = &subgraph_allocation_info[tensor_index];
       UpdateFirstCreated(current, allocation_scope_count_);
     }
@@ -276,9 +285,8 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
                                      scratch_buffer_handles, allocations);
 
     // Figure out when the last use of each tensor is.
-    for (size_t n = 0; op->inputs() != nullptr && n < op->inputs()->size();
-         ++n) {
-      const int tensor_index = op->inputs()->Get(n);
+    for (int n = 0; node.inputs != nullptr && n < node.inputs->size; ++n) {
+      const int tensor_index = node.inputs->data[n];
       // Optional bias tensors can have an index of -1 when they are omitted.
       if (tensor_index >= 0) {
         AllocationInfo* current = &subgraph_allocation_info[tensor_index];
@@ -288,9 +296,8 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
         UpdateLastUsed(current, allocation_scope_count_);
       }
     }
-    for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
-         ++n) {
-      const int tensor_index = op->outputs()->Get(n);
+    for (int n = 0; node.outputs != nullptr && n < node.outputs->size; ++n) {
+      const int tensor_index = node.outputs->data[n];
       AllocationInfo* current = &subgraph_allocation_info[tensor_index];
       UpdateLastUsed(current, allocation_scope_count_);
     }
@@ -333,6 +340,97 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
   return kTfLiteOk;
 }
 
+TfLiteStatus AllocationInfoBuilder::MarkUnusedAllocations() {
+  const SubGraph* subgraph = model_->subgraphs()->Get(0);
+  AllocationInfo* subgraph_allocation_info =
+      &info_.allocation_info[info_.subgraph_offsets[0]];
+
+  for (size_t i = 0; i < subgraph->tensors()->size(); ++i) {
+    AllocationInfo* current = &subgraph_allocation_info[i];
+    if (current->needs_allocating &&
+        current->first_created == kUninitializedLifetime) {
+      current->needs_allocating = false;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus AllocationInfoBuilder::MarkAliasedAllocations() {
+  const SubGraph* subgraph = model_->subgraphs()->Get(0);
+  AllocationInfo* subgraph_allocation_info =
+      &info_.allocation_info[info_.subgraph_offsets[0]];
+
+  uint32_t operators_size = NumSubgraphOperators(subgraph);
+  for (uint32_t i = 0; i < operators_size; i++) {
+    const auto* op = subgraph->operators()->Get(i);
+    const OperatorCode* opcode =
+        model_->operator_codes()->Get(op->opcode_index());
+    const BuiltinOperator code = GetBuiltinCode(opcode);
+    if ((code != BuiltinOperator_RESHAPE && code != BuiltinOperator_SQUEEZE &&
+         code != BuiltinOperator_EXPAND_DIMS) ||
+        op->inputs() == nullptr || op->inputs()->size() < 1 ||
+        op->outputs() == nullptr || op->outputs()->size() != 1) {
+      continue;
+    }
+    const int input_index = op->inputs()->Get(0);
+    const int output_index = op->outputs()->Get(0);
+    if (input_index < 0 ||
+        subgraph->tensors()->Get(input_index)->is_variable() ||
+        subgraph->tensors()->Get(output_index)->is_variable()) {
+      continue;
+    }
+
+    // The input may already share the buffer of another tensor.
+    AllocationInfo* input = &subgraph_allocation_info[input_index];
+    if (input->alias_of >= 0) {
+      input = &info_.allocation_info[input->alias_of];
+    }
+    AllocationInfo* output = &subgraph_allocation_info[output_index];
+    if (!input->needs_allocating || !output->needs_allocating ||
+        input->bytes != output->bytes ||
+        input->offline_offset != output->offline_offset) {
+      continue;
+    }
+
+    input->first_created =
+        std::min(input->first_created, output->first_created);
+    input->last_used = std::max(input->last_used, output->last_used);
+    output->needs_allocating = false;
+    output->alias_of = input - info_.allocation_info;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus AllocationInfoBuilder::PoolScratchBuffers(size_t* pool_bytes) {
+  AllocationInfo* scratch_allocation_info =
+      &info_.allocation_info[info_.scratch_offset];
+  size_t pool_size = 0;
+  for (size_t i = 0; i < info_.scratch_buffer_count; i++) {
+    AllocationInfo* current = &scratch_allocation_info[i];
+    if (!current->needs_allocating) {
+      continue;
+    }
+    size_t offset = 0;
+    for (size_t j = 0; j < i; j++) {
+      const AllocationInfo* other = &scratch_allocation_info[j];
+      if (other->scratch_pool_offset >= 0 &&
+          other->first_created <= current->last_used &&
+          current->first_created <= other->last_used) {
+        offset = std::max(
+            offset, other->scratch_pool_offset +
+                        AlignSizeUp(other->bytes, MicroArenaBufferAlignment()));
+      }
+    }
+    current->scratch_pool_offset = static_cast<int32_t>(offset);
+    current->needs_allocating = false;
+    pool_size = std::max(
+        pool_size,
+        offset + AlignSizeUp(current->bytes, MicroArenaBufferAlignment()));
+  }
+  *pool_bytes = pool_size;
+  return kTfLiteOk;
+}
+
 // Get offline tensors allocation plan. See
 // micro/docs/memory_management.md for more info.
 TfLiteStatus AllocationInfoBuilder::GetOfflinePlannedOffsets(
@@ -31,6 +31,12 @@ struct AllocationInfo {
   int last_used;
   int32_t offline_offset;
   bool needs_allocating;
+  // Index of the AllocationInfo whose buffer is shared (-1 if none), see
+  // AllocationInfoBuilder::MarkAliasedAllocations().
+  int alias_of;
+  // Offset of a scratch buffer in the shared scratch pool (-1 if planned), see
+  // AllocationInfoBuilder::PoolScratchBuffers().
+  int32_t scratch_pool_offset;
 };
 
 // Used to hold the allocation info list and related metadata for the entire
@@ -86,7 +92,8 @@ class AllocationInfoBuilder {
   // Mark the scope of each tensor and scratch buffer across the graph. Enter
   // all possible subgraphs invoked by each control flow operator. This method
   // marks the maximum lifetime of each buffer so that tensors are correctly
-  // planned for all valid invocation flows.
+  // planned for all valid invocation flows. The inputs and outputs of the
+  // nodes are used, see FuseConvMaxPool() (micro_op_fusion.h).
   TfLiteStatus MarkAllocationLifetimes(
       int subgraph_idx, internal::ScratchBufferRequest* scratch_buffer_request,
       ScratchBufferHandle* scratch_buffer_handles,
@@ -104,6 +111,29 @@ class AllocationInfoBuilder {
       ScratchBufferHandle* scratch_buffer_handles,
       SubgraphAllocations* allocations);
 
+  // A tensor of the main subgraph which is neither used by a node nor a
+  // subgraph input or output (e.g. the intermediate tensor of fused operators)
+  // is removed from the plan (needs_allocating = false). Must be called after
+  // MarkAllocationLifetimes().
+  TfLiteStatus MarkUnusedAllocations();
+
+  // The output of a shape-only operator (RESHAPE, SQUEEZE, EXPAND_DIMS) of the
+  // main subgraph shares the buffer of its input: the kernel has nothing to
+  // copy. The lifetime of the shared buffer is extended to cover both tensors
+  // and the output is removed from the plan (needs_allocating = false). Only
+  // online planned tensors are aliased, or offline planned tensors with the
+  // same offset (plan already aliased by the offline planner). Must be called
+  // after MarkAllocationLifetimes().
+  TfLiteStatus MarkAliasedAllocations();
+
+  // The scratch buffers are removed from the plan (needs_allocating = false)
+  // and placed in a pool shared by all the nodes: a buffer is placed above the
+  // pooled buffers with an overlapping lifetime (the buffers of a node are
+  // stacked, the nodes re-use the same bytes). pool_bytes returns the size of
+  // the pool, the maximum of the scratch memory of a node. Must be called
+  // after MarkAllocationLifetimes().
+  TfLiteStatus PoolScratchBuffers(size_t* pool_bytes);
+
   // Returns the number of allocations.
   int AllocationCount() const { return info_.allocation_info_count; }
 
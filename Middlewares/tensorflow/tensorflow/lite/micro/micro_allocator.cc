@@ -95,6 +95,7 @@ TfLiteStatus CreatePlan(MicroMemoryPlanner* planner,
 }
 
 TfLiteStatus CommitPlan(MicroMemoryPlanner* planner, uint8_t* starting_point,
+                        uint8_t* scratch_pool,
                         const AllocationInfo* allocation_info,
                         size_t allocation_info_size) {
   // Figure out the actual memory addresses for each buffer, based on the plan.
@@ -107,10 +108,49 @@ TfLiteStatus CommitPlan(MicroMemoryPlanner* planner, uint8_t* starting_point,
           planner->GetOffsetForBuffer(planner_index, &offset));
       *current->output_ptr = reinterpret_cast<void*>(starting_point + offset);
       ++planner_index;
+    } else if (current->scratch_pool_offset >= 0) {
+      *current->output_ptr = reinterpret_cast<void*>(
+          scratch_pool + current->scratch_pool_offset);
+    }
+  }
+  // Tensors sharing the buffer of another tensor (shape-only operators).
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->alias_of >= 0) {
+      *current->output_ptr = *allocation_info[current->alias_of].output_ptr;
+    }
+  }
+  return kTfLiteOk;
+}
+
+#if defined(TF_LITE_CHECK_MEMORY_PLAN)
+// Checks the committed plan: the buffers (planned, offline planned or in the
+// scratch pool, not the aliases) whose lifetimes overlap must not overlap in
+// memory.
+TfLiteStatus CheckPlan(const AllocationInfo* allocation_info,
+                       size_t allocation_info_size) {
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* a = &allocation_info[i];
+    if (!a->needs_allocating && a->scratch_pool_offset < 0) {
+      continue;
+    }
+    const uint8_t* a_begin = static_cast<uint8_t*>(*a->output_ptr);
+    for (size_t j = i + 1; j < allocation_info_size; ++j) {
+      const AllocationInfo* b = &allocation_info[j];
+      if ((!b->needs_allocating && b->scratch_pool_offset < 0) ||
+          a->first_created > b->last_used || b->first_created > a->last_used) {
+        continue;
+      }
+      const uint8_t* b_begin = static_cast<uint8_t*>(*b->output_ptr);
+      if (a_begin < b_begin + b->bytes && b_begin < a_begin + a->bytes) {
+        MicroPrintf("Memory plan: buffers %d and %d overlap", i, j);
+        return kTfLiteError;
+      }
     }
   }
   return kTfLiteOk;
 }
+#endif
 
 IPersistentBufferAllocator* CreatePersistentArenaAllocator(uint8_t* buffer_head,
                                                            size_t buffer_size) {
@@ -840,6 +880,12 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
       GetScratchBufferRequests();
   TF_LITE_ENSURE_STATUS(builder.MarkAllocationLifetimes(
       0, scratch_buffer_requests, scratch_buffer_handles, allocations));
+  TF_LITE_ENSURE_STATUS(builder.MarkUnusedAllocations());
+  TF_LITE_ENSURE_STATUS(builder.MarkAliasedAllocations());
+  size_t scratch_pool_bytes = 0;
+  if (scratch_pool_) {
+    TF_LITE_ENSURE_STATUS(builder.PoolScratchBuffers(&scratch_pool_bytes));
+  }
   int allocation_info_count = builder.AllocationCount();
   AllocationInfo* allocation_info = builder.Finish();
 
@@ -858,11 +904,19 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   TF_LITE_ENSURE_STATUS(
       CreatePlan(memory_planner_, allocation_info, allocation_info_count));
 
+  // The scratch pool is placed above the planned buffers.
+  const size_t scratch_pool_offset = AlignSizeUp(
+      memory_planner_->GetMaximumMemorySize(), MicroArenaBufferAlignment());
+  uint8_t* overlay =
+      non_persistent_buffer_allocator_->GetOverlayMemoryAddress();
+
   // Commit the plan.
-  TF_LITE_ENSURE_STATUS(
-      CommitPlan(memory_planner_,
-                 non_persistent_buffer_allocator_->GetOverlayMemoryAddress(),
-                 allocation_info, allocation_info_count));
+  TF_LITE_ENSURE_STATUS(CommitPlan(memory_planner_, overlay,
+                                   overlay + scratch_pool_offset,
+                                   allocation_info, allocation_info_count));
+#if defined(TF_LITE_CHECK_MEMORY_PLAN)
+  TF_LITE_ENSURE_STATUS(CheckPlan(allocation_info, allocation_info_count));
+#endif
 
   // Reset all temp allocations used above:
   builder.FreeAllocationInfo();
@@ -877,6 +931,9 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   memory_planner_->PrintMemoryPlan();
 #endif
   head_usage = memory_planner_->GetMaximumMemorySize();
+  if (scratch_pool_bytes > 0) {
+    head_usage = scratch_pool_offset + scratch_pool_bytes;
+  }
 
   // The head is used to store memory plans for one model at a time during the
   // model preparation stage, and is re-purposed to store scratch buffer handles
@@ -229,6 +229,13 @@ class MicroAllocator {
   // next node prepare block.
   TfLiteStatus FinishPrepareNodeAllocations(int node_id);
 
+  // Places the scratch buffers in a pool shared by all the nodes, above the
+  // planned tensors, instead of planning them with the tensors (see
+  // AllocationInfoBuilder::PoolScratchBuffers()). Must be called before
+  // FinishModelAllocation(). Building with TF_LITE_CHECK_MEMORY_PLAN checks
+  // that the buffers alive at the same time do not overlap.
+  void SetScratchPool(bool enable) { scratch_pool_ = enable; }
+
   // Returns the arena usage in bytes, only available after
   // `FinishModelAllocation`. Otherwise, it will return 0.
   size_t used_bytes() const;
@@ -314,6 +321,9 @@ class MicroAllocator {
 
   bool model_is_allocating_;
 
+  // Scratch buffers in a shared pool, see SetScratchPool().
+  bool scratch_pool_ = false;
+
   // Holds the number of ScratchBufferRequest instances stored in the head
   // section when a model is allocating.
   size_t scratch_buffer_request_count_ = 0;
@@ -35,6 +35,47 @@ const char* OpNameFromRegistration(const TfLiteRegistration_V1* registration) {
   }
 }
 
+// Invokes the operators of a dispatch table. The loop without profiler does
+// not evaluate the operator names nor call the profiler hooks.
+template <bool kProfiled>
+TfLiteStatus InvokeDispatchTable(TfLiteContext* context,
+                                 MicroAllocator* allocator,
+                                 const MicroDispatchTable& table) {
+  MicroProfilerInterface* profiler =
+      reinterpret_cast<MicroProfilerInterface*>(context->profiler);
+  const MicroDispatchEntry* end = table.entries + table.size;
+  for (const MicroDispatchEntry* entry = table.entries; entry != end;
+       ++entry) {
+    uint32_t event_handle = 0;
+    if (kProfiled) {
+      event_handle =
+          profiler->BeginEvent(OpNameFromRegistration(entry->registration));
+    }
+
+    TfLiteStatus invoke_status = entry->invoke(context, entry->node);
+
+    // All TfLiteTensor structs used in the kernel are allocated from temp
+    // memory in the allocator. This creates a chain of allocations in the
+    // temp section. The call below resets the chain of allocations to
+    // prepare for the next call.
+    allocator->ResetTempAllocations();
+
+    if (kProfiled) {
+      profiler->EndEvent(event_handle);
+    }
+
+    if (invoke_status == kTfLiteError) {
+      MicroPrintf("Node %s (number %d) failed to invoke with status %d",
+                  OpNameFromRegistration(entry->registration),
+                  static_cast<int>(entry - table.entries), invoke_status);
+      return kTfLiteError;
+    } else if (invoke_status != kTfLiteOk) {
+      return invoke_status;
+    }
+  }
+  return kTfLiteOk;
+}
+
 }  // namespace
 
 MicroGraph::MicroGraph(TfLiteContext* context, const Model* model,
@@ -142,6 +183,56 @@ TfLiteStatus MicroGraph::FreeSubgraphs() {
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroGraph::BuildDispatchTables() {
+  const size_t subgraphs_size = subgraphs_->size();
+  if (dispatch_tables_ == nullptr) {
+    MicroDispatchTable* tables = static_cast<MicroDispatchTable*>(
+        allocator_->AllocatePersistentBuffer(sizeof(MicroDispatchTable) *
+                                             subgraphs_size));
+    if (tables == nullptr) {
+      MicroPrintf("Failed to allocate memory for the dispatch tables");
+      return kTfLiteError;
+    }
+    for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_size;
+         subgraph_idx++) {
+      MicroDispatchTable& table = tables[subgraph_idx];
+      table.size = NumSubgraphOperators(model_, subgraph_idx);
+      table.entries = nullptr;
+      if (table.size > 0) {
+        table.entries = static_cast<MicroDispatchEntry*>(
+            allocator_->AllocatePersistentBuffer(sizeof(MicroDispatchEntry) *
+                                                 table.size));
+        if (table.entries == nullptr) {
+          MicroPrintf("Failed to allocate memory for the dispatch table %d",
+                      subgraph_idx);
+          return kTfLiteError;
+        }
+      }
+    }
+    dispatch_tables_ = tables;
+  }
+
+  for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_size;
+       subgraph_idx++) {
+    const MicroDispatchTable& table = dispatch_tables_[subgraph_idx];
+    for (size_t i = 0; i < table.size; ++i) {
+      NodeAndRegistration& node_and_registration =
+          subgraph_allocations_[subgraph_idx].node_and_registrations[i];
+      const TfLiteRegistration_V1* registration =
+          node_and_registration.registration;
+      if (registration == nullptr || registration->invoke == nullptr) {
+        MicroPrintf("Node %d of subgraph %d has no invoke function", i,
+                    subgraph_idx);
+        return kTfLiteError;
+      }
+      table.entries[i].invoke = registration->invoke;
+      table.entries[i].node = &node_and_registration.node;
+      table.entries[i].registration = registration;
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
   int previous_subgraph_idx = current_subgraph_index_;
   current_subgraph_index_ = subgraph_idx;
@@ -151,40 +242,26 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
                 subgraph_idx, subgraphs_->size());
     return kTfLiteError;
   }
-  uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
-  for (size_t i = 0; i < operators_size; ++i) {
-    TfLiteNode* node =
-        &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
-    const TfLiteRegistration_V1* registration =
-        subgraph_allocations_[subgraph_idx]
-            .node_and_registrations[i]
-            .registration;
-
-// This ifdef is needed (even though ScopedMicroProfiler itself is a no-op with
-// -DTF_LITE_STRIP_ERROR_STRINGS) because the function OpNameFromRegistration is
-// only defined for builds with the error strings.
+  if (dispatch_tables_ == nullptr) {
+    MicroPrintf("Invoking subgraph %d before BuildDispatchTables()",
+                subgraph_idx);
+    return kTfLiteError;
+  }
+  const MicroDispatchTable& table = dispatch_tables_[subgraph_idx];
+
+// No profiler hooks with -DTF_LITE_STRIP_ERROR_STRINGS, as for
+// ScopedMicroProfiler (no-op in that configuration).
 #if !defined(TF_LITE_STRIP_ERROR_STRINGS)
-    ScopedMicroProfiler scoped_profiler(
-        OpNameFromRegistration(registration),
-        reinterpret_cast<MicroProfilerInterface*>(context_->profiler));
+  TfLiteStatus invoke_status =
+      (context_->profiler != nullptr)
+          ? InvokeDispatchTable<true>(context_, allocator_, table)
+          : InvokeDispatchTable<false>(context_, allocator_, table);
+#else
+  TfLiteStatus invoke_status =
+      InvokeDispatchTable<false>(context_, allocator_, table);
 #endif
-
-    TFLITE_DCHECK(registration->invoke);
-    TfLiteStatus invoke_status = registration->invoke(context_, node);
-
-    // All TfLiteTensor structs used in the kernel are allocated from temp
-    // memory in the allocator. This creates a chain of allocations in the
-    // temp section. The call below resets the chain of allocations to
-    // prepare for the next call.
-    allocator_->ResetTempAllocations();
-
-    if (invoke_status == kTfLiteError) {
-      MicroPrintf("Node %s (number %d) failed to invoke with status %d",
-                  OpNameFromRegistration(registration), i, invoke_status);
-      return kTfLiteError;
-    } else if (invoke_status != kTfLiteOk) {
-      return invoke_status;
-    }
+  if (invoke_status != kTfLiteOk) {
+    return invoke_status;
   }
   current_subgraph_index_ = previous_subgraph_idx;
   return kTfLiteOk;
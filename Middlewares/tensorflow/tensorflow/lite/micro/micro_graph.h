@@ -23,6 +23,21 @@ limitations under the License.
 
 namespace tflite {
 
+// Operator of a subgraph as invoked by MicroGraph::InvokeSubgraph(), copied
+// from its NodeAndRegistration. The registration is only used for the name of
+// the operator (profiling and error messages).
+struct MicroDispatchEntry {
+  TfLiteStatus (*invoke)(TfLiteContext* context, TfLiteNode* node);
+  TfLiteNode* node;
+  const TfLiteRegistration_V1* registration;
+};
+
+// Operators of a subgraph in execution order.
+struct MicroDispatchTable {
+  MicroDispatchEntry* entries;
+  uint32_t size;
+};
+
 // Abstracts the details of interacting with the tflite::Model.
 //
 // Provides methods to access, initialize, prepare, invoke and free any
@@ -50,8 +65,15 @@ class MicroGraph {
   // the model.
   virtual TfLiteStatus FreeSubgraphs();
 
+  // Builds the dispatch table of every subgraph in the persistent section of
+  // the arena, must be called once the operators are prepared. If the
+  // registration of a node is replaced afterwards, calling it again updates
+  // the tables in place.
+  TfLiteStatus BuildDispatchTables();
+
   // Calls TfLiteRegistration_V1->Invoke for every operator in a single subgraph
-  // in the model.
+  // in the model, through its dispatch table. The profiler events are only
+  // emitted if the context has a profiler.
   virtual TfLiteStatus InvokeSubgraph(int subgraph_idx);
 
   // Zeros out all variable tensors in all subgraphs in the model.
@@ -95,6 +117,7 @@ class MicroGraph {
   int current_subgraph_index_;
   MicroResourceVariables* resource_variables_;
   const flatbuffers::Vector<flatbuffers::Offset<SubGraph>>* subgraphs_;
+  MicroDispatchTable* dispatch_tables_ = nullptr;
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
@@ -79,6 +79,16 @@ class MicroInterpreter {
   // one external context.
   TfLiteStatus SetMicroExternalContext(void* external_context_payload);
 
+  // Enables the prepare-time fusion of the CONV_2D -> [RELU] -> MAX_POOL_2D
+  // chains (see micro_op_fusion.h). Must be called before AllocateTensors().
+  void SetOperatorFusion(bool enable) { fuse_operators_ = enable; }
+
+  // Replaces the profiler given to the constructor, nullptr to invoke the
+  // operators without profiler hooks.
+  void SetProfiler(MicroProfilerInterface* profiler) {
+    context_.profiler = profiler;
+  }
+
   TfLiteTensor* input(size_t index);
   size_t inputs_size() const {
     return model_->subgraphs()->Get(0)->inputs()->size();
@@ -153,6 +163,7 @@ class MicroInterpreter {
   MicroAllocator& allocator_;
   MicroGraph graph_;
   bool tensors_allocated_;
+  bool fuse_operators_ = false;
 
   TfLiteStatus initialization_status_;
 
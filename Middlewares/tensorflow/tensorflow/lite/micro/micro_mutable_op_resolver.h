@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/compatibility.h"
 #include "tensorflow/lite/micro/kernels/add.h"
+#include "tensorflow/lite/micro/kernels/block_sparse_fully_connected.h"
 #include "tensorflow/lite/micro/kernels/conv.h"
 #include "tensorflow/lite/micro/kernels/depthwise_conv.h"
 #include "tensorflow/lite/micro/kernels/ethosu.h"
@@ -151,6 +152,11 @@ class MicroMutableOpResolver : public MicroOpResolver {
                       Register_BATCH_TO_SPACE_ND(), ParseBatchToSpaceNd);
   }
 
+  TfLiteStatus AddBlockSparseFullyConnected() {
+    return AddCustom(tflite::micro::kBlockSparseFullyConnectedName,
+                     tflite::Register_BLOCK_SPARSE_FULLY_CONNECTED());
+  }
+
   TfLiteStatus AddBroadcastArgs() {
     return AddBuiltin(BuiltinOperator_BROADCAST_ARGS, Register_BROADCAST_ARGS(),
                       ParseBroadcastArgs);
@@ -0,0 +1,239 @@
+/* Copyright 2026 The ml_model_attestation Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/*
+ * Prepare-time operator fusion, see micro_op_fusion.h
+ */
+
+#include "tensorflow/lite/micro/micro_op_fusion.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+namespace {
+
+constexpr char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
+
+// Invoke of the RELU and MAX_POOL_2D nodes of a fused chain.
+TfLiteStatus FusedNodeEval(TfLiteContext* context, TfLiteNode* node) {
+  return kTfLiteOk;
+}
+
+bool HasOfflinePlan(const Model* model) {
+  if (model->metadata() == nullptr) {
+    return false;
+  }
+  for (size_t i = 0; i < model->metadata()->size(); ++i) {
+    const auto* metadata = model->metadata()->Get(i);
+    if (metadata->name() != nullptr &&
+        strcmp(metadata->name()->c_str(), kOfflineMemAllocMetadata) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IsInt8(const SubGraph* subgraph, int tensor_index) {
+  return tensor_index >= 0 &&
+         subgraph->tensors()->Get(tensor_index)->type() == TensorType_INT8;
+}
+
+// Per-tensor quantization, same scale and zero point.
+bool SameQuantization(const SubGraph* subgraph, int a, int b) {
+  const auto* qa = subgraph->tensors()->Get(a)->quantization();
+  const auto* qb = subgraph->tensors()->Get(b)->quantization();
+  if (qa == nullptr || qb == nullptr || qa->scale() == nullptr ||
+      qb->scale() == nullptr || qa->zero_point() == nullptr ||
+      qb->zero_point() == nullptr || qa->scale()->size() != 1 ||
+      qb->scale()->size() != 1 || qa->zero_point()->size() != 1 ||
+      qb->zero_point()->size() != 1) {
+    return false;
+  }
+  return qa->scale()->Get(0) == qb->scale()->Get(0) &&
+         qa->zero_point()->Get(0) == qb->zero_point()->Get(0);
+}
+
+// The tensor is only used by one node and is not a subgraph output.
+bool HasSingleConsumer(const SubGraph* subgraph,
+                       const NodeAndRegistration* nodes, int tensor_index) {
+  for (size_t i = 0;
+       subgraph->outputs() != nullptr && i < subgraph->outputs()->size(); ++i) {
+    if (subgraph->outputs()->Get(i) == tensor_index) {
+      return false;
+    }
+  }
+  int uses = 0;
+  for (uint32_t i = 0; i < NumSubgraphOperators(subgraph); ++i) {
+    const TfLiteIntArray* inputs = nodes[i].node.inputs;
+    for (int n = 0; inputs != nullptr && n < inputs->size; ++n) {
+      uses += (inputs->data[n] == tensor_index) ? 1 : 0;
+    }
+  }
+  return uses == 1;
+}
+
+// Single input and output, the input being the given tensor.
+bool IsChainedNode(const NodeAndRegistration& n, BuiltinOperator code,
+                   int input_index) {
+  return n.registration != nullptr && n.registration->builtin_code == code &&
+         n.node.inputs != nullptr && n.node.inputs->size == 1 &&
+         n.node.inputs->data[0] == input_index && n.node.outputs != nullptr &&
+         n.node.outputs->size == 1;
+}
+
+// Folds the activation of a RELU node in the pooling activation.
+bool FoldActivation(TfLiteFusedActivation relu, TfLiteFusedActivation* act) {
+  if (*act == kTfLiteActNone || *act == relu) {
+    *act = relu;
+    return true;
+  }
+  if ((*act == kTfLiteActRelu && relu == kTfLiteActRelu6) ||
+      (*act == kTfLiteActRelu6 && relu == kTfLiteActRelu)) {
+    *act = kTfLiteActRelu6;
+    return true;
+  }
+  return false;
+}
+
+TfLiteIntArray* AllocateIntArray(MicroAllocator* allocator, int size) {
+  TfLiteIntArray* array = static_cast<TfLiteIntArray*>(
+      allocator->AllocatePersistentBuffer(TfLiteIntArrayGetSizeInBytes(size)));
+  if (array != nullptr) {
+    array->size = size;
+  }
+  return array;
+}
+
+// Turns the node into a no-op node without tensors, the name of the operator
+// is kept (profiling).
+TfLiteStatus DisableNode(MicroAllocator* allocator, TfLiteIntArray* empty,
+                         NodeAndRegistration* n) {
+  TfLiteRegistration_V1* registration = static_cast<TfLiteRegistration_V1*>(
+      allocator->AllocatePersistentBuffer(sizeof(TfLiteRegistration_V1)));
+  if (registration == nullptr) {
+    return kTfLiteError;
+  }
+  *registration = *n->registration;
+  registration->init = nullptr;
+  registration->free = nullptr;
+  registration->prepare = nullptr;
+  registration->invoke = FusedNodeEval;
+  registration->profiling_string = nullptr;
+  n->registration = registration;
+  n->node.inputs = empty;
+  n->node.outputs = empty;
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TfLiteStatus FuseConvMaxPool(const Model* model,
+                             SubgraphAllocations* allocations,
+                             MicroAllocator* allocator, int* fused_count) {
+  if (fused_count != nullptr) {
+    *fused_count = 0;
+  }
+  if (HasOfflinePlan(model)) {
+    return kTfLiteOk;
+  }
+  const SubGraph* subgraph = model->subgraphs()->Get(0);
+  NodeAndRegistration* nodes = allocations[0].node_and_registrations;
+  const uint32_t operators_size = NumSubgraphOperators(subgraph);
+  TfLiteIntArray* empty = nullptr;
+
+  for (uint32_t i = 0; i + 1 < operators_size; ++i) {
+    NodeAndRegistration& conv = nodes[i];
+    if (conv.registration == nullptr ||
+        conv.registration->builtin_code != BuiltinOperator_CONV_2D ||
+        conv.node.inputs == nullptr || conv.node.inputs->size < 2 ||
+        conv.node.outputs == nullptr || conv.node.outputs->size != 1 ||
+        !IsInt8(subgraph, conv.node.inputs->data[0]) ||
+        !IsInt8(subgraph, conv.node.outputs->data[0])) {
+      continue;
+    }
+    const int conv_output = conv.node.outputs->data[0];
+
+    // optional RELU / RELU6
+    NodeAndRegistration* relu = nullptr;
+    TfLiteFusedActivation relu_activation = kTfLiteActNone;
+    uint32_t next = i + 1;
+    int pool_input = conv_output;
+    if (IsChainedNode(nodes[next], BuiltinOperator_RELU, pool_input) ||
+        IsChainedNode(nodes[next], BuiltinOperator_RELU6, pool_input)) {
+      relu = &nodes[next];
+      relu_activation =
+          (relu->registration->builtin_code == BuiltinOperator_RELU)
+              ? kTfLiteActRelu
+              : kTfLiteActRelu6;
+      const int relu_output = relu->node.outputs->data[0];
+      if (next + 1 >= operators_size || !IsInt8(subgraph, relu_output) ||
+          !SameQuantization(subgraph, pool_input, relu_output) ||
+          !HasSingleConsumer(subgraph, nodes, pool_input)) {
+        continue;
+      }
+      pool_input = relu_output;
+      ++next;
+    }
+
+    NodeAndRegistration& pool = nodes[next];
+    if (!IsChainedNode(pool, BuiltinOperator_MAX_POOL_2D, pool_input) ||
+        pool.node.builtin_data == nullptr) {
+      continue;
+    }
+    const int pool_output = pool.node.outputs->data[0];
+    TfLitePoolParams params =
+        *static_cast<const TfLitePoolParams*>(pool.node.builtin_data);
+    if (!IsInt8(subgraph, pool_output) ||
+        !SameQuantization(subgraph, pool_input, pool_output) ||
+        !HasSingleConsumer(subgraph, nodes, pool_input) ||
+        params.padding != kTfLitePaddingValid ||
+        params.stride_height < params.filter_height ||
+        (relu != nullptr &&
+         !FoldActivation(relu_activation, &params.activation))) {
+      continue;
+    }
+
+    FusedMaxPoolParams* fused = static_cast<FusedMaxPoolParams*>(
+        allocator->AllocatePersistentBuffer(sizeof(FusedMaxPoolParams)));
+    TfLiteIntArray* outputs = AllocateIntArray(allocator, 1);
+    if (empty == nullptr) {
+      empty = AllocateIntArray(allocator, 0);
+    }
+    if (fused == nullptr || outputs == nullptr || empty == nullptr) {
+      MicroPrintf("Failed to allocate memory for the fused node %d", i);
+      return kTfLiteError;
+    }
+    fused->pool = params;
+    fused->conv_output = conv_output;
+    outputs->data[0] = pool_output;
+    conv.node.outputs = outputs;
+    conv.node.custom_initial_data = reinterpret_cast<const char*>(fused);
+    conv.node.custom_initial_data_size = sizeof(FusedMaxPoolParams);
+    if (relu != nullptr) {
+      TF_LITE_ENSURE_STATUS(DisableNode(allocator, empty, relu));
+    }
+    TF_LITE_ENSURE_STATUS(DisableNode(allocator, empty, &pool));
+    if (fused_count != nullptr) {
+      ++*fused_count;
+    }
+    i = next;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,76 @@
+/* Copyright 2026 The ml_model_attestation Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/*
+ * Prepare-time fusion of CONV_2D -> [RELU | RELU6] -> MAX_POOL_2D (int8),
+ * enabled with MicroInterpreter::SetOperatorFusion().
+ *
+ * The nodes of the main subgraph are rewritten after their creation, before
+ * Init/Prepare: the CONV_2D node gets the output of the MAX_POOL_2D node and a
+ * FusedMaxPoolParams descriptor (TfLiteNode::custom_initial_data), the RELU
+ * and MAX_POOL_2D nodes become no-op nodes without tensors. The conv kernel
+ * (kernels/cmsis_nn/conv.cc) computes the conv rows of one pooling window at a
+ * time in a scratch buffer and pools them, so the conv output is never stored:
+ * as it is not used anymore by a node, it is removed from the memory plan
+ * (AllocationInfoBuilder::MarkUnusedAllocations()). A RELU is folded in the
+ * pooling activation (max and clamp commute).
+ *
+ * Fused chains: consecutive operators, int8 tensors, intermediate tensors used
+ * only by the next operator of the chain (not subgraph outputs), same
+ * quantization for the input and the output of RELU and MAX_POOL_2D, VALID
+ * pooling with stride_height >= filter_height (no conv row computed twice).
+ * Models with an offline memory plan are not fused (plan made for the unfused
+ * graph).
+ */
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_OP_FUSION_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_OP_FUSION_H_
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Attached to a CONV_2D node fused with the following MAX_POOL_2D.
+struct FusedMaxPoolParams {
+  // Parameters of the MAX_POOL_2D node, the activation includes the RELU.
+  TfLitePoolParams pool;
+  // Index of the (not allocated) conv output tensor.
+  int conv_output;
+};
+
+// Returns the descriptor of a fused CONV_2D node, nullptr if not fused.
+inline const FusedMaxPoolParams* GetFusedMaxPoolParams(
+    const TfLiteNode* node) {
+  if (node->custom_initial_data == nullptr ||
+      node->custom_initial_data_size != sizeof(FusedMaxPoolParams)) {
+    return nullptr;
+  }
+  return static_cast<const FusedMaxPoolParams*>(node->custom_initial_data);
+}
+
+// Fuses the chains of the main subgraph, the descriptors and the new tensor
+// lists are allocated in the persistent section of the arena. fused_count
+// (optional) returns the number of fused chains.
+TfLiteStatus FuseConvMaxPool(const Model* model,
+                             SubgraphAllocations* allocations,
+                             MicroAllocator* allocator,
+                             int* fused_count = nullptr);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_OP_FUSION_H_
@@ -25,6 +25,10 @@ namespace tflite {
 // performance. Bottleck operators can be identified along with slow code
 // sections. This can be used in conjunction with running the relevant micro
 // benchmark to evaluate end-to-end performance.
+//
+// With TF_LITE_PROFILER_WITH_BUFFER the event buffers take 80 KB on a 32-bit
+// target, see MicroRingProfiler (micro_ring_profiler.h) for a bounded buffer
+// drained while the inferences run.
 class MicroProfiler : public MicroProfilerInterface {
  public:
   MicroProfiler() = default;
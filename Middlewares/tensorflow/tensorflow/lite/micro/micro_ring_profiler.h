@@ -0,0 +1,183 @@
+/* Copyright 2026 The ml_model_attestation Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/*
+ * Ring-buffer profiler with a capacity fixed at compile time, alternative to
+ * MicroProfiler built with TF_LITE_PROFILER_WITH_BUFFER (4096 tag pointers,
+ * start and end ticks and a 4096-entry TicksPerTag table: 80 KB on a 32-bit
+ * target).
+ *
+ * An event is an operator index (16 bits) and its duration in ticks
+ * (TickType, modulo 2^(8 * sizeof(TickType)): uint16_t is enough with a
+ * prescaled timer). The operator index is the rank of the event since the last
+ * StartInference() call, i.e. the node index when only the operators are
+ * profiled (MicroGraph::InvokeSubgraph()), the tag is not stored (the host
+ * resolves the index with the model). When the buffer is full, the oldest
+ * event is overwritten and counted as dropped.
+ *
+ * The events are consumed oldest first with ReadEvent() or drained through a
+ * write function, e.g. the UART one used by DebugLog(), so the profiler can
+ * stay enabled: capacity of one or a few inferences, drained between the
+ * inferences (no concurrent access).
+ *
+ *   MicroRingProfiler<64, uint16_t> profiler;  // 256 bytes of events
+ *   MicroInterpreter interpreter(model, resolver, arena, size, nullptr,
+ *                                &profiler);
+ *   ..
+ *   profiler.StartInference();
+ *   interpreter.Invoke();
+ *   profiler.Drain(tflm_io_write);
+ */
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_RING_PROFILER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_RING_PROFILER_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+
+template <uint32_t kCapacity, typename TickType = uint32_t>
+class MicroRingProfiler : public MicroProfilerInterface {
+ public:
+  static_assert(kCapacity > 0 && kCapacity <= 65536 &&
+                    (kCapacity & (kCapacity - 1)) == 0,
+                "kCapacity must be a power of two, 65536 at most");
+  static_assert(sizeof(TickType) <= sizeof(uint32_t),
+                "TickType must be a 8, 16 or 32-bit unsigned type");
+
+  // Record of an event, also the binary format of Drain() (host byte order).
+  struct Event {
+    uint16_t op;
+    TickType ticks;
+  };
+
+  // Returns the number of bytes written (count if OK), as tflm_io_write().
+  typedef int (*WriteFn)(const void* data, uint16_t count);
+
+  // get_ticks: time source, GetCurrentTimeTicks() (micro_time.h) by default.
+  explicit MicroRingProfiler(uint32_t (*get_ticks)() = GetCurrentTimeTicks)
+      : get_ticks_(get_ticks) {}
+  virtual ~MicroRingProfiler() = default;
+
+  // The start tick is kept in the record until EndEvent().
+  virtual uint32_t BeginEvent(const char* tag) override {
+    if (head_ - tail_ == kCapacity) {
+      ++tail_;
+      ++dropped_;
+    }
+    Event& event = events_[head_ & kMask];
+    event.op = op_++;
+    event.ticks = static_cast<TickType>(get_ticks_());
+    return head_++;
+  }
+
+  // Ignored if the event has already been overwritten or consumed.
+  virtual void EndEvent(uint32_t event_handle) override {
+    if (event_handle - tail_ >= head_ - tail_) {
+      return;
+    }
+    Event& event = events_[event_handle & kMask];
+    event.ticks = static_cast<TickType>(get_ticks_() - event.ticks);
+  }
+
+  // Restarts the operator indexes, to call before each inference.
+  void StartInference() { op_ = 0; }
+
+  // Removes the events and resets the dropped count.
+  void ClearEvents() {
+    tail_ = head_;
+    dropped_ = 0;
+  }
+
+  // Number of buffered events.
+  uint32_t Size() const { return head_ - tail_; }
+
+  // Number of events overwritten before being consumed.
+  uint32_t Dropped() const { return dropped_; }
+
+  // Removes the oldest event, false if there is none.
+  bool ReadEvent(Event* event) {
+    if (head_ == tail_) {
+      return false;
+    }
+    *event = events_[tail_++ & kMask];
+    return true;
+  }
+
+  // Writes up to max_events events (oldest first, contiguous chunks of the
+  // buffer) and removes them. Stops at the first incomplete write, the events
+  // of that chunk are kept. Returns the number of events written.
+  uint32_t Drain(WriteFn write, uint32_t max_events = kCapacity) {
+    constexpr uint32_t kMaxChunk = 0xFFFF / sizeof(Event);
+    uint32_t written = 0;
+    while (written < max_events && head_ != tail_) {
+      const uint32_t first = tail_ & kMask;
+      uint32_t count = head_ - tail_;
+      if (count > kCapacity - first) {
+        count = kCapacity - first;
+      }
+      if (count > max_events - written) {
+        count = max_events - written;
+      }
+      if (count > kMaxChunk) {
+        count = kMaxChunk;
+      }
+      const uint16_t bytes = static_cast<uint16_t>(count * sizeof(Event));
+      if (write(&events_[first], bytes) != bytes) {
+        break;
+      }
+      tail_ += count;
+      written += count;
+    }
+    return written;
+  }
+
+  // Prints and removes the events in CSV form (MicroPrintf()).
+  void LogCsv() {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+    MicroPrintf("\"Op\",\"Ticks\"");
+    Event event;
+    while (ReadEvent(&event)) {
+      MicroPrintf("%d,%u", event.op, static_cast<unsigned>(event.ticks));
+    }
+    if (dropped_ != 0) {
+      MicroPrintf("dropped events, %u", static_cast<unsigned>(dropped_));
+    }
+#endif
+  }
+
+ private:
+  static constexpr uint32_t kMask = kCapacity - 1;
+
+  uint32_t (*get_ticks_)();
+  // Sequence numbers (also the event handles), the buffered events are
+  // [tail_, head_).
+  uint32_t head_ = 0;
+  uint32_t tail_ = 0;
+  uint32_t dropped_ = 0;
+  uint16_t op_ = 0;
+  Event events_[kCapacity];
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_RING_PROFILER_H_
@@ -0,0 +1,214 @@
+/*
+ * SPDX-FileCopyrightText: Copyright 2026 The ml_model_attestation Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * x86 SIMD inner loops of the CMSIS-NN kernels for the host builds
+ * (CMSIS_NN_HOST_SIMD, SSE4.1, AVX2 if __AVX2__). Not used on the targets.
+ *
+ * The kernels built with CMSIS_NN_HOST_SIMD replace their portable C inner
+ * loops by these functions. The products are s4/s8/s16 x s16 or s8 x s8, summed by
+ * pairs into 32 bits (PMADDWD, as SMLAD) and accumulated modulo 2^32, so the
+ * results are the ones of the Cortex-M DSP path whatever the summation order.
+ */
+
+#ifndef ARM_NN_HOST_SIMD_H
+#define ARM_NN_HOST_SIMD_H
+
+#include <immintrin.h>
+#include <stdint.h>
+#include <string.h>
+
+#if !defined(__SSE4_1__)
+    #error "CMSIS_NN_HOST_SIMD requires SSE4.1 (-msse4.1)"
+#endif
+
+/* Shorter dot products (e.g. 3x3x1 conv) are faster with the portable C loop */
+#define ARM_NN_HOST_SIMD_MIN_COLS (16)
+
+__STATIC_FORCEINLINE int32_t arm_nn_host_hsum_s32(__m128i acc)
+{
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc);
+}
+
+/**
+ * @brief sum(a[i] * b[i]), i < n, a s8, b s16
+ */
+__STATIC_FORCEINLINE int32_t arm_nn_host_dot_s8_s16(const int8_t *a, const int16_t *b, const int32_t n)
+{
+    int32_t i = 0;
+#if defined(__AVX2__)
+    __m256i acc_256 = _mm256_setzero_si256();
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(a + i)));
+        const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        acc_256 = _mm256_add_epi32(acc_256, _mm256_madd_epi16(va, vb));
+    }
+    __m128i acc = _mm_add_epi32(_mm256_castsi256_si128(acc_256), _mm256_extracti128_si256(acc_256, 1));
+#else
+    __m128i acc = _mm_setzero_si128();
+#endif
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i va = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(a + i)));
+        const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+    }
+    uint32_t sum = (uint32_t)arm_nn_host_hsum_s32(acc);
+    for (; i < n; i++)
+    {
+        sum += (uint32_t)(a[i] * b[i]);
+    }
+    return (int32_t)sum;
+}
+
+/**
+ * @brief m[j] = sum(a[k][j][0] * b[k][j][0] + a[k][j][1] * b[k][j][1]), j < 16, k < n, a and b s16 [n][16][2]
+ *        (Winograd F(2x2, 3x3) tile, pairs of input channels)
+ */
+__STATIC_FORCEINLINE void arm_nn_host_dot_16x2_s16(int32_t *m, const int16_t *a, const int16_t *b, const int32_t n)
+{
+    __m128i acc[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+    for (int32_t k = 0; k < n; k++)
+    {
+        for (int32_t j = 0; j < 4; j++)
+        {
+            const __m128i va = _mm_loadu_si128((const __m128i *)(a + 8 * j));
+            const __m128i vb = _mm_loadu_si128((const __m128i *)(b + 8 * j));
+            acc[j] = _mm_add_epi32(acc[j], _mm_madd_epi16(va, vb));
+        }
+        a += 32;
+        b += 32;
+    }
+    for (int32_t j = 0; j < 4; j++)
+    {
+        _mm_storeu_si128((__m128i *)(m + 4 * j), acc[j]);
+    }
+}
+
+/**
+ * @brief acc + a[i] * b[i] summed by pairs, i < n, a s8, b s16, n multiple of 8 (arm_nn_host_hsum_s32() of the result
+ *        for the dot product)
+ */
+__STATIC_FORCEINLINE __m128i arm_nn_host_mla_s8_s16(__m128i acc, const int8_t *a, const int16_t *b, const int32_t n)
+{
+    for (int32_t i = 0; i < n; i += 8)
+    {
+        const __m128i va = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(a + i)));
+        const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+    }
+    return acc;
+}
+
+/**
+ * @brief sum((a[i] + a_offset) * b[i]), i < n, a and b s8, a_offset in [-128, 128]
+ */
+__STATIC_FORCEINLINE int32_t arm_nn_host_dot_s8_s8(const int8_t *a,
+                                                   const int8_t *b,
+                                                   const int32_t n,
+                                                   const int32_t a_offset)
+{
+    int32_t i = 0;
+#if defined(__AVX2__)
+    const __m256i offset_256 = _mm256_set1_epi16((int16_t)a_offset);
+    __m256i acc_256 = _mm256_setzero_si256();
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i va =
+            _mm256_add_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(a + i))), offset_256);
+        const __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(b + i)));
+        acc_256 = _mm256_add_epi32(acc_256, _mm256_madd_epi16(va, vb));
+    }
+    __m128i acc = _mm_add_epi32(_mm256_castsi256_si128(acc_256), _mm256_extracti128_si256(acc_256, 1));
+#else
+    __m128i acc = _mm_setzero_si128();
+#endif
+    const __m128i offset = _mm_set1_epi16((int16_t)a_offset);
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i va = _mm_add_epi16(_mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(a + i))), offset);
+        const __m128i vb = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(b + i)));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+    }
+    uint32_t sum = (uint32_t)arm_nn_host_hsum_s32(acc);
+    for (; i < n; i++)
+    {
+        sum += (uint32_t)((a[i] + a_offset) * b[i]);
+    }
+    return (int32_t)sum;
+}
+
+/**
+ * @brief sum(a[i] * b[i]), i < n, a s4 packed two per byte (low nibble first), b s16, n multiple of 16
+ */
+__STATIC_FORCEINLINE int32_t arm_nn_host_dot_s4_s16(const int8_t *a, const int16_t *b, const int32_t n)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i sign = _mm_set1_epi8(0x08);
+    int32_t i = 0;
+#if defined(__AVX2__)
+    __m256i acc_256 = _mm256_setzero_si256();
+    for (; i + 32 <= n; i += 32)
+    {
+        /* ((nibble ^ 8) - 8) sign extends the nibbles, unpack restores the order of the values */
+        const __m128i packed = _mm_loadu_si128((const __m128i *)(a + i / 2));
+        const __m128i low = _mm_sub_epi8(_mm_xor_si128(_mm_and_si128(packed, mask), sign), sign);
+        const __m128i high =
+            _mm_sub_epi8(_mm_xor_si128(_mm_and_si128(_mm_srli_epi16(packed, 4), mask), sign), sign);
+        const __m256i va_0 = _mm256_cvtepi8_epi16(_mm_unpacklo_epi8(low, high));
+        const __m256i va_1 = _mm256_cvtepi8_epi16(_mm_unpackhi_epi8(low, high));
+        acc_256 = _mm256_add_epi32(acc_256, _mm256_madd_epi16(va_0, _mm256_loadu_si256((const __m256i *)(b + i))));
+        acc_256 =
+            _mm256_add_epi32(acc_256, _mm256_madd_epi16(va_1, _mm256_loadu_si256((const __m256i *)(b + i + 16))));
+    }
+    __m128i acc = _mm_add_epi32(_mm256_castsi256_si128(acc_256), _mm256_extracti128_si256(acc_256, 1));
+#else
+    __m128i acc = _mm_setzero_si128();
+#endif
+    for (; i < n; i += 16)
+    {
+        const __m128i packed = _mm_loadl_epi64((const __m128i *)(a + i / 2));
+        const __m128i low = _mm_sub_epi8(_mm_xor_si128(_mm_and_si128(packed, mask), sign), sign);
+        const __m128i high = _mm_sub_epi8(_mm_xor_si128(_mm_and_si128(_mm_srli_epi16(packed, 4), mask), sign), sign);
+        const __m128i va = _mm_unpacklo_epi8(low, high);
+        const __m128i vb_0 = _mm_loadu_si128((const __m128i *)(b + i));
+        const __m128i vb_1 = _mm_loadu_si128((const __m128i *)(b + i + 8));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_cvtepi8_epi16(va), vb_0));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_cvtepi8_epi16(_mm_srli_si128(va, 8)), vb_1));
+    }
+    return arm_nn_host_hsum_s32(acc);
+}
+
+/**
+ * @brief acc[j] + (a[j] + a_offset) * b[j], j < 4, a and b s8 (4 channels of a depthwise conv)
+ */
+__STATIC_FORCEINLINE __m128i arm_nn_host_mla_s8x4(__m128i acc, const int8_t *a, const int8_t *b, const __m128i a_offset)
+{
+    int32_t a_s8x4;
+    int32_t b_s8x4;
+    memcpy(&a_s8x4, a, 4);
+    memcpy(&b_s8x4, b, 4);
+    const __m128i va = _mm_add_epi32(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(a_s8x4)), a_offset);
+    const __m128i vb = _mm_cvtepi8_epi32(_mm_cvtsi32_si128(b_s8x4));
+    return _mm_add_epi32(acc, _mm_mullo_epi32(va, vb));
+}
+
+#endif /* ARM_NN_HOST_SIMD_H */
@@ -141,6 +141,18 @@ typedef struct
     cmsis_nn_activation activation;
 } cmsis_nn_fc_params;
 
+/** CMSIS-NN object for a block sparse (BSR) s8 matrix, only the non-zero blocks are stored */
+typedef struct
+{
+    int32_t rows;                  /**< Output depth */
+    int32_t cols;                  /**< Accumulation depth */
+    int32_t block_rows;            /**< Rows of a block */
+    int32_t block_cols;            /**< Columns of a block */
+    const uint16_t *block_row_ptr; /**< First block of each block row, ceil(rows / block_rows) + 1 entries */
+    const uint16_t *block_col;     /**< Block column of each block */
+    const int8_t *values;          /**< block_rows x block_cols values (row-major) per block, zero padded */
+} cmsis_nn_bsr_s8;
+
 /** CMSIS-NN object for SVDF layer parameters */
 typedef struct
 {
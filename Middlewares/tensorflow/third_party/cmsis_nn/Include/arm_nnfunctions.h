@@ -355,6 +355,283 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
  */
 int32_t arm_convolve_s8_get_buffer_size(const cmsis_nn_dims *input_dims, const cmsis_nn_dims *filter_dims);
 
+/**
+ * @brief s8 convolution function with the filter in the reordered layout
+ * @param[in, out] ctx            Function context, same as arm_convolve_s8(). arm_convolve_s8_get_buffer_size will
+ *                                return the buffer_size if required.
+ * @param[in]      conv_params    Convolution parameters (e.g. strides, dilations, pads,...).
+ *                                Range of conv_params->input_offset  : [-127, 128]
+ *                                Range of conv_params->output_offset : [-128, 127]
+ * @param[in]      quant_params   Per-channel quantization info.
+ *                                It contains the multiplier and shift values to be applied to each output channel
+ * @param[in]      input_dims     Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+ * @param[in]      input_data     Input (activation) data pointer. Data type: int8
+ * @param[in]      filter_dims    Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN] where HK and WK are the
+ *                                spatial filter dimensions
+ * @param[in]      filter_data    Filter data pointer, reordered by arm_convolve_s8_reorder_filter(). Data type: int8
+ * @param[in]      bias_dims      Bias tensor dimensions. Format: [C_OUT]
+ * @param[in]      bias_data      Optional bias data pointer. Data type: int32
+ * @param[in]      output_dims    Output tensor dimensions. Format: [N, H, W, C_OUT]
+ * @param[out]     output_data    Output data pointer. Data type: int8
+ *
+ * @return     The function returns <code>ARM_CMSIS_NN_SUCCESS</code> or
+ *             <code>ARM_CMSIS_NN_NO_IMPL_ERROR</code> for MVE targets (no reordered layout)
+ *
+ * @details
+ *    1. Supported framework: TensorFlow Lite micro
+ *    2. Same output as arm_convolve_s8() with the original filter. The weights are read with
+ *       read_and_pad_reordered(): the two PKHBT/PKHTB of read_and_pad() per 4 weights are done once by
+ *       arm_convolve_s8_reorder_filter() instead of at each call.
+ *
+ */
+arm_cmsis_nn_status arm_convolve_s8_reordered(const cmsis_nn_context *ctx,
+                                              const cmsis_nn_conv_params *conv_params,
+                                              const cmsis_nn_per_channel_quant_params *quant_params,
+                                              const cmsis_nn_dims *input_dims,
+                                              const int8_t *input_data,
+                                              const cmsis_nn_dims *filter_dims,
+                                              const int8_t *filter_data,
+                                              const cmsis_nn_dims *bias_dims,
+                                              const int32_t *bias_data,
+                                              const cmsis_nn_dims *output_dims,
+                                              int8_t *output_data);
+
+/**
+ * @brief Get the size of the reordered filter of arm_convolve_s8_reordered()
+ *
+ * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN] where HK and WK
+ * are the spatial filter dimensions
+ * @return          Size of the filter (bytes) if arm_convolve_wrapper_s8() uses arm_convolve_s8() for this filter
+ *                  whatever the input (HK > 1) on a target with the DSP extension and without MVE, 0 otherwise
+ *                  (the reordered layout brings nothing, the filter is used as is)
+ *
+ */
+int32_t arm_convolve_s8_get_reordered_filter_size(const cmsis_nn_dims *filter_dims);
+
+/**
+ * @brief Reorder a s8 filter for arm_convolve_s8_reordered()
+ *
+ * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+ * @param[in]       src                   Filter data pointer. Data type: int8
+ * @param[out]      dst                   Reordered filter, arm_convolve_s8_get_reordered_filter_size() bytes.
+ *
+ * @details   In each row of HK * WK * C_IN weights (one output channel), the weights 1 and 2 of each group of 4
+ *            are swapped, the weights after the last complete group are copied as is.
+ *
+ */
+void arm_convolve_s8_reorder_filter(const cmsis_nn_dims *filter_dims, const int8_t *src, int8_t *dst);
+
+/**
+ * @brief s8 3x3 stride 1 convolution in the Winograd F(2x2, 3x3) domain
+ * @param[in, out] ctx                Function context that contains the additional buffer, required.
+ *                                    arm_convolve_winograd_3x3_s8_get_buffer_size will return the buffer_size.
+ * @param[in]      conv_params        Convolution parameters (e.g. strides, dilations, pads,...).
+ *                                    Range of conv_params->input_offset  : [-127, 128]
+ *                                    Range of conv_params->output_offset : [-128, 127]
+ *                                    stride and dilation 1
+ * @param[in]      quant_params       Per-channel quantization info.
+ *                                    It contains the multiplier and shift values to be applied to each output channel
+ * @param[in]      input_dims         Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+ * @param[in]      input_data         Input (activation) data pointer. Data type: int8
+ * @param[in]      filter_dims        Filter tensor dimensions. Format: [C_OUT, 3, 3, C_IN]
+ * @param[in]      transformed_filter Filter transformed by arm_convolve_winograd_3x3_s8_transform_filter().
+ *                                    Data type: int16
+ * @param[in]      bias_dims          Bias tensor dimensions. Format: [C_OUT]
+ * @param[in]      bias_data          Optional bias data pointer. Data type: int32
+ * @param[in]      output_dims        Output tensor dimensions. Format: [N, H, W, C_OUT]
+ * @param[out]     output_data        Output data pointer. Data type: int8
+ *
+ * @return     The function returns <code>ARM_CMSIS_NN_SUCCESS</code> or
+ *             <code>ARM_CMSIS_NN_ARG_ERROR</code> if the buffer is missing or
+ *             arm_convolve_winograd_3x3_s8_get_filter_size() is 0 for these parameters
+ *
+ * @details
+ *    1. Supported framework: TensorFlow Lite micro
+ *    2. Same output as arm_convolve_s8(). Each 2x2 output tile takes 16 multiplications per input channel instead
+ *       of 36. The transformed filter is kept in 16 bits and the sums in 32 bits (C_IN limited), so the result is
+ *       exact: the filter is never re-quantized in the Winograd domain.
+ *
+ */
+arm_cmsis_nn_status arm_convolve_winograd_3x3_s8(const cmsis_nn_context *ctx,
+                                                 const cmsis_nn_conv_params *conv_params,
+                                                 const cmsis_nn_per_channel_quant_params *quant_params,
+                                                 const cmsis_nn_dims *input_dims,
+                                                 const int8_t *input_data,
+                                                 const cmsis_nn_dims *filter_dims,
+                                                 const int16_t *transformed_filter,
+                                                 const cmsis_nn_dims *bias_dims,
+                                                 const int32_t *bias_data,
+                                                 const cmsis_nn_dims *output_dims,
+                                                 int8_t *output_data);
+
+/**
+ * @brief Get the size of the transformed filter of arm_convolve_winograd_3x3_s8()
+ *
+ * @param[in]       conv_params           Convolution parameters (e.g. strides, dilations, pads,...).
+ * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+ * @return          Size of the filter (bytes, 16 int16 values per output and input channel, C_IN rounded up to
+ *                  even) for a 3x3 filter with
+ *                  stride and dilation 1 and a number of input channels for which the Winograd domain is exact and
+ *                  faster than arm_convolve_s8(), 0 otherwise (arm_convolve_wrapper_s8() is to be used)
+ *
+ */
+int32_t arm_convolve_winograd_3x3_s8_get_filter_size(const cmsis_nn_conv_params *conv_params,
+                                                     const cmsis_nn_dims *filter_dims);
+
+/**
+ * @brief Get the required buffer size for arm_convolve_winograd_3x3_s8()
+ *
+ * @param[in]       input_dims            Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+ * @return          The function returns required buffer size (bytes)
+ *
+ */
+int32_t arm_convolve_winograd_3x3_s8_get_buffer_size(const cmsis_nn_dims *input_dims);
+
+/**
+ * @brief Transform a s8 3x3 filter for arm_convolve_winograd_3x3_s8()
+ *
+ * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, 3, 3, C_IN]
+ * @param[in]       src                   Filter data pointer. Data type: int8
+ * @param[out]      dst                   Transformed filter, arm_convolve_winograd_3x3_s8_get_filter_size() bytes.
+ *
+ * @details   U = (2G) g (2G)^T for each output and input channel, in the order [C_OUT, C_IN / 2, 4 x 4, 2]: the
+ *            values of two consecutive input channels are interleaved (the last one is 0 for an odd C_IN).
+ *
+ */
+void arm_convolve_winograd_3x3_s8_transform_filter(const cmsis_nn_dims *filter_dims, const int8_t *src, int16_t *dst);
+
+/**
+ * @brief s8 direct convolution for 1 to 4 input channels, without im2col
+ * @param[in, out] ctx                Function context that contains the additional buffer, required.
+ *                                    arm_convolve_direct_s8_get_buffer_size will return the buffer_size.
+ * @param[in]      conv_params        Convolution parameters (e.g. strides, dilations, pads,...).
+ *                                    Range of conv_params->input_offset  : [-127, 128]
+ *                                    Range of conv_params->output_offset : [-128, 127]
+ *                                    dilation 1
+ * @param[in]      quant_params       Per-channel quantization info.
+ *                                    It contains the multiplier and shift values to be applied to each output channel
+ * @param[in]      input_dims         Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+ * @param[in]      input_data         Input (activation) data pointer. Data type: int8
+ * @param[in]      filter_dims        Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+ * @param[in]      transformed_filter Filter transformed by arm_convolve_direct_s8_transform_filter().
+ *                                    Data type: int16
+ * @param[in]      bias_dims          Bias tensor dimensions. Format: [C_OUT]
+ * @param[in]      bias_data          Optional bias data pointer. Data type: int32
+ * @param[in]      output_dims        Output tensor dimensions. Format: [N, H, W, C_OUT]
+ * @param[out]     output_data        Output data pointer. Data type: int8
+ *
+ * @return     The function returns <code>ARM_CMSIS_NN_SUCCESS</code> or
+ *             <code>ARM_CMSIS_NN_ARG_ERROR</code> if the buffer is missing or
+ *             arm_convolve_direct_s8_get_filter_size() is 0 for these parameters
+ *
+ * @details
+ *    1. Supported framework: TensorFlow Lite micro
+ *    2. Same output as arm_convolve_s8(). The HK input rows of an output row are expanded once into a row strip
+ *       (buffer), the receptive fields are windows sliding along it: no im2col copy of the overlapping patches.
+ *
+ */
+arm_cmsis_nn_status arm_convolve_direct_s8(const cmsis_nn_context *ctx,
+                                           const cmsis_nn_conv_params *conv_params,
+                                           const cmsis_nn_per_channel_quant_params *quant_params,
+                                           const cmsis_nn_dims *input_dims,
+                                           const int8_t *input_data,
+                                           const cmsis_nn_dims *filter_dims,
+                                           const int16_t *transformed_filter,
+                                           const cmsis_nn_dims *bias_dims,
+                                           const int32_t *bias_data,
+                                           const cmsis_nn_dims *output_dims,
+                                           int8_t *output_data);
+
+/**
+ * @brief Get the size of the transformed filter of arm_convolve_direct_s8()
+ *
+ * @param[in]       conv_params           Convolution parameters (e.g. strides, dilations, pads,...).
+ * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+ * @return          Size of the filter (bytes, int16 values) for 1 to 4 input channels, a filter height above 1 and
+ *                  dilation 1, 0 otherwise (arm_convolve_wrapper_s8() is to be used)
+ *
+ */
+int32_t arm_convolve_direct_s8_get_filter_size(const cmsis_nn_conv_params *conv_params,
+                                               const cmsis_nn_dims *filter_dims);
+
+/**
+ * @brief Get the required buffer size for arm_convolve_direct_s8()
+ *
+ * @param[in]       conv_params           Convolution parameters (e.g. strides, dilations, pads,...).
+ * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+ * @param[in]       output_dims           Output tensor dimensions. Format: [N, H, W, C_OUT]
+ * @return          The function returns required buffer size (bytes), one row strip
+ *
+ */
+int32_t arm_convolve_direct_s8_get_buffer_size(const cmsis_nn_conv_params *conv_params,
+                                               const cmsis_nn_dims *filter_dims,
+                                               const cmsis_nn_dims *output_dims);
+
+/**
+ * @brief Transform a s8 filter for arm_convolve_direct_s8()
+ *
+ * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+ * @param[in]       src                   Filter data pointer. Data type: int8
+ * @param[out]      dst                   Transformed filter, arm_convolve_direct_s8_get_filter_size() bytes.
+ *
+ * @details   Values widened to int16, in the order [C_OUT, WK, HK, C_IN] of the row strip windows.
+ *
+ */
+void arm_convolve_direct_s8_transform_filter(const cmsis_nn_dims *filter_dims, const int8_t *src, int16_t *dst);
+
+/**
+ * @brief s8 convolution function with packed s4 weights
+ * @param[in, out] ctx                Function context that contains the additional buffer, required.
+ *                                    arm_convolve_s4_get_buffer_size will return the buffer_size.
+ *                                    The caller is expected to clear the buffer ,if applicable, for security reasons.
+ * @param[in]      conv_params        Convolution parameters (e.g. strides, dilations, pads,...).
+ *                                    Range of conv_params->input_offset  : [-127, 128]
+ *                                    Range of conv_params->output_offset : [-128, 127]
+ * @param[in]      quant_params       Per-channel quantization info.
+ *                                    It contains the multiplier and shift values to be applied to each output channel
+ * @param[in]      input_dims         Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+ * @param[in]      input_data         Input (activation) data pointer. Data type: int8
+ * @param[in]      filter_dims        Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN] where HK and WK are the
+ *                                    spatial filter dimensions. HK * WK * C_IN <= 65535
+ * @param[in]      packed_filter_data Filter data pointer, int4 values packed two per byte, the low nibble first, in
+ *                                    the order of the values of an int8 filter (TensorFlow Lite INT4 tensor)
+ * @param[in]      bias_dims          Bias tensor dimensions. Format: [C_OUT]
+ * @param[in]      bias_data          Optional bias data pointer. Data type: int32
+ * @param[in]      output_dims        Output tensor dimensions. Format: [N, H, W, C_OUT]
+ * @param[out]     output_data        Output data pointer. Data type: int8
+ *
+ * @return     The function returns <code>ARM_CMSIS_NN_SUCCESS</code> or
+ *             <code>ARM_CMSIS_NN_ARG_ERROR</code> if the buffer is missing or the filter too large
+ *
+ * @details
+ *    1. Supported framework: TensorFlow Lite micro
+ *    2. Same output as arm_convolve_s8() with the unpacked filter. The filter is read from its packed form (half
+ *       the bytes of the int8 filter), the nibbles are expanded in registers.
+ *
+ */
+arm_cmsis_nn_status arm_convolve_s4(const cmsis_nn_context *ctx,
+                                    const cmsis_nn_conv_params *conv_params,
+                                    const cmsis_nn_per_channel_quant_params *quant_params,
+                                    const cmsis_nn_dims *input_dims,
+                                    const int8_t *input_data,
+                                    const cmsis_nn_dims *filter_dims,
+                                    const int8_t *packed_filter_data,
+                                    const cmsis_nn_dims *bias_dims,
+                                    const int32_t *bias_data,
+                                    const cmsis_nn_dims *output_dims,
+                                    int8_t *output_data);
+
+/**
+ * @brief Get the required buffer size for s8 convolution function with packed s4 weights
+ *
+ * @param[in]       input_dims            Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+ * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN] where HK and WK
+ * are the spatial filter dimensions
+ * @return          The function returns required buffer size(bytes)
+ *
+ */
+int32_t arm_convolve_s4_get_buffer_size(const cmsis_nn_dims *input_dims, const cmsis_nn_dims *filter_dims);
+
 /**
  * @brief Basic s16 convolution function
  * @param[in, out] ctx            Function context that contains the additional buffer if required by the function.
@@ -1077,6 +1354,113 @@ int32_t arm_fully_connected_s8_get_buffer_size_dsp(const cmsis_nn_dims *filter_d
  */
 int32_t arm_fully_connected_s8_get_buffer_size_mve(const cmsis_nn_dims *filter_dims);
 
+/**
+ * @brief s8 Fully Connected function with packed s4 weights.
+ *
+ * @param[in, out] ctx           Function context that contains the additional buffer, required.
+ *                               arm_fully_connected_s4_get_buffer_size() provides the buffer size.
+ *                               The caller is expected to clear the buffer ,if applicable, for security reasons.
+ * @param[in]      fc_params     Fully Connected layer parameters.
+ *                               Range of fc_params->input_offset  : [-127, 128]
+ *                               fc_params->filter_offset : 0
+ *                               Range of fc_params->output_offset : [-128, 127]
+ * @param[in]      quant_params  Per-tensor quantization info.
+ *                               It contains the multiplier and shift values to be applied to the output tensor.
+ * @param[in]      input_dims    Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+ *                               Input dimension is taken as Nx(H * W * C_IN)
+ * @param[in]      input_data    Input (activation) data pointer. Data type: int8
+ * @param[in]      filter_dims   Two dimensional filter dimensions. Format: [N, C]
+ *                               N : accumulation depth and equals (H * W * C_IN) from input_dims, <= 65535
+ *                               C : output depth and equals C_OUT in output_dims
+ *                               H & W : Not used
+ * @param[in]      filter_data   Filter data pointer, int4 values packed two per byte, the low nibble first
+ *                               (TensorFlow Lite INT4 tensor)
+ * @param[in]      bias_dims     Bias tensor dimensions. Format: [C_OUT]
+ *                               N, H, W : Not used
+ * @param[in]      bias_data     Bias data pointer. Data type: int32
+ * @param[in]      output_dims   Output tensor dimensions. Format: [N, C_OUT]
+ *                               N : Batches
+ *                               C_OUT : Output depth
+ *                               H & W : Not used.
+ * @param[in, out] output_data    Output data pointer. Data type: int8
+ * @return     The function returns <code>ARM_CMSIS_NN_SUCCESS</code> or
+ *             <code>ARM_CMSIS_NN_ARG_ERROR</code> if the buffer is missing or the accumulation depth too large
+ *
+ * @details
+ *    - Supported framework: TensorFlow Lite
+ *    - Same output as arm_fully_connected_s8() with the unpacked filter. The filter is read from its packed form
+ *      (half the bytes of the int8 filter), the nibbles are expanded in registers.
+ */
+arm_cmsis_nn_status arm_fully_connected_s4(const cmsis_nn_context *ctx,
+                                           const cmsis_nn_fc_params *fc_params,
+                                           const cmsis_nn_per_tensor_quant_params *quant_params,
+                                           const cmsis_nn_dims *input_dims,
+                                           const int8_t *input_data,
+                                           const cmsis_nn_dims *filter_dims,
+                                           const int8_t *filter_data,
+                                           const cmsis_nn_dims *bias_dims,
+                                           const int32_t *bias_data,
+                                           const cmsis_nn_dims *output_dims,
+                                           int8_t *output_data);
+
+/**
+ * @brief Get size of additional buffer required by arm_fully_connected_s4(): the input as s16 values.
+ * @param[in]      filter_dims             dimension of filter
+ * @return         The function returns    required buffer size in bytes
+ *
+ */
+int32_t arm_fully_connected_s4_get_buffer_size(const cmsis_nn_dims *filter_dims);
+
+/**
+ * @brief s8 Fully Connected function with a block sparse filter.
+ *
+ * @param[in, out] ctx           Function context that contains the additional buffer, required.
+ *                               arm_fully_connected_block_sparse_s8_get_buffer_size() provides the buffer size.
+ *                               The caller is expected to clear the buffer ,if applicable, for security reasons.
+ * @param[in]      fc_params     Fully Connected layer parameters.
+ *                               Range of fc_params->input_offset  : [-127, 128]
+ *                               fc_params->filter_offset : 0
+ *                               Range of fc_params->output_offset : [-128, 127]
+ * @param[in]      quant_params  Per-tensor quantization info.
+ *                               It contains the multiplier and shift values to be applied to the output tensor.
+ * @param[in]      input_dims    Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+ *                               Input dimension is taken as Nx(H * W * C_IN), H * W * C_IN equals filter->cols
+ * @param[in]      input_data    Input (activation) data pointer. Data type: int8
+ * @param[in]      filter        Filter in block sparse row format (rows: output depth, cols: accumulation depth).
+ *                               The blocks of a block row are in increasing column order.
+ * @param[in]      bias_data     Bias data pointer, filter->rows values. Data type: int32. NULL if no bias.
+ * @param[in]      output_dims   Output tensor dimensions. Format: [N, C_OUT]
+ *                               N : Batches
+ *                               C_OUT : Output depth, equals filter->rows
+ *                               H & W : Not used.
+ * @param[in, out] output_data    Output data pointer. Data type: int8
+ * @return     The function returns <code>ARM_CMSIS_NN_SUCCESS</code> or
+ *             <code>ARM_CMSIS_NN_ARG_ERROR</code> if the buffer is missing
+ *
+ * @details
+ *    - Supported framework: TensorFlow Lite (BLOCK_SPARSE_FULLY_CONNECTED custom operator)
+ *    - Same output as arm_fully_connected_s8() with the dense filter: the missing blocks are zero and skipped, the
+ *      MACs are proportional to the number of stored blocks.
+ */
+arm_cmsis_nn_status arm_fully_connected_block_sparse_s8(const cmsis_nn_context *ctx,
+                                                        const cmsis_nn_fc_params *fc_params,
+                                                        const cmsis_nn_per_tensor_quant_params *quant_params,
+                                                        const cmsis_nn_dims *input_dims,
+                                                        const int8_t *input_data,
+                                                        const cmsis_nn_bsr_s8 *filter,
+                                                        const int32_t *bias_data,
+                                                        const cmsis_nn_dims *output_dims,
+                                                        int8_t *output_data);
+
+/**
+ * @brief Get size of additional buffer required by arm_fully_connected_block_sparse_s8(): the input as s16 values,
+ *        padded to a whole number of blocks.
+ * @param[in]      filter                  block sparse filter
+ * @return         The function returns    required buffer size in bytes
+ *
+ */
+int32_t arm_fully_connected_block_sparse_s8_get_buffer_size(const cmsis_nn_bsr_s8 *filter);
+
 /**
  * @brief Basic s16 Fully Connected function.
  *
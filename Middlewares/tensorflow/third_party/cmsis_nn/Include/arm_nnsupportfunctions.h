@@ -36,6 +36,10 @@
 
 #include <stdbool.h>
 
+#if defined(CMSIS_NN_HOST_SIMD)
+    #include "Internal/arm_nn_host_simd.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -380,6 +384,38 @@ arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s8(const int8_t *lhs,
                                              const int32_t activation_max,
                                              const int32_t address_offset);
 
+/**
+ * @brief s16 Vector by packed s4 Matrix (transposed) multiplication
+ *
+ * @param[in]      lhs             Input left-hand side vector, s8 input with its offset added (see
+ *                                 arm_q7_to_q15_with_offset())
+ * @param[in]      rhs             Input right-hand side matrix (transposed), s4 values packed two per byte (low
+ *                                 nibble first, the rows are not padded to a byte)
+ * @param[in]      bias            Input bias
+ * @param[out]     dst             Output vector
+ * @param[in]      dst_offset      Offset to be added to the output values. Range: -127 to 128
+ * @param[in]      dst_multiplier  Output multiplier
+ * @param[in]      dst_shift       Output shift
+ * @param[in]      rhs_cols        Number of columns in the right-hand side input matrix. Range: [1, 65535]
+ * @param[in]      rhs_rows        Number of rows in the right-hand side input matrix
+ * @param[in]      activation_min  Minimum value to clamp the output to. Range: int8
+ * @param[in]      activation_max  Maximum value to clamp the output to. Range: int8
+ *
+ * @return         The function returns <code>ARM_CMSIS_NN_SUCCESS</code>
+ *
+ */
+arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s4(const int16_t *lhs,
+                                             const int8_t *rhs,
+                                             const int32_t *bias,
+                                             int8_t *dst,
+                                             const int32_t dst_offset,
+                                             const int32_t dst_multiplier,
+                                             const int32_t dst_shift,
+                                             const int32_t rhs_cols,
+                                             const int32_t rhs_rows,
+                                             const int32_t activation_min,
+                                             const int32_t activation_max);
+
 /**
  * @brief s16 Vector by Matrix (transposed) multiplication
  *
@@ -694,7 +730,144 @@ __STATIC_FORCEINLINE const int8_t *read_and_pad_reordered(const int8_t *source,
     return source;
 }
 
+    #ifndef ARM_MATH_BIG_ENDIAN
+/**
+ * @brief read one word of 8 packed s4 values and expand it into four s16 words, each value scaled by 16
+ *
+ * @details   Value 2 * i is the low nibble of byte i, value 2 * i + 1 its high nibble. The nibbles are moved to the
+ *            top of their byte by masks, so SXTB16 gives them sign extended and scaled by 16: out1 holds values 0
+ *            and 1, out2 values 2 and 3, out3 values 4 and 5, out4 values 6 and 7.
+ */
+
+__STATIC_FORCEINLINE const int8_t *
+read_and_pad_s4(const int8_t *source, int32_t *out1, int32_t *out2, int32_t *out3, int32_t *out4)
+{
+    const uint32_t inA = (uint32_t)arm_nn_read_s8x4_ia(&source);
+    const uint32_t low = (inA << 4) & 0xF0F0F0F0U;
+    const uint32_t high = inA & 0xF0F0F0F0U;
+    const int32_t low_02 = SXTB16(low);
+    const int32_t high_02 = SXTB16(high);
+    const int32_t low_13 = SXTB16_RORn(low, 8);
+    const int32_t high_13 = SXTB16_RORn(high, 8);
+
+    *out1 = (int32_t)(PKHBT(low_02, high_02, 16));
+    *out2 = (int32_t)(PKHBT(low_13, high_13, 16));
+    *out3 = (int32_t)(PKHTB(high_02, low_02, 16));
+    *out4 = (int32_t)(PKHTB(high_13, low_13, 16));
+
+    return source;
+}
+    #endif
+
+#endif
+
+/**
+ * @brief Dot products of one row of packed s4 values with one or two s16 vectors
+ *
+ * @param[in]       row         Packed s4 values, two per byte, the low nibble first
+ * @param[in]       high_first  The first value of the row is the high nibble of row[0] (rows of an odd length)
+ * @param[in]       vec_0       First s16 vector of len values
+ * @param[in]       vec_1       Second s16 vector of len values, NULL for one vector only
+ * @param[in]       len         Number of values of the row. Range: [0, 65535]
+ * @param[in, out]  sum_0       Accumulator of the dot product with vec_0
+ * @param[in, out]  sum_1       Accumulator of the dot product with vec_1, not used if vec_1 is NULL
+ *
+ * @details   The nibbles are unpacked in registers (read_and_pad_s4() with the DSP extension), the weights are
+ *            never stored as s8. The DSP path accumulates the values scaled by 16, which fits in 32 bits for
+ *            s16 values of an offset s8 input (|value| <= 255) and len <= 65535, so the sums are exact.
+ */
+__STATIC_FORCEINLINE void arm_nn_dot_s4_s16(const int8_t *row,
+                                            const int32_t high_first,
+                                            const int16_t *vec_0,
+                                            const int16_t *vec_1,
+                                            const int32_t len,
+                                            int32_t *sum_0,
+                                            int32_t *sum_1)
+{
+    int32_t i = 0;
+    int32_t acc_0 = *sum_0;
+    int32_t acc_1 = vec_1 ? *sum_1 : 0;
+
+    if (high_first && len > 0)
+    {
+        const int32_t w = *row++ >> 4;
+        acc_0 += w * vec_0[0];
+        if (vec_1)
+        {
+            acc_1 += w * vec_1[0];
+        }
+        i = 1;
+    }
+
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_BIG_ENDIAN)
+    if (len - i >= 8)
+    {
+        int32_t acc_x16_0 = 0;
+        int32_t acc_x16_1 = 0;
+        const int16_t *ip_0 = vec_0 + i;
+        const int16_t *ip_1 = vec_1 ? vec_1 + i : NULL;
+        for (; i + 8 <= len; i += 8)
+        {
+            int32_t w01, w23, w45, w67;
+            row = read_and_pad_s4(row, &w01, &w23, &w45, &w67);
+
+            acc_x16_0 = SMLAD(w01, arm_nn_read_q15x2_ia(&ip_0), acc_x16_0);
+            acc_x16_0 = SMLAD(w23, arm_nn_read_q15x2_ia(&ip_0), acc_x16_0);
+            acc_x16_0 = SMLAD(w45, arm_nn_read_q15x2_ia(&ip_0), acc_x16_0);
+            acc_x16_0 = SMLAD(w67, arm_nn_read_q15x2_ia(&ip_0), acc_x16_0);
+            if (ip_1)
+            {
+                acc_x16_1 = SMLAD(w01, arm_nn_read_q15x2_ia(&ip_1), acc_x16_1);
+                acc_x16_1 = SMLAD(w23, arm_nn_read_q15x2_ia(&ip_1), acc_x16_1);
+                acc_x16_1 = SMLAD(w45, arm_nn_read_q15x2_ia(&ip_1), acc_x16_1);
+                acc_x16_1 = SMLAD(w67, arm_nn_read_q15x2_ia(&ip_1), acc_x16_1);
+            }
+        }
+        acc_0 += acc_x16_0 >> 4;
+        acc_1 += acc_x16_1 >> 4;
+    }
+#elif defined(CMSIS_NN_HOST_SIMD)
+    {
+        const int32_t n = (len - i) & ~15;
+        if (n > 0)
+        {
+            acc_0 += arm_nn_host_dot_s4_s16(row, vec_0 + i, n);
+            if (vec_1)
+            {
+                acc_1 += arm_nn_host_dot_s4_s16(row, vec_1 + i, n);
+            }
+            row += n / 2;
+            i += n;
+        }
+    }
 #endif
+    for (; i + 2 <= len; i += 2)
+    {
+        const int8_t packed = *row++;
+        const int32_t w_0 = (int8_t)((uint8_t)packed << 4) >> 4;
+        const int32_t w_1 = packed >> 4;
+        acc_0 += w_0 * vec_0[i] + w_1 * vec_0[i + 1];
+        if (vec_1)
+        {
+            acc_1 += w_0 * vec_1[i] + w_1 * vec_1[i + 1];
+        }
+    }
+    if (i < len)
+    {
+        const int32_t w = (int8_t)((uint8_t)*row << 4) >> 4;
+        acc_0 += w * vec_0[i];
+        if (vec_1)
+        {
+            acc_1 += w * vec_1[i];
+        }
+    }
+
+    *sum_0 = acc_0;
+    if (vec_1)
+    {
+        *sum_1 = acc_1;
+    }
+}
 
 /**
  * @brief Matrix-multiplication function for convolution with per-channel requantization.
@@ -730,6 +903,70 @@ int8_t *arm_nn_mat_mult_kernel_s8_s16(const int8_t *input_a,
                                       const int32_t *const output_bias,
                                       int8_t *out_0);
 
+/**
+ * @brief Matrix-multiplication function for convolution with per-channel requantization and reordered weights.
+ * @param[in]       input_a     pointer to operand A, rows reordered by arm_convolve_s8_reorder_filter()
+ * @param[in]       input_b     pointer to operand B, always consists of 2 vectors.
+ * @param[in]       output_ch   number of rows of A
+ * @param[in]       out_shift  pointer to per output channel requantization shift parameter.
+ * @param[in]       out_mult   pointer to per output channel requantization multiplier parameter.
+ * @param[in]       out_offset      output tensor offset.
+ * @param[in]       activation_min   minimum value to clamp the output to. Range : int8
+ * @param[in]       activation_max   maximum value to clamp the output to. Range : int8
+ * @param[in]       num_col_a   number of columns of A
+ * @param[in]       output_bias per output channel bias. Range : int32
+ * @param[in,out]   out_0       pointer to output
+ * @return     The function returns one of the two
+ *              1. The incremented output pointer for a successful operation or
+ *              2. NULL if implementation is not available.
+ *
+ * @details   Same as arm_nn_mat_mult_kernel_s8_s16(), the weights are expanded with read_and_pad_reordered().
+ */
+int8_t *arm_nn_mat_mult_kernel_s8_s16_reordered(const int8_t *input_a,
+                                                const int16_t *input_b,
+                                                const uint16_t output_ch,
+                                                const int32_t *out_shift,
+                                                const int32_t *out_mult,
+                                                const int32_t out_offset,
+                                                const int16_t activation_min,
+                                                const int16_t activation_max,
+                                                const uint16_t num_col_a,
+                                                const int32_t *const output_bias,
+                                                int8_t *out_0);
+
+/**
+ * @brief Matrix-multiplication function for convolution with per-channel requantization and packed s4 weights.
+ * @param[in]       input_a     pointer to operand A, output_ch rows of num_col_a s4 values packed two per byte
+ *                              (low nibble first, the rows are not padded to a byte)
+ * @param[in]       input_b     pointer to operand B, num_col_b vectors of num_col_a values
+ * @param[in]       num_col_b   number of vectors of B (columns of the im2col buffer). Range : 1 or 2
+ * @param[in]       output_ch   number of rows of A
+ * @param[in]       out_shift  pointer to per output channel requantization shift parameter.
+ * @param[in]       out_mult   pointer to per output channel requantization multiplier parameter.
+ * @param[in]       out_offset      output tensor offset.
+ * @param[in]       activation_min   minimum value to clamp the output to. Range : int8
+ * @param[in]       activation_max   maximum value to clamp the output to. Range : int8
+ * @param[in]       num_col_a   number of columns of A
+ * @param[in]       output_bias per output channel bias. Range : int32
+ * @param[in,out]   out_0       pointer to output
+ * @return     The incremented output pointer (num_col_b * output_ch values written)
+ *
+ * @details   Same outputs as arm_nn_mat_mult_kernel_s8_s16() with the unpacked weights. The weights are unpacked
+ *            in registers by arm_nn_dot_s4_s16(), once for the two vectors of B.
+ */
+int8_t *arm_nn_mat_mult_kernel_s4_s16(const int8_t *input_a,
+                                      const int16_t *input_b,
+                                      const int32_t num_col_b,
+                                      const uint16_t output_ch,
+                                      const int32_t *out_shift,
+                                      const int32_t *out_mult,
+                                      const int32_t out_offset,
+                                      const int16_t activation_min,
+                                      const int16_t activation_max,
+                                      const uint16_t num_col_a,
+                                      const int32_t *const output_bias,
+                                      int8_t *out_0);
+
 /**
  * @brief Common softmax function for s8 input and s8 or s16 output
  * @param[in]  input          Pointer to the input tensor
@@ -0,0 +1,265 @@
+/*
+ * SPDX-FileCopyrightText: Copyright 2026 The ml_model_attestation Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_convolve_direct_s8.c
+ * Description:  s8 direct convolution for 1 to 4 input channels, without im2col
+ *
+ * $Date:        19 October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target :  Arm(R) M-Profile Architecture
+ *
+ * -------------------------------------------------------------------- */
+
+#include "arm_nnfunctions.h"
+#include "arm_nnsupportfunctions.h"
+
+/**
+ *  @ingroup Public
+ */
+
+/**
+ * @addtogroup NNConv
+ * @{
+ */
+
+/* More input channels: the im2col columns are long enough for the mat mult kernels */
+#define ARM_NN_DIRECT_MAX_INPUT_CH (4)
+
+/* sum[j][k] = sum(w_j[i] * x_k[i]), i < n, j < 2 (filters), k < 2 (windows), s16 */
+static void arm_nn_direct_dot_2x2_s16(const int16_t *w_0,
+                                      const int16_t *w_1,
+                                      const int16_t *x_0,
+                                      const int16_t *x_1,
+                                      const int32_t n,
+                                      int32_t sum[2][2])
+{
+    int32_t acc_00 = 0;
+    int32_t acc_01 = 0;
+    int32_t acc_10 = 0;
+    int32_t acc_11 = 0;
+    int32_t i = 0;
+#if defined(ARM_MATH_DSP)
+    for (; i + 2 <= n; i += 2)
+    {
+        const int32_t a_0 = arm_nn_read_q15x2_ia(&x_0);
+        const int32_t a_1 = arm_nn_read_q15x2_ia(&x_1);
+        const int32_t b_0 = arm_nn_read_q15x2_ia(&w_0);
+        const int32_t b_1 = arm_nn_read_q15x2_ia(&w_1);
+        acc_00 = SMLAD(b_0, a_0, acc_00);
+        acc_01 = SMLAD(b_0, a_1, acc_01);
+        acc_10 = SMLAD(b_1, a_0, acc_10);
+        acc_11 = SMLAD(b_1, a_1, acc_11);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        const int32_t a_0 = *x_0++;
+        const int32_t a_1 = *x_1++;
+        const int32_t b_0 = *w_0++;
+        const int32_t b_1 = *w_1++;
+        acc_00 += b_0 * a_0;
+        acc_01 += b_0 * a_1;
+        acc_10 += b_1 * a_0;
+        acc_11 += b_1 * a_1;
+    }
+    sum[0][0] = acc_00;
+    sum[0][1] = acc_01;
+    sum[1][0] = acc_10;
+    sum[1][1] = acc_11;
+}
+
+/*
+ * s8 direct convolution for 1 to 4 input channels.
+ *
+ * Refer header file for details. For each output row, the kernel rows of the input (input offset applied, 0 in the
+ * padding) are written once in the buffer column by column, [W][HK][C_IN]. The receptive field of an output is then
+ * a contiguous window of that row strip, which slides by stride.w columns from one output to the next, so the
+ * filter, in the same [C_OUT][WK][HK][C_IN] order (arm_convolve_direct_s8_transform_filter()), is applied in place.
+ * Two outputs of two output channels are computed at a time: each window and filter value loaded is used twice.
+ *
+ */
+
+arm_cmsis_nn_status arm_convolve_direct_s8(const cmsis_nn_context *ctx,
+                                           const cmsis_nn_conv_params *conv_params,
+                                           const cmsis_nn_per_channel_quant_params *quant_params,
+                                           const cmsis_nn_dims *input_dims,
+                                           const int8_t *input_data,
+                                           const cmsis_nn_dims *filter_dims,
+                                           const int16_t *transformed_filter,
+                                           const cmsis_nn_dims *bias_dims,
+                                           const int32_t *bias_data,
+                                           const cmsis_nn_dims *output_dims,
+                                           int8_t *output_data)
+{
+    (void)bias_dims;
+
+    if (ctx->buf == NULL || arm_convolve_direct_s8_get_filter_size(conv_params, filter_dims) == 0)
+    {
+        return ARM_CMSIS_NN_ARG_ERROR;
+    }
+    int16_t *strip = (int16_t *)ctx->buf;
+
+    const int32_t input_batches = input_dims->n;
+    const int32_t input_x = input_dims->w;
+    const int32_t input_y = input_dims->h;
+    const int32_t input_ch = input_dims->c;
+    const int32_t kernel_x = filter_dims->w;
+    const int32_t kernel_y = filter_dims->h;
+    const int32_t output_x = output_dims->w;
+    const int32_t output_y = output_dims->h;
+    const int32_t output_ch = output_dims->c;
+    const int32_t pad_x = conv_params->padding.w;
+    const int32_t pad_y = conv_params->padding.h;
+    const int32_t stride_x = conv_params->stride.w;
+    const int32_t stride_y = conv_params->stride.h;
+    const int32_t input_offset = conv_params->input_offset;
+    const int32_t out_offset = conv_params->output_offset;
+    const int32_t out_activation_min = conv_params->activation.min;
+    const int32_t out_activation_max = conv_params->activation.max;
+    const int32_t *output_mult = quant_params->multiplier;
+    const int32_t *output_shift = quant_params->shift;
+
+    const int32_t strip_x = (output_x - 1) * stride_x + kernel_x;
+    const int32_t col_size = kernel_y * input_ch;
+    const int32_t window_size = kernel_x * col_size;
+
+    for (int32_t i_batch = 0; i_batch < input_batches; i_batch++)
+    {
+        for (int32_t i_out_y = 0; i_out_y < output_y; i_out_y++)
+        {
+            /* Row strip, [strip_x][HK][C_IN] */
+            const int32_t base_y = i_out_y * stride_y - pad_y;
+            int16_t *dst = strip;
+            for (int32_t i_col = 0; i_col < strip_x; i_col++)
+            {
+                const int32_t x = i_col - pad_x;
+                for (int32_t i_ker_y = 0; i_ker_y < kernel_y; i_ker_y++)
+                {
+                    const int32_t y = base_y + i_ker_y;
+                    if (y < 0 || y >= input_y || x < 0 || x >= input_x)
+                    {
+                        for (int32_t i_ch = 0; i_ch < input_ch; i_ch++)
+                        {
+                            *dst++ = 0;
+                        }
+                    }
+                    else
+                    {
+                        const int8_t *src = input_data + (y * input_x + x) * input_ch;
+                        for (int32_t i_ch = 0; i_ch < input_ch; i_ch++)
+                        {
+                            *dst++ = (int16_t)(src[i_ch] + input_offset);
+                        }
+                    }
+                }
+            }
+
+            int8_t *out = output_data + i_out_y * output_x * output_ch;
+            for (int32_t i_out_x = 0; i_out_x < output_x; i_out_x += 2)
+            {
+                const int16_t *window_a = strip + i_out_x * stride_x * col_size;
+                /* Odd output width: the last window is computed twice */
+                const int32_t second = i_out_x + 1 < output_x;
+                const int16_t *window_b = second ? window_a + stride_x * col_size : window_a;
+                const int16_t *w = transformed_filter;
+
+                for (int32_t i_out_ch = 0; i_out_ch < output_ch; i_out_ch += 2)
+                {
+                    /* Odd output depth: the last filter is applied twice */
+                    const int32_t ch_count = MIN(2, output_ch - i_out_ch);
+                    const int16_t *w_next = ch_count == 2 ? w + window_size : w;
+                    int32_t sum[2][2];
+                    arm_nn_direct_dot_2x2_s16(w, w_next, window_a, window_b, window_size, sum);
+                    w += 2 * window_size;
+
+                    for (int32_t i = 0; i < ch_count; i++)
+                    {
+                        const int32_t ch = i_out_ch + i;
+                        const int32_t bias = bias_data ? bias_data[ch] : 0;
+                        for (int32_t j = 0; j < 1 + second; j++)
+                        {
+                            int32_t res = arm_nn_requantize(sum[i][j] + bias, output_mult[ch], output_shift[ch]);
+                            res += out_offset;
+                            res = MAX(res, out_activation_min);
+                            res = MIN(res, out_activation_max);
+                            out[j * output_ch + ch] = (int8_t)res;
+                        }
+                    }
+                }
+                out += 2 * output_ch;
+            }
+        }
+
+        /* Advance to the next batch */
+        input_data += (input_x * input_y * input_ch);
+        output_data += (output_x * output_y * output_ch);
+    }
+
+    /* Return to application */
+    return ARM_CMSIS_NN_SUCCESS;
+}
+
+int32_t arm_convolve_direct_s8_get_filter_size(const cmsis_nn_conv_params *conv_params,
+                                               const cmsis_nn_dims *filter_dims)
+{
+    /* 1 x N filters go to arm_convolve_1x1_s8_fast(), arm_convolve_1x1_s8() or arm_convolve_1_x_n_s8() */
+    if (filter_dims->c > ARM_NN_DIRECT_MAX_INPUT_CH || filter_dims->h == 1 || conv_params->dilation.h != 1 ||
+        conv_params->dilation.w != 1)
+    {
+        return 0;
+    }
+    return filter_dims->n * filter_dims->h * filter_dims->w * filter_dims->c * (int32_t)sizeof(int16_t);
+}
+
+int32_t arm_convolve_direct_s8_get_buffer_size(const cmsis_nn_conv_params *conv_params,
+                                               const cmsis_nn_dims *filter_dims,
+                                               const cmsis_nn_dims *output_dims)
+{
+    const int32_t strip_x = (output_dims->w - 1) * conv_params->stride.w + filter_dims->w;
+    return strip_x * filter_dims->h * filter_dims->c * (int32_t)sizeof(int16_t);
+}
+
+void arm_convolve_direct_s8_transform_filter(const cmsis_nn_dims *filter_dims, const int8_t *src, int16_t *dst)
+{
+    const int32_t input_ch = filter_dims->c;
+    const int32_t kernel_x = filter_dims->w;
+    const int32_t kernel_y = filter_dims->h;
+
+    for (int32_t i_out_ch = 0; i_out_ch < filter_dims->n; i_out_ch++)
+    {
+        for (int32_t i_ker_x = 0; i_ker_x < kernel_x; i_ker_x++)
+        {
+            for (int32_t i_ker_y = 0; i_ker_y < kernel_y; i_ker_y++)
+            {
+                const int8_t *g = src + (i_ker_y * kernel_x + i_ker_x) * input_ch;
+                for (int32_t i_ch = 0; i_ch < input_ch; i_ch++)
+                {
+                    *dst++ = g[i_ch];
+                }
+            }
+        }
+        src += kernel_y * kernel_x * input_ch;
+    }
+}
+
+/**
+ * @} end of NNConv group
+ */
@@ -0,0 +1,286 @@
+/*
+ * SPDX-FileCopyrightText: Copyright 2010-2023 Arm Limited and/or its affiliates <open-source-office@arm.com>
+ * SPDX-FileCopyrightText: Copyright 2026 The ml_model_attestation Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_convolve_s8_reordered.c
+ * Description:  s8 version of convolution using symmetric quantization, filter in the reordered layout.
+ *               Derived from arm_convolve_s8.c V.3.2.0.
+ *
+ * $Date:        19 October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target :  Arm(R) M-Profile Architecture
+ *
+ * -------------------------------------------------------------------- */
+
+#include "arm_nnfunctions.h"
+#include "arm_nnsupportfunctions.h"
+
+/**
+ *  @ingroup Public
+ */
+
+/**
+ * @addtogroup NNConv
+ * @{
+ */
+
+/*
+ * s8 convolution function with the filter in the reordered layout.
+ *
+ * Refer header file for details. Same computation as the DSP path of arm_convolve_s8(), the weights are
+ * reordered once (arm_convolve_s8_reorder_filter()) for read_and_pad_reordered().
+ *
+ */
+
+arm_cmsis_nn_status arm_convolve_s8_reordered(const cmsis_nn_context *ctx,
+                                              const cmsis_nn_conv_params *conv_params,
+                                              const cmsis_nn_per_channel_quant_params *quant_params,
+                                              const cmsis_nn_dims *input_dims,
+                                              const int8_t *input_data,
+                                              const cmsis_nn_dims *filter_dims,
+                                              const int8_t *filter_data,
+                                              const cmsis_nn_dims *bias_dims,
+                                              const int32_t *bias_data,
+                                              const cmsis_nn_dims *output_dims,
+                                              int8_t *output_data)
+{
+    (void)bias_dims;
+
+#if defined(ARM_MATH_MVEI)
+    (void)ctx;
+    (void)conv_params;
+    (void)quant_params;
+    (void)input_dims;
+    (void)input_data;
+    (void)filter_dims;
+    (void)filter_data;
+    (void)bias_data;
+    (void)output_dims;
+    (void)output_data;
+    return ARM_CMSIS_NN_NO_IMPL_ERROR;
+#else
+    if (ctx->buf == NULL && arm_convolve_s8_get_buffer_size(input_dims, filter_dims) > 0)
+    {
+        return ARM_CMSIS_NN_ARG_ERROR;
+    }
+    int16_t *buffer_a = (int16_t *)ctx->buf;
+
+    const int32_t input_batches = input_dims->n;
+    const uint16_t input_x = input_dims->w;
+    const uint16_t input_y = input_dims->h;
+    const uint16_t input_ch = input_dims->c;
+    const uint16_t kernel_x = filter_dims->w;
+    const uint16_t kernel_y = filter_dims->h;
+    const uint16_t output_x = output_dims->w;
+    const uint16_t output_y = output_dims->h;
+    const uint16_t output_ch = output_dims->c;
+
+    const uint16_t pad_x = conv_params->padding.w;
+    const uint16_t pad_y = conv_params->padding.h;
+    const uint16_t stride_x = conv_params->stride.w;
+    const uint16_t stride_y = conv_params->stride.h;
+
+    const int32_t input_offset = conv_params->input_offset;
+    const int32_t out_offset = conv_params->output_offset;
+    const int32_t out_activation_min = conv_params->activation.min;
+    const int32_t out_activation_max = conv_params->activation.max;
+    int32_t *output_mult = quant_params->multiplier;
+    int32_t *output_shift = quant_params->shift;
+
+    int i_batch;
+    for (i_batch = 0; i_batch < input_batches; i_batch++)
+    {
+        const uint16_t dilation_x = conv_params->dilation.w;
+        const uint16_t dilation_y = conv_params->dilation.h;
+
+        int32_t i_out_y, i_out_x, i_ker_y, i_ker_x;
+
+        /* Generate two columns from the input tensor a GEMM computation */
+        int16_t *two_column_buf = buffer_a;
+        int8_t *out = output_data;
+
+        /* This part implements the im2col function */
+        for (i_out_y = 0; i_out_y < output_y; i_out_y++)
+        {
+            for (i_out_x = 0; i_out_x < output_x; i_out_x++)
+            {
+                const int32_t base_idx_y = stride_y * i_out_y - pad_y;
+                const int32_t base_idx_x = stride_x * i_out_x - pad_x;
+
+                for (i_ker_y = 0; i_ker_y < kernel_y; i_ker_y++)
+                {
+                    for (i_ker_x = 0; i_ker_x < kernel_x; i_ker_x++)
+                    {
+                        const int32_t k_y = base_idx_y + dilation_y * i_ker_y;
+                        const int32_t k_x = base_idx_x + dilation_x * i_ker_x;
+
+                        if (k_y < 0 || k_y >= input_y || k_x < 0 || k_x >= input_x)
+                        {
+                            /* Filling 0 for out-of-bound paddings */
+                            memset(two_column_buf, 0, sizeof(int16_t) * input_ch);
+                        }
+                        else
+                        {
+                            /* Copying the pixel data to column */
+                            arm_q7_to_q15_with_offset(
+                                input_data + (k_y * input_x + k_x) * input_ch, two_column_buf, input_ch, input_offset);
+                        }
+                        two_column_buf += input_ch;
+                    }
+                }
+
+                /* Computation is filed for every 2 columns */
+                if (two_column_buf == buffer_a + 2 * input_ch * kernel_y * kernel_x)
+                {
+                    out = arm_nn_mat_mult_kernel_s8_s16_reordered(filter_data,
+                                                                  buffer_a,
+                                                                  output_ch,
+                                                                  output_shift,
+                                                                  output_mult,
+                                                                  out_offset,
+                                                                  out_activation_min,
+                                                                  out_activation_max,
+                                                                  input_ch * kernel_y * kernel_x,
+                                                                  bias_data,
+                                                                  out);
+
+                    /* counter reset */
+                    two_column_buf = buffer_a;
+                }
+            }
+        }
+
+        /* left-over because odd number of output pixels */
+        if (two_column_buf != buffer_a)
+        {
+            const int8_t *ker_a = filter_data;
+            int i;
+
+            for (i = 0; i < output_ch; i++)
+            {
+                /* Load the accumulator with bias first */
+                int32_t sum = 0;
+                if (bias_data)
+                {
+                    sum = bias_data[i];
+                }
+
+                /* Point to the beginning of the im2col buffer where the input is available as a rearranged column */
+                const int16_t *ip_as_col = buffer_a;
+
+                /* 4 multiply and accumulates are done in one loop. */
+    #if defined(ARM_MATH_DSP)
+                uint16_t col_count = (input_ch * kernel_y * kernel_x) >> 2;
+
+                while (col_count)
+                {
+                    int32_t ker_a1, ker_a2;
+                    int32_t ip_b1, ip_b2;
+
+                    ker_a = read_and_pad_reordered(ker_a, &ker_a1, &ker_a2);
+
+                    ip_b1 = arm_nn_read_q15x2_ia(&ip_as_col);
+                    sum = SMLAD(ker_a1, ip_b1, sum);
+                    ip_b2 = arm_nn_read_q15x2_ia(&ip_as_col);
+                    sum = SMLAD(ker_a2, ip_b2, sum);
+
+                    col_count--;
+                }
+                /* Handle left over mac */
+                col_count = input_ch * kernel_y * kernel_x & 0x3;
+    #else
+                uint16_t col_count = (input_ch * kernel_y * kernel_x) >> 2;
+
+                while (col_count)
+                {
+                    sum += ker_a[0] * ip_as_col[0] + ker_a[2] * ip_as_col[1] + ker_a[1] * ip_as_col[2] +
+                        ker_a[3] * ip_as_col[3];
+                    ker_a += 4;
+                    ip_as_col += 4;
+                    col_count--;
+                }
+                col_count = input_ch * kernel_y * kernel_x & 0x3;
+    #endif
+                while (col_count)
+                {
+                    int8_t ker_a1 = *ker_a++;
+                    int16_t ip_b1 = *ip_as_col++;
+                    sum += ker_a1 * ip_b1;
+                    col_count--;
+                }
+
+                sum = arm_nn_requantize(sum, output_mult[i], output_shift[i]);
+                sum += out_offset;
+                sum = MAX(sum, out_activation_min);
+                sum = MIN(sum, out_activation_max);
+                *out++ = (int8_t)sum;
+            }
+        }
+        /* Advance to the next batch */
+        input_data += (input_x * input_y * input_ch);
+        output_data += (output_x * output_y * output_ch);
+    }
+
+    /* Return to application */
+    return ARM_CMSIS_NN_SUCCESS;
+#endif // #if defined(ARM_MATH_MVEI)
+}
+
+int32_t arm_convolve_s8_get_reordered_filter_size(const cmsis_nn_dims *filter_dims)
+{
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+    /* 1 x N filters may go to arm_convolve_1x1_s8_fast(), arm_convolve_1x1_s8() or arm_convolve_1_x_n_s8() */
+    if (filter_dims->h > 1)
+    {
+        return filter_dims->n * filter_dims->h * filter_dims->w * filter_dims->c;
+    }
+#else
+    (void)filter_dims;
+#endif
+    return 0;
+}
+
+void arm_convolve_s8_reorder_filter(const cmsis_nn_dims *filter_dims, const int8_t *src, int8_t *dst)
+{
+    const int32_t row_size = filter_dims->h * filter_dims->w * filter_dims->c;
+    const int32_t groups = row_size >> 2;
+
+    for (int32_t i_row = 0; i_row < filter_dims->n; i_row++)
+    {
+        for (int32_t i_group = 0; i_group < groups; i_group++)
+        {
+            dst[0] = src[0];
+            dst[1] = src[2];
+            dst[2] = src[1];
+            dst[3] = src[3];
+            src += 4;
+            dst += 4;
+        }
+        for (int32_t i = groups << 2; i < row_size; i++)
+        {
+            *dst++ = *src++;
+        }
+    }
+}
+
+/**
+ * @} end of NNConv group
+ */
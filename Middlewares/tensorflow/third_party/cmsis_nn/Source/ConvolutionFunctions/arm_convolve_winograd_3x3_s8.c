@@ -0,0 +1,288 @@
+/*
+ * SPDX-FileCopyrightText: Copyright 2026 The ml_model_attestation Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_convolve_winograd_3x3_s8.c
+ * Description:  s8 version of 3x3 stride 1 convolution in the Winograd F(2x2, 3x3) domain
+ *
+ * $Date:        19 October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target :  Arm(R) M-Profile Architecture
+ *
+ * -------------------------------------------------------------------- */
+
+#include "arm_nnfunctions.h"
+#include "arm_nnsupportfunctions.h"
+
+/**
+ *  @ingroup Public
+ */
+
+/**
+ * @addtogroup NNConv
+ * @{
+ */
+
+/* Exact int32 accumulation: |U| <= 9 * 128, |V| <= 4 * 255, C_IN * 9 * 128 * 4 * 255 < 2^31 */
+#define ARM_NN_WINOGRAD_MAX_INPUT_CH (1024)
+
+/* A single input channel is padded to a pair: half of the multiplications are wasted, little gain */
+#define ARM_NN_WINOGRAD_MIN_INPUT_CH (2)
+
+/* m[j] = sum over the pairs of input channels of u * v, j < 16, u and v s16 [pairs][16][2] */
+static void arm_nn_winograd_dot_16x2_s16(int32_t *m, const int16_t *u, const int16_t *v, const int32_t pairs)
+{
+#if defined(CMSIS_NN_HOST_SIMD)
+    arm_nn_host_dot_16x2_s16(m, u, v, pairs);
+#else
+    for (int32_t j = 0; j < 16; j++)
+    {
+        m[j] = 0;
+    }
+    for (int32_t k = 0; k < pairs; k++)
+    {
+        for (int32_t j = 0; j < 16; j++)
+        {
+    #if defined(ARM_MATH_DSP)
+            m[j] = SMLAD(arm_nn_read_q15x2_ia(&u), arm_nn_read_q15x2_ia(&v), m[j]);
+    #else
+            m[j] += u[0] * v[0] + u[1] * v[1];
+            u += 2;
+            v += 2;
+    #endif
+        }
+    }
+#endif
+}
+
+/*
+ * s8 convolution in the Winograd F(2x2, 3x3) domain.
+ *
+ * Refer header file for details. For each 2x2 output tile, V = B^T d B of the 4x4 input tile d (input offset
+ * applied, 0 in the padding) is computed for all the input channels, then for each output channel the 16 sums over
+ * the input channels of U * V (U = 4 G g G^T, arm_convolve_winograd_3x3_s8_transform_filter()) are transformed back
+ * by A^T M A, that is 4 times the output of the direct convolution.
+ *
+ */
+
+arm_cmsis_nn_status arm_convolve_winograd_3x3_s8(const cmsis_nn_context *ctx,
+                                                 const cmsis_nn_conv_params *conv_params,
+                                                 const cmsis_nn_per_channel_quant_params *quant_params,
+                                                 const cmsis_nn_dims *input_dims,
+                                                 const int8_t *input_data,
+                                                 const cmsis_nn_dims *filter_dims,
+                                                 const int16_t *transformed_filter,
+                                                 const cmsis_nn_dims *bias_dims,
+                                                 const int32_t *bias_data,
+                                                 const cmsis_nn_dims *output_dims,
+                                                 int8_t *output_data)
+{
+    (void)bias_dims;
+
+    if (ctx->buf == NULL || arm_convolve_winograd_3x3_s8_get_filter_size(conv_params, filter_dims) == 0)
+    {
+        return ARM_CMSIS_NN_ARG_ERROR;
+    }
+    int16_t *v = (int16_t *)ctx->buf;
+
+    const int32_t input_batches = input_dims->n;
+    const int32_t input_x = input_dims->w;
+    const int32_t input_y = input_dims->h;
+    const int32_t input_ch = input_dims->c;
+    const int32_t input_ch_pairs = (input_ch + 1) / 2;
+    const int32_t output_x = output_dims->w;
+    const int32_t output_y = output_dims->h;
+    const int32_t output_ch = output_dims->c;
+    const int32_t pad_x = conv_params->padding.w;
+    const int32_t pad_y = conv_params->padding.h;
+    const int32_t input_offset = conv_params->input_offset;
+    const int32_t out_offset = conv_params->output_offset;
+    const int32_t out_activation_min = conv_params->activation.min;
+    const int32_t out_activation_max = conv_params->activation.max;
+    const int32_t *output_mult = quant_params->multiplier;
+    const int32_t *output_shift = quant_params->shift;
+
+    /* Channel added to an odd number of input channels */
+    if (input_ch & 1)
+    {
+        for (int32_t i = 0; i < 16; i++)
+        {
+            v[(input_ch_pairs - 1) * 32 + i * 2 + 1] = 0;
+        }
+    }
+
+    for (int32_t i_batch = 0; i_batch < input_batches; i_batch++)
+    {
+        for (int32_t i_out_y = 0; i_out_y < output_y; i_out_y += 2)
+        {
+            for (int32_t i_out_x = 0; i_out_x < output_x; i_out_x += 2)
+            {
+                const int32_t base_y = i_out_y - pad_y;
+                const int32_t base_x = i_out_x - pad_x;
+                const int32_t inside = base_y >= 0 && base_y + 4 <= input_y && base_x >= 0 && base_x + 4 <= input_x;
+
+                /* Input transform, V[C_IN / 2][16][2] */
+                for (int32_t i_ch = 0; i_ch < input_ch; i_ch++)
+                {
+                    int32_t d[4][4];
+                    for (int32_t i = 0; i < 4; i++)
+                    {
+                        const int32_t y = base_y + i;
+                        for (int32_t j = 0; j < 4; j++)
+                        {
+                            const int32_t x = base_x + j;
+                            d[i][j] = (inside || (y >= 0 && y < input_y && x >= 0 && x < input_x))
+                                ? input_data[(y * input_x + x) * input_ch + i_ch] + input_offset
+                                : 0;
+                        }
+                    }
+                    int32_t t[4][4];
+                    for (int32_t j = 0; j < 4; j++)
+                    {
+                        t[0][j] = d[0][j] - d[2][j];
+                        t[1][j] = d[1][j] + d[2][j];
+                        t[2][j] = d[2][j] - d[1][j];
+                        t[3][j] = d[1][j] - d[3][j];
+                    }
+                    int16_t *v_ch = v + (i_ch >> 1) * 32 + (i_ch & 1);
+                    for (int32_t i = 0; i < 4; i++)
+                    {
+                        v_ch[(i * 4 + 0) * 2] = (int16_t)(t[i][0] - t[i][2]);
+                        v_ch[(i * 4 + 1) * 2] = (int16_t)(t[i][1] + t[i][2]);
+                        v_ch[(i * 4 + 2) * 2] = (int16_t)(t[i][2] - t[i][1]);
+                        v_ch[(i * 4 + 3) * 2] = (int16_t)(t[i][1] - t[i][3]);
+                    }
+                }
+
+                const int32_t tile_y = MIN(2, output_y - i_out_y);
+                const int32_t tile_x = MIN(2, output_x - i_out_x);
+                int8_t *out = output_data + (i_out_y * output_x + i_out_x) * output_ch;
+                const int16_t *u = transformed_filter;
+
+                for (int32_t i_out_ch = 0; i_out_ch < output_ch; i_out_ch++)
+                {
+                    int32_t m[16];
+                    arm_nn_winograd_dot_16x2_s16(m, u, v, input_ch_pairs);
+                    u += input_ch_pairs * 32;
+
+                    /* Output transform A^T M A (modulo 2^32, the result fits), divided by 4 */
+                    uint32_t s[2][4];
+                    for (int32_t j = 0; j < 4; j++)
+                    {
+                        s[0][j] = (uint32_t)m[j] + (uint32_t)m[4 + j] + (uint32_t)m[8 + j];
+                        s[1][j] = (uint32_t)m[4 + j] - (uint32_t)m[8 + j] - (uint32_t)m[12 + j];
+                    }
+                    int32_t y[2][2];
+                    for (int32_t i = 0; i < 2; i++)
+                    {
+                        y[i][0] = (int32_t)(s[i][0] + s[i][1] + s[i][2]) >> 2;
+                        y[i][1] = (int32_t)(s[i][1] - s[i][2] - s[i][3]) >> 2;
+                    }
+
+                    const int32_t bias = bias_data ? bias_data[i_out_ch] : 0;
+                    for (int32_t i = 0; i < tile_y; i++)
+                    {
+                        for (int32_t j = 0; j < tile_x; j++)
+                        {
+                            int32_t res = arm_nn_requantize(y[i][j] + bias, output_mult[i_out_ch], output_shift[i_out_ch]);
+                            res += out_offset;
+                            res = MAX(res, out_activation_min);
+                            res = MIN(res, out_activation_max);
+                            out[(i * output_x + j) * output_ch + i_out_ch] = (int8_t)res;
+                        }
+                    }
+                }
+            }
+        }
+
+        /* Advance to the next batch */
+        input_data += (input_x * input_y * input_ch);
+        output_data += (output_x * output_y * output_ch);
+    }
+
+    /* Return to application */
+    return ARM_CMSIS_NN_SUCCESS;
+}
+
+int32_t arm_convolve_winograd_3x3_s8_get_filter_size(const cmsis_nn_conv_params *conv_params,
+                                                     const cmsis_nn_dims *filter_dims)
+{
+    if (filter_dims->h != 3 || filter_dims->w != 3 || conv_params->stride.h != 1 || conv_params->stride.w != 1 ||
+        conv_params->dilation.h != 1 || conv_params->dilation.w != 1 ||
+        filter_dims->c < ARM_NN_WINOGRAD_MIN_INPUT_CH || filter_dims->c > ARM_NN_WINOGRAD_MAX_INPUT_CH)
+    {
+        return 0;
+    }
+    return filter_dims->n * 16 * ((filter_dims->c + 1) & ~1) * (int32_t)sizeof(int16_t);
+}
+
+int32_t arm_convolve_winograd_3x3_s8_get_buffer_size(const cmsis_nn_dims *input_dims)
+{
+    return 16 * ((input_dims->c + 1) & ~1) * (int32_t)sizeof(int16_t);
+}
+
+void arm_convolve_winograd_3x3_s8_transform_filter(const cmsis_nn_dims *filter_dims, const int8_t *src, int16_t *dst)
+{
+    const int32_t input_ch = filter_dims->c;
+    const int32_t input_ch_pairs = (input_ch + 1) / 2;
+
+    for (int32_t i_out_ch = 0; i_out_ch < filter_dims->n; i_out_ch++)
+    {
+        const int8_t *g = src + i_out_ch * 9 * input_ch;
+        int16_t *u = dst + i_out_ch * input_ch_pairs * 32;
+        for (int32_t i_ch = 0; i_ch < input_ch_pairs * 2; i_ch++)
+        {
+            int16_t *u_ch = u + (i_ch >> 1) * 32 + (i_ch & 1);
+            if (i_ch == input_ch)
+            {
+                /* Channel added to an odd number of input channels */
+                for (int32_t i = 0; i < 16; i++)
+                {
+                    u_ch[i * 2] = 0;
+                }
+                break;
+            }
+            /* (2G) g, 2G = [2 0 0; 1 1 1; 1 -1 1; 0 0 2] */
+            int32_t t[4][3];
+            for (int32_t j = 0; j < 3; j++)
+            {
+                const int32_t g0 = g[(0 * 3 + j) * input_ch + i_ch];
+                const int32_t g1 = g[(1 * 3 + j) * input_ch + i_ch];
+                const int32_t g2 = g[(2 * 3 + j) * input_ch + i_ch];
+                t[0][j] = 2 * g0;
+                t[1][j] = g0 + g1 + g2;
+                t[2][j] = g0 - g1 + g2;
+                t[3][j] = 2 * g2;
+            }
+            /* ((2G) g) (2G)^T */
+            for (int32_t i = 0; i < 4; i++)
+            {
+                u_ch[(i * 4 + 0) * 2] = (int16_t)(2 * t[i][0]);
+                u_ch[(i * 4 + 1) * 2] = (int16_t)(t[i][0] + t[i][1] + t[i][2]);
+                u_ch[(i * 4 + 2) * 2] = (int16_t)(t[i][0] - t[i][1] + t[i][2]);
+                u_ch[(i * 4 + 3) * 2] = (int16_t)(2 * t[i][2]);
+            }
+        }
+    }
+}
+
+/**
+ * @} end of NNConv group
+ */
@@ -173,6 +173,35 @@ arm_cmsis_nn_status arm_depthwise_conv_3x3_s8(const cmsis_nn_context *ctx,
                     kernel_ptr += (input_ch * 3);
                 }
 
+#elif defined(CMSIS_NN_HOST_SIMD)
+                const __m128i lhs_offset_s32x4 = _mm_set1_epi32(input_offset);
+                __m128i out_buff = _mm_setr_epi32(out_buff0, out_buff1, out_buff2, out_buff3);
+
+                for (int32_t ker_h = ker_h_start; ker_h < MIN(3, input_y - in_h); ++ker_h)
+                {
+                    if (ker_w_start == 0)
+                    {
+                        out_buff = arm_nn_host_mla_s8x4(out_buff, input_ptr, kernel_ptr, lhs_offset_s32x4);
+                    }
+
+                    out_buff =
+                        arm_nn_host_mla_s8x4(out_buff, input_ptr + input_ch, kernel_ptr + input_ch, lhs_offset_s32x4);
+
+                    if ((input_x - in_w) >= 3)
+                    {
+                        out_buff = arm_nn_host_mla_s8x4(
+                            out_buff, input_ptr + (input_ch << 1), kernel_ptr + (input_ch << 1), lhs_offset_s32x4);
+                    }
+
+                    input_ptr += (input_ch * input_x);
+                    kernel_ptr += (input_ch * 3);
+                }
+
+                out_buff0 = _mm_extract_epi32(out_buff, 0);
+                out_buff1 = _mm_extract_epi32(out_buff, 1);
+                out_buff2 = _mm_extract_epi32(out_buff, 2);
+                out_buff3 = _mm_extract_epi32(out_buff, 3);
+
 #else
 
                 for (int32_t ker_h = ker_h_start; ker_h < MIN(3, input_y - in_h); ++ker_h)
@@ -423,6 +423,89 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
         }
     }
     #endif
+#elif defined(CMSIS_NN_HOST_SIMD)
+    (void)bias_dims;
+    const int32_t input_x = input_dims->w;
+    const int32_t input_y = input_dims->h;
+    const int32_t kernel_x = filter_dims->w;
+    const int32_t kernel_y = filter_dims->h;
+    const int32_t pad_x = dw_conv_params->padding.w;
+    const int32_t pad_y = dw_conv_params->padding.h;
+    const int32_t stride_x = dw_conv_params->stride.w;
+    const int32_t stride_y = dw_conv_params->stride.h;
+    const int32_t *output_shift = quant_params->shift;
+    const int32_t *output_mult = quant_params->multiplier;
+    const int32_t output_x = output_dims->w;
+    const int32_t output_y = output_dims->h;
+    const int32_t output_offset = dw_conv_params->output_offset;
+    const int32_t input_offset = dw_conv_params->input_offset;
+    const int32_t output_activation_min = dw_conv_params->activation.min;
+    const int32_t output_activation_max = dw_conv_params->activation.max;
+    const __m128i lhs_offset_s32x4 = _mm_set1_epi32(input_offset);
+    int8_t *out = output;
+
+    for (int32_t out_y = 0; out_y < output_y; out_y++)
+    {
+        const int32_t base_y = out_y * stride_y - pad_y;
+        const int32_t ker_y_start = MAX(0, -base_y);
+        const int32_t ker_y_end = MIN(kernel_y, input_y - base_y);
+
+        for (int32_t out_x = 0; out_x < output_x; out_x++)
+        {
+            const int32_t base_x = out_x * stride_x - pad_x;
+            const int32_t ker_x_start = MAX(0, -base_x);
+            const int32_t ker_x_end = MIN(kernel_x, input_x - base_x);
+            int32_t ch = 0;
+
+            /* Four channels per step: one 32-bit lane per channel */
+            for (; ch <= (input_ch - 4); ch += 4)
+            {
+                __m128i acc = bias ? _mm_loadu_si128((const __m128i *)(bias + ch)) : _mm_setzero_si128();
+                for (int32_t ker_y = ker_y_start; ker_y < ker_y_end; ker_y++)
+                {
+                    const int32_t in_idx = ((base_y + ker_y) * input_x + base_x + ker_x_start) * input_ch + ch;
+                    const int8_t *input_ptr = input + in_idx;
+                    const int8_t *kernel_ptr = kernel + (ker_y * kernel_x + ker_x_start) * input_ch + ch;
+                    for (int32_t ker_x = ker_x_start; ker_x < ker_x_end; ker_x++)
+                    {
+                        acc = arm_nn_host_mla_s8x4(acc, input_ptr, kernel_ptr, lhs_offset_s32x4);
+                        input_ptr += input_ch;
+                        kernel_ptr += input_ch;
+                    }
+                }
+
+                int32_t res[4];
+                _mm_storeu_si128((__m128i *)res, acc);
+                for (int32_t i = 0; i < 4; i++)
+                {
+                    res[i] = arm_nn_requantize(res[i], output_mult[ch + i], output_shift[ch + i]);
+                    res[i] += output_offset;
+                    res[i] = MAX(res[i], output_activation_min);
+                    res[i] = MIN(res[i], output_activation_max);
+                    out[ch + i] = (int8_t)res[i];
+                }
+            }
+
+            for (; ch < input_ch; ch++)
+            {
+                int32_t acc = bias ? bias[ch] : 0;
+                for (int32_t ker_y = ker_y_start; ker_y < ker_y_end; ker_y++)
+                {
+                    for (int32_t ker_x = ker_x_start; ker_x < ker_x_end; ker_x++)
+                    {
+                        const int32_t in_idx = ((base_y + ker_y) * input_x + base_x + ker_x) * input_ch + ch;
+                        acc += (input[in_idx] + input_offset) * kernel[(ker_y * kernel_x + ker_x) * input_ch + ch];
+                    }
+                }
+                acc = arm_nn_requantize(acc, output_mult[ch], output_shift[ch]);
+                acc += output_offset;
+                acc = MAX(acc, output_activation_min);
+                acc = MIN(acc, output_activation_max);
+                out[ch] = (int8_t)acc;
+            }
+            out += input_ch;
+        }
+    }
 #else
     /* Run the following code as reference implementation for Cortex-M0 and Cortex-M3 */
     return arm_depthwise_conv_s8(ctx,
@@ -0,0 +1,89 @@
+/*
+ * SPDX-FileCopyrightText: Copyright 2026 The ml_model_attestation Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_nn_mat_mult_kernel_s4_s16.c
+ * Description:  Matrix-multiplication function for convolution with packed s4 weights
+ *
+ * $Date:        19 October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target :  Arm(R) M-Profile Architecture
+ * -------------------------------------------------------------------- */
+
+#include "arm_nnfunctions.h"
+#include "arm_nnsupportfunctions.h"
+
+/*
+ * Matrix-multiplication function for convolution with per-channel requantization and packed s4 weights.
+ *
+ * Refer header file for details.
+ *
+ */
+
+int8_t *arm_nn_mat_mult_kernel_s4_s16(const int8_t *input_a,
+                                      const int16_t *input_b,
+                                      const int32_t num_col_b,
+                                      const uint16_t output_ch,
+                                      const int32_t *out_shift,
+                                      const int32_t *out_mult,
+                                      const int32_t out_offset,
+                                      const int16_t activation_min,
+                                      const int16_t activation_max,
+                                      const uint16_t num_col_a,
+                                      const int32_t *const output_bias,
+                                      int8_t *out_0)
+{
+    int8_t *out_1 = out_0 + output_ch;
+    const int16_t *ip_b1 = num_col_b == 2 ? input_b + num_col_a : NULL;
+
+    for (int32_t i_ch = 0; i_ch < output_ch; i_ch++)
+    {
+        /* Index of the first value of the row, rows of an odd length start on a high nibble every other row */
+        const int32_t first = i_ch * num_col_a;
+
+        int32_t ch_out_0 = 0;
+        int32_t ch_out_1 = 0;
+        if (output_bias)
+        {
+            ch_out_0 = output_bias[i_ch];
+            ch_out_1 = output_bias[i_ch];
+        }
+
+        arm_nn_dot_s4_s16(input_a + first / 2, first & 1, input_b, ip_b1, num_col_a, &ch_out_0, &ch_out_1);
+
+        ch_out_0 = arm_nn_requantize(ch_out_0, out_mult[i_ch], out_shift[i_ch]);
+        ch_out_0 += out_offset;
+        ch_out_0 = MAX(ch_out_0, activation_min);
+        ch_out_0 = MIN(ch_out_0, activation_max);
+        out_0[i_ch] = (int8_t)ch_out_0;
+
+        if (ip_b1)
+        {
+            ch_out_1 = arm_nn_requantize(ch_out_1, out_mult[i_ch], out_shift[i_ch]);
+            ch_out_1 += out_offset;
+            ch_out_1 = MAX(ch_out_1, activation_min);
+            ch_out_1 = MIN(ch_out_1, activation_max);
+            out_1[i_ch] = (int8_t)ch_out_1;
+        }
+    }
+
+    /* return the new output pointer with offset */
+    return out_0 + num_col_b * output_ch;
+}
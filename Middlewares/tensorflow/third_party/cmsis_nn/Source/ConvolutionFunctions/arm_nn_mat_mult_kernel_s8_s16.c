@@ -107,6 +107,17 @@ int8_t *arm_nn_mat_mult_kernel_s8_s16(const int8_t *input_a,
             col_count--;
         } /* while over col_count */
         col_count = num_col_a & 0x3;
+    #elif defined(CMSIS_NN_HOST_SIMD)
+        uint16_t col_count = num_col_a;
+        if (num_col_a >= ARM_NN_HOST_SIMD_MIN_COLS)
+        {
+            ch_0_out_0 += arm_nn_host_dot_s8_s16(ip_a0, ip_b0, num_col_a);
+            ch_0_out_1 += arm_nn_host_dot_s8_s16(ip_a0, ip_b1, num_col_a);
+            ch_1_out_0 += arm_nn_host_dot_s8_s16(ip_a1, ip_b0, num_col_a);
+            ch_1_out_1 += arm_nn_host_dot_s8_s16(ip_a1, ip_b1, num_col_a);
+            ip_a0 += num_col_a;
+            col_count = 0;
+        }
     #else
         uint16_t col_count = num_col_a;
     #endif
@@ -195,6 +206,15 @@ int8_t *arm_nn_mat_mult_kernel_s8_s16(const int8_t *input_a,
             col_count--;
         }
         col_count = num_col_a & 0x3;
+    #elif defined(CMSIS_NN_HOST_SIMD)
+        uint16_t col_count = num_col_a;
+        if (num_col_a >= ARM_NN_HOST_SIMD_MIN_COLS)
+        {
+            ch_0_out_0 += arm_nn_host_dot_s8_s16(ip_a0, ip_b0, num_col_a);
+            ch_0_out_1 += arm_nn_host_dot_s8_s16(ip_a0, ip_b1, num_col_a);
+            ip_a0 += num_col_a;
+            col_count = 0;
+        }
     #else
         uint16_t col_count = num_col_a;
     #endif
@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: Copyright 2026 The ml_model_attestation Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_fully_connected_block_sparse_s8
+ * Description:  Fully connected function compatible with TF Lite, block sparse (BSR) filter.
+ *
+ * $Date:        19 October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target :  Arm(R) M-Profile Architecture
+ *
+ * -------------------------------------------------------------------- */
+
+#include "arm_nnfunctions.h"
+#include "arm_nnsupportfunctions.h"
+
+/**
+ *  @ingroup Public
+ */
+
+/**
+ * @addtogroup FC
+ * @{
+ */
+
+/* sum over the blocks [first_block, last_block) of one filter row of the dot products with the input blocks */
+static int32_t arm_nn_block_row_dot_s8_s16(const int8_t *values,
+                                           const int16_t *lhs,
+                                           const cmsis_nn_bsr_s8 *filter,
+                                           const int32_t first_block,
+                                           const int32_t last_block)
+{
+    const int32_t block_cols = filter->block_cols;
+    const int32_t block_size = filter->block_rows * block_cols;
+    int32_t sum = 0;
+#if defined(CMSIS_NN_HOST_SIMD) && !defined(ARM_MATH_DSP)
+    if (block_cols % 8 == 0)
+    {
+        /* one horizontal sum per row */
+        __m128i acc = _mm_setzero_si128();
+        for (int32_t i_block = first_block; i_block < last_block; i_block++)
+        {
+            acc = arm_nn_host_mla_s8_s16(acc, values, lhs + filter->block_col[i_block] * block_cols, block_cols);
+            values += block_size;
+        }
+        return arm_nn_host_hsum_s32(acc);
+    }
+#endif
+    for (int32_t i_block = first_block; i_block < last_block; i_block++)
+    {
+        const int8_t *row = values;
+        const int16_t *vec = lhs + filter->block_col[i_block] * block_cols;
+        int32_t i = 0;
+#if defined(ARM_MATH_DSP)
+        for (; i + 4 <= block_cols; i += 4)
+        {
+            int32_t w01, w23;
+            row = read_and_pad(row, &w01, &w23);
+            sum = SMLAD(w01, arm_nn_read_q15x2_ia(&vec), sum);
+            sum = SMLAD(w23, arm_nn_read_q15x2_ia(&vec), sum);
+        }
+#endif
+        for (; i < block_cols; i++)
+        {
+            sum += *row++ * *vec++;
+        }
+        values += block_size;
+    }
+    return sum;
+}
+
+/*
+ * S8 fully-connected layer function with a block sparse filter for TensorFlow Lite
+ *
+ * Refer header file for details. The input (with its offset) is widened once per batch, zero padded to a whole number
+ * of blocks, each stored block is a block_cols dot product per row.
+ *
+ */
+
+arm_cmsis_nn_status arm_fully_connected_block_sparse_s8(const cmsis_nn_context *ctx,
+                                                        const cmsis_nn_fc_params *fc_params,
+                                                        const cmsis_nn_per_tensor_quant_params *quant_params,
+                                                        const cmsis_nn_dims *input_dims,
+                                                        const int8_t *input,
+                                                        const cmsis_nn_bsr_s8 *filter,
+                                                        const int32_t *bias,
+                                                        const cmsis_nn_dims *output_dims,
+                                                        int8_t *output)
+{
+    (void)fc_params->filter_offset;
+
+    if (ctx->buf == NULL)
+    {
+        return ARM_CMSIS_NN_ARG_ERROR;
+    }
+    int16_t *lhs = (int16_t *)ctx->buf;
+
+    const int32_t block_row_count = (filter->rows + filter->block_rows - 1) / filter->block_rows;
+    const int32_t padded_cols =
+        arm_fully_connected_block_sparse_s8_get_buffer_size(filter) / (int32_t)sizeof(int16_t);
+    arm_memset_s8((int8_t *)(lhs + filter->cols), 0, (padded_cols - filter->cols) * sizeof(int16_t));
+
+    int32_t batch_cnt = input_dims->n;
+
+    while (batch_cnt)
+    {
+        arm_q7_to_q15_with_offset(input, lhs, filter->cols, fc_params->input_offset);
+
+        for (int32_t i_block_row = 0; i_block_row < block_row_count; i_block_row++)
+        {
+            const int32_t first_block = filter->block_row_ptr[i_block_row];
+            const int32_t last_block = filter->block_row_ptr[i_block_row + 1];
+
+            for (int32_t i = 0; i < filter->block_rows; i++)
+            {
+                const int32_t i_row = i_block_row * filter->block_rows + i;
+                if (i_row >= filter->rows)
+                {
+                    break;
+                }
+
+                int32_t res = 0;
+                if (bias)
+                {
+                    res = bias[i_row];
+                }
+
+                const int8_t *values = filter->values + (first_block * filter->block_rows + i) * filter->block_cols;
+                res += arm_nn_block_row_dot_s8_s16(values, lhs, filter, first_block, last_block);
+
+                res = arm_nn_requantize(res, quant_params->multiplier, quant_params->shift);
+                res += fc_params->output_offset;
+                res = MAX(res, fc_params->activation.min);
+                res = MIN(res, fc_params->activation.max);
+                output[i_row] = (int8_t)res;
+            }
+        }
+
+        input += filter->cols;
+        output += output_dims->c;
+        batch_cnt--;
+    }
+    return (ARM_CMSIS_NN_SUCCESS);
+}
+
+int32_t arm_fully_connected_block_sparse_s8_get_buffer_size(const cmsis_nn_bsr_s8 *filter)
+{
+    const int32_t block_col_count = (filter->cols + filter->block_cols - 1) / filter->block_cols;
+    return block_col_count * filter->block_cols * (int32_t)sizeof(int16_t);
+}
+
+/**
+ * @} end of FC group
+ */
@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: Copyright 2010-2023 Arm Limited and/or its affiliates <open-source-office@arm.com>
+ * SPDX-FileCopyrightText: Copyright 2026 The ml_model_attestation Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_fully_connected_s4
+ * Description:  Fully connected function compatible with TF Lite, packed s4 weights.
+ *               Derived from arm_fully_connected_s8.c V.5.1.0.
+ *
+ * $Date:        19 October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target :  Arm(R) M-Profile Architecture
+ *
+ * -------------------------------------------------------------------- */
+
+#include "arm_nnfunctions.h"
+#include "arm_nnsupportfunctions.h"
+
+/**
+ *  @ingroup Public
+ */
+
+/**
+ * @addtogroup FC
+ * @{
+ */
+
+/*
+ * S8 fully-connected layer function with packed s4 weights for TensorFlow Lite
+ *
+ * Refer header file for details.
+ *
+ */
+
+arm_cmsis_nn_status arm_fully_connected_s4(const cmsis_nn_context *ctx,
+                                           const cmsis_nn_fc_params *fc_params,
+                                           const cmsis_nn_per_tensor_quant_params *quant_params,
+                                           const cmsis_nn_dims *input_dims,
+                                           const int8_t *input,
+                                           const cmsis_nn_dims *filter_dims,
+                                           const int8_t *packed_kernel,
+                                           const cmsis_nn_dims *bias_dims,
+                                           const int32_t *bias,
+                                           const cmsis_nn_dims *output_dims,
+                                           int8_t *output)
+{
+    (void)bias_dims;
+    (void)fc_params->filter_offset;
+
+    if (ctx->buf == NULL || filter_dims->n > UINT16_MAX)
+    {
+        return ARM_CMSIS_NN_ARG_ERROR;
+    }
+    int16_t *lhs = (int16_t *)ctx->buf;
+
+    int32_t batch_cnt = input_dims->n;
+
+    while (batch_cnt)
+    {
+        /* Input with its offset added, shared by all the rows */
+        arm_q7_to_q15_with_offset(input, lhs, filter_dims->n, fc_params->input_offset);
+
+        arm_nn_vec_mat_mult_t_s4(lhs,
+                                 packed_kernel,
+                                 bias,
+                                 output,
+                                 fc_params->output_offset,
+                                 quant_params->multiplier,
+                                 quant_params->shift,
+                                 filter_dims->n, /* col_dim or accum_depth */
+                                 output_dims->c, /* row_dim or output_depth */
+                                 fc_params->activation.min,
+                                 fc_params->activation.max);
+
+        input += filter_dims->n;
+        output += output_dims->c;
+        batch_cnt--;
+    }
+    return (ARM_CMSIS_NN_SUCCESS);
+}
+
+int32_t arm_fully_connected_s4_get_buffer_size(const cmsis_nn_dims *filter_dims)
+{
+    return filter_dims->n * (int32_t)sizeof(int16_t);
+}
+
+/**
+ * @} end of FC group
+ */
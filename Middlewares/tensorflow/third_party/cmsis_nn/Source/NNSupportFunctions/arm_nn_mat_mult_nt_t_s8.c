@@ -617,6 +617,35 @@ arm_cmsis_nn_status arm_nn_mat_mult_nt_t_s8(const int8_t *lhs,
             dst_ptr += rhs_rows;
         }
     }
+#elif defined(CMSIS_NN_HOST_SIMD)
+    for (int32_t lhs_rows_idx = 0; lhs_rows_idx < lhs_rows; ++lhs_rows_idx)
+    {
+        const int8_t *rhs_ptr = rhs;
+
+        for (int32_t rhs_rows_idx = 0; rhs_rows_idx < rhs_rows; ++rhs_rows_idx)
+        {
+            int32_t res00 = 0;
+            if (bias)
+            {
+                res00 = bias[rhs_rows_idx];
+            }
+            res00 += arm_nn_host_dot_s8_s8(lhs, rhs_ptr, rhs_cols, lhs_offset);
+            rhs_ptr += rhs_cols;
+
+            // Quantize down
+            res00 = arm_nn_requantize(res00, dst_multipliers[rhs_rows_idx], dst_shifts[rhs_rows_idx]);
+
+            // Add offset
+            res00 += dst_offset;
+
+            // Clamp the result
+            res00 = MAX(res00, activation_min);
+            res00 = MIN(res00, activation_max);
+
+            *dst++ = (int8_t)res00;
+        }
+        lhs += rhs_cols_offset;
+    }
 #else
     (void)rhs_cols_offset;
     for (int32_t rhs_rows_idx = 0; rhs_rows_idx <= (rhs_rows - 2); rhs_rows_idx += 2)
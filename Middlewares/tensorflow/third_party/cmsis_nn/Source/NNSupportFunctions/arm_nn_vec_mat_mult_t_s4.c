@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: Copyright 2026 The ml_model_attestation Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_nn_vec_mat_mult_t_s4
+ * Description:  s16 vector by packed s4 matrix (transposed) multiplication
+ *
+ * $Date:        19 October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target :  Arm(R) M-Profile Architecture
+ *
+ * -------------------------------------------------------------------- */
+
+#include "arm_nnsupportfunctions.h"
+
+/**
+ * @ingroup groupSupport
+ */
+
+/**
+ * @addtogroup supportFC
+ * @{
+ */
+
+/*
+ * s16 vector (lhs) by packed s4 matrix (transposed) multiplication
+ *
+ * Refer header file for details.
+ *
+ */
+arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s4(const int16_t *lhs,
+                                             const int8_t *rhs,
+                                             const int32_t *bias,
+                                             int8_t *dst,
+                                             const int32_t dst_offset,
+                                             const int32_t dst_multiplier,
+                                             const int32_t dst_shift,
+                                             const int32_t rhs_cols,
+                                             const int32_t rhs_rows,
+                                             const int32_t activation_min,
+                                             const int32_t activation_max)
+{
+    for (int32_t i_row = 0; i_row < rhs_rows; i_row++)
+    {
+        /* Index of the first value of the row, rows of an odd length start on a high nibble every other row */
+        const int32_t first = i_row * rhs_cols;
+
+        int32_t res = 0;
+        if (bias)
+        {
+            res = bias[i_row];
+        }
+
+        arm_nn_dot_s4_s16(rhs + first / 2, first & 1, lhs, NULL, rhs_cols, &res, NULL);
+
+        res = arm_nn_requantize(res, dst_multiplier, dst_shift);
+        res += dst_offset;
+        res = MAX(res, activation_min);
+        res = MIN(res, activation_max);
+        dst[i_row] = (int8_t)res;
+    }
+
+    return ARM_CMSIS_NN_SUCCESS;
+}
+
+/**
+ * @} end of Doxygen group
+ */
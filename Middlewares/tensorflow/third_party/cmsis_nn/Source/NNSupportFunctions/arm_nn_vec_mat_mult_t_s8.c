@@ -301,6 +301,32 @@ arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s8(const int8_t *lhs,
         dst += address_offset;
     }
 
+#elif defined(CMSIS_NN_HOST_SIMD)
+
+    for (int32_t i_row = 0; i_row < rhs_rows; i_row++)
+    {
+        int32_t res00 = 0;
+        if (bias)
+        {
+            res00 = *bias++;
+        }
+        res00 += arm_nn_host_dot_s8_s8(lhs, rhs, rhs_cols, lhs_offset);
+
+        // Quantize down
+        res00 = arm_nn_requantize(res00, dst_multiplier, dst_shift);
+
+        // Add offset
+        res00 += dst_offset;
+
+        // Clamp the result
+        res00 = MAX(res00, activation_min);
+        res00 = MIN(res00, activation_max);
+
+        *dst = (int8_t)res00;
+        dst += address_offset;
+        rhs += rhs_cols;
+    }
+
 #else
 
     const int32_t row_loop_cnt = rhs_rows / 3;
@@ -114,6 +114,15 @@ if [ $? -ne 0 ]; then error_config 'adddata2blob'; fi
 $ITSbuilder addkey2blob $blob $blob -i $id_key -m "EC PRIVATE KEY" -o $owner --keytype=SECP_R1 -s ANY -b 256 -k $key1 -u SIGN -u SIGN_HASH --format=PEM >> $current_log_file
 if [ $? -ne 0 ]; then error_config 'addkey2blob'; fi
 
+# Model hot-swap (ML_MODEL_HOTSWAP, see Src/main.c): H(w)*G proofs (33 bytes, compressed
+# point on secp256k1, w: SHA-256 of the .tflite file) of the models which can be installed,
+# IDs 0x41 to 0x44. The header of a staged model gives the ID of its proof. Provision the
+# 4 IDs (unused ones with any 33 bytes): a free ID could be written by the application.
+# for i in 1 2 3 4; do
+#   $ITSbuilder adddata2blob $blob $blob -i 0x4$i -o $owner -p $flag -a $projectdir/SM/Binary/ITS_model_proof$i.bin >> $current_log_file
+#   if [ $? -ne 0 ]; then error_config 'adddata2blob'; fi
+# done
+
 
 #Parse blob
 $ITSbuilder infoblob $blob - >> $current_log_file
@@ -61,6 +61,33 @@ static GPIO_InitTypeDef  GPIO_InitStruct;
 #define ML_ECDSA_ATTEST_KEY_IDX      (0x46U) // as in ITS_BLOB.bat
 #define ML_HASH_SIZE          (32U)
 #define ML_SIGNATURE_SIZE     (64U)
+#define ML_MODEL_PROOF_UID    (0x40U)
+
+/* Model hot-swap (ML_MODEL_HOTSWAP build option): the new .tflite blob is
+ * staged in the ITS, header (size, UID of its proof) in ML_MODEL_STAGING_UID
+ * and data in chunks from ML_MODEL_STAGING_UID + 1. It is loaded in a single
+ * RAM slot, the model embedded in flash is the fallback.
+ * The H(w)*G proofs of the models which can be installed are provisioned
+ * with the factory ITS blob (ROT_Provisioning/SM/its_blob.bat), as the proof
+ * of the flash model (ML_MODEL_PROOF_UID): one WRITE_ONCE entry per model
+ * from ML_MODEL_PROOF_REGISTRY_UID. All the entries of the registry must be
+ * provisioned (unused ones with any 33 bytes), so that none can be created
+ * later by the application which stages the model.
+ */
+#if defined(ML_MODEL_HOTSWAP) && (ML_MODEL_HOTSWAP == 1)
+#define ML_MODEL_PROOF_REGISTRY_UID   (0x41U)
+#define ML_MODEL_PROOF_REGISTRY_SIZE  (4U)  /* 0x41 to 0x44 */
+#define ML_MODEL_STAGING_UID    (0x80U)
+#define ML_MODEL_STAGING_CHUNK  (512U)
+#define ML_MODEL_SLOT_SIZE      (32U * 1024U)
+
+/* Header of the staged model (ML_MODEL_STAGING_UID) */
+typedef struct
+{
+  uint32_t size;       /* bytes, .tflite blob */
+  uint32_t proof_uid;  /* UID of its proof, in the registry */
+} ML_StagedModelHeader_t;
+#endif
 
 #if defined(__ICCARM__)
 #include <LowLevelIOInterface.h>
@@ -143,6 +170,16 @@ TS_Init_t   hTS;
 unsigned char R_bytes[33]; // 33 bytes: 1 byte for prefix and 64 bytes for the point
 /* SHA256 of the TFLITE model. */
 unsigned char hash[32];
+/* UID of the provisioned proof of the installed model */
+static uint32_t ml_model_proof_uid = ML_MODEL_PROOF_UID;
+
+#if defined(ML_MODEL_HOTSWAP) && (ML_MODEL_HOTSWAP == 1)
+/* Model hot-swap slot, and hash/proof of the model embedded in flash */
+__ALIGNED(16) static uint8_t ml_model_slot[ML_MODEL_SLOT_SIZE];
+static bool ml_model_slot_active = false;
+static unsigned char ml_flash_hash[ML_HASH_SIZE];
+static unsigned char ml_flash_proof[ML_MODEL_PROOF_SIZE];
+#endif
 
 /* Private function prototypes -----------------------------------------------*/
 static void FW_APP_MAIN_PrintMenu(void);
@@ -154,10 +191,18 @@ static void MX_GPIO_Init(void);
 
 /* ML Attestation */
 static void ML_Attestation_ComputeCurrentModelProof(void);
-static bool ML_Attestation_Validate_Model_Proof(uint8_t *pModelProof);
+static bool ML_Attestation_Validate_Model_Proof(uint32_t uid, uint8_t *pModelProof);
 static void ML_Attestation_Model_Attestation(void);
 static bool ML_Attestation_Generate_Model_Proof(uint8_t *pChallange);
 static void ML_Attestation_GetDevicePublicKey(void);
+static int ML_Attestation_ComputeModelProof(const unsigned char *pHash, unsigned char *pProof);
+
+/* ML model hot-swap */
+#if defined(ML_MODEL_HOTSWAP) && (ML_MODEL_HOTSWAP == 1)
+static int ML_HotSwap_ReadStagedHeader(ML_StagedModelHeader_t *pHeader);
+static int ML_HotSwap_ReadStagedModel(uint32_t size, uint8_t *pModel, uint8_t *pHash);
+static void ML_HotSwap_Model(void);
+#endif
 
 /* Private functions ---------------------------------------------------------*/
 
@@ -241,6 +286,13 @@ int main(void)
     Error_Handler();
   }
 
+  /* Model in the external memory (TFLM_NETWORK_WEIGHTS_IN_OSPI): OctoSPI NOR
+   * in memory-mapped mode before any access to the model */
+  if (MX_X_CUBE_AI_ExtMemInit() != 0)
+  {
+    Error_Handler();
+  }
+
   /* Compute the hash of the model data in the init section */
   mbedtls_sha256(g_tflm_network_model_data, g_tflm_network_model_data_len, hash, 0);
 
@@ -257,9 +309,14 @@ int main(void)
      * E.g Now the model in embedded in flash and signed. But let's suppose that the model is loaded from SD card and it is not authenticated. */
     Error_Handler();
   }
+#if defined(ML_MODEL_HOTSWAP) && (ML_MODEL_HOTSWAP == 1)
+  memcpy(ml_flash_hash, hash, ML_HASH_SIZE);
+  memcpy(ml_flash_proof, R_bytes, ML_MODEL_PROOF_SIZE);
+#endif
 
   MX_X_CUBE_AI_Init();
 
+  /* First inference, the next ones are run from the main menu (entry 4) */
   MX_X_CUBE_AI_Process();
 
   /* Add your application code here */
@@ -283,6 +340,10 @@ void FW_APP_MAIN_PrintMenu(void)
   (void)printf("\r\n=================== ML model attestation ============================\r\n\r\n");
   (void)printf("  Start ML Attestation process ----------------------------- 1\r\n\r\n");
   (void)printf("  Get device public key ------------------------------------------- 2\r\n\r\n");
+#if defined(ML_MODEL_HOTSWAP) && (ML_MODEL_HOTSWAP == 1)
+  (void)printf("  Hot-swap the ML model (staged in ITS) ------------------- 3\r\n\r\n");
+#endif
+  (void)printf("  Run an inference ------------------------------------------ 4\r\n\r\n");
   (void)printf("  Selection :\r\n\r\n");
   (void)printf("  ");
 }
@@ -316,7 +377,14 @@ void FW_APP_MAIN_Run(void)
         case '2' :
           ML_Attestation_GetDevicePublicKey();
           break;
-        case '3':
+#if defined(ML_MODEL_HOTSWAP) && (ML_MODEL_HOTSWAP == 1)
+        case '3' :
+          ML_HotSwap_Model();
+          break;
+#endif
+        case '4' :
+          MX_X_CUBE_AI_Process();
+          break;
         default:
           (void)printf("\rInvalid Number !\r\n");
           break;
@@ -404,8 +472,14 @@ static void SystemClock_Config(void)
   }
 }
 
-/* Compute H(w)*G on the secp256k1 curve. */
+/* Compute H(w)*G of the installed model. */
 static void ML_Attestation_ComputeCurrentModelProof(void)
+{
+  (void)ML_Attestation_ComputeModelProof(hash, R_bytes);
+}
+
+/* Compute H(w)*G on the secp256k1 curve. */
+static int ML_Attestation_ComputeModelProof(const unsigned char *pHash, unsigned char *pProof)
 {
   int ret;
   mbedtls_ecp_group group;
@@ -433,7 +507,7 @@ static void ML_Attestation_ComputeCurrentModelProof(void)
   }
 
   // Convert hash to mbedtls_mpi (scalar)
-  ret = mbedtls_mpi_read_binary(&k, hash, sizeof(hash));
+  ret = mbedtls_mpi_read_binary(&k, pHash, ML_HASH_SIZE);
   if (ret != 0) {
       mbedtls_printf("Failed to convert hash to MPI: -0x%04x\n", -ret);
       return 1;
@@ -449,7 +523,7 @@ static void ML_Attestation_ComputeCurrentModelProof(void)
   // 6. Print the result
   size_t olen;
 
-  ret = mbedtls_ecp_point_write_binary(&group, &R, MBEDTLS_ECP_PF_COMPRESSED, &olen, R_bytes, sizeof(R_bytes));
+  ret = mbedtls_ecp_point_write_binary(&group, &R, MBEDTLS_ECP_PF_COMPRESSED, &olen, pProof, ML_MODEL_PROOF_SIZE);
   if (ret != 0) {
       mbedtls_printf("Failed to write point to binary: -0x%04x\n", -ret);
       return 1;
@@ -460,15 +534,17 @@ static void ML_Attestation_ComputeCurrentModelProof(void)
   mbedtls_ecp_point_free(&P);
   mbedtls_mpi_free(&k);
   mbedtls_ecp_point_free(&R);
+  return 0;
 }
 
-static bool ML_Attestation_Validate_Model_Proof(uint8_t *pModelProof)
+/* Check a model proof against the provisioned one at uid. */
+static bool ML_Attestation_Validate_Model_Proof(uint32_t uid, uint8_t *pModelProof)
 {
   size_t data_length = ML_MODEL_PROOF_SIZE;
   psa_status_t psa_status = PSA_ERROR_GENERIC_ERROR;
   uint8_t dataout[ML_MODEL_PROOF_SIZE] = {0U};
 
-  psa_status = psa_its_get(0x40, 0u, data_length, (void *)&dataout, &data_length);
+  psa_status = psa_its_get(uid, 0u, data_length, (void *)&dataout, &data_length);
   if(psa_status != PSA_SUCCESS)
   {
     (void)printf("\r\nNo provisioned model.\r\n");
@@ -572,7 +648,7 @@ static void ML_Attestation_Model_Attestation(void)
   if (COM_Receive(&challange, ML_CHALLANGE_SIZE + ML_MODEL_PROOF_SIZE, 10 * RX_TIMEOUT) == HAL_OK)
   {
     printf("Starting the authentication process...\n");
-    model_proof_valid = ML_Attestation_Validate_Model_Proof(pModelProof);
+    model_proof_valid = ML_Attestation_Validate_Model_Proof(ml_model_proof_uid, pModelProof);
     if(model_proof_valid != true)
     {
       (void)printf("\r\nRequest denied.\r\n");
@@ -585,6 +661,154 @@ static void ML_Attestation_Model_Attestation(void)
   }
 }
 
+#if defined(ML_MODEL_HOTSWAP) && (ML_MODEL_HOTSWAP == 1)
+/* Read the header of the model staged in the ITS. */
+static int ML_HotSwap_ReadStagedHeader(ML_StagedModelHeader_t *pHeader)
+{
+  size_t len = 0U;
+
+  if ((psa_its_get(ML_MODEL_STAGING_UID, 0u, sizeof(*pHeader), (void *)pHeader, &len) != PSA_SUCCESS)
+      || (len != sizeof(*pHeader)) || (pHeader->size == 0U) || (pHeader->size > ML_MODEL_SLOT_SIZE)
+      || (pHeader->proof_uid < ML_MODEL_PROOF_REGISTRY_UID)
+      || (pHeader->proof_uid >= ML_MODEL_PROOF_REGISTRY_UID + ML_MODEL_PROOF_REGISTRY_SIZE))
+  {
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ * Read the staged model chunk by chunk and compute its SHA256. The chunks are
+ * copied to pModel if not NULL: the model can be verified without touching
+ * the slot, which may hold the running model.
+ */
+static int ML_HotSwap_ReadStagedModel(uint32_t size, uint8_t *pModel, uint8_t *pHash)
+{
+  uint8_t chunk_data[ML_MODEL_STAGING_CHUNK];
+  mbedtls_sha256_context sha;
+  size_t len = 0U;
+  int res = 0;
+
+  mbedtls_sha256_init(&sha);
+  if (mbedtls_sha256_starts_ret(&sha, 0) != 0)
+  {
+    res = -1;
+  }
+  for (uint32_t pos = 0U, uid = ML_MODEL_STAGING_UID + 1U; (res == 0) && (pos < size); uid++)
+  {
+    size_t chunk = ((size - pos) < ML_MODEL_STAGING_CHUNK) ? (size - pos) : ML_MODEL_STAGING_CHUNK;
+    if ((psa_its_get(uid, 0u, chunk, (void *)chunk_data, &len) != PSA_SUCCESS) || (len != chunk)
+        || (mbedtls_sha256_update_ret(&sha, chunk_data, chunk) != 0))
+    {
+      res = -1;
+      break;
+    }
+    if (pModel != NULL)
+    {
+      memcpy(&pModel[pos], chunk_data, chunk);
+    }
+    pos += chunk;
+  }
+  if ((res == 0) && (mbedtls_sha256_finish_ret(&sha, pHash) != 0))
+  {
+    res = -1;
+  }
+  mbedtls_sha256_free(&sha);
+  return res;
+}
+
+static uint32_t ML_HotSwap_CyclesToUs(uint32_t cycles)
+{
+  return (uint32_t)(((uint64_t)cycles * 1000000U) / SystemCoreClock);
+}
+
+/*
+ * Replace the running model by the one staged in the ITS, without reset.
+ * The staged model is verified first, hashed from the ITS without touching
+ * the slot: its H(w)*G proof must match the one provisioned in the registry
+ * at the UID named by its header, else the current model stays installed.
+ * If a staged model is installed, the model embedded in flash is then
+ * installed again, so that the slot can be loaded with the new one, and the
+ * loaded data must have the verified hash. The swap replaces the instance in
+ * the single arena buffer (MX_X_CUBE_AI_Swap()).
+ */
+static void ML_HotSwap_Model(void)
+{
+  ML_StagedModelHeader_t header = {0U};
+  uint8_t new_hash[ML_HASH_SIZE];
+  uint8_t slot_hash[ML_HASH_SIZE];
+  uint8_t new_proof[ML_MODEL_PROOF_SIZE];
+  uint32_t t_load, t_verify, t_swap;
+  int res;
+
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  t_verify = DWT->CYCCNT;
+  if ((ML_HotSwap_ReadStagedHeader(&header) != 0) ||
+      (ML_HotSwap_ReadStagedModel(header.size, NULL, new_hash) != 0))
+  {
+    (void)printf("\r\nNo staged model.\r\n");
+    return;
+  }
+  if ((ML_Attestation_ComputeModelProof(new_hash, new_proof) != 0) ||
+      (ML_Attestation_Validate_Model_Proof(header.proof_uid, new_proof) != true))
+  {
+    (void)printf("\r\nStaged model rejected, current model is kept.\r\n");
+    return;
+  }
+  t_verify = DWT->CYCCNT - t_verify;
+
+  /* Verified: from here, the current model is replaced */
+  if (ml_model_slot_active)
+  {
+    if (MX_X_CUBE_AI_Swap(g_tflm_network_model_data, ml_flash_hash) != 0)
+    {
+      (void)printf("\r\nFlash model can not be re-installed.\r\n");
+      return;
+    }
+    ml_model_slot_active = false;
+    ml_model_proof_uid = ML_MODEL_PROOF_UID;
+    memcpy(hash, ml_flash_hash, ML_HASH_SIZE);
+    memcpy(R_bytes, ml_flash_proof, ML_MODEL_PROOF_SIZE);
+  }
+
+  t_load = DWT->CYCCNT;
+  if ((ML_HotSwap_ReadStagedModel(header.size, ml_model_slot, slot_hash) != 0) ||
+      (memcmp(slot_hash, new_hash, ML_HASH_SIZE) != 0))
+  {
+    /* Staged model changed since it has been verified */
+    (void)printf("\r\nStaged model can not be loaded, flash model is installed.\r\n");
+    return;
+  }
+  t_load = DWT->CYCCNT - t_load;
+
+  t_swap = DWT->CYCCNT;
+  res = MX_X_CUBE_AI_Swap(ml_model_slot, new_hash);
+  if (res == -1)
+  {
+    (void)printf("\r\nStaged model can not be installed, previous model is re-installed.\r\n");
+    return;
+  }
+  if (res != 0)
+  {
+    (void)printf("\r\nStaged model can not be installed, no model installed.\r\n");
+    return;
+  }
+  t_swap = DWT->CYCCNT - t_swap;
+
+  ml_model_slot_active = true;
+  ml_model_proof_uid = header.proof_uid;
+  memcpy(hash, new_hash, ML_HASH_SIZE);
+  memcpy(R_bytes, new_proof, ML_MODEL_PROOF_SIZE);
+
+  (void)printf("\r\nModel installed (%d bytes)\r\n", (int)header.size);
+  (void)printf("  verify : %lu us\r\n", (unsigned long)ML_HotSwap_CyclesToUs(t_verify));
+  (void)printf("  load   : %lu us\r\n", (unsigned long)ML_HotSwap_CyclesToUs(t_load));
+  (void)printf("  swap   : %lu us\r\n", (unsigned long)ML_HotSwap_CyclesToUs(t_swap));
+}
+#endif /* ML_MODEL_HOTSWAP */
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -156,3 +156,18 @@ void PPP_IRQHandler(void)
 }
 */
 
+#if defined(TFLM_NETWORK_WEIGHTS_IN_OSPI) && (TFLM_NETWORK_WEIGHTS_IN_OSPI == 1)
+extern DMA_HandleTypeDef hdma_ai_stream;
+
+/**
+  * @brief  This function handles GPDMA1 channel 7 interrupt request
+  *         (weights copied from the OctoSPI NOR, see app_x-cube-ai.c).
+  * @param  None
+  * @retval None
+  */
+void GPDMA1_Channel7_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_ai_stream);
+}
+#endif /* TFLM_NETWORK_WEIGHTS_IN_OSPI */
+
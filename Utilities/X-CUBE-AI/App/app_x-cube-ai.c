@@ -40,12 +40,21 @@
 #include "main.h"
 
 /* USER CODE BEGIN includes */
+#include "psa/internal_trusted_storage.h"
+#include "tflm_preproc.h"
+#if defined(TFLM_NETWORK_WEIGHTS_IN_OSPI) && (TFLM_NETWORK_WEIGHTS_IN_OSPI == 1)
+#include "stm32h573i_discovery_ospi.h"
+#endif
 /* USER CODE END includes */
 #include <tflm_c.h>
 
 /* Global handle - used to reference the instantiated model */
 static uint32_t model_hdl = 0;
 
+/* Model which is installed, see MX_X_CUBE_AI_Swap() */
+static const uint8_t *model_data = NULL;
+static uint8_t model_key[TFLM_C_SNAPSHOT_KEY_SIZE];
+
 /* tflm_io_write() is the final callback implementation to implement the DebugLog() function
  * requested by the tflite::MicroErrorReporter object
  */
@@ -64,6 +73,226 @@ int tflm_io_write(const void *buff, uint16_t count)
      return((int)count);
 }
 
+/*
+ * Warm-start: the snapshot of the prepared instance is stored in the ITS
+ * (size in AI_SNAPSHOT_ITS_UID, data in chunks from AI_SNAPSHOT_ITS_UID + 1).
+ * It is bound to the SHA-256 of the model computed at boot (see main.c),
+ * tflm_c_create_from_snapshot() rejects it after a model or firmware update,
+ * it is then re-built and overwritten. Only used for the model embedded in
+ * flash (a model installed by MX_X_CUBE_AI_Swap() is lost at reset).
+ */
+#ifndef AI_SNAPSHOT_ITS_UID
+#define AI_SNAPSHOT_ITS_UID       (0x60U)
+#endif
+#ifndef AI_SNAPSHOT_ITS_CHUNK
+#define AI_SNAPSHOT_ITS_CHUNK     (512U)
+#endif
+#ifndef AI_SNAPSHOT_MAX_SIZE
+#define AI_SNAPSHOT_MAX_SIZE      (4096U)
+#endif
+
+extern unsigned char hash[TFLM_C_SNAPSHOT_KEY_SIZE];
+
+static uint8_t snapshot[AI_SNAPSHOT_MAX_SIZE];
+static int ai_warm_start = 1;
+
+static int ai_snapshot_load(uint32_t *size)
+{
+  size_t len = 0;
+
+  if ((psa_its_get(AI_SNAPSHOT_ITS_UID, 0u, sizeof(*size), (void *)size, &len) != PSA_SUCCESS)
+      || (len != sizeof(*size)) || (*size > sizeof(snapshot)))
+    return -1;
+
+  for (uint32_t pos = 0, uid = AI_SNAPSHOT_ITS_UID + 1; pos < *size; uid++) {
+    size_t chunk = (*size - pos) < AI_SNAPSHOT_ITS_CHUNK ? (*size - pos) : AI_SNAPSHOT_ITS_CHUNK;
+    if ((psa_its_get(uid, 0u, chunk, (void *)&snapshot[pos], &len) != PSA_SUCCESS) || (len != chunk))
+      return -1;
+    pos += chunk;
+  }
+  return 0;
+}
+
+static int ai_snapshot_store(uint32_t size)
+{
+  const psa_storage_create_flags_t flags = PSA_STORAGE_FLAG_NO_CONFIDENTIALITY;
+
+  for (uint32_t pos = 0, uid = AI_SNAPSHOT_ITS_UID + 1; pos < size; uid++) {
+    size_t chunk = (size - pos) < AI_SNAPSHOT_ITS_CHUNK ? (size - pos) : AI_SNAPSHOT_ITS_CHUNK;
+    if (psa_its_set(uid, chunk, (const void *)&snapshot[pos], flags) != PSA_SUCCESS)
+      return -1;
+    pos += chunk;
+  }
+  /* size is written last, a partial snapshot is never loaded */
+  if (psa_its_set(AI_SNAPSHOT_ITS_UID, sizeof(size), (const void *)&size, flags) != PSA_SUCCESS)
+    return -1;
+  return 0;
+}
+
+static TfLiteStatus ai_create_instance(const uint8_t *model, uint8_t *arena_addr,
+    size_t arena_sz, uint32_t *hdl)
+{
+  TfLiteStatus res;
+  uint32_t size = 0;
+
+  if (!ai_warm_start)
+    return tflm_c_create(model, arena_addr, arena_sz, hdl);
+
+  if ((ai_snapshot_load(&size) == 0) &&
+      (tflm_c_create_from_snapshot(model, arena_addr, arena_sz, model_key, snapshot, size,
+          hdl) == kTfLiteOk)) {
+    printf(" Warm-start         : restored (%d bytes)\r\n", (int)size);
+    return kTfLiteOk;
+  }
+
+  res = tflm_c_create(model, arena_addr, arena_sz, hdl);
+  if (res != kTfLiteOk)
+    return res;
+
+  if ((tflm_c_snapshot_save(*hdl, model_key, snapshot, sizeof(snapshot), &size) == kTfLiteOk) &&
+      (ai_snapshot_store(size) == 0))
+    printf(" Warm-start         : snapshot saved (%d bytes)\r\n", (int)size);
+  else
+    printf(" Warm-start         : no snapshot (%d bytes requested)\r\n", (int)size);
+
+  return kTfLiteOk;
+}
+
+#if defined(TFLM_NETWORK_WEIGHTS_IN_OSPI) && (TFLM_NETWORK_WEIGHTS_IN_OSPI == 1)
+/*
+ * Model placed in the OctoSPI NOR flash (.ospi_model section, memory-mapped
+ * at OCTOSPI1_BASE). The weights of each operator are copied by the GPDMA in
+ * a SRAM double buffer, the copy of the next operator overlaps the current
+ * one (see tflm_c_stream_register()). The size of the buffer can be tuned on
+ * host with ml_model/tools/tflm_stream_sim, 40KB: all the weights of the
+ * MNIST model are streamed.
+ * Note: the SRAM is not cached by the DCACHE, no maintenance is requested.
+ */
+#ifndef AI_STREAM_BUFFER_SIZE
+#define AI_STREAM_BUFFER_SIZE     (40U * 1024U)  /* two slots */
+#endif
+#define AI_STREAM_MIN_SIZE        (64U)          /* smaller tensors are read in place */
+#define AI_STREAM_DMA_MAX_BLOCK   (65532U)       /* block size (BNDT), multiple of a word */
+#define AI_OSPI_INSTANCE          (0U)
+#define AI_OSPI_SIZE              (64U * 1024U * 1024U)
+
+DMA_HandleTypeDef hdma_ai_stream;
+
+__ALIGNED(16) static uint8_t stream_buffer[AI_STREAM_BUFFER_SIZE];
+static struct tflm_c_stream_options stream_options;
+
+static const struct tflm_c_stream_copy *stream_copies;
+static uint32_t stream_n_copies;
+static uint32_t stream_idx;          /* copy in progress */
+static uint32_t stream_offset;       /* offset in the copy in progress */
+static uint32_t stream_block;        /* size of the DMA block in progress */
+static volatile int stream_status;   /* 1: in progress, 0: done, -1: error */
+
+/* part of a copy done by the DMA (word aligned), the rest is done by the CPU */
+static uint32_t ai_stream_dma_size(const struct tflm_c_stream_copy *copy)
+{
+  if (((uint32_t)copy->src | (uint32_t)copy->dst) & 3U)
+    return 0;
+  return copy->size & ~3U;
+}
+
+static void ai_stream_dma_next(void)
+{
+  while ((stream_idx < stream_n_copies) &&
+         (stream_offset >= ai_stream_dma_size(&stream_copies[stream_idx]))) {
+    stream_idx++;
+    stream_offset = 0;
+  }
+  if (stream_idx == stream_n_copies) {
+    stream_status = 0;
+    return;
+  }
+
+  const struct tflm_c_stream_copy *copy = &stream_copies[stream_idx];
+  stream_block = ai_stream_dma_size(copy) - stream_offset;
+  if (stream_block > AI_STREAM_DMA_MAX_BLOCK)
+    stream_block = AI_STREAM_DMA_MAX_BLOCK;
+
+  if (HAL_DMA_Start_IT(&hdma_ai_stream, (uint32_t)copy->src + stream_offset,
+      (uint32_t)copy->dst + stream_offset, stream_block) != HAL_OK)
+    stream_status = -1;
+}
+
+/* called in the IRQ handler, the DMA is ready: the next block is chained */
+static void ai_stream_dma_cplt(DMA_HandleTypeDef *hdma)
+{
+  (void)hdma;
+  stream_offset += stream_block;
+  ai_stream_dma_next();
+}
+
+static void ai_stream_dma_error(DMA_HandleTypeDef *hdma)
+{
+  (void)hdma;
+  stream_status = -1;
+}
+
+static int ai_stream_start(const void *cookie, const struct tflm_c_stream_copy *copies,
+    uint32_t n_copies)
+{
+  (void)cookie;
+
+  /* misaligned copies and tails (a few bytes) */
+  for (uint32_t i = 0; i < n_copies; i++) {
+    uint32_t done = ai_stream_dma_size(&copies[i]);
+    if (done < copies[i].size)
+      memcpy((uint8_t *)copies[i].dst + done, (const uint8_t *)copies[i].src + done,
+          copies[i].size - done);
+  }
+
+  stream_copies = copies;
+  stream_n_copies = n_copies;
+  stream_idx = 0;
+  stream_offset = 0;
+  stream_status = 1;
+  ai_stream_dma_next();
+  return stream_status < 0 ? -1 : 0;
+}
+
+static int ai_stream_wait(const void *cookie)
+{
+  (void)cookie;
+  while (stream_status > 0) {
+  }
+  return stream_status;
+}
+
+static void ai_stream_register(uint32_t hdl, int verbose)
+{
+  struct tflm_c_stream_info info;
+
+  stream_options.ext_base = (const uint8_t *)OCTOSPI1_BASE;
+  stream_options.ext_size = AI_OSPI_SIZE;
+  stream_options.min_size = AI_STREAM_MIN_SIZE;
+  stream_options.buffer = stream_buffer;
+  stream_options.buffer_size = sizeof(stream_buffer);
+  stream_options.start = ai_stream_start;
+  stream_options.wait = ai_stream_wait;
+  stream_options.cookie = NULL;
+
+  if ((tflm_c_stream_register(hdl, &stream_options) != kTfLiteOk) ||
+      (tflm_c_stream_info(hdl, &info) != kTfLiteOk)) {
+    printf(" Weight streaming   : not available, weights read in place\r\n");
+    return;
+  }
+  if (verbose)
+    printf(" Weight streaming   : %d tensor(s), %d in place, %d bytes/invoke (slot %d bytes)\r\n",
+        (int)info.n_streamed, (int)(info.n_in_place + info.n_small),
+        (int)info.bytes_per_invoke, (int)info.slot_size);
+}
+#else
+static void ai_stream_register(uint32_t hdl, int verbose)
+{
+  (void)hdl;
+  (void)verbose;
+}
+#endif /* TFLM_NETWORK_WEIGHTS_IN_OSPI */
+
 static int ai_boostrap(const uint8_t *model, uint8_t *arena_addr,
     size_t arena_sz)
 {
@@ -74,12 +303,14 @@ static int ai_boostrap(const uint8_t *model, uint8_t *arena_addr,
   printf("\r\nInstancing the network (TFLM)..\r\n");
   /* USER CODE END 1 */
 
-  res = tflm_c_create(model, (uint8_t*)arena_addr, arena_sz, &model_hdl);
+  res = ai_create_instance(model, (uint8_t*)arena_addr, arena_sz, &model_hdl);
 
   if (res != kTfLiteOk) {
     return -1;
   }
 
+  ai_stream_register(model_hdl, 1);
+
   /* USER CODE BEGIN 2 */
 
   /* Report the main model info */
@@ -96,6 +327,9 @@ static int ai_boostrap(const uint8_t *model, uint8_t *arena_addr,
   printf(" Allocated size     : %d / %d\r\n", (int)tflm_c_arena_used_bytes(model_hdl),
       (int)arena_sz);
 
+  /* Report if the memory plan has been pre-computed off-line (model metadata) */
+  printf(" Offline planned    : %d tensor(s)\r\n", (int)tflm_c_offline_planned_tensors(model_hdl));
+
   /* Report the description of the IO tensors */
 
   size_io = tflm_c_inputs_size(model_hdl);
@@ -136,17 +370,75 @@ static int ai_boostrap(const uint8_t *model, uint8_t *arena_addr,
 }
 
 /* USER CODE BEGIN 3 */
+#define AI_INPUT_THRESHOLD  (32U)   /* pixels of the digit, see tflm_pp_bounding_box() */
+#define AI_INPUT_FIT        (20U)   /* MNIST: digit in a 20x20 box, centered */
+#define AI_OUTPUT_TOPK      (3U)    /* classes reported, see tflm_c_topk_enable() */
+
+/* Frame to classify (8-bit grayscale, e.g. digit drawn on the touch screen),
+ * set by the producer. The digit is resized, centered and quantized in the
+ * input tensor in one pass (see tflm_preproc.h).
+ */
+const struct tflm_pp_image *ai_input_frame = NULL;
+static struct tflm_pp_quant ai_input_quant;
+static struct tflm_c_tensor_info ai_input_info;
+
+/* IO buffers (index=0) of the installed instance, see ai_bind_io() */
+static uint8_t *ai_in_data = NULL;
+static uint8_t *ai_out_data = NULL;
+
 int acquire_and_process_data(void* data)
 {
 	printf("Fill the inputs..\r\n");
+	if (ai_input_frame)
+		(void)tflm_pp_mnist(&ai_input_quant, ai_input_frame, AI_INPUT_THRESHOLD,
+				(int8_t *)data, ai_input_info.width, ai_input_info.height, AI_INPUT_FIT);
 	return 0;
 }
 
 int post_process(void * data)
 {
+	struct tflm_c_topk_result topk;
+
+	(void)data;
 	printf("Process the outputs..\r\n");
+	if (tflm_c_topk(model_hdl, &topk) != kTfLiteOk)
+		return 0;
+	printf(" class %d (logit %d)", (int)topk.index[0], (int)topk.logit[0]);
+	for (uint32_t i = 1; i < topk.k; i++)
+		printf(", %d (%d)", (int)topk.index[i], (int)topk.logit[i]);
+	printf("\r\n");
 	return 0;
 }
+
+/* Retrieves the IO buffers of the installed instance and enables its top-k
+ * head. Called again each time an instance is created (MX_X_CUBE_AI_Swap()):
+ * the buffers of a destroyed instance are not valid anymore.
+ */
+static void ai_bind_io(void)
+{
+  struct tflm_c_tensor_info info;
+
+  ai_in_data = NULL;
+  ai_out_data = NULL;
+  if (!model_hdl)
+    return;
+
+  tflm_c_input(model_hdl, 0, &info);
+  ai_in_data = (uint8_t *)info.data;
+  ai_input_info = info;
+  /* input normalisation folded in the model (tflm_fold_input): raw pixels */
+  if ((info.scale == 1.0f) && (info.zero_point == -128))
+    (void)tflm_pp_quant_init(&ai_input_quant, 1.0f, 1.0f, -128, 0);
+  else
+    (void)tflm_pp_quant_init(&ai_input_quant, 1.0f / 255.0f, info.scale, info.zero_point, 0);
+
+  tflm_c_output(model_hdl, 0, &info);
+  ai_out_data = (uint8_t *)info.data;
+
+  /* classes selected on the logits, the trailing softmax is skipped */
+  if (tflm_c_topk_enable(model_hdl, AI_OUTPUT_TOPK) != kTfLiteOk)
+    printf("W: top-k head not available (int8 classifier output expected)\r\n");
+}
 /* USER CODE END 3 */
 
 /* USER CODE BEGIN 4 */
@@ -209,56 +501,138 @@ void MX_X_CUBE_AI_Init(void)
 
   printf("\r\nTEMPLATE - initialization\r\n");
 
+  memcpy(model_key, hash, sizeof(model_key));
   res = ai_boostrap(BIN_ADDRESS, tensor_arena, ARENA_SIZE);
   if (res) {
     printf("E: unable to instantiate the embedded image of the TFLite model/file..\n\r");
     return;
   }
+  model_data = BIN_ADDRESS;
+  ai_bind_io();
     /* USER CODE END 5 */
 }
 
 void MX_X_CUBE_AI_Process(void)
 {
     /* USER CODE BEGIN 6 */
-      volatile int res = -1;
+  volatile int res = -1;
+
+  /* One inference per call: the application (main menu) keeps control
+   * between two inferences, e.g. to install another model */
+  printf("TEMPLATE TFLM - run\r\n");
+
+  if (model_hdl && ai_in_data && ai_out_data) {
+    /* 1 - acquire and pre-process input data */
+    res = acquire_and_process_data(ai_in_data);
+    /* 2 - process the data - call inference engine */
+    if (res == 0) {
+      if (tflm_c_invoke(model_hdl) != kTfLiteOk) {
+        res = -1;
+      }
+    }
+    /* 3- post-process the predictions */
+    if (res == 0)
+      res = post_process(ai_out_data);
+  }
 
-  uint8_t *in_data = NULL;
-  uint8_t *out_data = NULL;
+  if (res) {
+    printf("E: unable to use the TFLite model..\n\r");
+  }
+    /* USER CODE END 6 */
+}
 
-  printf("TEMPLATE TFLM - run - main loop\r\n");
+/* USER CODE BEGIN 7 */
+/*
+ * Installs a new model (already verified by the caller) in place of the
+ * current one, without reset. There is a single arena buffer: the current
+ * instance is destroyed first, then the new one is created in the same
+ * buffer, no model is installed in between. The model buffer must stay valid
+ * while it is installed. Returns 0 if the new model is installed, -1 if it
+ * can not be instantiated (arena size, operators not supported by the
+ * resolver..) and the previous model has been installed again, -2 if the
+ * previous model can not be installed again either (no model installed).
+ */
+int MX_X_CUBE_AI_Swap(const uint8_t *model, const uint8_t *key)
+{
+  uint8_t prev_key[TFLM_C_SNAPSHOT_KEY_SIZE];
+  const uint8_t *prev_model = model_data;
 
+  memcpy(prev_key, model_key, sizeof(prev_key));
   if (model_hdl) {
+    tflm_c_destroy(model_hdl);
+    model_hdl = 0;
+  }
 
-    /* 1 - Retrieve the addresses of the IO buffers (index=0) */
-    struct tflm_c_tensor_info info;
+  ai_warm_start = 0;
+  memcpy(model_key, key, sizeof(model_key));
+  if (ai_create_instance(model, tensor_arena, ARENA_SIZE, &model_hdl) == kTfLiteOk) {
+    ai_stream_register(model_hdl, 0);
+    model_data = model;
+    ai_bind_io();
+    return 0;
+  }
 
-    tflm_c_input(model_hdl, 0, &info);
-    in_data = (uint8_t *)info.data;
+  printf("E: unable to instantiate the new model, previous model is re-installed..\r\n");
+  memcpy(model_key, prev_key, sizeof(model_key));
+  if (model_hdl) {
+    tflm_c_destroy(model_hdl);
+    model_hdl = 0;
+  }
+  if (!prev_model || (ai_create_instance(prev_model, tensor_arena, ARENA_SIZE, &model_hdl) != kTfLiteOk)) {
+    printf("E: unable to re-install the previous model, no model installed..\r\n");
+    model_hdl = 0;
+    model_data = NULL;
+    ai_bind_io();
+    return -2;
+  }
+  ai_stream_register(model_hdl, 0);
+  ai_bind_io();
+  return -1;
+}
 
-    tflm_c_output(model_hdl, 0, &info);
-    out_data = (uint8_t *)info.data;
+/*
+ * Initializes the external memory holding the model, before any access to
+ * the model (hash computed at boot..), 0 if ok. Nothing is done if the model
+ * is in the internal flash.
+ */
+int MX_X_CUBE_AI_ExtMemInit(void)
+{
+#if defined(TFLM_NETWORK_WEIGHTS_IN_OSPI) && (TFLM_NETWORK_WEIGHTS_IN_OSPI == 1)
+  BSP_OSPI_NOR_Init_t init;
 
-    /* 2 - main loop */
-    do {
-      /* 1 - acquire and pre-process input data */
-      res = acquire_and_process_data(in_data);
-      /* 2 - process the data - call inference engine */
-      if (res == 0) {
-        if (tflm_c_invoke(model_hdl) != kTfLiteOk) {
-          res = -1;
-        }
-      }
-      /* 3- post-process the predictions */
-      if (res == 0)
-        res = post_process(out_data);
-    } while (res==0);
-  }
+  init.InterfaceMode = BSP_OSPI_NOR_OPI_MODE;
+  init.TransferRate = BSP_OSPI_NOR_DTR_TRANSFER;
+  if ((BSP_OSPI_NOR_Init(AI_OSPI_INSTANCE, &init) != BSP_ERROR_NONE) ||
+      (BSP_OSPI_NOR_EnableMemoryMappedMode(AI_OSPI_INSTANCE) != BSP_ERROR_NONE))
+    return -1;
 
-  if (res) {
-    printf("E: unable to use the TFLite model..\n\r");
-  }
-    /* USER CODE END 6 */
+  /* GPDMA1 channel 7: memory-to-memory, memory-mapped window -> SRAM */
+  __HAL_RCC_GPDMA1_CLK_ENABLE();
+  hdma_ai_stream.Instance = GPDMA1_Channel7;
+  hdma_ai_stream.Init.Request = DMA_REQUEST_SW;
+  hdma_ai_stream.Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+  hdma_ai_stream.Init.Direction = DMA_MEMORY_TO_MEMORY;
+  hdma_ai_stream.Init.SrcInc = DMA_SINC_INCREMENTED;
+  hdma_ai_stream.Init.DestInc = DMA_DINC_INCREMENTED;
+  hdma_ai_stream.Init.SrcDataWidth = DMA_SRC_DATAWIDTH_WORD;
+  hdma_ai_stream.Init.DestDataWidth = DMA_DEST_DATAWIDTH_WORD;
+  hdma_ai_stream.Init.Priority = DMA_LOW_PRIORITY_HIGH_WEIGHT;
+  hdma_ai_stream.Init.SrcBurstLength = 1;
+  hdma_ai_stream.Init.DestBurstLength = 1;
+  hdma_ai_stream.Init.TransferAllocatedPort = DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT1;
+  hdma_ai_stream.Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+  hdma_ai_stream.Init.Mode = DMA_NORMAL;
+  if (HAL_DMA_Init(&hdma_ai_stream) != HAL_OK)
+    return -1;
+  hdma_ai_stream.XferCpltCallback = ai_stream_dma_cplt;
+  hdma_ai_stream.XferErrorCallback = ai_stream_dma_error;
+
+  HAL_NVIC_SetPriority(GPDMA1_Channel7_IRQn, 6, 0);
+  HAL_NVIC_EnableIRQ(GPDMA1_Channel7_IRQn);
+#endif /* TFLM_NETWORK_WEIGHTS_IN_OSPI */
+  return 0;
 }
+/* USER CODE END 7 */
 #ifdef __cplusplus
 }
 #endif
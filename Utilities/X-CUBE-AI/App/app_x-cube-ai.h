@@ -27,6 +27,10 @@ extern "C" {
 void MX_X_CUBE_AI_Init(void);
 void MX_X_CUBE_AI_Process(void);
 /* USER CODE BEGIN includes */
+#include <stdint.h>
+
+int MX_X_CUBE_AI_Swap(const uint8_t *model, const uint8_t *key);
+int MX_X_CUBE_AI_ExtMemInit(void);
 /* USER CODE END includes */
 #ifdef __cplusplus
 }
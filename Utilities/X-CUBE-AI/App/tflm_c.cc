@@ -21,10 +21,13 @@
  *
  * Notes: (implementation consideration)
  * - when an instance of the interpreter is created, a context object (~300 Bytes)
- *   is created, dynamically allocated (see tflm_c_create() fct).
- *   This allocation is done, through the new C++ operator. To be able to
- *   monitor the usage of the heap, new operator is expected to be
- *   based on the C-malloc/free functions.
+ *   is created at the head of the arena buffer (see tflm_c_create() fct), the
+ *   TFLM allocator uses the remaining part. No heap is used.
+ * - warm-start snapshot: the context object and the persistent part of the
+ *   arena (tail) fully describe a prepared instance. They are saved with a
+ *   relocation map (words which are pointers into the arena), the snapshot
+ *   can be restored in another arena buffer without re-preparing the model
+ *   (see tflm_c_snapshot_save()/tflm_c_create_from_snapshot()).
  */
 
 #include "tensorflow/lite/micro/all_ops_resolver.h"
@@ -34,9 +37,13 @@
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_context.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
 #include "tensorflow/lite/micro//memory_helpers.h"
 #include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/best_fit_memory_planner.h"
+#include "tensorflow/lite/micro/arena_allocator/single_arena_buffer_allocator.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
 
 // #include "tensorflow/lite/version.h"
 // Version is forced here, because current tflite-micro github is not tagged
@@ -47,28 +54,134 @@
 
 #include <tflm_c.h>
 
-// if (=0), resolver is created with all built-in operators
+#if defined(__linux__)
+#include <link.h>  /* dl_iterate_phdr(), host builds */
+#endif
+
+// if (=0), resolver is created with the operators of the model (generated
+// tflm_network_ops.h), else with all built-in operators
 #if !defined(TFLM_RUNTIME_USE_ALL_OPERATORS)
 #define TFLM_RUNTIME_USE_ALL_OPERATORS 1
 #endif
 
+#if TFLM_RUNTIME_USE_ALL_OPERATORS == 0
+#include "tflm_network_ops.h"
+#endif
+
 // forward declaration
 class CTfLiteInterpreterContext;
 
+// MicroInterpreter with an access to the evaluation tensors (weight streaming)
+class CTfLiteMicroInterpreter : public tflite::MicroInterpreter {
+public:
+  using tflite::MicroInterpreter::MicroInterpreter;
+
+  TfLiteEvalTensor* eval_tensor(int tensor_idx) {
+    TfLiteContext* context = const_cast<TfLiteContext*>(&this->context());
+    return context->GetEvalTensor(context, tensor_idx);
+  }
+
+  tflite::NodeAndRegistration* node_and_registration(int node_idx) {
+    tflite::MicroGraph& graph = tflite::GetMicroContext(&this->context())->graph();
+    return &graph.GetAllocations()[0].node_and_registrations[node_idx];
+  }
+
+  /* to call after the registration of a node is replaced */
+  TfLiteStatus update_dispatch_tables() {
+    return tflite::GetMicroContext(&this->context())->graph().BuildDispatchTables();
+  }
+};
+
+#if !defined(TFLM_C_STREAM_MAX_COPIES)
+#define TFLM_C_STREAM_MAX_COPIES 4  /* streamed constant inputs per operator */
+#endif
+
+/*
+ * Weight streaming: the schedule (one entry per streamed constant input of
+ * each operator) is built by register_cb(). The operators with streamed
+ * weights use the two slots alternately. Before such an operator (profiler
+ * hook), begin_node() waits the copy of its weights, starts the copy of the
+ * weights of the next one in the other slot and redirects the evaluation
+ * tensors to the slot; end_node() restores them. The operators without
+ * streamed weights do not wait, the copy in progress continues.
+ */
+class CTfLiteWeightStream {
+public:
+  CTfLiteWeightStream(const tflite::Model* model, CTfLiteMicroInterpreter* interp) :
+    model_(model), interp_(interp), options_(nullptr), pending_(false) {}
+
+  bool active() const { return options_ != nullptr; }
+
+  struct tflm_c_stream_options* options() { return options_; }
+
+  TfLiteStatus register_cb(struct tflm_c_stream_options* options,
+      tflite::SingleArenaBufferAllocator* allocator);
+
+  TfLiteStatus info(struct tflm_c_stream_info* p_info) {
+    if (!p_info || !options_)
+      return kTfLiteError;
+    *p_info = info_;
+    return kTfLiteOk;
+  }
+
+  void start();
+  void begin_node();
+  void end_node();
+
+private:
+  struct Entry {
+    TfLiteEvalTensor* tensor;
+    void* src;          /* data in the external memory */
+    uint32_t offset;    /* in the slot */
+    uint32_t size;
+  };
+
+  bool is_external(const void* data) const {
+    return ((const uint8_t*)data >= options_->ext_base) &&
+        ((const uint8_t*)data < options_->ext_base + options_->ext_size);
+  }
+
+  int32_t next_streamed(int32_t node);
+  void prefetch(int32_t node, int slot);
+  void redirect(int32_t node, uint8_t* dst);
+
+  const tflite::Model* model_;
+  CTfLiteMicroInterpreter* interp_;
+  struct tflm_c_stream_options* options_;
+  uint8_t* buffer_;
+  Entry* entries_;
+  uint16_t* first_;     /* entries of the node i: [first_[i], first_[i + 1]) */
+  int32_t n_nodes_;
+  int32_t node_;        /* current operator */
+  int32_t active_node_; /* operator using a slot, -1 if none */
+  int32_t fetch_node_;  /* operator of the last copy started (n_nodes_: none) */
+  int fetch_slot_;
+  bool fetch_ok_;
+  bool pending_;        /* copy started, not waited */
+  struct tflm_c_stream_copy copies_[TFLM_C_STREAM_MAX_COPIES];
+  struct tflm_c_stream_info info_;
+};
+
 class CTfLiteProfiler : public tflite::MicroProfilerInterface {
 public:
-  CTfLiteProfiler(CTfLiteInterpreterContext* interp) : ctx_(interp), options_(nullptr),
-    event_starts_(0), event_ends_(0) {}
+  CTfLiteProfiler(CTfLiteInterpreterContext* interp, CTfLiteWeightStream* stream) :
+    ctx_(interp), stream_(stream), options_(nullptr), event_starts_(0), event_ends_(0) {}
   ~CTfLiteProfiler() override = default;
 
+  /* called before/after each operator, the time to wait the weights is part
+   * of the duration of the operator */
   uint32_t BeginEvent(const char* tag) override {
+    uint32_t res = 0;
     if (options_)
-      return begin_event(tag);
-    else
-      return 0;
+      res = begin_event(tag);
+    if (stream_->active())
+      stream_->begin_node();
+    return res;
   }
 
   void EndEvent(uint32_t event_handle) override {
+    if (stream_->active())
+      stream_->end_node();
     if (options_)
       end_event(event_handle);
   }
@@ -82,6 +195,8 @@ public:
     return kTfLiteOk;
   }
 
+  struct tflm_c_observer_options* options() { return options_; }
+
   TfLiteStatus unregister_cb(struct tflm_c_observer_options* options) {
     if (options_ == options) {
       options_ = nullptr;
@@ -125,6 +240,7 @@ protected:
 
 private:
   CTfLiteInterpreterContext* ctx_;
+  CTfLiteWeightStream* stream_;
   struct tflm_c_observer_options* options_;
   int event_starts_;
   int event_ends_;
@@ -137,82 +253,216 @@ private:
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
+/*
+ * Top-k classification head: selects the k largest int8 logits (highest
+ * first, lowest index first for equal values). If the model ends with an
+ * int8 SOFTMAX producing output 0, the registration of the node is replaced
+ * by the head (the softmax input is the logits, node->user_data points to
+ * the head while it is replaced), else the head runs on output 0 after the
+ * operators (eval()).
+ */
+class CTfLiteTopK {
+public:
+  CTfLiteTopK(const tflite::Model* model, CTfLiteMicroInterpreter* interp): model_(model),
+      interp_(interp), node_(nullptr), registration_(nullptr), user_data_(nullptr),
+      k_(0), logits_(-1) {
+    memset(&result_, 0, sizeof(result_));
+  }
+
+  uint32_t k() const { return k_; }
+
+  TfLiteStatus enable(uint32_t k);
+  void start() { result_.k = 0; }
+  TfLiteStatus eval() {
+    return (k_ && !node_) ? select(interp_->eval_tensor(logits_)) : kTfLiteOk;
+  }
+  TfLiteStatus result(struct tflm_c_topk_result* result);
+
+private:
+  static TfLiteStatus invoke_fused(TfLiteContext* context, TfLiteNode* node);
+  static const TfLiteRegistration_V1 registration;
+
+  void restore();
+  TfLiteStatus select(const TfLiteEvalTensor* logits);
+
+  const tflite::Model* model_;
+  CTfLiteMicroInterpreter* interp_;
+  tflite::NodeAndRegistration* node_;          /* replaced SOFTMAX node */
+  const TfLiteRegistration_V1* registration_;  /* and its registration/data */
+  void* user_data_;
+  uint32_t k_;
+  int32_t logits_;                             /* tensor index */
+  struct tflm_c_topk_result result_;
+};
+
 class CTfLiteInterpreterContext {
 public:
   CTfLiteInterpreterContext(const tflite::Model* model,
       const tflite::MicroOpResolver& op_resolver,
-      uint8_t* tensor_arena, size_t tensor_arena_size): model_(model), profiler(this),
-          interpreter(model, op_resolver, tensor_arena, tensor_arena_size,
-              nullptr, (tflite::MicroProfilerInterface *)&profiler),
-          n_invoks(0) {}
+      uint8_t* tensor_arena, size_t tensor_arena_size, uint32_t planner_kind): model_(model),
+          stream(model, &interpreter), profiler(this, &stream), topk(model, &interpreter),
+          arena_allocator(tflite::SingleArenaBufferAllocator::Create(tensor_arena,
+              tensor_arena_size)),
+          interpreter(model, op_resolver, create_allocator(arena_allocator, planner_kind)),
+          n_invoks(0), arena(nullptr), arena_size(0), planner(planner_kind), io_arena(nullptr) {}
 
 public:
   const tflite::Model *model_;
+  CTfLiteWeightStream stream;
   CTfLiteProfiler profiler;
-  tflite::MicroInterpreter interpreter;
+  CTfLiteTopK topk;
+  tflite::SingleArenaBufferAllocator* arena_allocator;
+  CTfLiteMicroInterpreter interpreter;
   int n_invoks;
+  uint8_t* arena;     /* arena buffer provided by the application */
+  size_t arena_size;
+  uint32_t planner;   /* TFLM_C_PLANNER_xx */
+  void** io_arena;    /* planned location of the inputs then the outputs (first binding) */
 
 public:
   static TfLiteStatus input(const uint32_t hdl, int32_t index, struct tflm_c_tensor_info* t_info) {
-    CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
     const TfLiteTensor* tens = ctx->interpreter.input(index);
     return ctx->tflitetensor_to(tens, t_info, -1);
   }
 
   static TfLiteStatus output(const uint32_t hdl, int32_t index, struct tflm_c_tensor_info* t_info) {
-    CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
     const TfLiteTensor* tens = ctx->interpreter.output(index);
     return ctx->tflitetensor_to(tens, t_info, -1);
   }
 
+  static TfLiteStatus bind(const uint32_t hdl, bool is_output, int32_t index, void* data) {
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
+    if (!ctx)
+      return kTfLiteError;
+    const size_t n_inputs = ctx->interpreter.inputs_size();
+    const size_t n_outputs = ctx->interpreter.outputs_size();
+    if ((index < 0) || ((size_t)index >= (is_output ? n_outputs : n_inputs)) ||
+        ((uintptr_t)data % tflite::MicroArenaBufferAlignment()))
+      return kTfLiteError;
+
+    if (!ctx->io_arena) {
+      ctx->io_arena = reinterpret_cast<void**>(ctx->arena_allocator->AllocatePersistentBuffer(
+          sizeof(void*) * (n_inputs + n_outputs), alignof(void*)));
+      if (!ctx->io_arena)
+        return kTfLiteError;
+      for (size_t i = 0; i < n_inputs; i++)
+        ctx->io_arena[i] = ctx->interpreter.input(i)->data.data;
+      for (size_t i = 0; i < n_outputs; i++)
+        ctx->io_arena[n_inputs + i] = ctx->interpreter.output(i)->data.data;
+    }
+
+    /* the kernels use the evaluation tensor, tflm_c_input()/tflm_c_output()
+     * report the TfLiteTensor */
+    TfLiteTensor* tens = is_output ? ctx->interpreter.output(index) : ctx->interpreter.input(index);
+    const int32_t tensor_idx = is_output ? ctx->interpreter.outputs().Get(index)
+        : ctx->interpreter.inputs().Get(index);
+    void* ptr = data ? data : ctx->io_arena[is_output ? n_inputs + index : index];
+    tens->data.data = ptr;
+    ctx->interpreter.eval_tensor(tensor_idx)->data.data = ptr;
+    return kTfLiteOk;
+  }
+
   static TfLiteStatus invoke(const uint32_t hdl) {
-    CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
     ctx->profiler.reset();
     ctx->n_invoks++;
-    return ctx->interpreter.Invoke();
+    if (ctx->stream.active())
+      ctx->stream.start();
+    ctx->topk.start();
+    /* the profiler hooks are only called with an observer or a stream */
+    ctx->interpreter.SetProfiler((ctx->profiler.options() || ctx->stream.active()) ?
+        (tflite::MicroProfilerInterface *)&ctx->profiler : nullptr);
+    TfLiteStatus status = ctx->interpreter.Invoke();
+    if (status != kTfLiteOk)
+      return status;
+    return ctx->topk.eval();
   }
 
   static TfLiteStatus reset_all_variables(const uint32_t hdl) {
-    CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
     ctx->profiler.reset();
     return ctx->interpreter.Reset();
   }
 
   static TfLiteStatus observer_register(const uint32_t hdl, struct tflm_c_observer_options* options)
   {
-    CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
     return ctx->profiler.register_cb(options);
   }
 
   static TfLiteStatus observer_unregister(const uint32_t hdl, struct tflm_c_observer_options* options)
   {
-    CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
     return ctx->profiler.unregister_cb(options);
   }
 
   static TfLiteStatus observer_start(const uint32_t hdl)
   {
-    CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
     ctx->n_invoks = 0;
     return ctx->profiler.start();
  }
 
   static TfLiteStatus observer_info(const uint32_t hdl, struct tflm_c_profile_info* p_info)
   {
-    CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
     TfLiteStatus res = ctx->profiler.info(p_info);
     if (res == kTfLiteOk)
       p_info->n_invoks = ctx->n_invoks;
     return res;
   }
 
-  uint32_t get_handle() {
-    return (uint32_t)this;
+  static TfLiteStatus stream_register(const uint32_t hdl, struct tflm_c_stream_options* options)
+  {
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
+    return ctx->stream.register_cb(options, ctx->arena_allocator);
+  }
+
+  static TfLiteStatus stream_info(const uint32_t hdl, struct tflm_c_stream_info* p_info)
+  {
+    CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
+    return ctx->stream.info(p_info);
   }
 
+  static CTfLiteInterpreterContext* from_handle(const uint32_t hdl);
+
+  static CTfLiteInterpreterContext* create(const tflite::Model* model,
+      uint8_t* tensor_arena, size_t tensor_arena_size, uint32_t planner_kind);
+
+  void destroy() { this->~CTfLiteInterpreterContext(); }
+
+  uint32_t get_handle();
+
+  void release_handle();
+
 private:
   TfLiteStatus tflitetensor_to(const TfLiteTensor* tfls, struct tflm_c_tensor_info* t_info, int32_t idx=-1);
 
+  /* same set-up as tflite::MicroAllocator::Create(tensor_arena, arena_size),
+   * with the requested memory planner */
+  static tflite::MicroAllocator* create_allocator(tflite::SingleArenaBufferAllocator* memory_allocator,
+      uint32_t planner_kind) {
+    tflite::MicroMemoryPlanner* planner;
+    const bool scratch_pool = (planner_kind & TFLM_C_PLANNER_SCRATCH_POOL) != 0;
+    planner_kind &= TFLM_C_PLANNER_MASK;
+    if (planner_kind == TFLM_C_PLANNER_GREEDY) {
+      uint8_t* planner_buffer = memory_allocator->AllocatePersistentBuffer(
+          sizeof(tflite::GreedyMemoryPlanner), alignof(tflite::GreedyMemoryPlanner));
+      planner = new (planner_buffer) tflite::GreedyMemoryPlanner();
+    } else {
+      uint8_t* planner_buffer = memory_allocator->AllocatePersistentBuffer(
+          sizeof(tflite::BestFitMemoryPlanner), alignof(tflite::BestFitMemoryPlanner));
+      planner = new (planner_buffer) tflite::BestFitMemoryPlanner(
+          (planner_kind == TFLM_C_PLANNER_SEARCH) ? TFLM_C_PLANNER_ORDERINGS : 1);
+    }
+    tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(memory_allocator, planner);
+    if (allocator)
+      allocator->SetScratchPool(scratch_pool);
+    return allocator;
+  }
+
 protected:
  friend class CTfLiteProfiler;
 };
@@ -286,8 +536,555 @@ TfLiteStatus CTfLiteInterpreterContext::tflitetensor_to(const TfLiteTensor* tft,
   return kTfLiteOk;
 }
 
+TfLiteStatus CTfLiteWeightStream::register_cb(struct tflm_c_stream_options* options,
+    tflite::SingleArenaBufferAllocator* allocator)
+{
+#if defined(TF_LITE_STRIP_ERROR_STRINGS)
+  /* no profiler hook around the operators, see MicroGraph::InvokeSubgraph() */
+  return kTfLiteError;
+#endif
+  if (options_ || !options || !options->start || !options->wait || !options->buffer ||
+      !options->ext_base || !options->ext_size || (model_->subgraphs()->size() != 1))
+    return kTfLiteError;
+
+  const size_t align = tflite::MicroArenaBufferAlignment();
+  uint8_t* buffer = tflite::AlignPointerUp(options->buffer, align);
+  uint8_t* end = options->buffer + options->buffer_size;
+  if (buffer >= end)
+    return kTfLiteError;
+  const size_t slot_size = ((size_t)(end - buffer) / 2) & ~(align - 1);
+  if (!slot_size)
+    return kTfLiteError;
+
+  const tflite::SubGraph* subgraph = model_->subgraphs()->Get(0);
+  const int32_t n_nodes = subgraph->operators()->size();
+
+  options_ = options;  /* is_external() */
+  memset(&info_, 0, sizeof(info_));
+  info_.slot_size = slot_size;
+
+  /* first pass: size of the schedule, second pass: schedule */
+  size_t n = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    n = 0;
+    for (int32_t i = 0; i < n_nodes; i++) {
+      const flatbuffers::Vector<int32_t>* inputs = subgraph->operators()->Get(i)->inputs();
+      size_t offset = 0;
+      int n_copies = 0;
+      if (pass)
+        first_[i] = n;
+      for (size_t j = 0; inputs && j < inputs->size(); j++) {
+        const int32_t idx = inputs->Get(j);
+        bool duplicated = false;
+        for (size_t k = 0; k < j; k++)
+          duplicated |= (inputs->Get(k) == idx);
+        if (idx < 0 || duplicated)
+          continue;
+        TfLiteEvalTensor* tensor = interp_->eval_tensor(idx);
+        const tflite::Buffer* fb = model_->buffers()->Get(subgraph->tensors()->Get(idx)->buffer());
+        if (!tensor->data.data || !is_external(tensor->data.data) || !fb->data())
+          continue;
+        /* stored size (compressed weights are copied compressed) */
+        const size_t size = fb->data()->size();
+        const size_t aligned = tflite::AlignSizeUp(size, align);
+        if (size < options->min_size) {
+          if (!pass)
+            info_.n_small++;
+          continue;
+        }
+        if ((n_copies == TFLM_C_STREAM_MAX_COPIES) || (offset + aligned > slot_size)) {
+          if (!pass)
+            info_.n_in_place++;
+          continue;
+        }
+        if (pass) {
+          entries_[n].tensor = tensor;
+          entries_[n].src = tensor->data.data;
+          entries_[n].offset = offset;
+          entries_[n].size = size;
+        } else {
+          info_.n_streamed++;
+          info_.bytes_per_invoke += size;
+        }
+        offset += aligned;
+        n_copies++;
+        n++;
+      }
+      if (!pass && offset > info_.max_slot_used)
+        info_.max_slot_used = offset;
+    }
+
+    if (!pass) {
+      if (n > UINT16_MAX) {
+        options_ = nullptr;
+        return kTfLiteError;
+      }
+      first_ = reinterpret_cast<uint16_t*>(allocator->AllocatePersistentBuffer(
+          (n_nodes + 1) * sizeof(uint16_t), alignof(uint16_t)));
+      entries_ = reinterpret_cast<Entry*>(allocator->AllocatePersistentBuffer(
+          (n ? n : 1) * sizeof(Entry), alignof(Entry)));
+      if (!first_ || !entries_) {
+        options_ = nullptr;
+        return kTfLiteError;
+      }
+    }
+  }
+  first_[n_nodes] = n;
+
+  buffer_ = buffer;
+  n_nodes_ = n_nodes;
+  node_ = -1;
+  active_node_ = -1;
+  fetch_node_ = n_nodes;
+  pending_ = false;
+  return kTfLiteOk;
+}
+
+/* next operator with streamed weights, from node */
+int32_t CTfLiteWeightStream::next_streamed(int32_t node)
+{
+  while ((node < n_nodes_) && (first_[node] == first_[node + 1]))
+    node++;
+  return node;
+}
+
+/* before Invoke(): copy of the weights of the first operator */
+void CTfLiteWeightStream::start()
+{
+  if (pending_) {
+    /* previous invoke aborted */
+    pending_ = false;
+    (void)options_->wait(options_->cookie);
+  }
+  node_ = -1;
+  active_node_ = -1;
+  prefetch(next_streamed(0), 0);
+}
+
+void CTfLiteWeightStream::begin_node()
+{
+  node_++;
+  if (node_ != fetch_node_)
+    return;  /* no streamed weights */
+  bool ok = fetch_ok_;
+  if (pending_) {
+    pending_ = false;
+    if (options_->wait(options_->cookie) != 0)
+      ok = false;  /* weights read in place */
+  }
+  const int slot = fetch_slot_;
+  /* the other slot was used by the previous operator with streamed weights */
+  prefetch(next_streamed(node_ + 1), 1 - slot);
+  if (ok) {
+    active_node_ = node_;
+    redirect(node_, buffer_ + slot * info_.slot_size);
+  }
+}
+
+void CTfLiteWeightStream::end_node()
+{
+  if (node_ == active_node_) {
+    redirect(node_, nullptr);
+    active_node_ = -1;
+  }
+}
+
+void CTfLiteWeightStream::prefetch(int32_t node, int slot)
+{
+  fetch_node_ = node;
+  fetch_slot_ = slot;
+  fetch_ok_ = false;
+  if (node >= n_nodes_)
+    return;
+  uint8_t* dst = buffer_ + slot * info_.slot_size;
+  const uint32_t n = first_[node + 1] - first_[node];
+  for (uint32_t i = 0; i < n; i++) {
+    const Entry& entry = entries_[first_[node] + i];
+    copies_[i].dst = dst + entry.offset;
+    copies_[i].src = entry.src;
+    copies_[i].size = entry.size;
+  }
+  if (options_->start(options_->cookie, copies_, n) == 0) {
+    pending_ = true;
+    fetch_ok_ = true;
+  }
+}
+
+/* evaluation tensors of the node to the slot dst, or to the external memory */
+void CTfLiteWeightStream::redirect(int32_t node, uint8_t* dst)
+{
+  for (uint32_t i = first_[node]; i < first_[node + 1]; i++) {
+    Entry& entry = entries_[i];
+    entry.tensor->data.data = dst ? (void*)(dst + entry.offset) : entry.src;
+  }
+}
+
+const TfLiteRegistration_V1 CTfLiteTopK::registration = {
+  nullptr, nullptr, nullptr, CTfLiteTopK::invoke_fused, nullptr,
+  tflite::BuiltinOperator_CUSTOM, "TOPK_HEAD", 1
+};
+
+TfLiteStatus CTfLiteTopK::enable(uint32_t k)
+{
+  if (k > TFLM_C_TOPK_MAX)
+    return kTfLiteError;
+  restore();
+  k_ = 0;
+  memset(&result_, 0, sizeof(result_));
+  if (k == 0)
+    return kTfLiteOk;
+
+  /* trailing int8 SOFTMAX producing output 0 */
+  const int32_t output = interp_->outputs().Get(0);
+  const int32_t n_nodes = model_->subgraphs()->Get(0)->operators()->size();
+  tflite::NodeAndRegistration* last = n_nodes ? interp_->node_and_registration(n_nodes - 1) : nullptr;
+  if (last && (last->registration->builtin_code == tflite::BuiltinOperator_SOFTMAX) &&
+      (last->node.outputs->size == 1) && (last->node.outputs->data[0] == output) &&
+      (interp_->eval_tensor(last->node.inputs->data[0])->type == kTfLiteInt8))
+    logits_ = last->node.inputs->data[0];
+  else {
+    last = nullptr;
+    logits_ = output;
+  }
+
+  const TfLiteEvalTensor* logits = interp_->eval_tensor(logits_);
+  if ((logits->type != kTfLiteInt8) || (logits->dims->size < 1))
+    return kTfLiteError;
+  const int32_t n_classes = logits->dims->data[logits->dims->size - 1];
+  for (int i = 0; i < logits->dims->size - 1; i++) {
+    if (logits->dims->data[i] != 1)
+      return kTfLiteError;  /* one row only */
+  }
+
+  const tflite::QuantizationParameters* q =
+      model_->subgraphs()->Get(0)->tensors()->Get(logits_)->quantization();
+  if (q && q->scale() && q->scale()->size() && q->zero_point() && q->zero_point()->size()) {
+    result_.scale = q->scale()->Get(0);
+    result_.zero_point = (int)q->zero_point()->Get(0);
+  }
+
+  if (last) {
+    node_ = last;
+    registration_ = last->registration;
+    user_data_ = last->node.user_data;
+    last->registration = &registration;
+    last->node.user_data = this;
+    if (interp_->update_dispatch_tables() != kTfLiteOk) {
+      restore();
+      return kTfLiteError;
+    }
+  }
+  result_.fused = last ? 1 : 0;
+  k_ = ((int32_t)k < n_classes) ? k : (uint32_t)n_classes;
+  return kTfLiteOk;
+}
+
+void CTfLiteTopK::restore()
+{
+  if (node_) {
+    node_->registration = registration_;
+    node_->node.user_data = user_data_;
+    node_ = nullptr;
+    (void)interp_->update_dispatch_tables();
+  }
+}
+
+TfLiteStatus CTfLiteTopK::invoke_fused(TfLiteContext* context, TfLiteNode* node)
+{
+  CTfLiteTopK* head = reinterpret_cast<CTfLiteTopK*>(node->user_data);
+  return head->select(context->GetEvalTensor(context, node->inputs->data[0]));
+}
+
+/* insertion in the sorted list of the k best values, one pass */
+TfLiteStatus CTfLiteTopK::select(const TfLiteEvalTensor* logits)
+{
+  const int8_t* values = logits->data.int8;
+  const int32_t n_classes = logits->dims->data[logits->dims->size - 1];
+  int32_t* index = result_.index;
+  int8_t* best = result_.logit;
+  uint32_t n = 0;
+
+  for (int32_t i = 0; i < n_classes; i++) {
+    const int8_t v = values[i];
+    if ((n == k_) && (v <= best[n - 1]))
+      continue;
+    uint32_t j = (n < k_) ? n++ : n - 1;
+    for (; (j > 0) && (best[j - 1] < v); j--) {
+      best[j] = best[j - 1];
+      index[j] = index[j - 1];
+    }
+    best[j] = v;
+    index[j] = i;
+  }
+  result_.k = n;
+  return kTfLiteOk;
+}
+
+TfLiteStatus CTfLiteTopK::result(struct tflm_c_topk_result* result)
+{
+  if (!result || !result_.k)
+    return kTfLiteError;
+  *result = result_;
+  return kTfLiteOk;
+}
+
 static tflite::MicroErrorReporter micro_error_reporter;
 
+// name of the metadata entry holding the offline memory plan (see micro_allocation_info.cc)
+static const char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
+
+#if UINTPTR_MAX > UINT32_MAX
+/*
+ * 64-bit host build (validation/benchmark tools): a pointer does not fit
+ * in the uint32_t handle, the handle is the 1-based index of the context
+ * in a small table. On target, the handle is the address of the context.
+ */
+#if !defined(TFLM_C_MAX_INSTANCES)
+#define TFLM_C_MAX_INSTANCES 16
+#endif
+
+static CTfLiteInterpreterContext* _instances[TFLM_C_MAX_INSTANCES];
+
+CTfLiteInterpreterContext* CTfLiteInterpreterContext::from_handle(const uint32_t hdl)
+{
+  if (hdl == 0 || hdl > TFLM_C_MAX_INSTANCES)
+    return nullptr;
+  return _instances[hdl - 1];
+}
+
+uint32_t CTfLiteInterpreterContext::get_handle()
+{
+  for (uint32_t i = 0; i < TFLM_C_MAX_INSTANCES; i++) {
+    if (_instances[i] == this)
+      return i + 1;
+  }
+  for (uint32_t i = 0; i < TFLM_C_MAX_INSTANCES; i++) {
+    if (_instances[i] == nullptr) {
+      _instances[i] = this;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+void CTfLiteInterpreterContext::release_handle()
+{
+  for (uint32_t i = 0; i < TFLM_C_MAX_INSTANCES; i++) {
+    if (_instances[i] == this)
+      _instances[i] = nullptr;
+  }
+}
+#else
+CTfLiteInterpreterContext* CTfLiteInterpreterContext::from_handle(const uint32_t hdl)
+{
+  return reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+}
+
+uint32_t CTfLiteInterpreterContext::get_handle()
+{
+  return (uint32_t)this;
+}
+
+void CTfLiteInterpreterContext::release_handle()
+{
+}
+#endif
+
+static const tflite::MicroOpResolver& get_resolver()
+{
+#if defined(TFLM_RUNTIME_USE_ALL_OPERATORS) && TFLM_RUNTIME_USE_ALL_OPERATORS == 1
+  static tflite::AllOpsResolver _resolver;
+#else
+    // operators of the embedded model, see tflm_network_ops.h
+    static tflite::MicroMutableOpResolver<TFLM_NETWORK_OPS_COUNT> _resolver;
+    static bool _resolver_ready = false;
+    if (!_resolver_ready) {
+#define TFLM_ADD_OP(op) _resolver.Add##op();
+      TFLM_NETWORK_OPS(TFLM_ADD_OP)
+#undef TFLM_ADD_OP
+      _resolver_ready = true;
+    }
+ #endif
+  return _resolver;
+}
+
+/* Size of the context object in the arena buffer */
+static size_t context_size()
+{
+  return tflite::AlignSizeUp(sizeof(CTfLiteInterpreterContext),
+      tflite::MicroArenaBufferAlignment());
+}
+
+CTfLiteInterpreterContext* CTfLiteInterpreterContext::create(const tflite::Model* model,
+    uint8_t* tensor_arena, size_t tensor_arena_size, uint32_t planner_kind)
+{
+  uint8_t* head = tflite::AlignPointerUp(tensor_arena, tflite::MicroArenaBufferAlignment());
+  uint8_t* tail = tensor_arena + tensor_arena_size;
+  if (head + context_size() >= tail) {
+    printf("Arena buffer too small\r\n");
+    return nullptr;
+  }
+
+  CTfLiteInterpreterContext *ctx = new (head) CTfLiteInterpreterContext(
+      model,
+      get_resolver(),
+      head + context_size(),
+      tail - head - context_size(),
+      planner_kind
+  );
+  ctx->arena = tensor_arena;
+  ctx->arena_size = tensor_arena_size;
+  ctx->interpreter.SetOperatorFusion((planner_kind & TFLM_C_PLANNER_FUSE_OPS) != 0);
+
+  // Allocate the resources
+  if (ctx->interpreter.AllocateTensors() != kTfLiteOk) {
+    printf("AllocateTensors() fails\r\n");
+    ctx->destroy();
+    return nullptr;
+  }
+  return ctx;
+}
+
+/*
+ * Warm-start snapshot
+ *
+ *  header | context object | persistent part of the arena | relocation map
+ *
+ * The two images are word aligned, the relocation map has one bit per word:
+ * set if the word is a pointer into the arena buffer. The map is built by
+ * preparing the model twice, the second time with an arena shifted by
+ * kSnapshotShift bytes: a word which differs by kSnapshotShift is a pointer
+ * into the arena, an unchanged word is a value or a pointer to the model or
+ * to the firmware (resolver, kernels). Any other difference aborts the save.
+ *
+ * A snapshot is only valid for the same firmware image (GNU build-id, see
+ * snapshot_build_id()), the same model address and the same key (SHA-256 of
+ * the model provided by the caller).
+ */
+#define TFLM_C_SNAPSHOT_MAGIC   (0x4E534D54U)  /* "TMSN" */
+#define TFLM_C_SNAPSHOT_VERSION (1)
+
+static const size_t kSnapshotShift = tflite::MicroArenaBufferAlignment();
+
+struct tflm_c_snapshot_hdr {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t build_id;
+  uint32_t checksum;      /* of the data after the header */
+  uint8_t  key[TFLM_C_SNAPSHOT_KEY_SIZE];
+  uint64_t model;         /* address of the model (root table) */
+  uint64_t head;          /* address of the context object */
+  uint32_t region_size;   /* size of the arena region from the context object */
+  uint32_t ctx_size;      /* bytes, context object image */
+  uint32_t tail_size;     /* bytes, persistent part image */
+  uint32_t map_size;      /* bytes, relocation map */
+};
+
+/* FNV-1a, 32-bit words (any remaining bytes one by one) */
+static uint32_t fnv1a(const uint8_t* data, size_t size, uint32_t h = 2166136261U)
+{
+  size_t i = 0;
+  for (; i + sizeof(uint32_t) <= size; i += sizeof(uint32_t)) {
+    uint32_t w;
+    memcpy(&w, data + i, sizeof(w));
+    h ^= w;
+    h *= 16777619U;
+  }
+  for (; i < size; i++) {
+    h ^= data[i];
+    h *= 16777619U;
+  }
+  return h;
+}
+
+/* GNU build-id note of the image (linked with --build-id): the linker script
+   of the firmware places it between these symbols, the host tools find it in
+   the program headers */
+extern "C" const uint8_t __gnu_build_id_start[] __attribute__((weak));
+extern "C" const uint8_t __gnu_build_id_end[] __attribute__((weak));
+
+/* Descriptor of the NT_GNU_BUILD_ID note in [note, end), nullptr if none */
+static const uint8_t* gnu_build_id(const uint8_t* note, const uint8_t* end, uint32_t* size)
+{
+  while (note + 3 * sizeof(uint32_t) <= end) {
+    uint32_t nhdr[3];  /* name size, descriptor size, type */
+    memcpy(nhdr, note, sizeof(nhdr));
+    const uint8_t* name = note + sizeof(nhdr);
+    const uint8_t* desc = name + ((nhdr[0] + 3U) & ~3U);
+    const uint8_t* next = desc + ((nhdr[1] + 3U) & ~3U);
+    if (next > end || next <= note)
+      break;
+    if ((nhdr[2] == 3U) && (nhdr[0] == 4U) && !memcmp(name, "GNU", 4)) {
+      *size = nhdr[1];
+      return desc;
+    }
+    note = next;
+  }
+  return nullptr;
+}
+
+#if defined(__linux__)
+/* PT_NOTE segments of the executable */
+static int gnu_build_id_phdr(struct dl_phdr_info* info, size_t, void* data)
+{
+  const uint8_t** id = (const uint8_t**)data;
+  for (int i = 0; i < info->dlpi_phnum; i++) {
+    if (info->dlpi_phdr[i].p_type != PT_NOTE)
+      continue;
+    const uint8_t* note = (const uint8_t*)(info->dlpi_addr + info->dlpi_phdr[i].p_vaddr);
+    uint32_t size;
+    if (gnu_build_id(note, note + info->dlpi_phdr[i].p_memsz, &size)) {
+      id[0] = note;
+      id[1] = note + info->dlpi_phdr[i].p_memsz;
+      return 1;
+    }
+  }
+  return 1;  /* first object only: the executable */
+}
+#endif
+
+/* Identify the firmware image: hash of its GNU build-id, 0 if the image has
+   none (no snapshot can then be saved or restored). Any rebuild changing the
+   code or the layout of the objects gives another build-id. */
+static uint32_t snapshot_build_id()
+{
+  const uint8_t* note[2] = { __gnu_build_id_start, __gnu_build_id_end };
+#if defined(__linux__)
+  if (!note[0])
+    dl_iterate_phdr(gnu_build_id_phdr, note);
+#endif
+  uint32_t size = 0;
+  const uint8_t* id = note[0] ? gnu_build_id(note[0], note[1], &size) : nullptr;
+  if (!id || !size)
+    return 0;
+  const uint32_t h = fnv1a(id, size);
+  return h ? h : 1U;
+}
+
+/* Aligned size of the region used by the context in [tensor_arena, tensor_arena + size) */
+static size_t snapshot_region_size(uint8_t* tensor_arena, size_t tensor_arena_size)
+{
+  uint8_t* head = tflite::AlignPointerUp(tensor_arena, tflite::MicroArenaBufferAlignment());
+  if (tensor_arena + tensor_arena_size < head + kSnapshotShift)
+    return 0;
+  size_t size = tensor_arena + tensor_arena_size - head;
+  return (size - kSnapshotShift) & ~(tflite::MicroArenaBufferAlignment() - 1);
+}
+
+/* Persistent part of the arena, from a word aligned address */
+static uint8_t* snapshot_tail(CTfLiteInterpreterContext* ctx, uint8_t* end)
+{
+  uint8_t* tail = end - ctx->arena_allocator->GetPersistentUsedBytes();
+  return tflite::AlignPointerDown(tail, tflite::MicroArenaBufferAlignment());
+}
+
+static size_t snapshot_size(size_t tail_size)
+{
+  size_t words = (context_size() + tail_size) / sizeof(uintptr_t);
+  return sizeof(struct tflm_c_snapshot_hdr) + context_size() + tail_size
+      + tflite::AlignSizeUp((words + 7) / 8, sizeof(uint32_t));
+}
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -298,9 +1095,19 @@ TfLiteStatus tflm_c_create(const uint8_t *model_data,
     const uint32_t tensor_arena_size,
     uint32_t *hdl)
 {
-  TfLiteStatus status;
+  return tflm_c_create_with_planner(model_data, tensor_arena, tensor_arena_size,
+      TFLM_C_PLANNER, hdl);
+}
 
-  if (!hdl || !tensor_arena_size || !tensor_arena || !model_data)
+TfLiteStatus tflm_c_create_with_planner(const uint8_t *model_data,
+    uint8_t *tensor_arena,
+    const uint32_t tensor_arena_size,
+    const uint32_t planner,
+    uint32_t *hdl)
+{
+  if (!hdl || !tensor_arena_size || !tensor_arena || !model_data ||
+      ((planner & TFLM_C_PLANNER_MASK) > TFLM_C_PLANNER_SEARCH) ||
+      (planner & ~(TFLM_C_PLANNER_MASK | TFLM_C_PLANNER_FUSE_OPS | TFLM_C_PLANNER_SCRATCH_POOL)))
     return kTfLiteError;
 
   *hdl = 0;
@@ -312,31 +1119,10 @@ TfLiteStatus tflm_c_create(const uint8_t *model_data,
     return kTfLiteError;
   }
 
-#if defined(TFLM_RUNTIME_USE_ALL_OPERATORS) && TFLM_RUNTIME_USE_ALL_OPERATORS == 1
-  static tflite::AllOpsResolver _resolver;
-#else
-    static tflite::MicroMutableOpResolver<5> _resolver;
-    _resolver.AddConv2D();
-    _resolver.AddMaxPool2D();
-    _resolver.AddReshape();
-    _resolver.AddFullyConnected();
-    _resolver.AddSoftmax();
- #endif
-
-  CTfLiteInterpreterContext *ctx = new CTfLiteInterpreterContext(
-      model,
-      _resolver,
-      tensor_arena,
-      tensor_arena_size
-  );
-
-  // Allocate the resources
-  status = ctx->interpreter.AllocateTensors();
-  if (status != kTfLiteOk) {
-    printf("AllocateTensors() fails\r\n");
-    delete ctx;
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::create(model,
+      tensor_arena, tensor_arena_size, planner);
+  if (!ctx)
     return kTfLiteError;
-  }
 
   // tflite::ErrorReporter* error_reporter = &micro_error_reporter;
   // error_reporter->Report("hello %d\n\t", sizeof(CTfLiteInterpreterContext));
@@ -344,26 +1130,33 @@ TfLiteStatus tflm_c_create(const uint8_t *model_data,
   // error_reporter->Report("hello %d\n\t", sizeof(tflite::MicroInterpreter));
 
   *hdl = ctx->get_handle();
+  if (*hdl == 0) {
+    ctx->destroy();
+    return kTfLiteError;
+  }
 
   return kTfLiteOk;
 }
 
 TfLiteStatus tflm_c_destroy(uint32_t hdl)
 {
-  CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
-  delete ctx;
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
+  if (!ctx)
+    return kTfLiteError;
+  ctx->release_handle();
+  ctx->destroy();
   return kTfLiteOk;
 }
 
 int32_t tflm_c_inputs_size(const uint32_t hdl)
 {
-  CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
   return ctx->interpreter.inputs_size();
 }
 
 int32_t tflm_c_outputs_size(const uint32_t hdl)
 {
-  CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
   return ctx->interpreter.outputs_size();
 }
 
@@ -377,11 +1170,37 @@ TfLiteStatus tflm_c_output(const uint32_t hdl, int32_t index, struct tflm_c_tens
   return CTfLiteInterpreterContext::output(hdl, index, t_info);
 }
 
+TfLiteStatus tflm_c_bind_input(const uint32_t hdl, int32_t index, void *data)
+{
+  return CTfLiteInterpreterContext::bind(hdl, false, index, data);
+}
+
+TfLiteStatus tflm_c_bind_output(const uint32_t hdl, int32_t index, void *data)
+{
+  return CTfLiteInterpreterContext::bind(hdl, true, index, data);
+}
+
 TfLiteStatus tflm_c_invoke(const uint32_t hdl)
 {
   return CTfLiteInterpreterContext::invoke(hdl);
 }
 
+TfLiteStatus tflm_c_topk_enable(const uint32_t hdl, uint32_t k)
+{
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
+  if (!ctx)
+    return kTfLiteError;
+  return ctx->topk.enable(k);
+}
+
+TfLiteStatus tflm_c_topk(const uint32_t hdl, struct tflm_c_topk_result *result)
+{
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
+  if (!ctx)
+    return kTfLiteError;
+  return ctx->topk.result(result);
+}
+
 TfLiteStatus tflm_c_reset_all_variables(const uint32_t hdl)
 {
   return CTfLiteInterpreterContext::reset_all_variables(hdl);
@@ -389,28 +1208,273 @@ TfLiteStatus tflm_c_reset_all_variables(const uint32_t hdl)
 
 int32_t tflm_c_operators_size(const uint32_t hdl)
 {
-  CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
   return ctx->model_->subgraphs()->Get(0)->operators()->size();
 }
 
 int32_t tflm_c_tensors_size(const uint32_t hdl)
 {
-  CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
   return ctx->model_->subgraphs()->Get(0)->tensors()->size();
 }
 
 int32_t tflm_c_operator_codes_size(const uint32_t hdl)
 {
-  CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
   return ctx->model_->operator_codes()->size();
 }
 
 int32_t tflm_c_arena_used_bytes(const uint32_t hdl)
 {
-  CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext *>(hdl);
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
   return ctx->interpreter.arena_used_bytes();
 }
 
+int32_t tflm_c_offline_planned_tensors(const uint32_t hdl)
+{
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
+  if (!ctx)
+    return 0;
+  const tflite::Model* model = ctx->model_;
+  if (!model->metadata() || !model->buffers() || !model->subgraphs())
+    return 0;
+
+  // same look-up and checks as
+  // tflite::AllocationInfoBuilder::GetOfflinePlannedOffsets(), one offset per
+  // tensor of all the subgraphs
+  size_t n_tensors = 0;
+  for (size_t i = 0; i < model->subgraphs()->size(); i++) {
+    const tflite::SubGraph* subgraph = model->subgraphs()->Get(i);
+    if (subgraph->tensors())
+      n_tensors += subgraph->tensors()->size();
+  }
+
+  for (size_t i = 0; i < model->metadata()->size(); i++) {
+    const tflite::Metadata* metadata = model->metadata()->Get(i);
+    if (!metadata->name() ||
+        strcmp(metadata->name()->c_str(), kOfflineMemAllocMetadata) != 0)
+      continue;
+    if (metadata->buffer() >= model->buffers()->size())
+      return 0;
+    const tflite::Buffer* buffer = model->buffers()->Get(metadata->buffer());
+    if (!buffer->data() || buffer->data()->size() < 3 * sizeof(int32_t))
+      return 0;
+    const int32_t* array = reinterpret_cast<const int32_t*>(buffer->data()->data());
+    const size_t n_words = buffer->data()->size() / sizeof(int32_t);
+    if (array[2] < 0 || static_cast<size_t>(array[2]) > n_words - 3 ||
+        static_cast<size_t>(array[2]) != n_tensors)
+      return 0;
+    int32_t n_planned = 0;
+    for (int32_t j = 0; j < array[2]; j++) {
+      if (array[3 + j] != tflite::kOnlinePlannedBuffer)
+        n_planned++;
+    }
+    return n_planned;
+  }
+  return 0;
+}
+
+int32_t tflm_c_snapshot_size(const uint32_t hdl)
+{
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
+  if (!ctx)
+    return -1;
+  return snapshot_size(tflite::AlignSizeUp(ctx->arena_allocator->GetPersistentUsedBytes(),
+      tflite::MicroArenaBufferAlignment()));
+}
+
+/* Prepare the model in [head, head + region_size) and save the snapshot */
+static TfLiteStatus snapshot_build(const tflite::Model* model, uint32_t planner,
+    uint8_t* head, size_t region_size, const uint8_t *key, uint8_t *buff, uint32_t buff_size,
+    uint32_t *size)
+{
+  const size_t ctx_size = context_size();
+  uint8_t* end = head + region_size;
+
+  /* 1 - reference image */
+  memset(head, 0, region_size + kSnapshotShift);
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::create(model, head, region_size, planner);
+  if (!ctx)
+    return kTfLiteError;
+  uint8_t* tail = snapshot_tail(ctx, end);
+  const size_t tail_size = end - tail;
+  const size_t total = snapshot_size(tail_size);
+  if (size)
+    *size = total;
+  if (buff_size < total) {
+    ctx->destroy();
+    return kTfLiteError;
+  }
+  struct tflm_c_snapshot_hdr hdr;
+  uint8_t* img = buff + sizeof(hdr);
+  uint8_t* map = img + ctx_size + tail_size;
+  memcpy(img, head, ctx_size);
+  memcpy(img + ctx_size, tail, tail_size);
+  ctx->destroy();
+
+  /* 2 - shifted image, the differences give the relocation map */
+  memset(head, 0, region_size + kSnapshotShift);
+  ctx = CTfLiteInterpreterContext::create(model, head + kSnapshotShift, region_size,
+      planner);
+  if (!ctx)
+    return kTfLiteError;
+  TfLiteStatus status = kTfLiteOk;
+  const uint8_t* tail2 = snapshot_tail(ctx, end + kSnapshotShift);
+  if ((size_t)(end + kSnapshotShift - tail2) != tail_size)
+    status = kTfLiteError;
+
+  const size_t ctx_words = ctx_size / sizeof(uintptr_t);
+  const size_t n_words = (ctx_size + tail_size) / sizeof(uintptr_t);
+  memset(map, 0, buff + total - map);
+  for (size_t i = 0; i < n_words && status == kTfLiteOk; i++) {
+    const uint8_t* p2 = (i < ctx_words) ? head + kSnapshotShift + i * sizeof(uintptr_t)
+        : tail2 + (i - ctx_words) * sizeof(uintptr_t);
+    uintptr_t w1, w2;
+    memcpy(&w1, img + i * sizeof(uintptr_t), sizeof(w1));
+    memcpy(&w2, p2, sizeof(w2));
+    if (w1 == w2)
+      continue;
+    if ((w2 - w1 == kSnapshotShift) && (w1 >= (uintptr_t)head) && (w1 <= (uintptr_t)end))
+      map[i / 8] |= (uint8_t)(1U << (i % 8));
+    else
+      status = kTfLiteError;  /* not relocatable */
+  }
+  ctx->destroy();
+  if (status != kTfLiteOk) {
+    printf("Snapshot: prepared state is not relocatable\r\n");
+    return status;
+  }
+
+  hdr.magic = TFLM_C_SNAPSHOT_MAGIC;
+  hdr.version = TFLM_C_SNAPSHOT_VERSION;
+  hdr.build_id = snapshot_build_id();
+  memcpy(hdr.key, key, TFLM_C_SNAPSHOT_KEY_SIZE);
+  hdr.model = (uintptr_t)model;
+  hdr.head = (uintptr_t)head;
+  hdr.region_size = region_size;
+  hdr.ctx_size = ctx_size;
+  hdr.tail_size = tail_size;
+  hdr.map_size = buff + total - map;
+  hdr.checksum = fnv1a(img, total - sizeof(hdr));
+  memcpy(buff, &hdr, sizeof(hdr));
+  return kTfLiteOk;
+}
+
+TfLiteStatus tflm_c_snapshot_save(const uint32_t hdl, const uint8_t *key,
+    uint8_t *buff, const uint32_t buff_size, uint32_t *size)
+{
+  CTfLiteInterpreterContext *ctx = CTfLiteInterpreterContext::from_handle(hdl);
+  if (!ctx || !key || !buff)
+    return kTfLiteError;
+  if (!snapshot_build_id()) {
+    printf("Snapshot: image without GNU build-id (link with --build-id)\r\n");
+    return kTfLiteError;
+  }
+
+  const tflite::Model* model = ctx->model_;
+  uint8_t* arena = ctx->arena;
+  const size_t arena_size = ctx->arena_size;
+  struct tflm_c_observer_options* options = ctx->profiler.options();
+  struct tflm_c_stream_options* stream_options = ctx->stream.options();
+  const uint32_t topk = ctx->topk.k();
+  const uint32_t planner = ctx->planner;
+  uint8_t* head = reinterpret_cast<uint8_t*>(ctx);
+  const size_t region_size = snapshot_region_size(arena, arena_size);
+
+  /* the arena is re-used to build the snapshot, the handle stays attached
+   * to the context object address */
+  ctx->destroy();
+  TfLiteStatus status = snapshot_build(model, planner, head, region_size, key, buff,
+      buff_size, size);
+
+  /* re-create the instance, as after tflm_c_create() */
+  ctx = CTfLiteInterpreterContext::create(model, arena, arena_size, planner);
+  if (!ctx) {
+    reinterpret_cast<CTfLiteInterpreterContext*>(head)->release_handle();
+    return kTfLiteError;
+  }
+  if (options)
+    ctx->profiler.register_cb(options);
+  if (stream_options)
+    (void)ctx->stream.register_cb(stream_options, ctx->arena_allocator);
+  if (topk)
+    (void)ctx->topk.enable(topk);
+  return status;
+}
+
+TfLiteStatus tflm_c_create_from_snapshot(const uint8_t *model_data,
+    uint8_t *tensor_arena,
+    const uint32_t tensor_arena_size,
+    const uint8_t *key,
+    const uint8_t *snapshot,
+    const uint32_t snapshot_size,
+    uint32_t *hdl)
+{
+  struct tflm_c_snapshot_hdr hdr;
+
+  if (!hdl || !tensor_arena_size || !tensor_arena || !model_data || !key || !snapshot)
+    return kTfLiteError;
+
+  *hdl = 0;
+
+  if (snapshot_size < sizeof(hdr))
+    return kTfLiteError;
+  memcpy(&hdr, snapshot, sizeof(hdr));
+
+  /* same firmware, model and key */
+  if ((hdr.magic != TFLM_C_SNAPSHOT_MAGIC) || (hdr.version != TFLM_C_SNAPSHOT_VERSION) ||
+      !hdr.build_id || (hdr.build_id != snapshot_build_id()) ||
+      (hdr.model != (uintptr_t)tflite::GetModel(model_data)) ||
+      memcmp(hdr.key, key, TFLM_C_SNAPSHOT_KEY_SIZE) != 0)
+    return kTfLiteError;
+
+  const size_t n_words = (hdr.ctx_size + hdr.tail_size) / sizeof(uintptr_t);
+  const size_t total = sizeof(hdr) + hdr.ctx_size + hdr.tail_size + hdr.map_size;
+  if ((hdr.ctx_size != context_size()) || (hdr.tail_size % sizeof(uintptr_t)) ||
+      (hdr.ctx_size + hdr.tail_size > hdr.region_size) || (hdr.map_size < (n_words + 7) / 8) ||
+      (snapshot_size < total) ||
+      (fnv1a(snapshot + sizeof(hdr), total - sizeof(hdr)) != hdr.checksum))
+    return kTfLiteError;
+
+  uint8_t* head = tflite::AlignPointerUp(tensor_arena, tflite::MicroArenaBufferAlignment());
+  if ((size_t)(head - tensor_arena) + hdr.region_size > tensor_arena_size)
+    return kTfLiteError;
+  uint8_t* end = head + hdr.region_size;
+  uint8_t* tail = end - hdr.tail_size;
+
+  /* copy and relocate the images */
+  const uint8_t* img = snapshot + sizeof(hdr);
+  const uint8_t* map = img + hdr.ctx_size + hdr.tail_size;
+  const size_t ctx_words = hdr.ctx_size / sizeof(uintptr_t);
+  const uintptr_t delta = (uintptr_t)head - (uintptr_t)hdr.head;
+  memcpy(head, img, hdr.ctx_size);
+  memcpy(tail, img + hdr.ctx_size, hdr.tail_size);
+  for (size_t i = 0; i < n_words; i++) {
+    if (map[i / 8] & (1U << (i % 8))) {
+      uintptr_t* w = (i < ctx_words) ? (uintptr_t*)head + i : (uintptr_t*)tail + (i - ctx_words);
+      *w += delta;
+    }
+  }
+
+  CTfLiteInterpreterContext *ctx = reinterpret_cast<CTfLiteInterpreterContext*>(head);
+  ctx->arena = tensor_arena;
+  ctx->arena_size = tensor_arena_size;
+
+  /* variable tensors are in the non-persistent part (not saved) */
+  if (ctx->interpreter.Reset() != kTfLiteOk) {
+    ctx->destroy();
+    return kTfLiteError;
+  }
+
+  *hdl = ctx->get_handle();
+  if (*hdl == 0) {
+    ctx->destroy();
+    return kTfLiteError;
+  }
+
+  return kTfLiteOk;
+}
+
 const char* tflm_c_TfLiteTypeGetName(TfLiteType type)
 {
   return TfLiteTypeGetName(type);
@@ -426,6 +1490,16 @@ void tflm_c_rt_version(struct tflm_c_version *version)
   }
 }
 
+TfLiteStatus tflm_c_stream_register(const uint32_t hdl, struct tflm_c_stream_options* options)
+{
+  return CTfLiteInterpreterContext::stream_register(hdl, options);
+}
+
+TfLiteStatus tflm_c_stream_info(const uint32_t hdl, struct tflm_c_stream_info* info)
+{
+  return CTfLiteInterpreterContext::stream_info(hdl, info);
+}
+
 TfLiteStatus tflm_c_observer_register(const uint32_t hdl, struct tflm_c_observer_options* options)
 {
   return CTfLiteInterpreterContext::observer_register(hdl, options);
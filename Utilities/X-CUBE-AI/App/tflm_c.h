@@ -33,6 +33,16 @@
  *         86c8d52 - Fix erroneous write from EXPAND_DIMS to an array that can be in read-only region (#649)
  *         Dump of the intermediate tensor is no more supported.
  * - v3.0: align code with ~TFLM 2.11
+ * - v3.1: add tflm_c_offline_planned_tensors() (offline memory plan)
+ *         handle is a context index on 64-bit host builds
+ * - v3.2: context object placed in the tensor arena (no heap)
+ *         add warm-start snapshot functions (tflm_c_snapshot_save()..)
+ * - v3.3: add weight streaming from an external memory (tflm_c_stream_register())
+ * - v3.4: add zero-copy binding of the IO tensors (tflm_c_bind_input()..)
+ * - v3.5: add top-k classification head (tflm_c_topk_enable()/tflm_c_topk())
+ * - v3.6: add selection of the memory planner (tflm_c_create_with_planner())
+ * - v3.7: add the fusion of CONV_2D -> [RELU] -> MAX_POOL_2D (TFLM_C_PLANNER_FUSE_OPS)
+ * - v3.8: add the shared scratch buffer pool (TFLM_C_PLANNER_SCRATCH_POOL)
  */
 
 #ifdef __cplusplus
@@ -155,6 +165,56 @@ struct tflm_c_observer_options {
   uint32_t flags;
 };
 
+/* Weight streaming (see tflm_c_stream_register()) */
+
+struct tflm_c_stream_copy {
+  void* dst;
+  const void* src;
+  uint32_t size;
+};
+
+/* Starts the copies (e.g. DMA) and returns, 0 if ok */
+typedef int (*tflm_c_stream_start_cb)(
+  const void* cookie,
+  const struct tflm_c_stream_copy* copies,
+  uint32_t n_copies);
+
+/* Waits the end of the copies started by the last start call, 0 if ok */
+typedef int (*tflm_c_stream_wait_cb)(const void* cookie);
+
+struct tflm_c_stream_options {
+  const uint8_t* ext_base;    /* memory-mapped window of the external memory */
+  uint32_t ext_size;
+  uint32_t min_size;          /* smaller constant tensors are read in place */
+  uint8_t* buffer;            /* SRAM double buffer (two slots) */
+  uint32_t buffer_size;
+  tflm_c_stream_start_cb start;
+  tflm_c_stream_wait_cb wait;
+  void* cookie;
+};
+
+struct tflm_c_stream_info {
+  uint32_t slot_size;         /* bytes, half of the aligned buffer */
+  uint32_t n_streamed;        /* constant tensors copied in a slot */
+  uint32_t n_in_place;        /* constant tensors read in place (slot too small) */
+  uint32_t n_small;           /* constant tensors read in place (< min_size) */
+  uint32_t max_slot_used;     /* bytes, largest set of weights of an operator */
+  uint32_t bytes_per_invoke;  /* bytes copied by one invoke */
+};
+
+/* Top-k classification head (see tflm_c_topk_enable()) */
+
+#define TFLM_C_TOPK_MAX (8)
+
+struct tflm_c_topk_result {
+  uint32_t k;                       /* number of reported classes */
+  uint32_t fused;                   /* 1: trailing SOFTMAX replaced by the head */
+  int32_t  index[TFLM_C_TOPK_MAX];  /* classes, highest logit first */
+  int8_t   logit[TFLM_C_TOPK_MAX];  /* raw int8 logits (not dequantized) */
+  float    scale;                   /* quantization of the logits */
+  int      zero_point;
+};
+
 
 /* -----------------------------------------------------------------------------
  *  Main/core functions
@@ -171,6 +231,50 @@ TfLiteStatus tflm_c_create(const uint8_t *model_data,
     const uint32_t tensor_arena_size,
     uint32_t *hdl);
 
+/*
+ * Memory planner of the tensor arena (activations and scratch buffers)
+ * - TFLM_C_PLANNER_GREEDY: tflite::GreedyMemoryPlanner (TFLM default)
+ * - TFLM_C_PLANNER_BEST_FIT: tflite::BestFitMemoryPlanner, best-fit placement
+ *   of the buffers which are live at the same time
+ * - TFLM_C_PLANNER_SEARCH: best-fit, smallest plan of TFLM_C_PLANNER_ORDERINGS
+ *   placement orders (longer tflm_c_create())
+ * TFLM_C_PLANNER is the planner used by tflm_c_create().
+ *
+ * TFLM_C_PLANNER_FUSE_OPS can be or-ed with the planner: the int8
+ * CONV_2D -> [RELU|RELU6] -> MAX_POOL_2D chains are fused when the tensors are
+ * allocated (micro_op_fusion.h), the conv output is not stored in the arena.
+ *
+ * TFLM_C_PLANNER_SCRATCH_POOL can be or-ed with the planner: the scratch
+ * buffers of the kernels are not planned with the tensors but placed in a pool
+ * shared by all the operators, above the tensors (size of the largest scratch
+ * memory of an operator), see MicroAllocator::SetScratchPool().
+ */
+#define TFLM_C_PLANNER_GREEDY   (0)
+#define TFLM_C_PLANNER_BEST_FIT (1)
+#define TFLM_C_PLANNER_SEARCH   (2)
+
+#define TFLM_C_PLANNER_MASK         (0xFF)
+#define TFLM_C_PLANNER_FUSE_OPS     (0x100)
+#define TFLM_C_PLANNER_SCRATCH_POOL (0x200)
+
+#ifndef TFLM_C_PLANNER
+#define TFLM_C_PLANNER TFLM_C_PLANNER_GREEDY
+#endif
+
+#ifndef TFLM_C_PLANNER_ORDERINGS
+#define TFLM_C_PLANNER_ORDERINGS (16)
+#endif
+
+/*
+ * Same as tflm_c_create() with the given memory planner (TFLM_C_PLANNER_xx).
+ * The planner is kept by the instance (re-used by tflm_c_snapshot_save()).
+ */
+TfLiteStatus tflm_c_create_with_planner(const uint8_t *model_data,
+    uint8_t *tensor_arena,
+    const uint32_t tensor_arena_size,
+    const uint32_t planner,
+    uint32_t *hdl);
+
 TfLiteStatus tflm_c_destroy(uint32_t hdl);
 
 int32_t tflm_c_inputs_size(const uint32_t hdl);
@@ -179,6 +283,17 @@ int32_t tflm_c_outputs_size(const uint32_t hdl);
 TfLiteStatus tflm_c_input(const uint32_t hdl, int32_t index, struct tflm_c_tensor_info *t_info);
 TfLiteStatus tflm_c_output(const uint32_t hdl, int32_t index, struct tflm_c_tensor_info *t_info);
 
+/*
+ * Binds an input/output tensor to a buffer owned by the application (e.g.
+ * filled by a DMA), no copy is needed before/after tflm_c_invoke(). data must
+ * be 16-bytes aligned and hold t_info.bytes, NULL restores the location
+ * planned in the arena (still reserved, the memory plan is not changed).
+ * tflm_c_input()/tflm_c_output() report the bound buffer. The bindings are
+ * lost by tflm_c_snapshot_save() (instance re-created).
+ */
+TfLiteStatus tflm_c_bind_input(const uint32_t hdl, int32_t index, void *data);
+TfLiteStatus tflm_c_bind_output(const uint32_t hdl, int32_t index, void *data);
+
 TfLiteStatus tflm_c_invoke(const uint32_t hdl);
 
 TfLiteStatus tflm_c_reset_all_variables(const uint32_t hdl);
@@ -189,6 +304,86 @@ int32_t tflm_c_operator_codes_size(const uint32_t hdl);
 
 int32_t tflm_c_arena_used_bytes(const uint32_t hdl);
 
+/*
+ * Enables the top-k classification head (k <= TFLM_C_TOPK_MAX, clipped to
+ * the number of classes), 0 disables it. The logits must be int8 with one
+ * row. If the model ends with an int8 SOFTMAX producing output 0, the operator
+ * is replaced by the head: the softmax is not computed (output 0 is not
+ * written) and the logits are its input. Otherwise, output 0 holds the logits
+ * (e.g. softmax removed by ml_model/tools/tflm_topk_head) and the head runs
+ * after the operators. Kept by tflm_c_snapshot_save().
+ */
+TfLiteStatus tflm_c_topk_enable(const uint32_t hdl, uint32_t k);
+
+/* Returns the classes selected by the last tflm_c_invoke() */
+TfLiteStatus tflm_c_topk(const uint32_t hdl, struct tflm_c_topk_result *result);
+
+/*
+ * Returns the number of tensors placed with an offline planned offset
+ * ("OfflineMemoryAllocation" metadata added by ml_model/tools/tflm_offline_plan).
+ * 0 means that the whole memory plan is computed by tflm_c_create().
+ */
+int32_t tflm_c_offline_planned_tensors(const uint32_t hdl);
+
+
+/* -----------------------------------------------------------------------------
+ *  Warm-start snapshot functions
+ * -----------------------------------------------------------------------------
+ */
+
+#define TFLM_C_SNAPSHOT_KEY_SIZE (32)  /* e.g. SHA-256 of the model */
+
+/*
+ * Returns the size in bytes of the snapshot of the prepared instance
+ * (persistent part of the arena + relocation map), -1 if hdl is invalid.
+ */
+int32_t tflm_c_snapshot_size(const uint32_t hdl);
+
+/*
+ * Saves the prepared state of the instance in buff. The model is prepared
+ * again twice in the arena to build the relocation map, the instance is then
+ * re-created (same handle, content of the tensors and variables are lost).
+ * size returns the required size, also in case of error.
+ */
+TfLiteStatus tflm_c_snapshot_save(const uint32_t hdl, const uint8_t *key,
+    uint8_t *buff, const uint32_t buff_size, uint32_t *size);
+
+/*
+ * Creates an instance from a snapshot (in place of tflm_c_create()), the
+ * AllocateTensors() step is skipped. The snapshot is rejected if it has not
+ * been built by the same firmware image (GNU build-id, the image must be
+ * linked with --build-id) with the same key and model address.
+ * The tensor arena can be at a different address.
+ */
+TfLiteStatus tflm_c_create_from_snapshot(const uint8_t *model_data,
+    uint8_t *tensor_arena,
+    const uint32_t tensor_arena_size,
+    const uint8_t *key,
+    const uint8_t *snapshot,
+    const uint32_t snapshot_size,
+    uint32_t *hdl);
+
+
+/* -----------------------------------------------------------------------------
+ *  Weight streaming functions
+ * -----------------------------------------------------------------------------
+ */
+
+/*
+ * Streams the constant tensors placed in an external memory (model in the
+ * memory-mapped window [ext_base, ext_base + ext_size)). The constant inputs
+ * of each operator are copied in a slot of the SRAM buffer and the operator
+ * uses the copy: while an operator runs, the weights of the next one are
+ * copied in the other slot (start/wait callbacks, e.g. DMA). A tensor which
+ * does not fit in a slot or smaller than min_size (shape, small bias..) is
+ * read in place (the window must be readable).
+ * Only single subgraph models are supported. The schedule is allocated in
+ * the persistent part of the arena, the stream can be registered once per
+ * instance (kept by tflm_c_snapshot_save()).
+ */
+TfLiteStatus tflm_c_stream_register(const uint32_t hdl, struct tflm_c_stream_options* options);
+TfLiteStatus tflm_c_stream_info(const uint32_t hdl, struct tflm_c_stream_info* info);
+
 
 /* -----------------------------------------------------------------------------
  *  Observer/Profiler functions
@@ -20,8 +20,14 @@ extern "C"
 #else
 #define DATA_ALIGN_ATTRIBUTE
 #endif
+/* model placed in the OctoSPI NOR flash (memory-mapped), see TFLM_NETWORK_WEIGHTS_IN_OSPI */
+#if defined(TFLM_NETWORK_WEIGHTS_IN_OSPI) && (TFLM_NETWORK_WEIGHTS_IN_OSPI == 1)
+#define DATA_SECTION_ATTRIBUTE __attribute__((section(".ospi_model")))
+#else
+#define DATA_SECTION_ATTRIBUTE
+#endif
 
-const uint8_t g_tflm_network_model_data[] DATA_ALIGN_ATTRIBUTE = {
+const uint8_t g_tflm_network_model_data[] DATA_ALIGN_ATTRIBUTE DATA_SECTION_ATTRIBUTE = {
     0x1c, 0x00, 0x00, 0x00, 0x54, 0x46, 0x4c, 0x33, 0x14, 0x00, 0x20, 0x00,
     0x1c, 0x00, 0x18, 0x00, 0x14, 0x00, 0x10, 0x00, 0x0c, 0x00, 0x00, 0x00,
     0x08, 0x00, 0x04, 0x00, 0x14, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,
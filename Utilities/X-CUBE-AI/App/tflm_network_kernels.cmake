@@ -0,0 +1,27 @@
+#
+# Kernels of the embedded model (TFLM_RUNTIME_USE_ALL_OPERATORS=OFF)
+#
+# Generated by ml_model/tools/tflm_gen_resolver from MNIST_full_quanitization.tflite
+# Do not edit.
+#
+
+set(tflm_network_kernels_SRCS
+    ${TFLM_KERNELS_PATH}/kernel_util.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/conv.cc
+    ${TFLM_KERNELS_PATH}/conv_common.cc
+    ${TFLM_KERNELS_PATH}/weight_compression.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/pooling.cc
+    ${TFLM_KERNELS_PATH}/pooling_common.cc
+    ${TFLM_KERNELS_PATH}/reshape.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/fully_connected.cc
+    ${TFLM_KERNELS_PATH}/fully_connected_common.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/softmax.cc
+    ${TFLM_KERNELS_PATH}/softmax_common.cc
+    ${cmsis_nn_NNSupportFunctions_SRCS}
+    ${cmsis_nn_ActivationFunctions_SRCS}
+    ${cmsis_nn_BasicMathFunctions_SRCS}
+    ${cmsis_nn_ConvolutionFunctions_SRCS}
+    ${cmsis_nn_PoolingFunctions_SRCS}
+    ${cmsis_nn_FullyConnectedFunctions_SRCS}
+    ${cmsis_nn_SoftmaxFunctions_SRCS}
+)
@@ -0,0 +1,24 @@
+/**
+ ******************************************************************************
+ * @file    tflm_network_ops.h
+ * @brief   Operators of the embedded model (MicroMutableOpResolver)
+ ******************************************************************************
+ *
+ * Generated by ml_model/tools/tflm_gen_resolver from MNIST_full_quanitization.tflite
+ * Do not edit.
+ */
+
+#ifndef __TFLM_NETWORK_OPS_H__
+#define __TFLM_NETWORK_OPS_H__
+
+#define TFLM_NETWORK_OPS_COUNT 5
+
+/* X(op) is expanded for each MicroMutableOpResolver::Add<op>() method */
+#define TFLM_NETWORK_OPS(X) \
+  X(Conv2D) \
+  X(MaxPool2D) \
+  X(Reshape) \
+  X(FullyConnected) \
+  X(Softmax) \
+
+#endif /* __TFLM_NETWORK_OPS_H__ */
@@ -0,0 +1,329 @@
+/**
+ ******************************************************************************
+ * @file    tflm_preproc.c
+ * @brief   Pre-processing of the image inputs (uint8 pixels -> int8 tensor)
+ ******************************************************************************
+ * @attention
+ *
+ * This software is licensed under terms that can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+
+#include "tflm_preproc.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "stm32h5xx.h"  /* CMSIS SIMD intrinsics */
+#define TFLM_PP_DSP 1
+#else
+#define TFLM_PP_DSP 0
+#endif
+
+#define TFLM_PP_MAX_DST_WIDTH   (256)   /* columns of the resized area */
+
+/* 4 pixels, unaligned access (single LDR/STR on Cortex-M33) */
+static inline uint32_t load32(const uint8_t *p)
+{
+  uint32_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+static inline void store32(int8_t *p, uint32_t w)
+{
+  memcpy(p, &w, sizeof(w));
+}
+
+/* != 0 if one of the 4 bytes of w is >= t (1..255) */
+static inline uint32_t any_byte_ge(uint32_t w, uint32_t t)
+{
+#if TFLM_PP_DSP
+  (void)__USUB8(w, t * 0x01010101U);  /* GE[i] set if byte i >= t */
+  return __SEL(0xFFFFFFFFU, 0U);
+#else
+  /* b + (256 - t) carries in bit 8 of its 16-bit lane if b >= t */
+  const uint32_t k = (256U - t) * 0x00010001U;
+  return ((((w & 0x00FF00FFU) + k) | (((w >> 8) & 0x00FF00FFU) + k)) & 0x01000100U);
+#endif
+}
+
+/* sum of n pixels */
+static inline uint32_t row_sum(const uint8_t *p, uint32_t n)
+{
+  uint32_t sum = 0;
+#if TFLM_PP_DSP
+  for (; n >= 4; n -= 4, p += 4)
+    sum = __USADA8(load32(p), 0U, sum);
+#else
+  /* two 16-bit lanes, folded before they can overflow (128 x 2 x 255) */
+  uint32_t acc = 0;
+  uint32_t words = 0;
+  for (; n >= 4; n -= 4, p += 4) {
+    const uint32_t w = load32(p);
+    acc += (w & 0x00FF00FFU) + ((w >> 8) & 0x00FF00FFU);
+    if (++words == 128) {
+      sum += (acc & 0xFFFFU) + (acc >> 16);
+      acc = 0;
+      words = 0;
+    }
+  }
+  sum += (acc & 0xFFFFU) + (acc >> 16);
+#endif
+  while (n--)
+    sum += *p++;
+  return sum;
+}
+
+/* p0 * w0 + p1 * w1, weights packed as (w1 << 16) | w0 */
+static inline uint32_t lerp2(uint32_t p0, uint32_t p1, uint32_t weights)
+{
+#if TFLM_PP_DSP
+  return (uint32_t)__SMUAD((p1 << 16) | p0, weights);
+#else
+  return p0 * (weights & 0xFFFFU) + p1 * (weights >> 16);
+#endif
+}
+
+int tflm_pp_quant_init(struct tflm_pp_quant *q, float pixel_scale, float scale,
+    int32_t zero_point, int invert)
+{
+  if (!q || !(scale > 0.0f))
+    return -1;
+
+  for (int p = 0; p < 256; p++) {
+    const float x = (float)(invert ? 255 - p : p) * pixel_scale / scale;
+    int32_t v = (x >= 0.0f ? (int32_t)(x + 0.5f) : -(int32_t)(0.5f - x)) + zero_point;
+    if (v < -128)
+      v = -128;
+    if (v > 127)
+      v = 127;
+    q->lut[p] = (int8_t)v;
+  }
+
+  /* e.g. scale = 1/255, zero_point = -128: q = p ^ 0x80 (0x7F if inverted) */
+  const uint8_t m = (uint8_t)q->lut[0];
+  int is_xor = 1;
+  for (int p = 0; p < 256; p++)
+    is_xor &= ((uint8_t)q->lut[p] == (uint8_t)(p ^ m));
+  q->xor_mask = is_xor ? m * 0x01010101U : 0U;
+  q->background = invert ? 255 : 0;
+  return 0;
+}
+
+void tflm_pp_quantize(const struct tflm_pp_quant *q, const uint8_t *src, int8_t *dst,
+    uint32_t n)
+{
+  if (q->xor_mask) {
+    for (; n >= 4; n -= 4, src += 4, dst += 4)
+      store32(dst, load32(src) ^ q->xor_mask);
+  } else {
+    for (; n >= 4; n -= 4, src += 4, dst += 4) {
+      const uint32_t w = load32(src);
+      store32(dst, (uint32_t)(uint8_t)q->lut[w & 0xFFU] |
+          ((uint32_t)(uint8_t)q->lut[(w >> 8) & 0xFFU] << 8) |
+          ((uint32_t)(uint8_t)q->lut[(w >> 16) & 0xFFU] << 16) |
+          ((uint32_t)(uint8_t)q->lut[w >> 24] << 24));
+    }
+  }
+  while (n--)
+    *dst++ = q->lut[*src++];
+}
+
+static int row_has_ink(const uint8_t *row, uint32_t width, uint32_t inv, uint32_t t)
+{
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    if (any_byte_ge(load32(&row[x]) ^ inv, t))
+      return 1;
+  }
+  for (; x < width; x++) {
+    if ((uint32_t)(row[x] ^ (uint8_t)inv) >= t)
+      return 1;
+  }
+  return 0;
+}
+
+int tflm_pp_bounding_box(const struct tflm_pp_image *img, const struct tflm_pp_quant *q,
+    uint8_t threshold, struct tflm_pp_rect *box)
+{
+  const uint32_t inv = q->background ? 0xFFFFFFFFU : 0U;
+  const uint32_t t = threshold ? threshold : 1U;
+  int32_t top, bottom, left, right;
+
+  if (!img->width || !img->height)
+    return -1;
+
+  for (top = 0; top < img->height; top++) {
+    if (row_has_ink(&img->data[top * img->stride], img->width, inv, t))
+      break;
+  }
+  if (top == img->height)
+    return -1;
+  for (bottom = img->height - 1; bottom > top; bottom--) {
+    if (row_has_ink(&img->data[bottom * img->stride], img->width, inv, t))
+      break;
+  }
+  /* columns: each row is scanned up to the current left/right bounds */
+  left = img->width;
+  right = -1;
+  for (int32_t y = top; y <= bottom; y++) {
+    const uint8_t *row = &img->data[y * img->stride];
+    int32_t x = 0;
+    while ((x + 4 <= left) && !any_byte_ge(load32(&row[x]) ^ inv, t))
+      x += 4;
+    for (; x < left; x++) {
+      if ((uint32_t)(row[x] ^ (uint8_t)inv) >= t) {
+        left = x;
+        break;
+      }
+    }
+    x = img->width;
+    while ((x - 4 > right) && !any_byte_ge(load32(&row[x - 4]) ^ inv, t))
+      x -= 4;
+    for (x = x - 1; x > right; x--) {
+      if ((uint32_t)(row[x] ^ (uint8_t)inv) >= t) {
+        right = x;
+        break;
+      }
+    }
+  }
+
+  box->x = (uint16_t)left;
+  box->y = (uint16_t)top;
+  box->width = (uint16_t)(right - left + 1);
+  box->height = (uint16_t)(bottom - top + 1);
+  return 0;
+}
+
+void tflm_pp_center(const struct tflm_pp_rect *box, uint16_t dst_width, uint16_t dst_height,
+    uint16_t fit, struct tflm_pp_rect *dst_rect)
+{
+  const uint32_t side = box->width > box->height ? box->width : box->height;
+  uint32_t w = (box->width * fit + side / 2) / side;
+  uint32_t h = (box->height * fit + side / 2) / side;
+
+  w = w ? w : 1;
+  h = h ? h : 1;
+  w = w > dst_width ? dst_width : w;
+  h = h > dst_height ? dst_height : h;
+  dst_rect->width = (uint16_t)w;
+  dst_rect->height = (uint16_t)h;
+  dst_rect->x = (uint16_t)((dst_width - w) / 2);
+  dst_rect->y = (uint16_t)((dst_height - h) / 2);
+}
+
+/* area averaging: each output pixel is the mean of its footprint */
+static void resize_area(const struct tflm_pp_quant *q, const struct tflm_pp_image *img,
+    const struct tflm_pp_rect *sr, int8_t *dst, uint16_t dst_width,
+    const struct tflm_pp_rect *dr)
+{
+  uint16_t xs[TFLM_PP_MAX_DST_WIDTH + 1];
+
+  for (uint32_t j = 0; j <= dr->width; j++)
+    xs[j] = (uint16_t)(sr->x + (j * sr->width) / dr->width);
+
+  for (uint32_t i = 0; i < dr->height; i++) {
+    uint32_t y0 = sr->y + (i * sr->height) / dr->height;
+    uint32_t y1 = sr->y + ((i + 1) * sr->height) / dr->height;
+    y1 = y1 > y0 ? y1 : y0 + 1;
+    int8_t *out = &dst[(dr->y + i) * dst_width + dr->x];
+
+    for (uint32_t j = 0; j < dr->width; j++) {
+      const uint32_t x0 = xs[j];
+      const uint32_t n = xs[j + 1] > x0 ? xs[j + 1] - x0 : 1;
+      const uint32_t count = n * (y1 - y0);
+      uint32_t sum = 0;
+      for (uint32_t y = y0; y < y1; y++)
+        sum += row_sum(&img->data[y * img->stride + x0], n);
+      out[j] = q->lut[(sum + count / 2) / count];
+    }
+  }
+}
+
+/* bilinear interpolation, 8-bit fractional positions (pixel centers aligned) */
+static void resize_bilinear(const struct tflm_pp_quant *q, const struct tflm_pp_image *img,
+    const struct tflm_pp_rect *sr, int8_t *dst, uint16_t dst_width,
+    const struct tflm_pp_rect *dr)
+{
+  uint16_t xs[TFLM_PP_MAX_DST_WIDTH];
+  uint32_t wx[TFLM_PP_MAX_DST_WIDTH];
+
+  for (uint32_t j = 0; j < dr->width; j++) {
+    int32_t fx = (int32_t)(((2 * j + 1) * sr->width * 128U) / dr->width) - 128;
+    fx = fx < 0 ? 0 : fx;
+    fx = fx > (sr->width - 1) * 256 ? (sr->width - 1) * 256 : fx;
+    const uint32_t f = fx & 0xFF;
+    xs[j] = (uint16_t)(sr->x + (fx >> 8));
+    wx[j] = (f << 16) | (256U - f);
+  }
+
+  for (uint32_t i = 0; i < dr->height; i++) {
+    int32_t fy = (int32_t)(((2 * i + 1) * sr->height * 128U) / dr->height) - 128;
+    fy = fy < 0 ? 0 : fy;
+    fy = fy > (sr->height - 1) * 256 ? (sr->height - 1) * 256 : fy;
+    const uint32_t f = fy & 0xFF;
+    const uint32_t y0 = sr->y + (fy >> 8);
+    const uint32_t y1 = (y0 + 1 < (uint32_t)(sr->y + sr->height)) ? y0 + 1 : y0;
+    const uint8_t *r0 = &img->data[y0 * img->stride];
+    const uint8_t *r1 = &img->data[y1 * img->stride];
+    const uint32_t last = sr->x + sr->width - 1;
+    int8_t *out = &dst[(dr->y + i) * dst_width + dr->x];
+
+    for (uint32_t j = 0; j < dr->width; j++) {
+      const uint32_t x0 = xs[j];
+      const uint32_t x1 = x0 < last ? x0 + 1 : x0;
+      const uint32_t top = lerp2(r0[x0], r0[x1], wx[j]);
+      const uint32_t bot = lerp2(r1[x0], r1[x1], wx[j]);
+      out[j] = q->lut[(top * (256U - f) + bot * f + 32768U) >> 16];
+    }
+  }
+}
+
+int tflm_pp_resize_quantize(const struct tflm_pp_quant *q, const struct tflm_pp_image *img,
+    const struct tflm_pp_rect *src_rect, int8_t *dst, uint16_t dst_width, uint16_t dst_height,
+    const struct tflm_pp_rect *dst_rect)
+{
+  const struct tflm_pp_rect *sr = src_rect;
+  const struct tflm_pp_rect *dr = dst_rect;
+
+  if (!sr->width || !sr->height || !dr->width || !dr->height ||
+      (dr->width > TFLM_PP_MAX_DST_WIDTH) ||
+      (sr->x + sr->width > img->width) || (sr->y + sr->height > img->height) ||
+      (dr->x + dr->width > dst_width) || (dr->y + dr->height > dst_height))
+    return -1;
+
+  /* background around the resized area, written once */
+  const int8_t bg = q->lut[q->background];
+  for (uint32_t i = 0; i < dst_height; i++) {
+    int8_t *row = &dst[i * dst_width];
+    if ((i < dr->y) || (i >= (uint32_t)(dr->y + dr->height))) {
+      memset(row, bg, dst_width);
+    } else {
+      memset(row, bg, dr->x);
+      memset(row + dr->x + dr->width, bg, dst_width - dr->x - dr->width);
+    }
+  }
+
+  if ((sr->width >= 2 * dr->width) || (sr->height >= 2 * dr->height))
+    resize_area(q, img, sr, dst, dst_width, dr);
+  else
+    resize_bilinear(q, img, sr, dst, dst_width, dr);
+  return 0;
+}
+
+int tflm_pp_mnist(const struct tflm_pp_quant *q, const struct tflm_pp_image *img,
+    uint8_t threshold, int8_t *dst, uint16_t dst_width, uint16_t dst_height, uint16_t fit)
+{
+  struct tflm_pp_rect box, dst_rect;
+
+  if (tflm_pp_bounding_box(img, q, threshold, &box) != 0) {
+    memset(dst, q->lut[q->background], (uint32_t)dst_width * dst_height);
+    return -1;
+  }
+  tflm_pp_center(&box, dst_width, dst_height, fit, &dst_rect);
+  return tflm_pp_resize_quantize(q, img, &box, dst, dst_width, dst_height, &dst_rect);
+}
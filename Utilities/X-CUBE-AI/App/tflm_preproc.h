@@ -0,0 +1,108 @@
+/**
+ ******************************************************************************
+ * @file    tflm_preproc.h
+ * @brief   Pre-processing of the image inputs (uint8 pixels -> int8 tensor)
+ ******************************************************************************
+ * @attention
+ *
+ * This software is licensed under terms that can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef __TFLM_PREPROC_H__
+#define __TFLM_PREPROC_H__
+
+/*
+ * 8-bit grayscale images are resized/centered and quantized with the
+ * parameters of the input tensor in one pass, the int8 values are written
+ * directly in the input tensor (1 channel, HxW, see tflm_c_input()).
+ *
+ * The kernels use the SIMD instructions of the Cortex-M33 (DSP extension:
+ * __USADA8, __SMUAD, __USUB8..) when available, portable C (SIMD within a
+ * register) otherwise, the results are identical.
+ *
+ * Typical use (MNIST-style digit drawn on a larger frame):
+ *
+ *   tflm_pp_quant_init(&q, 1.0f / 255.0f, info.scale, info.zero_point, 0);
+ *   tflm_pp_mnist(&q, &frame, threshold, (int8_t *)info.data, 28, 28, 20);
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tflm_pp_image {
+  const uint8_t *data;    /* 8-bit grayscale */
+  uint16_t width;
+  uint16_t height;
+  uint16_t stride;        /* bytes between two rows */
+};
+
+struct tflm_pp_rect {
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+};
+
+struct tflm_pp_quant {
+  int8_t lut[256];        /* quantized value of each pixel value */
+  uint32_t xor_mask;      /* != 0: lut[p] == p ^ mask (4 pixels per word) */
+  uint8_t background;     /* pixel value of the background (0, 255 if inverted) */
+};
+
+/*
+ * Builds the quantization table: real = pixel * pixel_scale (e.g. 1/255,
+ * pixel = 255 - pixel if invert), q = round(real / scale) + zero_point,
+ * saturated to int8. Returns -1 if scale is not valid.
+ */
+int tflm_pp_quant_init(struct tflm_pp_quant *q, float pixel_scale, float scale,
+    int32_t zero_point, int invert);
+
+/* Quantizes n pixels (image already at the size of the tensor) */
+void tflm_pp_quantize(const struct tflm_pp_quant *q, const uint8_t *src, int8_t *dst,
+    uint32_t n);
+
+/*
+ * Bounding box of the pixels which differ from the background by at least
+ * threshold. Returns -1 if the image is empty.
+ */
+int tflm_pp_bounding_box(const struct tflm_pp_image *img, const struct tflm_pp_quant *q,
+    uint8_t threshold, struct tflm_pp_rect *box);
+
+/*
+ * Returns the rectangle of size fit (longest side, aspect ratio kept)
+ * centered in a dst_width x dst_height image.
+ */
+void tflm_pp_center(const struct tflm_pp_rect *box, uint16_t dst_width, uint16_t dst_height,
+    uint16_t fit, struct tflm_pp_rect *dst_rect);
+
+/*
+ * Resizes the src_rect area of img to the dst_rect area of the
+ * dst_width x dst_height int8 tensor and quantizes it, the other pixels are
+ * set to the quantized background. Area averaging when the image is reduced
+ * by 2 or more, bilinear interpolation otherwise. Returns -1 if a rectangle
+ * is empty or out of bounds.
+ */
+int tflm_pp_resize_quantize(const struct tflm_pp_quant *q, const struct tflm_pp_image *img,
+    const struct tflm_pp_rect *src_rect, int8_t *dst, uint16_t dst_width, uint16_t dst_height,
+    const struct tflm_pp_rect *dst_rect);
+
+/*
+ * MNIST-style pre-processing: bounding box of the digit, resized to fit
+ * pixels (20 for MNIST) and centered in the dst_width x dst_height tensor.
+ * Returns -1 if no digit is found (tensor set to the background).
+ */
+int tflm_pp_mnist(const struct tflm_pp_quant *q, const struct tflm_pp_image *img,
+    uint8_t threshold, int8_t *dst, uint16_t dst_width, uint16_t dst_height, uint16_t fit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFLM_PREPROC_H__ */
@@ -0,0 +1,255 @@
+#
+# TFLM operators (kernels) and CMSIS-NN library sources
+#
+# Included by the firmware build (see TFLM_RUNTIME_USE_ALL_OPERATORS in the
+# top-level CMakeLists.txt) and by the host tools (ml_model/tools).
+# The CMSIS-NN sources are grouped by function family, the generated
+# Utilities/X-CUBE-AI/App/tflm_network_kernels.cmake only references the
+# groups used by the embedded model.
+#
+
+set(TFLM_KERNELS_PATH               ${PROJ_PATH}/Middlewares/tensorflow/tensorflow/lite/micro/kernels)
+set(CMSIS_NN_SRC_PATH               ${PROJ_PATH}/Middlewares/tensorflow/third_party/cmsis_nn/Source)
+
+# Kernels of all the built-in operators (AllOpsResolver)
+set(tflm_all_kernels_SRCS
+    ${PROJ_PATH}/Middlewares/tensorflow/tensorflow/lite/micro/all_ops_resolver.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/add.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/block_sparse_fully_connected.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/conv.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/depthwise_conv.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/fully_connected.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/mul.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/pooling.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/softmax.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/svdf.cc
+    ${TFLM_KERNELS_PATH}/cmsis_nn/unidirectional_sequence_lstm.cc
+    ${TFLM_KERNELS_PATH}/activations.cc
+    ${TFLM_KERNELS_PATH}/activations_common.cc
+    ${TFLM_KERNELS_PATH}/add_common.cc
+    ${TFLM_KERNELS_PATH}/add_n.cc
+    ${TFLM_KERNELS_PATH}/arg_min_max.cc
+    ${TFLM_KERNELS_PATH}/assign_variable.cc
+    ${TFLM_KERNELS_PATH}/batch_to_space_nd.cc
+    ${TFLM_KERNELS_PATH}/broadcast_args.cc
+    ${TFLM_KERNELS_PATH}/broadcast_to.cc
+    ${TFLM_KERNELS_PATH}/call_once.cc
+    ${TFLM_KERNELS_PATH}/cast.cc
+    ${TFLM_KERNELS_PATH}/ceil.cc
+    ${TFLM_KERNELS_PATH}/circular_buffer.cc
+    ${TFLM_KERNELS_PATH}/circular_buffer_common.cc
+    ${TFLM_KERNELS_PATH}/comparisons.cc
+    ${TFLM_KERNELS_PATH}/concatenation.cc
+    ${TFLM_KERNELS_PATH}/conv_common.cc
+    ${TFLM_KERNELS_PATH}/cumsum.cc
+    ${TFLM_KERNELS_PATH}/depth_to_space.cc
+    ${TFLM_KERNELS_PATH}/depthwise_conv_common.cc
+    ${TFLM_KERNELS_PATH}/dequantize.cc
+    ${TFLM_KERNELS_PATH}/dequantize_common.cc
+    ${TFLM_KERNELS_PATH}/detection_postprocess.cc
+    ${TFLM_KERNELS_PATH}/div.cc
+    ${TFLM_KERNELS_PATH}/elementwise.cc
+    ${TFLM_KERNELS_PATH}/elu.cc
+    ${TFLM_KERNELS_PATH}/ethosu.cc
+    ${TFLM_KERNELS_PATH}/exp.cc
+    ${TFLM_KERNELS_PATH}/expand_dims.cc
+    ${TFLM_KERNELS_PATH}/fill.cc
+    ${TFLM_KERNELS_PATH}/floor.cc
+    ${TFLM_KERNELS_PATH}/floor_div.cc
+    ${TFLM_KERNELS_PATH}/floor_mod.cc
+    ${TFLM_KERNELS_PATH}/fully_connected_common.cc
+    ${TFLM_KERNELS_PATH}/gather.cc
+    ${TFLM_KERNELS_PATH}/gather_nd.cc
+    ${TFLM_KERNELS_PATH}/hard_swish.cc
+    ${TFLM_KERNELS_PATH}/hard_swish_common.cc
+    ${TFLM_KERNELS_PATH}/if.cc
+    ${TFLM_KERNELS_PATH}/kernel_util.cc
+    ${TFLM_KERNELS_PATH}/l2_pool_2d.cc
+    ${TFLM_KERNELS_PATH}/l2norm.cc
+    ${TFLM_KERNELS_PATH}/leaky_relu.cc
+    ${TFLM_KERNELS_PATH}/leaky_relu_common.cc
+    ${TFLM_KERNELS_PATH}/log_softmax.cc
+    ${TFLM_KERNELS_PATH}/logical.cc
+    ${TFLM_KERNELS_PATH}/logical_common.cc
+    ${TFLM_KERNELS_PATH}/logistic.cc
+    ${TFLM_KERNELS_PATH}/logistic_common.cc
+    ${TFLM_KERNELS_PATH}/lstm_eval.cc
+    ${TFLM_KERNELS_PATH}/lstm_eval_common.cc
+    ${TFLM_KERNELS_PATH}/maximum_minimum.cc
+    ${TFLM_KERNELS_PATH}/micro_tensor_utils.cc
+    ${TFLM_KERNELS_PATH}/mirror_pad.cc
+    ${TFLM_KERNELS_PATH}/mul_common.cc
+    ${TFLM_KERNELS_PATH}/neg.cc
+    ${TFLM_KERNELS_PATH}/pack.cc
+    ${TFLM_KERNELS_PATH}/pad.cc
+    ${TFLM_KERNELS_PATH}/pooling_common.cc
+    ${TFLM_KERNELS_PATH}/prelu.cc
+    ${TFLM_KERNELS_PATH}/prelu_common.cc
+    ${TFLM_KERNELS_PATH}/quantize.cc
+    ${TFLM_KERNELS_PATH}/quantize_common.cc
+    ${TFLM_KERNELS_PATH}/read_variable.cc
+    ${TFLM_KERNELS_PATH}/reduce.cc
+    ${TFLM_KERNELS_PATH}/reduce_common.cc
+    ${TFLM_KERNELS_PATH}/reshape.cc
+    ${TFLM_KERNELS_PATH}/resize_bilinear.cc
+    ${TFLM_KERNELS_PATH}/resize_nearest_neighbor.cc
+    ${TFLM_KERNELS_PATH}/round.cc
+    ${TFLM_KERNELS_PATH}/select.cc
+    ${TFLM_KERNELS_PATH}/shape.cc
+    ${TFLM_KERNELS_PATH}/slice.cc
+    ${TFLM_KERNELS_PATH}/softmax_common.cc
+    ${TFLM_KERNELS_PATH}/space_to_batch_nd.cc
+    ${TFLM_KERNELS_PATH}/space_to_depth.cc
+    ${TFLM_KERNELS_PATH}/split.cc
+    ${TFLM_KERNELS_PATH}/split_v.cc
+    ${TFLM_KERNELS_PATH}/squared_difference.cc
+    ${TFLM_KERNELS_PATH}/squeeze.cc
+    ${TFLM_KERNELS_PATH}/strided_slice.cc
+    ${TFLM_KERNELS_PATH}/sub.cc
+    ${TFLM_KERNELS_PATH}/sub_common.cc
+    ${TFLM_KERNELS_PATH}/svdf_common.cc
+    ${TFLM_KERNELS_PATH}/tanh.cc
+    ${TFLM_KERNELS_PATH}/transpose.cc
+    ${TFLM_KERNELS_PATH}/transpose_conv.cc
+    ${TFLM_KERNELS_PATH}/unpack.cc
+    ${TFLM_KERNELS_PATH}/var_handle.cc
+    ${TFLM_KERNELS_PATH}/weight_compression.cc
+    ${TFLM_KERNELS_PATH}/while.cc
+    ${TFLM_KERNELS_PATH}/zeros_like.cc
+)
+
+# Test support (kernel runner, test models)
+set(tflm_test_support_SRCS
+    ${TFLM_KERNELS_PATH}/kernel_runner.cc
+    ${PROJ_PATH}/Middlewares/tensorflow/tensorflow/lite/micro/mock_micro_graph.cc
+    ${PROJ_PATH}/Middlewares/tensorflow/tensorflow/lite/micro/test_helper_custom_ops.cc
+    ${PROJ_PATH}/Middlewares/tensorflow/tensorflow/lite/micro/test_helpers.cc
+)
+
+# CMSIS-NN, per function group
+set(cmsis_nn_ActivationFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/ActivationFunctions/arm_nn_activation_s16.c
+    ${CMSIS_NN_SRC_PATH}/ActivationFunctions/arm_relu6_s8.c
+    ${CMSIS_NN_SRC_PATH}/ActivationFunctions/arm_relu_q15.c
+    ${CMSIS_NN_SRC_PATH}/ActivationFunctions/arm_relu_q7.c
+)
+
+set(cmsis_nn_BasicMathFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/BasicMathFunctions/arm_elementwise_add_s16.c
+    ${CMSIS_NN_SRC_PATH}/BasicMathFunctions/arm_elementwise_add_s8.c
+    ${CMSIS_NN_SRC_PATH}/BasicMathFunctions/arm_elementwise_mul_s16.c
+    ${CMSIS_NN_SRC_PATH}/BasicMathFunctions/arm_elementwise_mul_s16_s8.c
+    ${CMSIS_NN_SRC_PATH}/BasicMathFunctions/arm_elementwise_mul_s8.c
+)
+
+set(cmsis_nn_ConcatenationFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/ConcatenationFunctions/arm_concatenation_s8_w.c
+    ${CMSIS_NN_SRC_PATH}/ConcatenationFunctions/arm_concatenation_s8_x.c
+    ${CMSIS_NN_SRC_PATH}/ConcatenationFunctions/arm_concatenation_s8_y.c
+    ${CMSIS_NN_SRC_PATH}/ConcatenationFunctions/arm_concatenation_s8_z.c
+)
+
+set(cmsis_nn_ConvolutionFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_1_x_n_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_1x1_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_1x1_s8_fast.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_direct_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_fast_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_get_buffer_sizes_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_get_buffer_sizes_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_s4.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_s8_reordered.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_winograd_3x3_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_wrapper_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_convolve_wrapper_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_depthwise_conv_3x3_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_depthwise_conv_fast_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_depthwise_conv_get_buffer_sizes_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_depthwise_conv_get_buffer_sizes_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_depthwise_conv_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_depthwise_conv_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_depthwise_conv_s8_opt.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_depthwise_conv_wrapper_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_depthwise_conv_wrapper_s8.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_nn_depthwise_conv_s8_core.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_nn_mat_mult_kernel_s4_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_nn_mat_mult_kernel_s8_s16.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_nn_mat_mult_kernel_s8_s16_reordered.c
+    ${CMSIS_NN_SRC_PATH}/ConvolutionFunctions/arm_nn_mat_mult_s8.c
+)
+
+set(cmsis_nn_FullyConnectedFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/FullyConnectedFunctions/arm_fully_connected_block_sparse_s8.c
+    ${CMSIS_NN_SRC_PATH}/FullyConnectedFunctions/arm_fully_connected_get_buffer_sizes_s16.c
+    ${CMSIS_NN_SRC_PATH}/FullyConnectedFunctions/arm_fully_connected_get_buffer_sizes_s8.c
+    ${CMSIS_NN_SRC_PATH}/FullyConnectedFunctions/arm_fully_connected_s16.c
+    ${CMSIS_NN_SRC_PATH}/FullyConnectedFunctions/arm_fully_connected_s4.c
+    ${CMSIS_NN_SRC_PATH}/FullyConnectedFunctions/arm_fully_connected_s8.c
+)
+
+set(cmsis_nn_LSTMFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/LSTMFunctions/arm_lstm_unidirectional_s8_s16.c
+)
+
+set(cmsis_nn_NNSupportFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_depthwise_conv_nt_t_padded_s8.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_depthwise_conv_nt_t_s16.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_depthwise_conv_nt_t_s8.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_lstm_calculate_gate_s8_s16.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_lstm_step_s8_s16.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_lstm_update_cell_state_s16.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_lstm_update_output_s8_s16.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_mat_mul_core_1x_s8.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_mat_mul_core_4x_s8.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_mat_mul_kernel_s16.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_mat_mult_nt_t_s8.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_vec_mat_mul_result_acc_s8.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_vec_mat_mult_t_s16.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_vec_mat_mult_t_s4.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_vec_mat_mult_t_s8.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nn_vec_mat_mult_t_svdf_s8.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_nntables.c
+    ${CMSIS_NN_SRC_PATH}/NNSupportFunctions/arm_q7_to_q15_with_offset.c
+)
+
+set(cmsis_nn_PoolingFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/PoolingFunctions/arm_avgpool_get_buffer_sizes_s16.c
+    ${CMSIS_NN_SRC_PATH}/PoolingFunctions/arm_avgpool_get_buffer_sizes_s8.c
+    ${CMSIS_NN_SRC_PATH}/PoolingFunctions/arm_avgpool_s16.c
+    ${CMSIS_NN_SRC_PATH}/PoolingFunctions/arm_avgpool_s8.c
+    ${CMSIS_NN_SRC_PATH}/PoolingFunctions/arm_max_pool_s16.c
+    ${CMSIS_NN_SRC_PATH}/PoolingFunctions/arm_max_pool_s8.c
+)
+
+set(cmsis_nn_ReshapeFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/ReshapeFunctions/arm_reshape_s8.c
+)
+
+set(cmsis_nn_SoftmaxFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/SoftmaxFunctions/arm_nn_softmax_common_s8.c
+    ${CMSIS_NN_SRC_PATH}/SoftmaxFunctions/arm_softmax_s16.c
+    ${CMSIS_NN_SRC_PATH}/SoftmaxFunctions/arm_softmax_s8.c
+    ${CMSIS_NN_SRC_PATH}/SoftmaxFunctions/arm_softmax_s8_s16.c
+    ${CMSIS_NN_SRC_PATH}/SoftmaxFunctions/arm_softmax_u8.c
+)
+
+set(cmsis_nn_SVDFunctions_SRCS
+    ${CMSIS_NN_SRC_PATH}/SVDFunctions/arm_svdf_s8.c
+    ${CMSIS_NN_SRC_PATH}/SVDFunctions/arm_svdf_state_s16_s8.c
+)
+
+set(cmsis_nn_SRCS
+    ${cmsis_nn_ActivationFunctions_SRCS}
+    ${cmsis_nn_BasicMathFunctions_SRCS}
+    ${cmsis_nn_ConcatenationFunctions_SRCS}
+    ${cmsis_nn_ConvolutionFunctions_SRCS}
+    ${cmsis_nn_FullyConnectedFunctions_SRCS}
+    ${cmsis_nn_LSTMFunctions_SRCS}
+    ${cmsis_nn_NNSupportFunctions_SRCS}
+    ${cmsis_nn_PoolingFunctions_SRCS}
+    ${cmsis_nn_ReshapeFunctions_SRCS}
+    ${cmsis_nn_SoftmaxFunctions_SRCS}
+    ${cmsis_nn_SVDFunctions_SRCS}
+)
@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+ * @file    tflm_alloc_bench.cc
+ * @brief   Host benchmark of the model set-up (tflm_c_create/AllocateTensors)
+ ******************************************************************************
+ *
+ * usage: tflm_alloc_bench [-n runs] <model.tflite> [<model.tflite> ..]
+ *
+ * For each model, reports:
+ * - the duration of tflm_c_create() (AllocateTensors() included) and of the
+ *   memory planning step alone (GreedyMemoryPlanner, replayed with the
+ *   requirements of the model) and of tflm_c_create_from_snapshot()
+ *   (warm-start), min/median over the runs,
+ * - the size of the memory plan (non-persistent part of the arena) and the
+ *   arena used bytes. Note that the persistent part is larger on a 64-bit
+ *   host than on target.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+
+#include "tflm_c.h"
+#include "tflm_host_utils.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+uint8_t planner_scratch[64 * 1024] __attribute__((aligned(16)));
+uint8_t snapshot[tflm_host::kHostArenaSize];
+
+struct Stats {
+  double min;
+  double median;
+};
+
+Stats stats(std::vector<double>& v)
+{
+  std::sort(v.begin(), v.end());
+  return {v.front(), v[v.size() / 2]};
+}
+
+int bench(const char* path, int runs)
+{
+  std::vector<uint8_t> data = tflm_host::load_file(path);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", path);
+    return 1;
+  }
+
+  /* buffer requirements and plan size (the interpreter is released before the
+   * arena is re-used) */
+  std::vector<tflm_host::BufferRequirement> reqs;
+  size_t plan_size;
+  {
+    static tflite::AllOpsResolver resolver;
+    tflm_host::RecordingMemoryPlanner planner;
+    tflite::MicroAllocator* allocator =
+        tflite::MicroAllocator::Create(arena, sizeof(arena), &planner);
+    tflite::MicroInterpreter interpreter(tflite::GetModel(data.data()), resolver, allocator);
+    if (interpreter.AllocateTensors() != kTfLiteOk) {
+      fprintf(stderr, "E: AllocateTensors() fails\n");
+      return 1;
+    }
+    reqs = planner.requirements;
+    plan_size = planner.GetMaximumMemorySize();
+  }
+  int n_offline = 0;
+  for (const auto& r : reqs)
+    n_offline += r.offline_offset != tflite::kOnlinePlannedBuffer;
+
+  /* tflm_c_create(): full set-up as done on target at boot */
+  std::vector<double> t_create;
+  int32_t used = 0;
+  for (int i = 0; i < runs; i++) {
+    uint32_t hdl;
+    double t0 = tflm_host::now_us();
+    if (tflm_c_create(data.data(), arena, sizeof(arena), &hdl) != kTfLiteOk) {
+      fprintf(stderr, "E: tflm_c_create() fails\n");
+      return 1;
+    }
+    t_create.push_back(tflm_host::now_us() - t0);
+    used = tflm_c_arena_used_bytes(hdl);
+    tflm_c_destroy(hdl);
+  }
+
+  /* tflm_c_create_from_snapshot(): warm-start */
+  const uint8_t key[TFLM_C_SNAPSHOT_KEY_SIZE] = {0};
+  uint32_t hdl, snapshot_size = 0;
+  if ((tflm_c_create(data.data(), arena, sizeof(arena), &hdl) != kTfLiteOk) ||
+      (tflm_c_snapshot_save(hdl, key, snapshot, sizeof(snapshot), &snapshot_size) != kTfLiteOk)) {
+    fprintf(stderr, "E: tflm_c_snapshot_save() fails\n");
+    return 1;
+  }
+  tflm_c_destroy(hdl);
+  std::vector<double> t_restore;
+  for (int i = 0; i < runs; i++) {
+    double t0 = tflm_host::now_us();
+    if (tflm_c_create_from_snapshot(data.data(), arena, sizeof(arena), key, snapshot,
+        snapshot_size, &hdl) != kTfLiteOk) {
+      fprintf(stderr, "E: tflm_c_create_from_snapshot() fails\n");
+      return 1;
+    }
+    t_restore.push_back(tflm_host::now_us() - t0);
+    tflm_c_destroy(hdl);
+  }
+
+  /* memory planning alone */
+  std::vector<double> t_plan;
+  for (int i = 0; i < runs; i++) {
+    tflite::GreedyMemoryPlanner greedy;
+    double t0 = tflm_host::now_us();
+    greedy.Init(planner_scratch, sizeof(planner_scratch));
+    for (const auto& r : reqs) {
+      if (r.offline_offset == tflite::kOnlinePlannedBuffer)
+        greedy.AddBuffer(r.size, r.first, r.last);
+      else
+        greedy.AddBuffer(r.size, r.first, r.last, r.offline_offset);
+    }
+    greedy.GetMaximumMemorySize();
+    t_plan.push_back(tflm_host::now_us() - t0);
+  }
+
+  Stats s_create = stats(t_create);
+  Stats s_plan = stats(t_plan);
+  Stats s_restore = stats(t_restore);
+  printf("%s\n", path);
+  printf("  buffers          : %d (%d offline planned)\n", (int)reqs.size(), n_offline);
+  printf("  memory plan      : %d bytes\n", (int)plan_size);
+  printf("  arena used       : %d bytes (host)\n", (int)used);
+  printf("  tflm_c_create    : min %.2f us, median %.2f us\n", s_create.min, s_create.median);
+  printf("  planning         : min %.2f us, median %.2f us\n", s_plan.min, s_plan.median);
+  printf("  snapshot         : %d bytes (host)\n", (int)snapshot_size);
+  printf("  restore          : min %.2f us, median %.2f us\n", s_restore.min, s_restore.median);
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 1000;
+  int res = 0;
+  int n_models = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      runs = std::max(1, atoi(argv[++i]));
+      continue;
+    }
+    res |= bench(argv[i], runs);
+    n_models++;
+  }
+  if (!n_models) {
+    fprintf(stderr, "usage: %s [-n runs] <model.tflite> [<model.tflite> ..]\n", argv[0]);
+    return 2;
+  }
+  return res;
+}
@@ -0,0 +1,257 @@
+/**
+ ******************************************************************************
+ * @file    tflm_bench.cc
+ * @brief   Host benchmark of a TFLite model, per operator and end-to-end
+ ******************************************************************************
+ *
+ * usage: tflm_bench <model.tflite> [-n runs] [-w warmup] [-c out.csv]
+ *                   [-r baseline.csv] [-t tolerance_pct] [-s slack_us]
+ *
+ * The model is run with the host TFLM runtime (all built-in operators,
+ * CMSIS-NN portable C path) on random inputs (fixed seed):
+ * - end-to-end: duration of tflm_c_invoke(), no observer registered,
+ * - per operator: durations reported by the observer (tflm_c_observer_register()),
+ *   in separate runs (the callbacks add their own overhead).
+ * The distributions (min, median, p90, p99, max in us) are printed and saved
+ * as CSV (-c), one row per operator and a "total" row.
+ *
+ * Regression check (CI): with -r, the medians are compared with the rows of a
+ * CSV written by a previous run (same model, same host), exit code 1 if a
+ * median exceeds baseline * (1 + tolerance_pct / 100) + slack_us. Operators
+ * are matched by index and name.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+struct Stats {
+  std::string name;
+  double min, median, p90, p99, max;
+};
+
+Stats stats(const std::string& name, std::vector<double> v)
+{
+  std::sort(v.begin(), v.end());
+  auto q = [&v](double p) { return v[(size_t)(p * (v.size() - 1) + 0.5)]; };
+  return {name, v.front(), q(0.5), q(0.9), q(0.99), v.back()};
+}
+
+uint64_t host_time_ns(int mode)
+{
+  return (uint64_t)(tflm_host::now_us() * 1000.0);
+}
+
+/* per operator durations (us), indexed by the operator */
+struct NodeTimes {
+  std::vector<std::string> names;
+  std::vector<std::vector<double>> samples;
+  bool record = false;
+};
+
+int record_node(const void* cookie, const uint32_t flags, const struct tflm_c_node* node)
+{
+  NodeTimes* times = (NodeTimes*)cookie;
+  const uint32_t idx = node->node_info.idx;
+  if (idx >= times->samples.size()) {
+    times->samples.resize(idx + 1);
+    times->names.resize(idx + 1);
+  }
+  times->names[idx] = node->node_info.name ? node->node_info.name : "?";
+  if (times->record)
+    times->samples[idx].push_back((double)node->node_info.dur / 1000.0);
+  return 0;
+}
+
+void fill_inputs(uint32_t hdl)
+{
+  struct tflm_c_tensor_info info;
+  srand(1);
+  for (int i = 0; i < tflm_c_inputs_size(hdl); i++) {
+    tflm_c_input(hdl, i, &info);
+    for (size_t j = 0; j < info.bytes; j++)
+      ((uint8_t*)info.data)[j] = (uint8_t)rand();
+  }
+}
+
+bool save_csv(const char* path, const std::vector<Stats>& rows)
+{
+  FILE* f = fopen(path, "w");
+  if (!f)
+    return false;
+  fprintf(f, "idx,name,min_us,median_us,p90_us,p99_us,max_us\n");
+  for (size_t i = 0; i < rows.size(); i++) {
+    const Stats& s = rows[i];
+    const std::string idx = (i + 1 == rows.size()) ? "total" : std::to_string(i);
+    fprintf(f, "%s,%s,%.3f,%.3f,%.3f,%.3f,%.3f\n", idx.c_str(), s.name.c_str(), s.min,
+        s.median, s.p90, s.p99, s.max);
+  }
+  return fclose(f) == 0;
+}
+
+/* rows of a CSV written by save_csv(): "idx,name" -> median */
+bool load_csv(const char* path, std::vector<std::pair<std::string, double>>* rows)
+{
+  FILE* f = fopen(path, "r");
+  if (!f)
+    return false;
+  char line[256];
+  bool ok = fgets(line, sizeof(line), f) != nullptr;  /* header */
+  while (ok && fgets(line, sizeof(line), f)) {
+    char idx[32], name[64];
+    double min, median;
+    if (sscanf(line, "%31[^,],%63[^,],%lf,%lf", idx, name, &min, &median) != 4) {
+      ok = false;
+      break;
+    }
+    rows->emplace_back(std::string(idx) + "," + name, median);
+  }
+  fclose(f);
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 200;
+  int warmup = 10;
+  double tolerance = 20.0;
+  double slack = 2.0;
+  const char* path = nullptr;
+  const char* csv = nullptr;
+  const char* baseline = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+      warmup = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+      csv = argv[++i];
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+      baseline = argv[++i];
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      tolerance = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      slack = atof(argv[++i]);
+    else if (!path && argv[i][0] != '-')
+      path = argv[i];
+    else {
+      path = nullptr;
+      break;
+    }
+  }
+  if (!path || runs < 1 || warmup < 0) {
+    fprintf(stderr, "usage: %s <model.tflite> [-n runs] [-w warmup] [-c out.csv]"
+        " [-r baseline.csv] [-t tolerance_pct] [-s slack_us]\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(path);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", path);
+    return 1;
+  }
+  uint32_t hdl;
+  if (tflm_c_create(data.data(), arena, sizeof(arena), &hdl) != kTfLiteOk) {
+    fprintf(stderr, "E: tflm_c_create() fails\n");
+    return 1;
+  }
+  fill_inputs(hdl);
+
+  /* end-to-end, without observer */
+  std::vector<double> total;
+  bool ok = true;
+  for (int r = 0; r < warmup + runs && ok; r++) {
+    double t0 = tflm_host::now_us();
+    ok = tflm_c_invoke(hdl) == kTfLiteOk;
+    if (r >= warmup)
+      total.push_back(tflm_host::now_us() - t0);
+  }
+
+  /* per operator */
+  NodeTimes times;
+  struct tflm_c_observer_options options = {record_node, host_time_ns, &times,
+      OBSERVER_FLAGS_TIME_ONLY};
+  ok = ok && tflm_c_observer_register(hdl, &options) == kTfLiteOk;
+  for (int r = 0; r < warmup + runs && ok; r++) {
+    times.record = r >= warmup;
+    ok = tflm_c_invoke(hdl) == kTfLiteOk;
+  }
+  if (ok)
+    tflm_c_observer_unregister(hdl, &options);
+  const int32_t n_ops = tflm_c_operators_size(hdl);
+  const int32_t arena_used = tflm_c_arena_used_bytes(hdl);
+  tflm_c_destroy(hdl);
+  if (!ok || (int32_t)times.samples.size() != n_ops) {
+    fprintf(stderr, "E: unable to run the model\n");
+    return 1;
+  }
+
+  std::vector<Stats> rows;
+  double sum = 0;
+  for (int32_t i = 0; i < n_ops; i++) {
+    rows.push_back(stats(times.names[i], times.samples[i]));
+    sum += rows.back().median;
+  }
+  rows.push_back(stats("invoke", total));
+
+  printf("model              : %s\n", path);
+  printf("operators          : %d, arena %d bytes, %d runs (%d warm-up)\n", (int)n_ops,
+      (int)arena_used, runs, warmup);
+  printf("\n  %-4s %-24s %9s %9s %9s %9s %9s %6s\n", "idx", "operator", "min", "median", "p90",
+      "p99", "max", "%");
+  for (size_t i = 0; i < rows.size(); i++) {
+    const Stats& s = rows[i];
+    const bool last = i + 1 == rows.size();
+    if (last)
+      printf("\n");
+    printf("  %-4s %-24s %9.2f %9.2f %9.2f %9.2f %9.2f %6.1f\n",
+        last ? "" : std::to_string(i).c_str(), s.name.c_str(), s.min, s.median, s.p90, s.p99,
+        s.max, last ? 100.0 : 100.0 * s.median / sum);
+  }
+  printf("\n");
+
+  if (csv && !save_csv(csv, rows)) {
+    fprintf(stderr, "E: unable to write %s\n", csv);
+    return 1;
+  }
+
+  if (baseline) {
+    std::vector<std::pair<std::string, double>> ref;
+    if (!load_csv(baseline, &ref) || ref.size() != rows.size()) {
+      fprintf(stderr, "E: %s is not a baseline of this model\n", baseline);
+      return 1;
+    }
+    int regressions = 0;
+    for (size_t i = 0; i < rows.size(); i++) {
+      const std::string key = ((i + 1 == rows.size()) ? std::string("total")
+          : std::to_string(i)) + "," + rows[i].name;
+      if (ref[i].first != key) {
+        fprintf(stderr, "E: %s is not a baseline of this model (%s)\n", baseline, key.c_str());
+        return 1;
+      }
+      const double limit = ref[i].second * (1.0 + tolerance / 100.0) + slack;
+      if (rows[i].median > limit) {
+        printf("regression         : %s median %.2f us > %.2f us (baseline %.2f us)\n",
+            key.c_str(), rows[i].median, limit, ref[i].second);
+        regressions++;
+      }
+    }
+    printf("baseline           : %s, %d regression(s) (+%g%% +%g us)\n", baseline, regressions,
+        tolerance, slack);
+    if (regressions)
+      return 1;
+  }
+  return 0;
+}
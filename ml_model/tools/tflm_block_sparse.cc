@@ -0,0 +1,438 @@
+/**
+ ******************************************************************************
+ * @file    tflm_block_sparse.cc
+ * @brief   Host conversion of the fully connected layers to block sparse
+ ******************************************************************************
+ *
+ * usage: tflm_block_sparse <model.tflite> <output.tflite> [-b RxC] [-s sparsity]
+ *                          [-n runs]
+ *
+ * The int8 FULLY_CONNECTED operators (int8 input, constant filter not
+ * compressed nor shared, NONE/RELU/RELU_N1_TO_1/RELU6 activation) are replaced
+ * by the BLOCK_SPARSE_FULLY_CONNECTED custom operator: the filter is cut in
+ * blocks of R x C values (R output channels, C accumulation depth, default
+ * 1x16) and only the blocks with a non-zero value are stored (see
+ * kernels/block_sparse_fully_connected.h), arm_fully_connected_block_sparse_s8()
+ * skips the others.
+ *
+ * Without -s the conversion is lossless: only the all-zero blocks are dropped
+ * (filter pruned at training time, see dense_block_sparsity in
+ * train_mnist_model.py). With -s, the given fraction of the blocks of each
+ * layer with the smallest L1 norms are pruned first (magnitude pruning, no
+ * retraining: the accuracy loss is reported). A layer is kept dense if the
+ * block sparse filter would not be smaller, the model is then copied as is.
+ *
+ * Three models are run with the host TFLM runtime on the same inputs (random
+ * strokes): the original model, the block sparse one and a dense model with
+ * the same pruned filters: the outputs of the last two must be identical. The
+ * MAC reduction of the converted layers, the sizes, the invoke durations and
+ * the output difference/top-1 agreement with the original model are reported.
+ * Exit code 1 if the block sparse outputs differ from the dense ones.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/lite/micro/kernels/block_sparse_fully_connected.h"
+#include "tensorflow/lite/micro/kernels/weight_compression.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+constexpr int kSamples = 32;
+
+tflite::BuiltinOperator op_code(const tflite::ModelT& model, const tflite::OperatorT& op)
+{
+  const tflite::OperatorCodeT& code = *model.operator_codes[op.opcode_index];
+  return std::max(code.builtin_code, (tflite::BuiltinOperator)code.deprecated_builtin_code);
+}
+
+/* number of operator inputs referencing the tensor */
+int tensor_uses(const tflite::SubGraphT& sg, int tensor)
+{
+  int uses = 0;
+  for (const auto& op : sg.operators)
+    uses += (int)std::count(op->inputs.begin(), op->inputs.end(), tensor);
+  return uses;
+}
+
+int buffer_uses(const tflite::ModelT& model, uint32_t buffer)
+{
+  int uses = 0;
+  for (const auto& s : model.subgraphs)
+    for (const auto& t : s->tensors)
+      uses += t->buffer == buffer;
+  return uses;
+}
+
+size_t element_count(const std::vector<int>& shape)
+{
+  size_t n = 1;
+  for (int d : shape)
+    n *= (size_t)d;
+  return n;
+}
+
+struct Layer {
+  std::string name;
+  int rows, cols, batches;
+  int blocks, blocks_kept;
+  size_t bytes_dense, bytes_sparse;
+  bool converted;
+};
+
+/* Index of the BLOCK_SPARSE_FULLY_CONNECTED operator code, added if needed */
+int custom_code(tflite::ModelT* model)
+{
+  for (size_t i = 0; i < model->operator_codes.size(); i++) {
+    const tflite::OperatorCodeT& code = *model->operator_codes[i];
+    if (code.builtin_code == tflite::BuiltinOperator_CUSTOM &&
+        code.custom_code == tflite::micro::kBlockSparseFullyConnectedName)
+      return (int)i;
+  }
+  std::unique_ptr<tflite::OperatorCodeT> code(new tflite::OperatorCodeT());
+  code->builtin_code = tflite::BuiltinOperator_CUSTOM;
+  code->deprecated_builtin_code = (int8_t)tflite::BuiltinOperator_CUSTOM;
+  code->custom_code = tflite::micro::kBlockSparseFullyConnectedName;
+  code->version = 1;
+  model->operator_codes.push_back(std::move(code));
+  return (int)model->operator_codes.size() - 1;
+}
+
+/* Removes the operator codes no operator refers to any more */
+void remove_unused_codes(tflite::ModelT* model)
+{
+  std::vector<int> remap(model->operator_codes.size(), -1);
+  std::vector<std::unique_ptr<tflite::OperatorCodeT>> codes;
+  for (const auto& sg : model->subgraphs)
+    for (const auto& op : sg->operators)
+      remap[op->opcode_index] = 0;
+  for (size_t i = 0; i < remap.size(); i++) {
+    if (remap[i] < 0)
+      continue;
+    remap[i] = (int)codes.size();
+    codes.push_back(std::move(model->operator_codes[i]));
+  }
+  model->operator_codes = std::move(codes);
+  for (const auto& sg : model->subgraphs)
+    for (const auto& op : sg->operators)
+      op->opcode_index = (uint32_t)remap[op->opcode_index];
+}
+
+/* BlockSparseWeightsHeader and the sections of the rows x cols filter w */
+std::vector<uint8_t> encode(const int8_t* w, int rows, int cols, int br, int bc)
+{
+  tflite::micro::BlockSparseWeightsHeader header = {};
+  header.magic = tflite::micro::kBlockSparseWeightsMagic;
+  header.rows = (uint16_t)rows;
+  header.cols = (uint16_t)cols;
+  header.block_rows = (uint8_t)br;
+  header.block_cols = (uint8_t)bc;
+
+  const int n_block_rows = (int)tflite::micro::BlockSparseRowCount(header);
+  const int n_block_cols = (int)tflite::micro::BlockSparseColCount(header);
+  std::vector<uint16_t> row_ptr(1, 0), block_col;
+  std::vector<int8_t> values;
+  for (int r = 0; r < n_block_rows; r++) {
+    for (int c = 0; c < n_block_cols; c++) {
+      std::vector<int8_t> block(br * bc, 0);
+      bool zero = true;
+      for (int i = 0; i < br && r * br + i < rows; i++)
+        for (int j = 0; j < bc && c * bc + j < cols; j++) {
+          block[i * bc + j] = w[(size_t)(r * br + i) * cols + c * bc + j];
+          zero &= block[i * bc + j] == 0;
+        }
+      if (zero)
+        continue;
+      block_col.push_back((uint16_t)c);
+      values.insert(values.end(), block.begin(), block.end());
+    }
+    row_ptr.push_back((uint16_t)block_col.size());
+  }
+  header.block_count = (uint16_t)block_col.size();
+
+  std::vector<uint8_t> blob(tflite::micro::BlockSparseWeightsSize(header), 0);
+  memcpy(blob.data(), &header, sizeof(header));
+  memcpy(&blob[tflite::micro::BlockSparseRowPtrOffset()], row_ptr.data(),
+      row_ptr.size() * sizeof(uint16_t));
+  memcpy(&blob[tflite::micro::BlockSparseColOffset(header)], block_col.data(),
+      block_col.size() * sizeof(uint16_t));
+  memcpy(&blob[tflite::micro::BlockSparseValuesOffset(header)], values.data(), values.size());
+  return blob;
+}
+
+/* Zeroes the fraction of the blocks with the smallest L1 norms */
+void prune(int8_t* w, int rows, int cols, int br, int bc, double sparsity)
+{
+  const int n_block_rows = (rows + br - 1) / br;
+  const int n_block_cols = (cols + bc - 1) / bc;
+  std::vector<std::pair<int, int>> norms;
+  for (int r = 0; r < n_block_rows; r++)
+    for (int c = 0; c < n_block_cols; c++) {
+      int l1 = 0;
+      for (int i = r * br; i < std::min(rows, (r + 1) * br); i++)
+        for (int j = c * bc; j < std::min(cols, (c + 1) * bc); j++)
+          l1 += abs(w[(size_t)i * cols + j]);
+      norms.push_back({l1, r * n_block_cols + c});
+    }
+  std::stable_sort(norms.begin(), norms.end(),
+      [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; });
+  const size_t n_pruned = (size_t)(sparsity * norms.size());
+  for (size_t k = 0; k < n_pruned; k++) {
+    const int r = norms[k].second / n_block_cols, c = norms[k].second % n_block_cols;
+    for (int i = r * br; i < std::min(rows, (r + 1) * br); i++)
+      for (int j = c * bc; j < std::min(cols, (c + 1) * bc); j++)
+        w[(size_t)i * cols + j] = 0;
+  }
+}
+
+/* Prunes the filter of the operator in both models, and replaces the operator
+ * of the sparse one by BLOCK_SPARSE_FULLY_CONNECTED. Returns false if the
+ * operator is skipped. */
+bool convert_op(tflite::ModelT* model, tflite::ModelT* dense, size_t index, int br, int bc,
+    double sparsity, Layer* info)
+{
+  tflite::SubGraphT& sg = *model->subgraphs[0];
+  tflite::OperatorT& op = *sg.operators[index];
+  if (op_code(*model, op) != tflite::BuiltinOperator_FULLY_CONNECTED || op.inputs.size() < 2 ||
+      op.outputs.size() != 1)
+    return false;
+  const tflite::FullyConnectedOptionsT* options = op.builtin_options.AsFullyConnectedOptions();
+  if (!options || options->weights_format != tflite::FullyConnectedOptionsWeightsFormat_DEFAULT)
+    return false;
+  /* same values in tflite::ActivationFunctionType and TfLiteFusedActivation */
+  const tflite::ActivationFunctionType activation = options->fused_activation_function;
+  if (activation != tflite::ActivationFunctionType_NONE &&
+      activation != tflite::ActivationFunctionType_RELU &&
+      activation != tflite::ActivationFunctionType_RELU_N1_TO_1 &&
+      activation != tflite::ActivationFunctionType_RELU6)
+    return false;
+
+  const tflite::TensorT& input = *sg.tensors[op.inputs[0]];
+  const tflite::TensorT& output = *sg.tensors[op.outputs[0]];
+  tflite::TensorT& filter = *sg.tensors[op.inputs[1]];
+  if (input.type != tflite::TensorType_INT8 || output.type != tflite::TensorType_INT8 ||
+      filter.type != tflite::TensorType_INT8 || filter.shape.size() != 2 ||
+      !filter.quantization || filter.quantization->scale.empty() ||
+      tensor_uses(sg, op.inputs[1]) != 1 || buffer_uses(*model, filter.buffer) != 1)
+    return false;
+  std::vector<uint8_t>& w = model->buffers[filter.buffer]->data;
+  const int rows = filter.shape[0], cols = filter.shape[1];
+  const size_t n_w = (size_t)rows * cols;
+  if (w.size() != n_w || tflite::micro::IsCompressedWeights(w.data(), w.size(), n_w) ||
+      rows > UINT16_MAX || cols > UINT16_MAX || output.shape.empty() ||
+      output.shape.back() != rows)
+    return false;
+
+  if (sparsity > 0) {
+    prune((int8_t*)w.data(), rows, cols, br, bc, sparsity);
+    tflite::TensorT& dense_filter = *dense->subgraphs[0]->tensors[op.inputs[1]];
+    dense->buffers[dense_filter.buffer]->data = w;
+  }
+
+  const int n_blocks = ((rows + br - 1) / br) * ((cols + bc - 1) / bc);
+  std::vector<uint8_t> blob = encode((const int8_t*)w.data(), rows, cols, br, bc);
+  const tflite::micro::BlockSparseWeightsHeader* header =
+      (const tflite::micro::BlockSparseWeightsHeader*)blob.data();
+  info->name = filter.name;
+  info->rows = rows;
+  info->cols = cols;
+  info->batches = (int)(element_count(output.shape) / rows);
+  info->blocks = n_blocks;
+  info->blocks_kept = header->block_count;
+  info->bytes_dense = w.size();
+  info->bytes_sparse = blob.size();
+  /* uint16 block indexes */
+  info->converted = blob.size() < w.size() && n_blocks <= UINT16_MAX;
+  if (!info->converted)
+    return true;
+
+  /* the filter tensor holds the encoded buffer, per tensor quantization (the
+   * FULLY_CONNECTED kernels only apply the first scale) */
+  w = std::move(blob);
+  filter.shape = {(int)w.size()};
+  filter.quantization->scale.resize(1);
+  filter.quantization->zero_point.resize(1);
+  filter.quantization->quantized_dimension = 0;
+
+  flexbuffers::Builder fbb;
+  fbb.Map([&]() { fbb.Int("fused_activation_function", (int)activation); });
+  fbb.Finish();
+  op.opcode_index = (uint32_t)custom_code(model);
+  op.builtin_options.Reset();
+  op.custom_options = fbb.GetBuffer();
+  op.custom_options_format = tflite::CustomOptionsFormat_FLEXBUFFERS;
+  return true;
+}
+
+std::vector<uint8_t> pack(const tflite::ModelT& model)
+{
+  /* the TFLM copy of flatbuffers has no implicit default allocator */
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder fbb(16 * 1024, &allocator);
+  tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, &model));
+  return std::vector<uint8_t>(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+/* Runs the model on each input (first input tensor), returns the int8
+ * outputs (first output tensor) and the median invoke duration */
+bool run(const std::vector<uint8_t>& model, const std::vector<std::vector<int8_t>>& inputs,
+    int runs, std::vector<std::vector<int8_t>>* outputs, double* t_invoke)
+{
+  uint32_t hdl;
+  if (tflm_c_create(model.data(), arena, sizeof(arena), &hdl) != kTfLiteOk)
+    return false;
+
+  struct tflm_c_tensor_info in, out;
+  tflm_c_input(hdl, 0, &in);
+  std::vector<double> t;
+  bool ok = true;
+  outputs->clear();
+  for (int r = 0; r < runs && ok; r++) {
+    for (const auto& input : inputs) {
+      memcpy(in.data, input.data(), std::min(in.bytes, input.size()));
+      const double t0 = tflm_host::now_us();
+      ok &= tflm_c_invoke(hdl) == kTfLiteOk;
+      t.push_back(tflm_host::now_us() - t0);
+      if (r == 0) {
+        tflm_c_output(hdl, 0, &out);
+        outputs->emplace_back((int8_t*)out.data, (int8_t*)out.data + out.bytes);
+      }
+    }
+  }
+  std::sort(t.begin(), t.end());
+  *t_invoke = t[t.size() / 2];
+  tflm_c_destroy(hdl);
+  return ok;
+}
+
+int argmax(const std::vector<int8_t>& v)
+{
+  return (int)(std::max_element(v.begin(), v.end()) - v.begin());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 5;
+  int br = 1, bc = 16;
+  double sparsity = 0.0;
+  const char* paths[2] = {nullptr, nullptr};
+  int n_paths = 0;
+  bool usage = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+      usage |= sscanf(argv[++i], "%dx%d", &br, &bc) != 2;
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      sparsity = atof(argv[++i]);
+    else if (n_paths < 2)
+      paths[n_paths++] = argv[i];
+    else
+      usage = true;
+  }
+  if (n_paths != 2 || usage || br < 1 || br > 255 || bc < 1 || bc > 255 || sparsity < 0 ||
+      sparsity >= 1) {
+    fprintf(stderr, "usage: %s <model.tflite> <output.tflite> [-b RxC] [-s sparsity] [-n runs]\n",
+        argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(paths[0]);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", paths[0]);
+    return 1;
+  }
+  std::unique_ptr<tflite::ModelT> model = tflite::UnPackModel(data.data());
+  std::unique_ptr<tflite::ModelT> dense = tflite::UnPackModel(data.data());
+  if (model->subgraphs.size() != 1) {
+    fprintf(stderr, "E: only single subgraph models are supported\n");
+    return 1;
+  }
+
+  std::vector<Layer> layers;
+  for (size_t i = 0; i < model->subgraphs[0]->operators.size(); i++) {
+    Layer info;
+    if (convert_op(model.get(), dense.get(), i, br, bc, sparsity, &info))
+      layers.push_back(info);
+  }
+  if (layers.empty()) {
+    fprintf(stderr, "E: no int8 FULLY_CONNECTED operator to convert\n");
+    return 1;
+  }
+  remove_unused_codes(model.get());
+  bool any_converted = false;
+  for (const Layer& l : layers)
+    any_converted |= l.converted;
+  std::vector<uint8_t> out = any_converted ? pack(*model) : data;
+  std::vector<uint8_t> out_dense = pack(*dense);
+
+  const tflite::SubGraphT& sg = *model->subgraphs[0];
+  const std::vector<int>& in_shape = sg.tensors[sg.inputs[0]]->shape;
+  std::vector<std::vector<int8_t>> inputs(kSamples,
+      std::vector<int8_t>(element_count(in_shape)));
+  srand(1);
+  for (auto& input : inputs)
+    tflm_host::draw_strokes(in_shape, &input);
+
+  std::vector<std::vector<int8_t>> ref, res, res_dense;
+  double t_ref, t_sparse, t_dense;
+  if (!run(data, inputs, runs, &ref, &t_ref) || !run(out, inputs, runs, &res, &t_sparse) ||
+      !run(out_dense, inputs, runs, &res_dense, &t_dense)) {
+    fprintf(stderr, "E: unable to run the models\n");
+    return 1;
+  }
+
+  int max_diff = 0, agree = 0;
+  for (size_t s = 0; s < res.size(); s++) {
+    for (size_t i = 0; i < res[s].size(); i++)
+      max_diff = std::max(max_diff, abs(res[s][i] - ref[s][i]));
+    agree += argmax(res[s]) == argmax(ref[s]);
+  }
+
+  printf("model              : %s\n", paths[0]);
+  printf("blocks             : %dx%d, %.0f%% pruned by magnitude\n", br, bc, 100.0 * sparsity);
+  long macs_dense = 0, macs_sparse = 0;
+  for (const Layer& l : layers) {
+    const long dense_macs = (long)l.batches * l.rows * l.cols;
+    const long sparse_macs = l.converted ? (long)l.batches * l.blocks_kept * br * bc : dense_macs;
+    printf("  %-16s: %d -> %d, %d/%d blocks, %ld -> %ld MACs, %d -> %d bytes%s\n",
+        l.name.c_str(), l.cols, l.rows, l.blocks_kept, l.blocks, dense_macs, sparse_macs,
+        (int)l.bytes_dense, (int)(l.converted ? l.bytes_sparse : l.bytes_dense),
+        l.converted ? "" : " (kept dense)");
+    macs_dense += dense_macs;
+    macs_sparse += sparse_macs;
+  }
+  printf("MACs (fc)          : %ld -> %ld (%.1f%% less)\n", macs_dense, macs_sparse,
+      100.0 * (macs_dense - macs_sparse) / macs_dense);
+  printf("model              : %d -> %d bytes (%d bytes saved)\n", (int)data.size(),
+      (int)out.size(), (int)data.size() - (int)out.size());
+  printf("invoke (host)      : median %.2f us original, %.2f us pruned dense -> %.2f us block "
+      "sparse (x%.2f)\n", t_ref, t_dense, t_sparse, t_dense / t_sparse);
+  printf("outputs vs original: max. difference %d, top-1 agreement %d/%d\n",
+      max_diff, agree, (int)res.size());
+  if (res != res_dense) {
+    fprintf(stderr, "E: outputs of the block sparse model differ from the dense ones\n");
+    return 1;
+  }
+
+  if (!tflm_host::save_file(paths[1], out.data(), out.size())) {
+    fprintf(stderr, "E: unable to write %s\n", paths[1]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,215 @@
+/**
+ ******************************************************************************
+ * @file    tflm_block_sparse_bench.cc
+ * @brief   Host check and timing of the block sparse fully connected kernel
+ ******************************************************************************
+ *
+ * usage: tflm_block_sparse_bench [-n runs]
+ *
+ * For a set of fully connected shapes (MNIST dense layers, odd depths which
+ * leave partial blocks, batches) and block sizes, random int8 filters with
+ * 0, 50, 75, 90 and 95% of their blocks zeroed are run dense by
+ * arm_fully_connected_s8() and block sparse (only the non-zero blocks stored)
+ * by arm_fully_connected_block_sparse_s8(): the outputs must be identical.
+ * The MAC reduction and the speedup of the median durations are reported.
+ *
+ * The tool is built twice: tflm_block_sparse_bench with the x86 SIMD inner
+ * loops of the host library, tflm_block_sparse_bench_dsp with the DSP path of
+ * the kernels (ARM_MATH_DSP, intrinsics emulated by tflm_dsp_emulation.h: the
+ * durations do not represent the Cortex-M33 ones).
+ *
+ * Exit code 1 if an output differs.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Include/arm_nnfunctions.h"
+#include "Include/arm_nnsupportfunctions.h"
+
+#include "tflm_host_utils.h"
+
+namespace {
+
+struct FcCase {
+  const char* name;
+  int batches, cols, rows;
+  int block_rows, block_cols;
+};
+
+const FcCase kFcCases[] = {
+  {"MNIST dense 4732 -> 128, 1x16", 1, 4732, 128, 1, 16},
+  {"MNIST dense 4732 -> 128, 4x8", 1, 4732, 128, 4, 8},
+  {"MNIST dense 2028 -> 10, 1x16", 1, 2028, 10, 1, 16},
+  {"128 -> 10, 1x16", 1, 128, 10, 1, 16},
+  {"odd depth 37 -> 5, 2x4, 3 batches", 3, 37, 5, 2, 4},
+};
+
+const int kSparsity[] = {0, 50, 75, 90, 95};
+
+/* Block sparse encoding of the rows x cols filter w */
+struct Bsr {
+  std::vector<uint16_t> row_ptr;
+  std::vector<uint16_t> col;
+  std::vector<int8_t> values;
+  cmsis_nn_bsr_s8 filter;
+};
+
+void encode(const std::vector<int8_t>& w, int rows, int cols, int br, int bc, Bsr* bsr)
+{
+  const int n_block_rows = (rows + br - 1) / br;
+  const int n_block_cols = (cols + bc - 1) / bc;
+  bsr->row_ptr.assign(1, 0);
+  bsr->col.clear();
+  bsr->values.clear();
+  for (int r = 0; r < n_block_rows; r++) {
+    for (int c = 0; c < n_block_cols; c++) {
+      std::vector<int8_t> block(br * bc, 0);
+      bool zero = true;
+      for (int i = 0; i < br && r * br + i < rows; i++)
+        for (int j = 0; j < bc && c * bc + j < cols; j++) {
+          block[i * bc + j] = w[(size_t)(r * br + i) * cols + c * bc + j];
+          zero &= block[i * bc + j] == 0;
+        }
+      if (zero)
+        continue;
+      bsr->col.push_back((uint16_t)c);
+      bsr->values.insert(bsr->values.end(), block.begin(), block.end());
+    }
+    bsr->row_ptr.push_back((uint16_t)bsr->col.size());
+  }
+  bsr->filter = {rows, cols, br, bc, bsr->row_ptr.data(), bsr->col.data(), bsr->values.data()};
+}
+
+/* random filter with sparsity% of its blocks zeroed (non-zero values in the
+ * other ones) */
+void random_filter(int rows, int cols, int br, int bc, int sparsity, std::vector<int8_t>* w)
+{
+  const int n_block_rows = (rows + br - 1) / br;
+  const int n_block_cols = (cols + bc - 1) / bc;
+  std::vector<int> blocks(n_block_rows * n_block_cols);
+  for (size_t k = 0; k < blocks.size(); k++)
+    blocks[k] = (int)k;
+  for (size_t k = blocks.size(); k > 1; k--)
+    std::swap(blocks[k - 1], blocks[rand() % k]);
+
+  w->resize((size_t)rows * cols);
+  for (auto& v : *w)
+    v = (int8_t)(rand() % 255 - 127);
+  const size_t n_zero = blocks.size() * sparsity / 100;
+  for (size_t k = 0; k < n_zero; k++) {
+    const int r = blocks[k] / n_block_cols, c = blocks[k] % n_block_cols;
+    for (int i = r * br; i < std::min(rows, (r + 1) * br); i++)
+      for (int j = c * bc; j < std::min(cols, (c + 1) * bc); j++)
+        (*w)[(size_t)i * cols + j] = 0;
+  }
+}
+
+/* median duration (us) of n calls, status of the last one */
+template <typename F>
+double median_us(int runs, F call, arm_cmsis_nn_status* status)
+{
+  std::vector<double> t;
+  for (int i = 0; i < runs; i++) {
+    const double t0 = tflm_host::now_us();
+    *status = call();
+    t.push_back(tflm_host::now_us() - t0);
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+bool run_fc(const FcCase& c, int runs)
+{
+  cmsis_nn_fc_params params;
+  params.input_offset = 1 + rand() % 127;
+  params.filter_offset = 0;
+  params.output_offset = -(rand() % 128);
+  params.activation.min = -128;
+  params.activation.max = 127;
+  cmsis_nn_per_tensor_quant_params quant = {(1 << 30) + rand() % (1 << 30), -(8 + rand() % 4)};
+
+  const cmsis_nn_dims input_dims = {c.batches, 1, 1, c.cols};
+  const cmsis_nn_dims filter_dims = {c.cols, 1, 1, c.rows};
+  const cmsis_nn_dims bias_dims = {1, 1, 1, c.rows};
+  const cmsis_nn_dims output_dims = {c.batches, 1, 1, c.rows};
+
+  std::vector<int8_t> input(c.batches * c.cols);
+  for (auto& v : input)
+    v = (int8_t)rand();
+  std::vector<int32_t> bias(c.rows);
+  for (auto& v : bias)
+    v = rand() % 20001 - 10000;
+
+  printf("  %s\n", c.name);
+  bool ok = true;
+  for (int sparsity : kSparsity) {
+    std::vector<int8_t> filter;
+    random_filter(c.rows, c.cols, c.block_rows, c.block_cols, sparsity, &filter);
+    Bsr bsr;
+    encode(filter, c.rows, c.cols, c.block_rows, c.block_cols, &bsr);
+
+    std::vector<int16_t> buf_dense(arm_fully_connected_s8_get_buffer_size(&filter_dims) / 2 + 1);
+    std::vector<int16_t> buf_sparse(
+        arm_fully_connected_block_sparse_s8_get_buffer_size(&bsr.filter) / 2 + 1);
+    cmsis_nn_context ctx_dense = {buf_dense.data(), (int32_t)(buf_dense.size() * sizeof(int16_t))};
+    cmsis_nn_context ctx_sparse = {buf_sparse.data(),
+        (int32_t)(buf_sparse.size() * sizeof(int16_t))};
+    std::vector<int8_t> out_dense(c.batches * c.rows), out_sparse(c.batches * c.rows, 0);
+
+    arm_cmsis_nn_status st_dense = ARM_CMSIS_NN_ARG_ERROR;
+    arm_cmsis_nn_status st_sparse = ARM_CMSIS_NN_ARG_ERROR;
+    const double t_dense = median_us(runs, [&] {
+      return arm_fully_connected_s8(&ctx_dense, &params, &quant, &input_dims, input.data(),
+          &filter_dims, filter.data(), &bias_dims, bias.data(), &output_dims, out_dense.data());
+    }, &st_dense);
+    const double t_sparse = median_us(runs, [&] {
+      return arm_fully_connected_block_sparse_s8(&ctx_sparse, &params, &quant, &input_dims,
+          input.data(), &bsr.filter, bias.data(), &output_dims, out_sparse.data());
+    }, &st_sparse);
+
+    const bool same = st_dense == ARM_CMSIS_NN_SUCCESS && st_sparse == ARM_CMSIS_NN_SUCCESS &&
+        out_dense == out_sparse;
+    const long macs_dense = (long)c.batches * c.rows * c.cols;
+    const long macs_sparse = (long)c.batches * bsr.col.size() * c.block_rows * c.block_cols;
+    printf("    %2d%% blocks zero : %7ld -> %7ld MACs (%+6.1f%%), %8.2f us -> %8.2f us (x%.2f)%s\n",
+        sparsity, macs_dense, macs_sparse, 100.0 * (macs_sparse - macs_dense) / macs_dense,
+        t_dense, t_sparse, t_dense / t_sparse, same ? "" : " FAILED");
+    ok &= same;
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 200;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else {
+      fprintf(stderr, "usage: %s [-n runs]\n", argv[0]);
+      return 2;
+    }
+  }
+
+#if defined(ARM_MATH_DSP)
+  printf("DSP path (emulated intrinsics)\n");
+#elif defined(CMSIS_NN_HOST_SIMD)
+  printf("x86 SIMD inner loops\n");
+#else
+  printf("portable C path\n");
+#endif
+
+  int res = 0;
+  srand(1);
+  printf("fully connected (arm_fully_connected_s8 -> arm_fully_connected_block_sparse_s8)\n");
+  for (const FcCase& c : kFcCases)
+    res |= !run_fc(c, runs);
+  return res;
+}
@@ -0,0 +1,303 @@
+/**
+ ******************************************************************************
+ * @file    tflm_cmsis_simd_bench.cc
+ * @brief   Host check and timing of the CMSIS-NN x86 SIMD inner loops
+ ******************************************************************************
+ *
+ * usage: tflm_cmsis_simd_bench [-n runs] [-r random_cases] [-s seed]
+ *
+ * The host library is built with CMSIS_NN_HOST_SIMD (x86-64): the inner
+ * loops of the s8 conv (arm_nn_mat_mult_kernel_s8_s16(), 1x1 conv
+ * arm_nn_mat_mult_nt_t_s8()), fully connected (arm_nn_vec_mat_mult_t_s8())
+ * and depthwise conv (3x3 and generic paths) kernels use SSE4.1/AVX2
+ * (arm_nn_host_simd.h). The outputs of the wrappers called by the TFLM
+ * operators must be identical to a naive reference:
+ *  - for a set of fixed shapes (MNIST layers, odd channels and columns for
+ *    the SIMD tails, padding, stride, batches), median durations reported,
+ *  - for random shapes (-r, -s).
+ *
+ * The tool is built twice: tflm_cmsis_simd_bench with the host library,
+ * tflm_cmsis_simd_bench_scalar with the portable C path of the same sources,
+ * to compare the durations.
+ *
+ * Exit code 1 if an output differs.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Include/arm_nnfunctions.h"
+#include "Include/arm_nnsupportfunctions.h"
+
+#include "tflm_host_utils.h"
+
+namespace {
+
+enum Kind { kConv, kFullyConnected, kDepthwise };
+
+struct LayerCase {
+  const char* name;
+  Kind kind;
+  int n, h, w, c_in;
+  int kh, kw, c_out;
+  int stride, pad, dilation;
+};
+
+const LayerCase kCases[] = {
+  {"conv 28x28x1, 3x3x28", kConv, 1, 28, 28, 1, 3, 3, 28, 1, 0, 1},
+  {"conv 14x14x16, 3x3x32, pad 1", kConv, 1, 14, 14, 16, 3, 3, 32, 1, 1, 1},
+  {"conv 13x13x5, 3x3x7, stride 2", kConv, 1, 13, 13, 5, 3, 3, 7, 2, 0, 1},
+  {"conv 1x1 14x14x32 -> 64", kConv, 1, 14, 14, 32, 1, 1, 64, 1, 0, 1},
+  {"conv 1x1 7x7x13 -> 17", kConv, 1, 7, 7, 13, 1, 1, 17, 1, 0, 1},
+  {"conv 1x1 14x14x20, stride 2", kConv, 1, 14, 14, 20, 1, 1, 24, 2, 0, 1},
+  {"fc 4732 -> 10", kFullyConnected, 1, 1, 1, 4732, 1, 1, 10, 1, 0, 1},
+  {"fc 2 x 256 -> 64", kFullyConnected, 2, 1, 1, 256, 1, 1, 64, 1, 0, 1},
+  {"fc 100 -> 37", kFullyConnected, 1, 1, 1, 100, 1, 1, 37, 1, 0, 1},
+  {"dw 14x14x32, 3x3, pad 1", kDepthwise, 1, 14, 14, 32, 3, 3, 32, 1, 1, 1},
+  {"dw 15x15x7, 3x3, stride 2", kDepthwise, 1, 15, 15, 7, 3, 3, 7, 2, 1, 1},
+  {"dw 12x12x16, 5x5, pad 2", kDepthwise, 1, 12, 12, 16, 5, 5, 16, 1, 2, 1},
+  {"dw 11x11x10, 3x3, pad 2", kDepthwise, 1, 11, 11, 10, 3, 3, 10, 1, 2, 1},
+  {"dw 10x10x9, 3x3, dilation 2", kDepthwise, 1, 10, 10, 9, 3, 3, 9, 1, 2, 2},
+};
+
+struct LayerData {
+  LayerCase c;
+  cmsis_nn_conv_params conv_params;
+  cmsis_nn_dw_conv_params dw_params;
+  cmsis_nn_fc_params fc_params;
+  cmsis_nn_dims input_dims, filter_dims, bias_dims, output_dims;
+  std::vector<int8_t> input, filter;
+  std::vector<int32_t> bias, multiplier, shift;
+  std::vector<int8_t> buffer;
+};
+
+void setup(const LayerCase& c, LayerData* d)
+{
+  d->c = c;
+  const int32_t input_offset = 1 + rand() % 128;
+  const int32_t output_offset = -(rand() % 128);
+  const cmsis_nn_activation activation = {-128 + rand() % 16, 127 - rand() % 16};
+
+  d->conv_params.input_offset = input_offset;
+  d->conv_params.output_offset = output_offset;
+  d->conv_params.stride.h = d->conv_params.stride.w = c.stride;
+  d->conv_params.padding.h = d->conv_params.padding.w = c.pad;
+  d->conv_params.dilation.h = d->conv_params.dilation.w = c.dilation;
+  d->conv_params.activation = activation;
+
+  d->dw_params.input_offset = input_offset;
+  d->dw_params.output_offset = output_offset;
+  d->dw_params.ch_mult = 1;
+  d->dw_params.stride = d->conv_params.stride;
+  d->dw_params.padding = d->conv_params.padding;
+  d->dw_params.dilation = d->conv_params.dilation;
+  d->dw_params.activation = activation;
+
+  d->fc_params.input_offset = input_offset;
+  d->fc_params.filter_offset = 0;
+  d->fc_params.output_offset = output_offset;
+  d->fc_params.activation = activation;
+
+  const int eff_kh = (c.kh - 1) * c.dilation + 1;
+  const int eff_kw = (c.kw - 1) * c.dilation + 1;
+  d->input_dims = {c.n, c.h, c.w, c.c_in};
+  d->bias_dims = {1, 1, 1, c.c_out};
+  d->output_dims = {c.n, (c.h + 2 * c.pad - eff_kh) / c.stride + 1,
+      (c.w + 2 * c.pad - eff_kw) / c.stride + 1, c.c_out};
+  if (c.kind == kConv)
+    d->filter_dims = {c.c_out, c.kh, c.kw, c.c_in};
+  else if (c.kind == kDepthwise)
+    d->filter_dims = {1, c.kh, c.kw, c.c_out};
+  else
+    d->filter_dims = {c.h * c.w * c.c_in, 1, 1, c.c_out};
+
+  d->input.resize(c.n * c.h * c.w * c.c_in);
+  d->filter.resize(c.kind == kDepthwise ? c.kh * c.kw * c.c_out : c.c_out * c.kh * c.kw * c.c_in);
+  for (auto& v : d->input)
+    v = (int8_t)rand();
+  for (auto& v : d->filter)
+    v = (int8_t)rand();
+
+  /* per tensor quantization for the fully connected layers */
+  const int32_t multiplier = (1 << 30) + rand() % (1 << 30);
+  const int32_t shift = -(8 + rand() % 4);
+  d->bias.resize(c.c_out);
+  d->multiplier.resize(c.c_out);
+  d->shift.resize(c.c_out);
+  for (int i = 0; i < c.c_out; i++) {
+    d->bias[i] = rand() % 20001 - 10000;
+    d->multiplier[i] = c.kind == kFullyConnected ? multiplier : (1 << 30) + rand() % (1 << 30);
+    d->shift[i] = c.kind == kFullyConnected ? shift : -(7 + rand() % 4);
+  }
+
+  int32_t size = 0;
+  if (c.kind == kConv)
+    size = arm_convolve_wrapper_s8_get_buffer_size(&d->conv_params, &d->input_dims,
+        &d->filter_dims, &d->output_dims);
+  else if (c.kind == kDepthwise)
+    size = arm_depthwise_conv_wrapper_s8_get_buffer_size(&d->dw_params, &d->input_dims,
+        &d->filter_dims, &d->output_dims);
+  else
+    size = arm_fully_connected_s8_get_buffer_size(&d->filter_dims);
+  d->buffer.resize(size + 1);
+}
+
+/* direct computation with the same requantization */
+std::vector<int8_t> reference(const LayerData& d)
+{
+  const cmsis_nn_dims& in = d.input_dims;
+  const cmsis_nn_dims& out = d.output_dims;
+  const cmsis_nn_conv_params& p = d.conv_params;
+  const int kh = d.c.kh, kw = d.c.kw;
+  std::vector<int8_t> res;
+  for (int b = 0; b < out.n; b++)
+    for (int oy = 0; oy < out.h; oy++)
+      for (int ox = 0; ox < out.w; ox++)
+        for (int oc = 0; oc < out.c; oc++) {
+          int32_t acc = d.bias[oc];
+          for (int ky = 0; ky < kh; ky++)
+            for (int kx = 0; kx < kw; kx++) {
+              const int iy = oy * p.stride.h - p.padding.h + ky * p.dilation.h;
+              const int ix = ox * p.stride.w - p.padding.w + kx * p.dilation.w;
+              if (iy < 0 || iy >= in.h || ix < 0 || ix >= in.w)
+                continue;
+              const int8_t* input = &d.input[((b * in.h + iy) * in.w + ix) * in.c];
+              if (d.c.kind == kDepthwise) {
+                acc += (input[oc] + p.input_offset) * d.filter[(ky * kw + kx) * out.c + oc];
+                continue;
+              }
+              for (int ic = 0; ic < in.c; ic++)
+                acc += (input[ic] + p.input_offset) * d.filter[((oc * kh + ky) * kw + kx) * in.c + ic];
+            }
+          acc = arm_nn_requantize(acc, d.multiplier[oc], d.shift[oc]) + p.output_offset;
+          acc = std::min(std::max(acc, p.activation.min), p.activation.max);
+          res.push_back((int8_t)acc);
+        }
+  return res;
+}
+
+arm_cmsis_nn_status call(LayerData& d, int8_t* output)
+{
+  cmsis_nn_context ctx = {d.buffer.data(), (int32_t)d.buffer.size()};
+  if (d.c.kind == kFullyConnected) {
+    cmsis_nn_per_tensor_quant_params quant = {d.multiplier[0], d.shift[0]};
+    return arm_fully_connected_s8(&ctx, &d.fc_params, &quant, &d.input_dims, d.input.data(),
+        &d.filter_dims, d.filter.data(), &d.bias_dims, d.bias.data(), &d.output_dims, output);
+  }
+  cmsis_nn_per_channel_quant_params quant = {d.multiplier.data(), d.shift.data()};
+  if (d.c.kind == kDepthwise)
+    return arm_depthwise_conv_wrapper_s8(&ctx, &d.dw_params, &quant, &d.input_dims,
+        d.input.data(), &d.filter_dims, d.filter.data(), &d.bias_dims, d.bias.data(),
+        &d.output_dims, output);
+  return arm_convolve_wrapper_s8(&ctx, &d.conv_params, &quant, &d.input_dims, d.input.data(),
+      &d.filter_dims, d.filter.data(), &d.bias_dims, d.bias.data(), &d.output_dims, output);
+}
+
+/* median duration (us) of n calls, output of the last one */
+double run(LayerData& d, int runs, std::vector<int8_t>* output)
+{
+  output->assign(d.output_dims.n * d.output_dims.h * d.output_dims.w * d.output_dims.c, 0);
+  std::vector<double> t;
+  for (int i = 0; i < runs; i++) {
+    const double t0 = tflm_host::now_us();
+    const arm_cmsis_nn_status status = call(d, output->data());
+    t.push_back(tflm_host::now_us() - t0);
+    if (status != ARM_CMSIS_NN_SUCCESS)
+      return -1.0;
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+LayerCase random_case(int i)
+{
+  LayerCase c = {"random", (Kind)(i % 3), 1 + rand() % 2, 1 + rand() % 12, 1 + rand() % 12,
+      1 + rand() % 40, 1 + rand() % 5, 1 + rand() % 5, 1 + rand() % 40,
+      1 + rand() % 2, 0, 1};
+  if (c.kind == kFullyConnected) {
+    c.c_in *= 1 + rand() % 40;
+    c.h = c.w = c.kh = c.kw = 1;
+  } else {
+    if (c.kind == kDepthwise) {
+      c.c_out = c.c_in;
+      c.n = 1;
+      c.dilation = rand() % 4 ? 1 : 2;
+    }
+    if (rand() % 4 == 0)
+      c.kh = c.kw = 1;
+    else if (rand() % 2)
+      c.kh = c.kw = 3;
+    c.pad = rand() % std::min(c.kh, c.kw);
+    c.h = std::max(c.h, (c.kh - 1) * c.dilation + 1);
+    c.w = std::max(c.w, (c.kw - 1) * c.dilation + 1);
+  }
+  return c;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 200;
+  int random_cases = 200;
+  unsigned seed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+      random_cases = std::max(0, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      seed = (unsigned)strtoul(argv[++i], NULL, 0);
+    else {
+      fprintf(stderr, "usage: %s [-n runs] [-r random_cases] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+
+#if defined(CMSIS_NN_HOST_SIMD) && defined(__AVX2__)
+  printf("x86 SIMD path (AVX2)\n");
+#elif defined(CMSIS_NN_HOST_SIMD)
+  printf("x86 SIMD path (SSE4.1)\n");
+#else
+  printf("portable C path\n");
+#endif
+
+  int res = 0;
+  srand(seed);
+  double total = 0.0;
+  for (const LayerCase& c : kCases) {
+    LayerData d;
+    std::vector<int8_t> output;
+    setup(c, &d);
+    const std::vector<int8_t> ref = reference(d);
+    const double t = run(d, runs, &output);
+    const bool ok = t >= 0.0 && output == ref;
+    printf("  %-30s : %8.2f us%s\n", c.name, t, ok ? "" : " FAILED");
+    total += t;
+    if (!ok)
+      res = 1;
+  }
+  printf("  %-30s : %8.2f us\n", "total", total);
+
+  int failed = 0;
+  for (int i = 0; i < random_cases; i++) {
+    const LayerCase c = random_case(i);
+    LayerData d;
+    std::vector<int8_t> output;
+    setup(c, &d);
+    if (run(d, 1, &output) < 0.0 || output != reference(d)) {
+      printf("  random case %d (kind %d, %dx%dx%dx%d, %dx%dx%d, stride %d, pad %d, dilation %d)"
+          " FAILED\n", i, c.kind, c.n, c.h, c.w, c.c_in, c.kh, c.kw, c.c_out, c.stride, c.pad,
+          c.dilation);
+      failed++;
+    }
+  }
+  printf("  %d random shapes, %d failed (seed %u)\n", random_cases, failed, seed);
+  if (failed)
+    res = 1;
+  return res;
+}
@@ -0,0 +1,448 @@
+/**
+ ******************************************************************************
+ * @file    tflm_compress.cc
+ * @brief   Host packer compressing the weights of a TFLite model
+ ******************************************************************************
+ *
+ * usage: tflm_compress <model.tflite> <output.tflite> [-c clusters] [-n runs]
+ *
+ * The int8 filter buffers of the CONV_2D and FULLY_CONNECTED operators are
+ * palettised and their indices are bit-packed or Huffman coded (the smaller
+ * one is kept), see tensorflow/lite/micro/kernels/weight_compression.h for
+ * the format. A buffer is only replaced if it is smaller once compressed and
+ * if it is not shared with another tensor/operator.
+ *
+ * -c clusters: without this option, the palette is made of the distinct
+ *              values of the buffer (lossless). Else the values are clustered
+ *              (1D k-means) in at most "clusters" values (lossy).
+ * -n runs:     number of invokes to measure the latency
+ *
+ * The two models are run with the host TFLM runtime (CMSIS-NN kernels) with
+ * the same inputs: in lossless mode the outputs must be bit-identical. The
+ * flash saved and the latency added by the decompression are reported.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <string>
+
+#include "tensorflow/lite/micro/kernels/weight_compression.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+
+namespace {
+
+using tflite::micro::CompressedWeightsHeader;
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+struct Encoded {
+  std::vector<uint8_t> data;
+  int palette_size;
+  uint8_t codec;
+};
+
+/* Palette of the buffer and index of each value */
+void palettise(const std::vector<int8_t>& values, int clusters,
+    std::vector<int8_t>* palette, std::vector<uint8_t>* indices)
+{
+  int hist[256] = {0};
+  for (int8_t v : values)
+    hist[v + 128]++;
+
+  std::vector<int> distinct;
+  for (int i = 0; i < 256; i++)
+    if (hist[i])
+      distinct.push_back(i - 128);
+
+  std::vector<int> centers;
+  if (clusters <= 0 || (int)distinct.size() <= clusters) {
+    centers = distinct;
+  } else {
+    /* 1D k-means on the histogram, initialized with the quantiles */
+    std::vector<double> c(clusters);
+    for (int k = 0, seen = 0, i = 0; k < clusters; k++) {
+      const double target = (k + 0.5) * values.size() / clusters;
+      while (i < 255 && seen + hist[i] < target)
+        seen += hist[i++];
+      c[k] = i - 128;
+    }
+    for (int it = 0; it < 50; it++) {
+      std::vector<double> sum(clusters, 0.0), n(clusters, 0.0);
+      for (int i = 0; i < 256; i++) {
+        if (!hist[i])
+          continue;
+        int best = 0;
+        for (int k = 1; k < clusters; k++)
+          if (fabs(c[k] - (i - 128)) < fabs(c[best] - (i - 128)))
+            best = k;
+        sum[best] += (double)hist[i] * (i - 128);
+        n[best] += hist[i];
+      }
+      for (int k = 0; k < clusters; k++)
+        if (n[k] > 0)
+          c[k] = sum[k] / n[k];
+    }
+    for (double v : c)
+      centers.push_back((int)lround(v));
+    std::sort(centers.begin(), centers.end());
+    centers.erase(std::unique(centers.begin(), centers.end()), centers.end());
+  }
+
+  palette->clear();
+  for (int v : centers)
+    palette->push_back((int8_t)v);
+
+  uint8_t lut[256];
+  for (int i = 0; i < 256; i++) {
+    int best = 0;
+    for (int k = 1; k < (int)centers.size(); k++)
+      if (abs(centers[k] - (i - 128)) < abs(centers[best] - (i - 128)))
+        best = k;
+    lut[i] = (uint8_t)best;
+  }
+  indices->clear();
+  for (int8_t v : values)
+    indices->push_back(lut[v + 128]);
+}
+
+/* Code lengths of a Huffman code limited to kCompressedWeightsMaxCodeLength */
+std::vector<uint8_t> huffman_lengths(std::vector<uint64_t> freq)
+{
+  const int n = (int)freq.size();
+  std::vector<uint8_t> lengths(n, 0);
+  int used = 0;
+  for (uint64_t f : freq)
+    used += f != 0;
+  if (used == 1) {
+    for (int i = 0; i < n; i++)
+      lengths[i] = freq[i] ? 1 : 0;
+    return lengths;
+  }
+
+  for (;;) {
+    typedef std::pair<uint64_t, int> Node;
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> q;
+    std::vector<int> parent(2 * n, -1);
+    int next = n;
+    for (int i = 0; i < n; i++)
+      if (freq[i])
+        q.push(Node(freq[i], i));
+    while (q.size() > 1) {
+      Node a = q.top();
+      q.pop();
+      Node b = q.top();
+      q.pop();
+      parent[a.second] = parent[b.second] = next;
+      q.push(Node(a.first + b.first, next++));
+    }
+    int max_len = 0;
+    for (int i = 0; i < n; i++) {
+      if (!freq[i])
+        continue;
+      int len = 0;
+      for (int p = i; parent[p] >= 0; p = parent[p])
+        len++;
+      lengths[i] = (uint8_t)len;
+      max_len = std::max(max_len, len);
+    }
+    if (max_len <= tflite::micro::kCompressedWeightsMaxCodeLength)
+      return lengths;
+    for (uint64_t& f : freq)
+      if (f)
+        f = (f + 1) / 2;
+  }
+}
+
+struct BitWriter {
+  std::vector<uint8_t> data;
+  uint32_t acc = 0;
+  int n_bits = 0;
+
+  /* LSB first */
+  void put_lsb(uint32_t value, int bits) {
+    acc |= value << n_bits;
+    n_bits += bits;
+    while (n_bits >= 8) {
+      data.push_back((uint8_t)acc);
+      acc >>= 8;
+      n_bits -= 8;
+    }
+  }
+
+  /* MSB first */
+  void put_msb(uint32_t code, int bits) {
+    for (int b = bits - 1; b >= 0; b--) {
+      acc = (acc << 1) | ((code >> b) & 1);
+      if (++n_bits == 8) {
+        data.push_back((uint8_t)acc);
+        acc = 0;
+        n_bits = 0;
+      }
+    }
+  }
+
+  void flush_lsb() {
+    if (n_bits)
+      data.push_back((uint8_t)acc);
+    acc = 0;
+    n_bits = 0;
+  }
+
+  void flush_msb() {
+    if (n_bits)
+      data.push_back((uint8_t)(acc << (8 - n_bits)));
+    acc = 0;
+    n_bits = 0;
+  }
+};
+
+void pad4(std::vector<uint8_t>* v)
+{
+  while (v->size() % 4)
+    v->push_back(0);
+}
+
+Encoded encode(const std::vector<int8_t>& palette, const std::vector<uint8_t>& indices,
+    uint8_t codec)
+{
+  CompressedWeightsHeader hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = tflite::micro::kCompressedWeightsMagic;
+  hdr.codec = codec;
+  hdr.palette_size = (uint16_t)palette.size();
+  hdr.count = (uint32_t)indices.size();
+
+  std::vector<uint8_t> body(palette.begin(), palette.end());
+  pad4(&body);
+
+  BitWriter bw;
+  if (codec == tflite::micro::kCompressedWeightsCodecPacked) {
+    int bits = 1;
+    while ((1u << bits) < palette.size())
+      bits++;
+    hdr.index_bits = (uint8_t)bits;
+    for (uint8_t idx : indices)
+      bw.put_lsb(idx, bits);
+    bw.flush_lsb();
+  } else {
+    std::vector<uint64_t> freq(palette.size(), 0);
+    for (uint8_t idx : indices)
+      freq[idx]++;
+    std::vector<uint8_t> lengths = huffman_lengths(freq);
+    body.insert(body.end(), lengths.begin(), lengths.end());
+    pad4(&body);
+
+    /* canonical codes, ordered by (length, index) */
+    std::vector<uint32_t> codes(palette.size(), 0);
+    uint32_t code = 0;
+    for (int len = 1; len <= tflite::micro::kCompressedWeightsMaxCodeLength; len++) {
+      for (size_t i = 0; i < palette.size(); i++)
+        if (lengths[i] == len)
+          codes[i] = code++;
+      code <<= 1;
+    }
+    for (uint8_t idx : indices)
+      bw.put_msb(codes[idx], lengths[idx]);
+    bw.flush_msb();
+  }
+  hdr.payload_size = (uint32_t)bw.data.size();
+  body.insert(body.end(), bw.data.begin(), bw.data.end());
+  hdr.checksum = tflite::micro::CompressedWeightsChecksum(body.data(), body.size());
+
+  Encoded res;
+  res.data.resize(sizeof(hdr));
+  memcpy(res.data.data(), &hdr, sizeof(hdr));
+  res.data.insert(res.data.end(), body.begin(), body.end());
+  res.palette_size = (int)palette.size();
+  res.codec = codec;
+  return res;
+}
+
+/* Filter buffers which can be compressed: int8, only used as CONV_2D/FULLY_CONNECTED filter */
+std::vector<int> candidate_tensors(const tflite::ModelT& model)
+{
+  std::vector<int> res;
+  const tflite::SubGraphT& sg = *model.subgraphs[0];
+  std::vector<int> buffer_refs(model.buffers.size(), 0);
+  for (const auto& s : model.subgraphs)
+    for (const auto& t : s->tensors)
+      buffer_refs[t->buffer]++;
+
+  for (size_t t = 0; t < sg.tensors.size(); t++) {
+    const tflite::TensorT& tensor = *sg.tensors[t];
+    if (tensor.type != tflite::TensorType_INT8 || buffer_refs[tensor.buffer] != 1 ||
+        model.buffers[tensor.buffer]->data.empty())
+      continue;
+    bool filter_only = true;
+    int uses = 0;
+    for (const auto& op : sg.operators) {
+      const tflite::BuiltinOperator code =
+          std::max(model.operator_codes[op->opcode_index]->builtin_code,
+              (tflite::BuiltinOperator)model.operator_codes[op->opcode_index]->deprecated_builtin_code);
+      for (size_t i = 0; i < op->inputs.size(); i++) {
+        if (op->inputs[i] != (int)t)
+          continue;
+        uses++;
+        filter_only &= i == 1 && (code == tflite::BuiltinOperator_CONV_2D ||
+            code == tflite::BuiltinOperator_FULLY_CONNECTED);
+      }
+    }
+    if (uses && filter_only)
+      res.push_back((int)t);
+  }
+  return res;
+}
+
+std::vector<uint8_t> pack(const tflite::ModelT& model)
+{
+  /* the TFLM copy of flatbuffers has no implicit default allocator */
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder fbb(16 * 1024, &allocator);
+  tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, &model));
+  return std::vector<uint8_t>(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+/* Runs the model with a fixed input pattern, returns the outputs and the invoke duration */
+bool run(const std::vector<uint8_t>& model, int runs, std::vector<uint8_t>* outputs,
+    double* t_invoke)
+{
+  uint32_t hdl;
+  if (tflm_c_create(model.data(), arena, sizeof(arena), &hdl) != kTfLiteOk)
+    return false;
+
+  struct tflm_c_tensor_info info;
+  for (int i = 0; i < tflm_c_inputs_size(hdl); i++) {
+    tflm_c_input(hdl, i, &info);
+    for (size_t j = 0; j < info.bytes; j++)
+      ((uint8_t*)info.data)[j] = (uint8_t)(j * 37 + 11);
+  }
+
+  std::vector<double> t;
+  bool ok = true;
+  for (int r = 0; r < runs && ok; r++) {
+    double t0 = tflm_host::now_us();
+    ok = tflm_c_invoke(hdl) == kTfLiteOk;
+    t.push_back(tflm_host::now_us() - t0);
+  }
+  std::sort(t.begin(), t.end());
+  *t_invoke = t[t.size() / 2];
+
+  outputs->clear();
+  for (int i = 0; i < tflm_c_outputs_size(hdl); i++) {
+    tflm_c_output(hdl, i, &info);
+    outputs->insert(outputs->end(), (uint8_t*)info.data, (uint8_t*)info.data + info.bytes);
+  }
+  tflm_c_destroy(hdl);
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int clusters = 0;
+  int runs = 200;
+  const char* paths[2] = {nullptr, nullptr};
+  int n_paths = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-c") && i + 1 < argc)
+      clusters = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (n_paths < 2)
+      paths[n_paths++] = argv[i];
+  }
+  if (n_paths != 2 || clusters < 0 || clusters > tflite::micro::kCompressedWeightsMaxPalette) {
+    fprintf(stderr, "usage: %s <model.tflite> <output.tflite> [-c clusters] [-n runs]\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(paths[0]);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", paths[0]);
+    return 1;
+  }
+  std::unique_ptr<tflite::ModelT> model = tflite::UnPackModel(data.data());
+  if (model->subgraphs.size() != 1) {
+    fprintf(stderr, "E: only single subgraph models are supported\n");
+    return 1;
+  }
+
+  printf("model              : %s\n", paths[0]);
+  printf("mode               : %s\n", clusters ? "lossy (clustered)" : "lossless");
+  size_t raw_total = 0, comp_total = 0;
+  for (int t : candidate_tensors(*model)) {
+    const tflite::TensorT& tensor = *model->subgraphs[0]->tensors[t];
+    std::vector<uint8_t>& buffer = model->buffers[tensor.buffer]->data;
+    std::vector<int8_t> values(buffer.begin(), buffer.end());
+
+    std::vector<int8_t> palette;
+    std::vector<uint8_t> indices;
+    palettise(values, clusters, &palette, &indices);
+    Encoded packed = encode(palette, indices, tflite::micro::kCompressedWeightsCodecPacked);
+    Encoded huffman = encode(palette, indices, tflite::micro::kCompressedWeightsCodecHuffman);
+    const Encoded& best = packed.data.size() <= huffman.data.size() ? packed : huffman;
+
+    /* round trip */
+    std::vector<int8_t> decoded(values.size());
+    if (!tflite::micro::IsCompressedWeights(best.data.data(), values.size(), values.size()) ||
+        tflite::micro::DecompressWeights(best.data.data(), decoded.data(),
+            decoded.size()) != kTfLiteOk) {
+      printf("  %-16s: %6d bytes, kept (%d values, not smaller)\n", tensor.name.c_str(),
+          (int)buffer.size(), best.palette_size);
+      continue;
+    }
+    int max_err = 0;
+    for (size_t i = 0; i < values.size(); i++)
+      max_err = std::max(max_err, abs(decoded[i] - values[i]));
+    if (!clusters && max_err) {
+      fprintf(stderr, "E: %s: lossless round trip fails\n", tensor.name.c_str());
+      return 1;
+    }
+    printf("  %-16s: %6d -> %6d bytes (%s, %d values, max. error %d)\n", tensor.name.c_str(),
+        (int)buffer.size(), (int)best.data.size(),
+        best.codec == tflite::micro::kCompressedWeightsCodecPacked ? "packed" : "huffman",
+        best.palette_size, max_err);
+    raw_total += buffer.size();
+    comp_total += best.data.size();
+    buffer = best.data;
+  }
+
+  std::vector<uint8_t> out = pack(*model);
+
+  std::vector<uint8_t> ref_outputs, outputs;
+  double t_ref, t_comp;
+  if (!run(data, runs, &ref_outputs, &t_ref) || !run(out, runs, &outputs, &t_comp)) {
+    fprintf(stderr, "E: unable to run the models\n");
+    return 1;
+  }
+  int max_diff = 0;
+  for (size_t i = 0; i < outputs.size() && i < ref_outputs.size(); i++)
+    max_diff = std::max(max_diff, abs((int8_t)outputs[i] - (int8_t)ref_outputs[i]));
+  if (outputs.size() != ref_outputs.size() || (!clusters && max_diff)) {
+    fprintf(stderr, "E: outputs of the compressed model differ\n");
+    return 1;
+  }
+
+  printf("weights            : %d -> %d bytes\n", (int)raw_total, (int)comp_total);
+  printf("model              : %d -> %d bytes (%d bytes saved)\n", (int)data.size(),
+      (int)out.size(), (int)data.size() - (int)out.size());
+  printf("invoke (host)      : median %.2f us -> %.2f us (%+.2f us)\n", t_ref, t_comp,
+      t_comp - t_ref);
+  printf("outputs            : max. difference %d\n", max_diff);
+
+  if (!tflm_host::save_file(paths[1], out.data(), out.size())) {
+    fprintf(stderr, "E: unable to write %s\n", paths[1]);
+    return 1;
+  }
+  return 0;
+}
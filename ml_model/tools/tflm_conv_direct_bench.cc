@@ -0,0 +1,259 @@
+/**
+ ******************************************************************************
+ * @file    tflm_conv_direct_bench.cc
+ * @brief   Host check and timing of the direct s8 convolution (1 to 4 input
+ *          channels)
+ ******************************************************************************
+ *
+ * usage: tflm_conv_direct_bench [-n runs]
+ *
+ * The CMSIS-NN conv kernel (CONV_2D) runs the convs with 1 to 4 input
+ * channels without im2col (arm_convolve_direct_s8(), filter transformed at
+ * Prepare by arm_convolve_direct_s8_transform_filter()) when this is faster.
+ * For a set of such shapes (MNIST conv, RGB input, 5x5 filters, stride,
+ * padding, odd output widths, batches), the outputs of the im2col path
+ * (arm_convolve_s8_reordered() when the filter is reordered at Prepare,
+ * arm_convolve_s8() otherwise), of the Winograd path when it applies and of
+ * the direct path must be identical to a naive reference, and the median
+ * durations are reported (CONV_2D takes the Winograd path first, it is faster
+ * for the 3x3 stride 1 convs with 2 to 4 input channels). The shapes the direct
+ * path does not support (more input channels, dilation, 1 x N filters of the
+ * dedicated kernels) must be rejected.
+ *
+ * The tool is built twice: tflm_conv_direct_bench with the x86 SIMD inner
+ * loops of the host library, tflm_conv_direct_bench_dsp with the DSP path of
+ * the kernels (ARM_MATH_DSP, intrinsics emulated by tflm_dsp_emulation.h: the
+ * durations do not represent the Cortex-M33 ones).
+ *
+ * Exit code 1 if an output differs or a shape is wrongly accepted.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Include/arm_nnfunctions.h"
+#include "Include/arm_nnsupportfunctions.h"
+
+#include "tflm_host_utils.h"
+
+namespace {
+
+struct ConvCase {
+  const char* name;
+  int n, h, w, c_in;
+  int kh, kw, c_out;
+  int stride, pad, dilation;
+};
+
+const ConvCase kCases[] = {
+  {"MNIST conv 28x28x1, 3x3x28", 1, 28, 28, 1, 3, 3, 28, 1, 0, 1},
+  {"28x28x1, 5x5x8, pad 2", 1, 28, 28, 1, 5, 5, 8, 1, 2, 1},
+  {"32x32x3, 3x3x16, pad 1", 1, 32, 32, 3, 3, 3, 16, 1, 1, 1},
+  {"32x32x3, 3x3x16, stride 2", 1, 32, 32, 3, 3, 3, 16, 2, 1, 1},
+  {"16x16x2, 3x3x16, pad 1", 1, 16, 16, 2, 3, 3, 16, 1, 1, 1},
+  {"16x16x4, 3x3x16, pad 1", 1, 16, 16, 4, 3, 3, 16, 1, 1, 1},
+  {"15x15x2, 5x5x7, stride 2", 1, 15, 15, 2, 5, 5, 7, 2, 0, 1},
+  {"2 x 9x9x1, 3x3x5 (odd output)", 2, 9, 9, 1, 3, 3, 5, 1, 0, 1},
+};
+
+/* shapes arm_convolve_direct_s8_get_filter_size() must reject */
+const ConvCase kRejected[] = {
+  {"16x16x8, 3x3x16, pad 1", 1, 16, 16, 8, 3, 3, 16, 1, 1, 1},
+  {"16x16x1, 3x3x8, dilation 2", 1, 16, 16, 1, 3, 3, 8, 1, 2, 2},
+  {"16x16x4, 1x1x16", 1, 16, 16, 4, 1, 1, 16, 1, 0, 1},
+};
+
+enum Path { kIm2col, kWinograd, kDirect };
+
+struct ConvData {
+  cmsis_nn_conv_params params;
+  cmsis_nn_dims input_dims, filter_dims, bias_dims, output_dims;
+  std::vector<int8_t> input, filter, reordered;
+  std::vector<int16_t> winograd_filter, direct_filter;
+  std::vector<int32_t> bias, multiplier, shift;
+  std::vector<int16_t> buffer, winograd_buffer, direct_buffer;
+};
+
+void setup_params(const ConvCase& c, ConvData* d)
+{
+  d->params.input_offset = 1 + rand() % 127;
+  d->params.output_offset = -(rand() % 128);
+  d->params.stride.h = d->params.stride.w = c.stride;
+  d->params.padding.h = d->params.padding.w = c.pad;
+  d->params.dilation.h = d->params.dilation.w = c.dilation;
+  d->params.activation.min = -128;
+  d->params.activation.max = 127;
+
+  const int eff_k = (c.kh - 1) * c.dilation + 1;
+  d->input_dims = {c.n, c.h, c.w, c.c_in};
+  d->filter_dims = {c.c_out, c.kh, c.kw, c.c_in};
+  d->bias_dims = {1, 1, 1, c.c_out};
+  d->output_dims = {c.n, (c.h + 2 * c.pad - eff_k) / c.stride + 1,
+      (c.w + 2 * c.pad - eff_k) / c.stride + 1, c.c_out};
+}
+
+void setup(const ConvCase& c, ConvData* d)
+{
+  setup_params(c, d);
+  d->input.resize(c.n * c.h * c.w * c.c_in);
+  d->filter.resize(c.c_out * c.kh * c.kw * c.c_in);
+  for (auto& v : d->input)
+    v = (int8_t)rand();
+  for (auto& v : d->filter)
+    v = (int8_t)rand();
+  d->bias.resize(c.c_out);
+  d->multiplier.resize(c.c_out);
+  d->shift.resize(c.c_out);
+  for (int i = 0; i < c.c_out; i++) {
+    d->bias[i] = rand() % 20001 - 10000;
+    d->multiplier[i] = (1 << 30) + rand() % (1 << 30);
+    d->shift[i] = -(7 + rand() % 4);
+  }
+
+  d->reordered.resize(arm_convolve_s8_get_reordered_filter_size(&d->filter_dims));
+  if (!d->reordered.empty())
+    arm_convolve_s8_reorder_filter(&d->filter_dims, d->filter.data(), d->reordered.data());
+  d->buffer.resize(arm_convolve_s8_get_buffer_size(&d->input_dims, &d->filter_dims) / 2 + 1);
+
+  int32_t size = arm_convolve_winograd_3x3_s8_get_filter_size(&d->params, &d->filter_dims);
+  d->winograd_filter.resize(size / sizeof(int16_t));
+  if (size > 0)
+    arm_convolve_winograd_3x3_s8_transform_filter(&d->filter_dims, d->filter.data(),
+        d->winograd_filter.data());
+  d->winograd_buffer.resize(arm_convolve_winograd_3x3_s8_get_buffer_size(&d->input_dims) / 2);
+
+  size = arm_convolve_direct_s8_get_filter_size(&d->params, &d->filter_dims);
+  d->direct_filter.resize(size / sizeof(int16_t));
+  if (size > 0)
+    arm_convolve_direct_s8_transform_filter(&d->filter_dims, d->filter.data(),
+        d->direct_filter.data());
+  d->direct_buffer.resize(
+      arm_convolve_direct_s8_get_buffer_size(&d->params, &d->filter_dims, &d->output_dims) / 2);
+}
+
+/* direct computation with the same requantization */
+std::vector<int8_t> reference(const ConvData& d)
+{
+  const cmsis_nn_dims& in = d.input_dims;
+  const cmsis_nn_dims& f = d.filter_dims;
+  const cmsis_nn_dims& out = d.output_dims;
+  std::vector<int8_t> res;
+  for (int b = 0; b < out.n; b++)
+    for (int oy = 0; oy < out.h; oy++)
+      for (int ox = 0; ox < out.w; ox++)
+        for (int oc = 0; oc < out.c; oc++) {
+          int32_t acc = d.bias[oc];
+          for (int ky = 0; ky < f.h; ky++)
+            for (int kx = 0; kx < f.w; kx++) {
+              const int iy = oy * d.params.stride.h - d.params.padding.h + ky * d.params.dilation.h;
+              const int ix = ox * d.params.stride.w - d.params.padding.w + kx * d.params.dilation.w;
+              if (iy < 0 || iy >= in.h || ix < 0 || ix >= in.w)
+                continue;
+              for (int ic = 0; ic < in.c; ic++)
+                acc += (d.input[((b * in.h + iy) * in.w + ix) * in.c + ic] + d.params.input_offset) *
+                    d.filter[((oc * f.h + ky) * f.w + kx) * f.c + ic];
+            }
+          acc = arm_nn_requantize(acc, d.multiplier[oc], d.shift[oc]) + d.params.output_offset;
+          acc = std::min(std::max(acc, d.params.activation.min), d.params.activation.max);
+          res.push_back((int8_t)acc);
+        }
+  return res;
+}
+
+/* median duration (us) of n calls, output of the last one */
+double run(ConvData& d, Path path, int runs, std::vector<int8_t>* output)
+{
+  std::vector<int16_t>& buffer = path == kWinograd ? d.winograd_buffer :
+      path == kDirect ? d.direct_buffer : d.buffer;
+  cmsis_nn_context ctx = {buffer.data(), (int32_t)(buffer.size() * sizeof(int16_t))};
+  cmsis_nn_per_channel_quant_params quant = {d.multiplier.data(), d.shift.data()};
+  output->assign(d.output_dims.n * d.output_dims.h * d.output_dims.w * d.output_dims.c, 0);
+  std::vector<double> t;
+  for (int i = 0; i < runs; i++) {
+    arm_cmsis_nn_status status;
+    const double t0 = tflm_host::now_us();
+    if (path == kDirect)
+      status = arm_convolve_direct_s8(&ctx, &d.params, &quant, &d.input_dims, d.input.data(),
+          &d.filter_dims, d.direct_filter.data(), &d.bias_dims, d.bias.data(), &d.output_dims,
+          output->data());
+    else if (path == kWinograd)
+      status = arm_convolve_winograd_3x3_s8(&ctx, &d.params, &quant, &d.input_dims,
+          d.input.data(), &d.filter_dims, d.winograd_filter.data(), &d.bias_dims, d.bias.data(),
+          &d.output_dims, output->data());
+    else if (!d.reordered.empty())
+      status = arm_convolve_s8_reordered(&ctx, &d.params, &quant, &d.input_dims, d.input.data(),
+          &d.filter_dims, d.reordered.data(), &d.bias_dims, d.bias.data(), &d.output_dims,
+          output->data());
+    else
+      status = arm_convolve_s8(&ctx, &d.params, &quant, &d.input_dims, d.input.data(),
+          &d.filter_dims, d.filter.data(), &d.bias_dims, d.bias.data(), &d.output_dims,
+          output->data());
+    t.push_back(tflm_host::now_us() - t0);
+    if (status != ARM_CMSIS_NN_SUCCESS)
+      return -1.0;
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 200;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else {
+      fprintf(stderr, "usage: %s [-n runs]\n", argv[0]);
+      return 2;
+    }
+  }
+
+#if defined(ARM_MATH_DSP)
+  printf("DSP path (emulated intrinsics)\n");
+#elif defined(CMSIS_NN_HOST_SIMD)
+  printf("x86 SIMD inner loops\n");
+#else
+  printf("portable C path\n");
+#endif
+
+  int res = 0;
+  srand(1);
+  printf("1 to 4 input channels (im2col -> direct, Winograd when it applies)\n");
+  for (const ConvCase& c : kCases) {
+    ConvData d;
+    setup(c, &d);
+    const std::vector<int8_t> ref = reference(d);
+    std::vector<int8_t> im2col, winograd, direct;
+    const double t_im2col = run(d, kIm2col, runs, &im2col);
+    const double t_direct = run(d, kDirect, runs, &direct);
+    bool ok = t_im2col >= 0.0 && im2col == ref && t_direct >= 0.0 && direct == ref;
+    printf("  %-30s : %8.2f us -> %8.2f us (x%.2f)", c.name, t_im2col, t_direct,
+        t_im2col / t_direct);
+    if (!d.winograd_filter.empty()) {
+      /* CONV_2D takes the Winograd path first */
+      const double t_winograd = run(d, kWinograd, runs, &winograd);
+      ok &= t_winograd >= 0.0 && winograd == ref;
+      printf(", Winograd %8.2f us", t_winograd);
+    }
+    printf("%s\n", ok ? "" : " FAILED");
+    if (!ok)
+      res = 1;
+  }
+
+  printf("rejected shapes\n");
+  for (const ConvCase& c : kRejected) {
+    ConvData d;
+    setup_params(c, &d);
+    const bool ok = arm_convolve_direct_s8_get_filter_size(&d.params, &d.filter_dims) == 0;
+    printf("  %-30s : %s\n", c.name, ok ? "falls back" : "accepted FAILED");
+    if (!ok)
+      res = 1;
+  }
+  return res;
+}
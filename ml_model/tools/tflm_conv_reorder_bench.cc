@@ -0,0 +1,192 @@
+/**
+ ******************************************************************************
+ * @file    tflm_conv_reorder_bench.cc
+ * @brief   Host check and timing of the s8 convolution with reordered filter
+ ******************************************************************************
+ *
+ * usage: tflm_conv_reorder_bench [-n runs]
+ *
+ * On the DSP (non-MVE) targets, the CMSIS-NN conv kernel (CONV_2D) uses a
+ * filter reordered at Prepare (arm_convolve_s8_reorder_filter(),
+ * arm_convolve_s8_reordered()) instead of rearranging the weights at each
+ * call. For a set of conv shapes (MNIST conv, odd numbers of output pixels
+ * and channels, rows not multiple of 4, padding, stride, dilation, batches),
+ * the outputs of arm_convolve_s8() with the original filter and of
+ * arm_convolve_s8_reordered() with the reordered filter must be identical to
+ * a naive reference, and the median durations are reported.
+ *
+ * The tool is built twice: tflm_conv_reorder_bench with the portable C path
+ * of the host library, tflm_conv_reorder_bench_dsp with the DSP path of the
+ * kernels (ARM_MATH_DSP, intrinsics emulated by tflm_dsp_emulation.h: the
+ * durations do not represent the Cortex-M33 ones).
+ *
+ * Exit code 1 if an output differs.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Include/arm_nnfunctions.h"
+#include "Include/arm_nnsupportfunctions.h"
+
+#include "tflm_host_utils.h"
+
+namespace {
+
+struct ConvCase {
+  const char* name;
+  int n, h, w, c_in;
+  int kh, kw, c_out;
+  int stride, pad, dilation;
+};
+
+const ConvCase kCases[] = {
+  {"MNIST conv 28x28x1, 3x3x28", 1, 28, 28, 1, 3, 3, 28, 1, 0, 1},
+  {"14x14x8, 3x3x16, pad 1", 1, 14, 14, 8, 3, 3, 16, 1, 1, 1},
+  {"15x15x3, 3x3x15, stride 2", 1, 15, 15, 3, 3, 3, 15, 2, 0, 1},
+  {"12x12x6, 5x5x9, pad 2", 1, 12, 12, 6, 5, 5, 9, 1, 2, 1},
+  {"16x16x4, 3x3x8, dilation 2", 1, 16, 16, 4, 3, 3, 8, 1, 2, 2},
+  {"2 x 9x9x5, 3x3x7", 2, 9, 9, 5, 3, 3, 7, 1, 1, 1},
+};
+
+struct ConvData {
+  cmsis_nn_conv_params params;
+  cmsis_nn_dims input_dims, filter_dims, bias_dims, output_dims;
+  std::vector<int8_t> input, filter, reordered;
+  std::vector<int32_t> bias, multiplier, shift;
+  std::vector<int16_t> buffer;
+};
+
+void setup(const ConvCase& c, ConvData* d)
+{
+  d->params.input_offset = 1 + rand() % 127;
+  d->params.output_offset = -(rand() % 128);
+  d->params.stride.h = d->params.stride.w = c.stride;
+  d->params.padding.h = d->params.padding.w = c.pad;
+  d->params.dilation.h = d->params.dilation.w = c.dilation;
+  d->params.activation.min = -128;
+  d->params.activation.max = 127;
+
+  const int eff_k = (c.kh - 1) * c.dilation + 1;
+  d->input_dims = {c.n, c.h, c.w, c.c_in};
+  d->filter_dims = {c.c_out, c.kh, c.kw, c.c_in};
+  d->bias_dims = {1, 1, 1, c.c_out};
+  d->output_dims = {c.n, (c.h + 2 * c.pad - eff_k) / c.stride + 1,
+      (c.w + 2 * c.pad - eff_k) / c.stride + 1, c.c_out};
+
+  d->input.resize(c.n * c.h * c.w * c.c_in);
+  d->filter.resize(c.c_out * c.kh * c.kw * c.c_in);
+  for (auto& v : d->input)
+    v = (int8_t)rand();
+  for (auto& v : d->filter)
+    v = (int8_t)rand();
+  d->bias.resize(c.c_out);
+  d->multiplier.resize(c.c_out);
+  d->shift.resize(c.c_out);
+  for (int i = 0; i < c.c_out; i++) {
+    d->bias[i] = rand() % 20001 - 10000;
+    d->multiplier[i] = (1 << 30) + rand() % (1 << 30);
+    d->shift[i] = -(7 + rand() % 4);
+  }
+
+  d->reordered.resize(d->filter.size());
+  arm_convolve_s8_reorder_filter(&d->filter_dims, d->filter.data(), d->reordered.data());
+  d->buffer.resize(arm_convolve_s8_get_buffer_size(&d->input_dims, &d->filter_dims) / 2 + 1);
+}
+
+/* direct computation with the same requantization */
+std::vector<int8_t> reference(const ConvData& d)
+{
+  const cmsis_nn_dims& in = d.input_dims;
+  const cmsis_nn_dims& f = d.filter_dims;
+  const cmsis_nn_dims& out = d.output_dims;
+  std::vector<int8_t> res;
+  for (int b = 0; b < out.n; b++)
+    for (int oy = 0; oy < out.h; oy++)
+      for (int ox = 0; ox < out.w; ox++)
+        for (int oc = 0; oc < out.c; oc++) {
+          int32_t acc = d.bias[oc];
+          for (int ky = 0; ky < f.h; ky++)
+            for (int kx = 0; kx < f.w; kx++) {
+              const int iy = oy * d.params.stride.h - d.params.padding.h + ky * d.params.dilation.h;
+              const int ix = ox * d.params.stride.w - d.params.padding.w + kx * d.params.dilation.w;
+              if (iy < 0 || iy >= in.h || ix < 0 || ix >= in.w)
+                continue;
+              for (int ic = 0; ic < in.c; ic++)
+                acc += (d.input[((b * in.h + iy) * in.w + ix) * in.c + ic] + d.params.input_offset) *
+                    d.filter[((oc * f.h + ky) * f.w + kx) * f.c + ic];
+            }
+          acc = arm_nn_requantize(acc, d.multiplier[oc], d.shift[oc]) + d.params.output_offset;
+          acc = std::min(std::max(acc, d.params.activation.min), d.params.activation.max);
+          res.push_back((int8_t)acc);
+        }
+  return res;
+}
+
+/* median duration (us) of n calls, output of the last one */
+double run(ConvData& d, bool reordered, int runs, std::vector<int8_t>* output)
+{
+  cmsis_nn_context ctx = {d.buffer.data(), (int32_t)(d.buffer.size() * sizeof(int16_t))};
+  cmsis_nn_per_channel_quant_params quant = {d.multiplier.data(), d.shift.data()};
+  output->assign(d.output_dims.n * d.output_dims.h * d.output_dims.w * d.output_dims.c, 0);
+  std::vector<double> t;
+  for (int i = 0; i < runs; i++) {
+    const double t0 = tflm_host::now_us();
+    arm_cmsis_nn_status status = reordered ?
+        arm_convolve_s8_reordered(&ctx, &d.params, &quant, &d.input_dims, d.input.data(),
+            &d.filter_dims, d.reordered.data(), &d.bias_dims, d.bias.data(), &d.output_dims,
+            output->data()) :
+        arm_convolve_s8(&ctx, &d.params, &quant, &d.input_dims, d.input.data(), &d.filter_dims,
+            d.filter.data(), &d.bias_dims, d.bias.data(), &d.output_dims, output->data());
+    t.push_back(tflm_host::now_us() - t0);
+    if (status != ARM_CMSIS_NN_SUCCESS)
+      return -1.0;
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 200;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else {
+      fprintf(stderr, "usage: %s [-n runs]\n", argv[0]);
+      return 2;
+    }
+  }
+
+#if defined(ARM_MATH_DSP)
+  printf("DSP path (emulated intrinsics)\n");
+#else
+  printf("portable C path\n");
+#endif
+  const cmsis_nn_dims mnist_filter = {28, 3, 3, 1};
+  printf("reordered at Prepare (MNIST conv filter): %s\n",
+      arm_convolve_s8_get_reordered_filter_size(&mnist_filter) ? "yes" : "no");
+
+  int res = 0;
+  srand(1);
+  for (const ConvCase& c : kCases) {
+    ConvData d;
+    std::vector<int8_t> original, reordered;
+    setup(c, &d);
+    const std::vector<int8_t> ref = reference(d);
+    const double t_original = run(d, false, runs, &original);
+    const double t_reordered = run(d, true, runs, &reordered);
+    const bool ok = t_original >= 0.0 && t_reordered >= 0.0 && original == ref && reordered == ref;
+    printf("  %-28s : %8.2f us -> %8.2f us reordered (%+.1f%%)%s\n", c.name, t_original,
+        t_reordered, 100.0 * (t_reordered - t_original) / t_original, ok ? "" : " FAILED");
+    if (!ok)
+      res = 1;
+  }
+  return res;
+}
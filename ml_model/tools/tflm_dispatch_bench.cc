@@ -0,0 +1,141 @@
+/**
+ ******************************************************************************
+ * @file    tflm_dispatch_bench.cc
+ * @brief   Host measurement of the per operator dispatch cost of tflm_c_invoke()
+ ******************************************************************************
+ *
+ * usage: tflm_dispatch_bench [-n runs] [<model.tflite> ..]
+ *
+ * Chains of 16, 64 and 256 RELU operators on 8 int8 values are generated
+ * (tflm_model_builder.h): the kernel work is negligible, the duration of
+ * tflm_c_invoke() divided by the number of operators is the cost of the
+ * dispatch loop (MicroGraph::InvokeSubgraph()) and of the kernel call.
+ * The given models are also run (end-to-end duration).
+ *
+ * Reported (median and minimum of the runs, the minimum being less sensitive
+ * to the host load): without observer, then with an observer registered
+ * (tflm_c_observer_register(), empty callback), the difference is the cost of
+ * the profiling hooks.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tensorflow/lite/micro/micro_interpreter.h"
+
+#include "tflm_c.h"
+#include "tflm_host_utils.h"
+#include "tflm_model_builder.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+uint64_t host_time_ns(int mode)
+{
+  return (uint64_t)(tflm_host::now_us() * 1000.0);
+}
+
+int ignore_node(const void* cookie, const uint32_t flags, const struct tflm_c_node* node)
+{
+  return 0;
+}
+
+struct Timing {
+  double median;  /* us */
+  double min;
+};
+
+/* duration of tflm_c_invoke(), median < 0 if it fails */
+Timing time_invoke(uint32_t hdl, int runs)
+{
+  std::vector<double> t;
+  for (int i = 0; i < runs; i++) {
+    double t0 = tflm_host::now_us();
+    if (tflm_c_invoke(hdl) != kTfLiteOk)
+      return {-1.0, -1.0};
+    t.push_back(tflm_host::now_us() - t0);
+  }
+  std::sort(t.begin(), t.end());
+  return {t[t.size() / 2], t[0]};
+}
+
+int bench(const std::string& name, const std::vector<uint8_t>& data, int n_ops, int runs)
+{
+  uint32_t hdl;
+  if (data.empty() || tflm_c_create(data.data(), arena, sizeof(arena), &hdl) != kTfLiteOk) {
+    fprintf(stderr, "E: unable to create %s\n", name.c_str());
+    return 1;
+  }
+  struct tflm_c_tensor_info info;
+  srand(1);
+  for (int i = 0; i < tflm_c_inputs_size(hdl); i++) {
+    tflm_c_input(hdl, i, &info);
+    for (size_t j = 0; j < info.bytes; j++)
+      ((uint8_t*)info.data)[j] = (uint8_t)rand();
+  }
+  if (n_ops <= 0)
+    n_ops = tflm_c_operators_size(hdl);
+
+  time_invoke(hdl, runs / 10 + 1);  /* warm-up */
+  const Timing plain = time_invoke(hdl, runs);
+  struct tflm_c_observer_options options = {ignore_node, host_time_ns, nullptr, 0};
+  Timing observed = {-1.0, -1.0};
+  if (tflm_c_observer_register(hdl, &options) == kTfLiteOk) {
+    observed = time_invoke(hdl, runs);
+    tflm_c_observer_unregister(hdl, &options);
+  }
+  tflm_c_destroy(hdl);
+  if (plain.median < 0.0 || observed.median < 0.0) {
+    fprintf(stderr, "E: %s fails\n", name.c_str());
+    return 1;
+  }
+
+  const double ns = 1000.0 / n_ops;
+  printf("%s (%d ops)\n", name.c_str(), n_ops);
+  printf("  invoke           : %.2f us, %.1f ns/op (min %.1f ns/op)\n", plain.median,
+      plain.median * ns, plain.min * ns);
+  printf("  with observer    : %.2f us, %.1f ns/op (min %.1f ns/op)\n", observed.median,
+      observed.median * ns, observed.min * ns);
+  return 0;
+}
+
+/* n RELU operators on a 1x1x1x8 int8 tensor */
+std::vector<uint8_t> generate_chain(int n)
+{
+  tflm_host::ModelBuilder b;
+  int32_t x = b.input({1, 1, 1, 8}, 0.1f, 0);
+  for (int i = 0; i < n; i++)
+    x = b.relu(x);
+  b.output(x);
+  return b.pack();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 2000;
+  std::vector<const char*> paths;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (argv[i][0] != '-')
+      paths.push_back(argv[i]);
+    else {
+      fprintf(stderr, "usage: %s [-n runs] [<model.tflite> ..]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  int res = 0;
+  for (int n = 16; n <= 256; n *= 4)
+    res |= bench("RELU chain (generated)", generate_chain(n), n, runs);
+  for (const char* path : paths)
+    res |= bench(path, tflm_host::load_file(path), 0, runs);
+  return res;
+}
@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * @file    tflm_dsp_emulation.h
+ * @brief   C versions of the Arm DSP extension intrinsics used by CMSIS-NN
+ ******************************************************************************
+ *
+ * Forced include (-include) of the CMSIS-NN sources built on host with
+ * ARM_MATH_DSP, so the DSP path of the kernels (the Cortex-M33 one) runs on
+ * host: same results as the instructions (the Q flag is not emulated),
+ * not the same timings. Only the intrinsics of the sources built this way
+ * are provided (see tflm_conv_reorder_bench in CMakeLists.txt).
+ */
+
+#ifndef __TFLM_DSP_EMULATION_H__
+#define __TFLM_DSP_EMULATION_H__
+
+#include <stdint.h>
+
+#if defined(__ARM_FEATURE_DSP)
+#error "tflm_dsp_emulation.h is for the host builds"
+#endif
+
+static inline uint32_t ROR(uint32_t op1, uint32_t op2)
+{
+  op2 %= 32U;
+  return op2 ? (op1 >> op2) | (op1 << (32U - op2)) : op1;
+}
+
+/* sign extended bytes 0 and 2 */
+static inline uint32_t SXTB16(uint32_t op1)
+{
+  return (uint32_t)(uint16_t)(int16_t)(int8_t)op1 |
+      ((uint32_t)(uint16_t)(int16_t)(int8_t)(op1 >> 16) << 16);
+}
+
+static inline uint32_t SXTB16_RORn(uint32_t op1, uint32_t rotate)
+{
+  return SXTB16(ROR(op1, rotate));
+}
+
+/* halfwords of op1 + sign extended bytes 0 and 2 of op2 */
+static inline uint32_t SXTAB16(uint32_t op1, uint32_t op2)
+{
+  const uint16_t lo = (uint16_t)(op1 + (uint32_t)(int8_t)op2);
+  const uint16_t hi = (uint16_t)((op1 >> 16) + (uint32_t)(int8_t)(op2 >> 16));
+  return (uint32_t)lo | ((uint32_t)hi << 16);
+}
+
+static inline uint32_t SXTAB16_RORn(uint32_t op1, uint32_t op2, uint32_t rotate)
+{
+  return SXTAB16(op1, ROR(op2, rotate));
+}
+
+/* op3 + dual signed 16-bit multiply */
+static inline uint32_t SMLAD(uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  const int32_t lo = (int32_t)(int16_t)op1 * (int16_t)op2;
+  const int32_t hi = (int32_t)(int16_t)(op1 >> 16) * (int16_t)(op2 >> 16);
+  return op3 + (uint32_t)lo + (uint32_t)hi;
+}
+
+#define PKHBT(ARG1, ARG2, ARG3) \
+  ((((uint32_t)(ARG1)) & 0x0000FFFFUL) | ((((uint32_t)(ARG2)) << (ARG3)) & 0xFFFF0000UL))
+#define PKHTB(ARG1, ARG2, ARG3) \
+  ((((uint32_t)(ARG1)) & 0xFFFF0000UL) | ((((uint32_t)(ARG2)) >> (ARG3)) & 0x0000FFFFUL))
+
+#endif /* __TFLM_DSP_EMULATION_H__ */
@@ -0,0 +1,321 @@
+/**
+ ******************************************************************************
+ * @file    tflm_fold_input.cc
+ * @brief   Host rewrite folding the input normalisation in the first conv
+ ******************************************************************************
+ *
+ * usage: tflm_fold_input <model.tflite> <output.tflite> [-m mean] [-d std]
+ *                        [-n runs]
+ *
+ * The model has been trained with real = (pixel - mean) / std (MNIST:
+ * mean 0, std 255) and its int8 input is quantized at runtime with the
+ * calibrated scale/zero-point of the input tensor. After the rewrite, the
+ * input tensor holds the raw pixels: q = pixel - 128 (scale 1, zero-point
+ * -128), i.e. int8 pixels as is, or uint8 pixels ^ 0x80. The normalisation is
+ * folded in the CONV_2D/DEPTHWISE_CONV_2D consuming the input:
+ *
+ *   filter scale'[c] = filter scale[c] / std        (int8 weights unchanged)
+ *   bias'[c]         = round(bias[c] * input scale * std - mean * sum(w[c]))
+ *
+ * The mean is only folded with a VALID padding (padded values are not
+ * shifted) and with uncompressed weights (run it before tflm_compress). The
+ * filter/bias must only be used by this operator.
+ *
+ * The two models are run with the same pixels (those the original input
+ * quantization represents without saturation): original model fed by the
+ * runtime quantization pass, rewritten model fed by the raw pixels. The
+ * largest output difference and the duration of the removed pass are
+ * reported. Exit code 1 if the difference is larger than -t (default 0).
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "tensorflow/lite/micro/kernels/weight_compression.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+#include "tflm_preproc.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+constexpr int kSamples = 16;
+
+tflite::BuiltinOperator op_code(const tflite::ModelT& model, const tflite::OperatorT& op)
+{
+  const tflite::OperatorCodeT& code = *model.operator_codes[op.opcode_index];
+  return std::max(code.builtin_code, (tflite::BuiltinOperator)code.deprecated_builtin_code);
+}
+
+/* number of operator inputs referencing the tensor */
+int tensor_uses(const tflite::SubGraphT& sg, int tensor)
+{
+  int uses = 0;
+  for (const auto& op : sg.operators)
+    uses += (int)std::count(op->inputs.begin(), op->inputs.end(), tensor);
+  return uses;
+}
+
+int buffer_uses(const tflite::ModelT& model, uint32_t buffer)
+{
+  int uses = 0;
+  for (const auto& s : model.subgraphs)
+    for (const auto& t : s->tensors)
+      uses += t->buffer == buffer;
+  return uses;
+}
+
+bool fail(const char* msg)
+{
+  fprintf(stderr, "E: %s\n", msg);
+  return false;
+}
+
+bool fold(tflite::ModelT* model, float mean, float std_dev)
+{
+  tflite::SubGraphT& sg = *model->subgraphs[0];
+  if (sg.inputs.size() != 1)
+    return fail("single input models only");
+  const int input = sg.inputs[0];
+  tflite::TensorT& in = *sg.tensors[input];
+  if (in.type != tflite::TensorType_INT8 || !in.quantization ||
+      in.quantization->scale.size() != 1 || in.quantization->zero_point.size() != 1)
+    return fail("int8 input tensor (per-tensor quantization) expected");
+
+  tflite::OperatorT* conv = nullptr;
+  for (auto& op : sg.operators) {
+    for (size_t i = 0; i < op->inputs.size(); i++) {
+      if (op->inputs[i] != input)
+        continue;
+      if (conv || i != 0)
+        return fail("the input must only feed the first convolution");
+      conv = op.get();
+    }
+  }
+  const tflite::BuiltinOperator code = conv ? op_code(*model, *conv) : tflite::BuiltinOperator_ADD;
+  if (code != tflite::BuiltinOperator_CONV_2D && code != tflite::BuiltinOperator_DEPTHWISE_CONV_2D)
+    return fail("the input does not feed a CONV_2D/DEPTHWISE_CONV_2D operator");
+  if (conv->inputs.size() < 3 || conv->inputs[2] < 0)
+    return fail("the convolution has no bias");
+
+  const tflite::Padding padding = code == tflite::BuiltinOperator_CONV_2D
+      ? conv->builtin_options.AsConv2DOptions()->padding
+      : conv->builtin_options.AsDepthwiseConv2DOptions()->padding;
+  if (mean != 0.0f && padding != tflite::Padding_VALID)
+    return fail("the mean can only be folded with a VALID padding");
+
+  tflite::TensorT& filter = *sg.tensors[conv->inputs[1]];
+  tflite::TensorT& bias = *sg.tensors[conv->inputs[2]];
+  const std::vector<uint8_t>& w = model->buffers[filter.buffer]->data;
+  std::vector<uint8_t>& b = model->buffers[bias.buffer]->data;
+  if (filter.type != tflite::TensorType_INT8 || bias.type != tflite::TensorType_INT32 ||
+      w.empty() || b.empty() || !filter.quantization || filter.quantization->scale.empty())
+    return fail("int8 constant filter and int32 constant bias expected");
+  if (tensor_uses(sg, conv->inputs[1]) != 1 || tensor_uses(sg, conv->inputs[2]) != 1 ||
+      buffer_uses(*model, filter.buffer) != 1 || buffer_uses(*model, bias.buffer) != 1)
+    return fail("the filter/bias are shared with another operator");
+
+  /* output channels: first dimension (CONV_2D) or last one (DEPTHWISE_CONV_2D) */
+  const size_t n_out = b.size() / sizeof(int32_t);
+  size_t n_w = 1;
+  for (int d : filter.shape)
+    n_w *= (size_t)d;
+  if (n_out == 0 || n_w % n_out)
+    return fail("unexpected filter/bias shapes");
+  std::vector<int64_t> w_sum(n_out, 0);
+  if (mean != 0.0f) {
+    if (tflite::micro::IsCompressedWeights(w.data(), w.size(), n_w))
+      return fail("compressed filter, fold the input before tflm_compress");
+    if (w.size() != n_w)
+      return fail("unexpected filter size");
+    for (size_t k = 0; k < n_w; k++) {
+      const size_t c = code == tflite::BuiltinOperator_CONV_2D ? k / (n_w / n_out) : k % n_out;
+      w_sum[c] += (int8_t)w[k];
+    }
+  }
+
+  const float in_scale = in.quantization->scale[0];
+  for (size_t c = 0; c < n_out; c++) {
+    int32_t v;
+    memcpy(&v, &b[c * sizeof(v)], sizeof(v));
+    const double folded = (double)v * in_scale * std_dev - (double)mean * w_sum[c];
+    if (fabs(folded) > 2147483647.0)
+      return fail("folded bias out of range");
+    v = (int32_t)lround(folded);
+    memcpy(&b[c * sizeof(v)], &v, sizeof(v));
+  }
+
+  for (float& s : filter.quantization->scale)
+    s /= std_dev;
+  if (bias.quantization) {
+    bias.quantization->scale = filter.quantization->scale;
+    bias.quantization->zero_point.assign(filter.quantization->scale.size(), 0);
+  }
+
+  in.quantization->scale = {1.0f};
+  in.quantization->zero_point = {-128};
+  in.quantization->min.clear();
+  in.quantization->max.clear();
+  return true;
+}
+
+std::vector<uint8_t> pack(const tflite::ModelT& model)
+{
+  /* the TFLM copy of flatbuffers has no implicit default allocator */
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder fbb(16 * 1024, &allocator);
+  tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, &model));
+  return std::vector<uint8_t>(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+/* Runs the model on each frame: the quantization pass (q) writes the input
+ * tensor, returns the outputs and the median durations of the pass/invoke */
+bool run(const std::vector<uint8_t>& model, const tflm_pp_quant& q,
+    const std::vector<std::vector<uint8_t>>& frames, int runs, std::vector<int8_t>* outputs,
+    double* t_pass, double* t_invoke)
+{
+  uint32_t hdl;
+  if (tflm_c_create(model.data(), arena, sizeof(arena), &hdl) != kTfLiteOk)
+    return false;
+
+  struct tflm_c_tensor_info in, out;
+  tflm_c_input(hdl, 0, &in);
+  std::vector<double> tp, ti;
+  bool ok = true;
+  outputs->clear();
+  for (int r = 0; r < runs && ok; r++) {
+    for (const auto& frame : frames) {
+      double t0 = tflm_host::now_us();
+      tflm_pp_quantize(&q, frame.data(), (int8_t*)in.data, in.bytes);
+      double t1 = tflm_host::now_us();
+      ok &= tflm_c_invoke(hdl) == kTfLiteOk;
+      tp.push_back(t1 - t0);
+      ti.push_back(tflm_host::now_us() - t1);
+      if (r == 0) {
+        tflm_c_output(hdl, 0, &out);
+        outputs->insert(outputs->end(), (int8_t*)out.data, (int8_t*)out.data + out.bytes);
+      }
+    }
+  }
+  std::sort(tp.begin(), tp.end());
+  std::sort(ti.begin(), ti.end());
+  *t_pass = tp[tp.size() / 2];
+  *t_invoke = ti[ti.size() / 2];
+  tflm_c_destroy(hdl);
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  float mean = 0.0f;
+  float std_dev = 255.0f;
+  int tolerance = 0;
+  int runs = 20;
+  const char* paths[2] = {nullptr, nullptr};
+  int n_paths = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-m") && i + 1 < argc)
+      mean = (float)atof(argv[++i]);
+    else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+      std_dev = (float)atof(argv[++i]);
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      tolerance = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (n_paths < 2)
+      paths[n_paths++] = argv[i];
+  }
+  if (n_paths != 2 || !(std_dev > 0.0f)) {
+    fprintf(stderr, "usage: %s <model.tflite> <output.tflite> [-m mean] [-d std] [-t tolerance]"
+        " [-n runs]\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(paths[0]);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", paths[0]);
+    return 1;
+  }
+  std::unique_ptr<tflite::ModelT> model = tflite::UnPackModel(data.data());
+  if (model->subgraphs.size() != 1) {
+    fprintf(stderr, "E: only single subgraph models are supported\n");
+    return 1;
+  }
+  const tflite::TensorT& in = *model->subgraphs[0]->tensors[model->subgraphs[0]->inputs[0]];
+  const float in_scale = in.quantization ? in.quantization->scale[0] : 0.0f;
+  const int32_t in_zp = in.quantization ? (int32_t)in.quantization->zero_point[0] : 0;
+  if (!fold(model.get(), mean, std_dev))
+    return 1;
+  std::vector<uint8_t> out = pack(*model);
+
+  /* runtime pass of the original model: pixel -> (pixel - mean) / std -> int8,
+   * rewritten model: pixel ^ 0x80 */
+  tflm_pp_quant q_ref, q_raw;
+  tflm_pp_quant_init(&q_ref, 1.0f / std_dev, in_scale, in_zp, 0);
+  tflm_pp_quant_init(&q_raw, 1.0f, 1.0f, -128, 0);
+
+  /* the mean is applied here, only the pixels represented without saturation
+   * by the original quantization are used */
+  std::vector<uint8_t> pixels;
+  q_ref.xor_mask = 0;
+  for (int p = 0; p < 256; p++) {
+    const long v = lroundf(((float)p - mean) / std_dev / in_scale) + in_zp;
+    q_ref.lut[p] = (int8_t)std::min(127L, std::max(-128L, v));
+    if (v >= -128 && v <= 127)
+      pixels.push_back((uint8_t)p);
+  }
+  if (pixels.empty()) {
+    fprintf(stderr, "E: no pixel value is represented by the input quantization\n");
+    return 1;
+  }
+  size_t in_bytes = 1;
+  for (int d : in.shape)
+    in_bytes *= (size_t)d;
+  std::vector<std::vector<uint8_t>> frames(kSamples, std::vector<uint8_t>(in_bytes));
+  srand(1);
+  for (auto& frame : frames)
+    for (auto& p : frame)
+      p = pixels[rand() % pixels.size()];
+
+  std::vector<int8_t> ref_outputs, outputs;
+  double tp_ref, ti_ref, tp_raw, ti_raw;
+  if (!run(data, q_ref, frames, runs, &ref_outputs, &tp_ref, &ti_ref) ||
+      !run(out, q_raw, frames, runs, &outputs, &tp_raw, &ti_raw)) {
+    fprintf(stderr, "E: unable to run the models\n");
+    return 1;
+  }
+  int max_diff = 0;
+  for (size_t i = 0; i < outputs.size(); i++)
+    max_diff = std::max(max_diff, abs(outputs[i] - ref_outputs[i]));
+
+  printf("model              : %s\n", paths[0]);
+  printf("normalisation      : (pixel - %g) / %g\n", (double)mean, (double)std_dev);
+  printf("input              : scale=%g zp=%d -> scale=1 zp=-128 (raw pixels)\n",
+      (double)in_scale, (int)in_zp);
+  printf("pixels checked     : %d..%d (%d values), %d frames\n", pixels.front(), pixels.back(),
+      (int)pixels.size(), kSamples);
+  printf("input pass (host)  : median %.3f us (table) -> %.3f us (xor, none for int8 pixels)\n",
+      tp_ref, tp_raw);
+  printf("invoke (host)      : median %.2f us -> %.2f us\n", ti_ref, ti_raw);
+  printf("outputs            : max. difference %d\n", max_diff);
+  if (max_diff > tolerance) {
+    fprintf(stderr, "E: outputs of the rewritten model differ\n");
+    return 1;
+  }
+
+  if (!tflm_host::save_file(paths[1], out.data(), out.size())) {
+    fprintf(stderr, "E: unable to write %s\n", paths[1]);
+    return 1;
+  }
+  return 0;
+}
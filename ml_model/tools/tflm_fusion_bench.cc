@@ -0,0 +1,173 @@
+/**
+ ******************************************************************************
+ * @file    tflm_fusion_bench.cc
+ * @brief   Host comparison of the unfused and fused CONV_2D -> MAX_POOL_2D
+ ******************************************************************************
+ *
+ * usage: tflm_fusion_bench [-n runs] [-g] [<model.tflite> ..]
+ *
+ * Each model is created with tflm_c_create_with_planner() (greedy planner)
+ * without and with TFLM_C_PLANNER_FUSE_OPS: prepare-time fusion of the int8
+ * CONV_2D -> [RELU|RELU6] -> MAX_POOL_2D chains (micro_op_fusion.h), the conv
+ * output is pooled by bands of rows and never stored.
+ *
+ * Reported for both: number of planned buffers and size of the memory plan
+ * (activations and scratch buffers), arena used bytes and median latency of
+ * the inference (fixed random inputs). The outputs must be identical (the
+ * fused kernel computes the same conv rows and the same max).
+ *
+ * -g: int8 models generated with the layers of the selected_model variants of
+ * train_mnist_model.py (tflm_model_builder.h), plus a SAME padded conv
+ * followed by a RELU operator.
+ *
+ * Exit code 1 if the outputs differ or if the fused arena is larger.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+
+#include "tflm_c.h"
+#include "tflm_host_utils.h"
+#include "tflm_model_builder.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+struct Result {
+  int buffers;
+  size_t plan;      /* bytes */
+  int32_t used;     /* arena used bytes */
+  double us;        /* median invoke */
+  std::vector<uint8_t> outputs;
+};
+
+/* requirements recorded while the tensors are allocated */
+bool record(const std::vector<uint8_t>& data, bool fuse, Result* res)
+{
+  static tflite::AllOpsResolver resolver;
+  tflm_host::RecordingMemoryPlanner planner;
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(arena, sizeof(arena), &planner);
+  tflite::MicroInterpreter interpreter(tflite::GetModel(data.data()), resolver, allocator);
+  interpreter.SetOperatorFusion(fuse);
+  if (interpreter.AllocateTensors() != kTfLiteOk)
+    return false;
+  res->buffers = (int)planner.requirements.size();
+  res->plan = planner.GetMaximumMemorySize();
+  return true;
+}
+
+/* instance created with or without fusion, outputs for fixed random inputs */
+bool run(const std::vector<uint8_t>& data, bool fuse, int runs, Result* res)
+{
+  uint32_t hdl;
+  const uint32_t planner = TFLM_C_PLANNER_GREEDY | (fuse ? TFLM_C_PLANNER_FUSE_OPS : 0);
+  if (tflm_c_create_with_planner(data.data(), arena, sizeof(arena), planner, &hdl) != kTfLiteOk)
+    return false;
+  res->used = tflm_c_arena_used_bytes(hdl);
+  struct tflm_c_tensor_info info;
+  bool ok = true;
+  std::vector<double> t;
+  for (int i = 0; i < runs && ok; i++) {
+    /* the input buffers can be re-used by the plan, filled before each run */
+    srand(1);
+    for (int k = 0; k < tflm_c_inputs_size(hdl); k++) {
+      tflm_c_input(hdl, k, &info);
+      for (size_t j = 0; j < info.bytes; j++)
+        ((uint8_t*)info.data)[j] = (uint8_t)rand();
+    }
+    double t0 = tflm_host::now_us();
+    ok = tflm_c_invoke(hdl) == kTfLiteOk;
+    t.push_back(tflm_host::now_us() - t0);
+  }
+  std::sort(t.begin(), t.end());
+  res->us = t[t.size() / 2];
+  res->outputs.clear();
+  for (int i = 0; i < tflm_c_outputs_size(hdl) && ok; i++) {
+    tflm_c_output(hdl, i, &info);
+    res->outputs.insert(res->outputs.end(), (uint8_t*)info.data, (uint8_t*)info.data + info.bytes);
+  }
+  tflm_c_destroy(hdl);
+  return ok;
+}
+
+int bench(const std::string& name, const std::vector<uint8_t>& data, int runs)
+{
+  Result ref, fused;
+  if (data.empty() || !record(data, false, &ref) || !record(data, true, &fused) ||
+      !run(data, false, runs, &ref) || !run(data, true, runs, &fused)) {
+    fprintf(stderr, "E: unable to run %s\n", name.c_str());
+    return 1;
+  }
+  const bool same = fused.outputs == ref.outputs;
+  const bool smaller = fused.used <= ref.used;
+
+  printf("%s\n", name.c_str());
+  printf("  buffers          : %d -> %d\n", ref.buffers, fused.buffers);
+  printf("  plan             : %d -> %d bytes (%+.1f%%)\n", (int)ref.plan, (int)fused.plan,
+      ref.plan ? 100.0 * ((double)fused.plan - ref.plan) / ref.plan : 0.0);
+  printf("  arena used       : %d -> %d bytes (host)%s\n", (int)ref.used, (int)fused.used,
+      smaller ? "" : " FAILED");
+  printf("  invoke (median)  : %.2f -> %.2f us (%+.1f%%)\n", ref.us, fused.us,
+      100.0 * (fused.us - ref.us) / ref.us);
+  printf("  outputs          : %s\n", same ? "identical" : "FAILED, differ");
+  return (same && smaller) ? 0 : 1;
+}
+
+/* SAME padded conv, RELU operator then 2x2 pooling */
+std::vector<uint8_t> generate_conv_relu_pool()
+{
+  tflm_host::ModelBuilder b;
+  srand(6);
+  int32_t x = b.input({1, 28, 28, 1}, 1.0f / 255.0f, -128);
+  x = b.max_pool(b.relu(b.conv(x, 16, 1, 0.05f, -10, true)), 2, 2);
+  x = b.dense(b.reshape(x, {1, 14 * 14 * 16}), 10, false, 0.17f, 29);
+  b.softmax(x);
+  return b.pack();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 100;
+  bool generated = false;
+  std::vector<const char*> paths;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-g"))
+      generated = true;
+    else if (argv[i][0] != '-')
+      paths.push_back(argv[i]);
+    else {
+      paths.clear();
+      generated = false;
+      break;
+    }
+  }
+  if (paths.empty() && !generated) {
+    fprintf(stderr, "usage: %s [-n runs] [-g] [<model.tflite> ..]\n", argv[0]);
+    return 2;
+  }
+
+  int res = 0;
+  for (const char* path : paths)
+    res |= bench(path, tflm_host::load_file(path), runs);
+  for (int v = 0; v < 5 && generated; v++) {
+    std::vector<uint8_t> data = tflm_host::generate_mnist_model(v);
+    if (!data.empty())
+      res |= bench("selected_model " + std::to_string(v) + " (generated)", data, runs);
+  }
+  if (generated)
+    res |= bench("conv SAME + RELU + max pool (generated)", generate_conv_relu_pool(), runs);
+  return res;
+}
@@ -0,0 +1,309 @@
+/**
+ ******************************************************************************
+ * @file    tflm_gen_resolver.cc
+ * @brief   Host generator of the model specific TFLM op resolver
+ ******************************************************************************
+ *
+ * usage: tflm_gen_resolver <model.tflite> <ops.h> <kernels.cmake>
+ *
+ * The operator codes of the model are mapped on the registration methods of
+ * the MicroMutableOpResolver and on the kernel sources which implement them.
+ * Two files are generated:
+ *
+ * - <ops.h> (tflm_network_ops.h): TFLM_NETWORK_OPS_COUNT and the
+ *   TFLM_NETWORK_OPS(X) list, X(Conv2D) standing for AddConv2D(). Used by
+ *   tflm_c.cc to build a MicroMutableOpResolver<TFLM_NETWORK_OPS_COUNT>.
+ * - <kernels.cmake> (tflm_network_kernels.cmake): tflm_network_kernels_SRCS,
+ *   the kernel sources and CMSIS-NN function groups (see
+ *   cmake/tflm_kernels.cmake) used by the model.
+ *
+ * The generation fails if the model uses an operator without TFLM kernel
+ * (ex. MAX_POOL_3D, CONV_3D), the model can not be deployed as-is.
+ */
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+#include "tflm_host_utils.h"
+
+namespace {
+
+/*
+ * kernels: sources of ${TFLM_KERNELS_PATH}, dependencies included
+ * cmsis:   CMSIS-NN function groups (cmsis_nn_<group>_SRCS)
+ */
+struct OpDesc {
+  tflite::BuiltinOperator op;
+  const char* custom;
+  const char* method;
+  const char* kernels;
+  const char* cmsis;
+};
+
+#define BUILTIN(op, method, kernels, cmsis) \
+  {tflite::BuiltinOperator_##op, nullptr, #method, kernels, cmsis}
+#define CUSTOM(name, method, kernels, cmsis) \
+  {tflite::BuiltinOperator_CUSTOM, name, #method, kernels, cmsis}
+
+const OpDesc kOps[] = {
+  BUILTIN(ABS, Abs, "elementwise.cc", ""),
+  BUILTIN(ADD, Add, "cmsis_nn/add.cc add_common.cc", "BasicMathFunctions"),
+  BUILTIN(ADD_N, AddN, "add_n.cc", ""),
+  BUILTIN(ARG_MAX, ArgMax, "arg_min_max.cc", ""),
+  BUILTIN(ARG_MIN, ArgMin, "arg_min_max.cc", ""),
+  BUILTIN(ASSIGN_VARIABLE, AssignVariable, "assign_variable.cc", ""),
+  BUILTIN(AVERAGE_POOL_2D, AveragePool2D, "cmsis_nn/pooling.cc pooling_common.cc",
+      "PoolingFunctions"),
+  BUILTIN(BATCH_TO_SPACE_ND, BatchToSpaceNd, "batch_to_space_nd.cc", ""),
+  BUILTIN(BROADCAST_ARGS, BroadcastArgs, "broadcast_args.cc", ""),
+  BUILTIN(BROADCAST_TO, BroadcastTo, "broadcast_to.cc", ""),
+  BUILTIN(CALL_ONCE, CallOnce, "call_once.cc", ""),
+  BUILTIN(CAST, Cast, "cast.cc", ""),
+  BUILTIN(CEIL, Ceil, "ceil.cc", ""),
+  BUILTIN(CONCATENATION, Concatenation, "concatenation.cc", ""),
+  BUILTIN(CONV_2D, Conv2D, "cmsis_nn/conv.cc conv_common.cc weight_compression.cc",
+      "ConvolutionFunctions"),
+  BUILTIN(COS, Cos, "elementwise.cc", ""),
+  BUILTIN(CUMSUM, CumSum, "cumsum.cc", ""),
+  BUILTIN(DEPTH_TO_SPACE, DepthToSpace, "depth_to_space.cc", ""),
+  BUILTIN(DEPTHWISE_CONV_2D, DepthwiseConv2D,
+      "cmsis_nn/depthwise_conv.cc depthwise_conv_common.cc conv_common.cc",
+      "ConvolutionFunctions"),
+  BUILTIN(DEQUANTIZE, Dequantize, "dequantize.cc dequantize_common.cc", ""),
+  BUILTIN(DIV, Div, "div.cc", ""),
+  BUILTIN(ELU, Elu, "elu.cc", ""),
+  BUILTIN(EQUAL, Equal, "comparisons.cc", ""),
+  BUILTIN(EXP, Exp, "exp.cc", ""),
+  BUILTIN(EXPAND_DIMS, ExpandDims, "expand_dims.cc", ""),
+  BUILTIN(FILL, Fill, "fill.cc", ""),
+  BUILTIN(FLOOR, Floor, "floor.cc", ""),
+  BUILTIN(FLOOR_DIV, FloorDiv, "floor_div.cc", ""),
+  BUILTIN(FLOOR_MOD, FloorMod, "floor_mod.cc", ""),
+  BUILTIN(FULLY_CONNECTED, FullyConnected,
+      "cmsis_nn/fully_connected.cc fully_connected_common.cc weight_compression.cc",
+      "FullyConnectedFunctions ConvolutionFunctions"),
+  BUILTIN(GATHER, Gather, "gather.cc", ""),
+  BUILTIN(GATHER_ND, GatherNd, "gather_nd.cc", ""),
+  BUILTIN(GREATER, Greater, "comparisons.cc", ""),
+  BUILTIN(GREATER_EQUAL, GreaterEqual, "comparisons.cc", ""),
+  BUILTIN(HARD_SWISH, HardSwish, "hard_swish.cc hard_swish_common.cc", ""),
+  BUILTIN(IF, If, "if.cc", ""),
+  BUILTIN(L2_NORMALIZATION, L2Normalization, "l2norm.cc", ""),
+  BUILTIN(L2_POOL_2D, L2Pool2D, "l2_pool_2d.cc", ""),
+  BUILTIN(LEAKY_RELU, LeakyRelu, "leaky_relu.cc leaky_relu_common.cc", ""),
+  BUILTIN(LESS, Less, "comparisons.cc", ""),
+  BUILTIN(LESS_EQUAL, LessEqual, "comparisons.cc", ""),
+  BUILTIN(LOG, Log, "elementwise.cc", ""),
+  BUILTIN(LOG_SOFTMAX, LogSoftmax, "log_softmax.cc", ""),
+  BUILTIN(LOGICAL_AND, LogicalAnd, "logical.cc logical_common.cc", ""),
+  BUILTIN(LOGICAL_NOT, LogicalNot, "elementwise.cc", ""),
+  BUILTIN(LOGICAL_OR, LogicalOr, "logical.cc logical_common.cc", ""),
+  BUILTIN(LOGISTIC, Logistic, "logistic.cc logistic_common.cc", ""),
+  BUILTIN(MAX_POOL_2D, MaxPool2D, "cmsis_nn/pooling.cc pooling_common.cc", "PoolingFunctions"),
+  BUILTIN(MAXIMUM, Maximum, "maximum_minimum.cc", ""),
+  BUILTIN(MEAN, Mean, "reduce.cc reduce_common.cc", ""),
+  BUILTIN(MINIMUM, Minimum, "maximum_minimum.cc", ""),
+  BUILTIN(MIRROR_PAD, MirrorPad, "mirror_pad.cc", ""),
+  BUILTIN(MUL, Mul, "cmsis_nn/mul.cc mul_common.cc", "BasicMathFunctions"),
+  BUILTIN(NEG, Neg, "neg.cc", ""),
+  BUILTIN(NOT_EQUAL, NotEqual, "comparisons.cc", ""),
+  BUILTIN(PACK, Pack, "pack.cc", ""),
+  BUILTIN(PAD, Pad, "pad.cc", ""),
+  BUILTIN(PADV2, PadV2, "pad.cc", ""),
+  BUILTIN(PRELU, Prelu, "prelu.cc prelu_common.cc", ""),
+  BUILTIN(QUANTIZE, Quantize, "quantize.cc quantize_common.cc", ""),
+  BUILTIN(READ_VARIABLE, ReadVariable, "read_variable.cc", ""),
+  BUILTIN(REDUCE_MAX, ReduceMax, "reduce.cc reduce_common.cc", ""),
+  BUILTIN(RELU, Relu, "activations.cc activations_common.cc", ""),
+  BUILTIN(RELU6, Relu6, "activations.cc activations_common.cc", ""),
+  BUILTIN(RESHAPE, Reshape, "reshape.cc", ""),
+  BUILTIN(RESIZE_BILINEAR, ResizeBilinear, "resize_bilinear.cc", ""),
+  BUILTIN(RESIZE_NEAREST_NEIGHBOR, ResizeNearestNeighbor, "resize_nearest_neighbor.cc", ""),
+  BUILTIN(ROUND, Round, "round.cc", ""),
+  BUILTIN(RSQRT, Rsqrt, "elementwise.cc", ""),
+  BUILTIN(SELECT_V2, SelectV2, "select.cc", ""),
+  BUILTIN(SHAPE, Shape, "shape.cc", ""),
+  BUILTIN(SIN, Sin, "elementwise.cc", ""),
+  BUILTIN(SLICE, Slice, "slice.cc", ""),
+  BUILTIN(SOFTMAX, Softmax, "cmsis_nn/softmax.cc softmax_common.cc", "SoftmaxFunctions"),
+  BUILTIN(SPACE_TO_BATCH_ND, SpaceToBatchNd, "space_to_batch_nd.cc", ""),
+  BUILTIN(SPACE_TO_DEPTH, SpaceToDepth, "space_to_depth.cc", ""),
+  BUILTIN(SPLIT, Split, "split.cc", ""),
+  BUILTIN(SPLIT_V, SplitV, "split_v.cc", ""),
+  BUILTIN(SQRT, Sqrt, "elementwise.cc", ""),
+  BUILTIN(SQUARE, Square, "elementwise.cc", ""),
+  BUILTIN(SQUARED_DIFFERENCE, SquaredDifference, "squared_difference.cc", ""),
+  BUILTIN(SQUEEZE, Squeeze, "squeeze.cc", ""),
+  BUILTIN(STRIDED_SLICE, StridedSlice, "strided_slice.cc", ""),
+  BUILTIN(SUB, Sub, "sub.cc sub_common.cc", ""),
+  BUILTIN(SUM, Sum, "reduce.cc reduce_common.cc", ""),
+  BUILTIN(SVDF, Svdf, "cmsis_nn/svdf.cc svdf_common.cc", "SVDFunctions"),
+  BUILTIN(TANH, Tanh, "tanh.cc", ""),
+  BUILTIN(TRANSPOSE, Transpose, "transpose.cc", ""),
+  BUILTIN(TRANSPOSE_CONV, TransposeConv, "transpose_conv.cc", ""),
+  BUILTIN(UNIDIRECTIONAL_SEQUENCE_LSTM, UnidirectionalSequenceLSTM,
+      "cmsis_nn/unidirectional_sequence_lstm.cc lstm_eval.cc lstm_eval_common.cc "
+      "fully_connected_common.cc micro_tensor_utils.cc",
+      "LSTMFunctions"),
+  BUILTIN(UNPACK, Unpack, "unpack.cc", ""),
+  BUILTIN(VAR_HANDLE, VarHandle, "var_handle.cc", ""),
+  BUILTIN(WHILE, While, "while.cc", ""),
+  BUILTIN(ZEROS_LIKE, ZerosLike, "zeros_like.cc", ""),
+  CUSTOM("BLOCK_SPARSE_FULLY_CONNECTED", BlockSparseFullyConnected,
+      "cmsis_nn/block_sparse_fully_connected.cc", "FullyConnectedFunctions"),
+  CUSTOM("CIRCULAR_BUFFER", CircularBuffer, "circular_buffer.cc circular_buffer_common.cc", ""),
+  CUSTOM("TFLite_Detection_PostProcess", DetectionPostprocess, "detection_postprocess.cc", ""),
+};
+
+/* always linked: kernel helpers and CMSIS-NN support functions */
+const char kBaseKernels[] = "kernel_util.cc";
+const char kBaseCmsis[] = "NNSupportFunctions ActivationFunctions BasicMathFunctions";
+
+const OpDesc* find_op(const tflite::OperatorCode* code)
+{
+  const tflite::BuiltinOperator op = tflite::GetBuiltinCode(code);
+  for (const OpDesc& desc : kOps) {
+    if (desc.op != op)
+      continue;
+    if (op != tflite::BuiltinOperator_CUSTOM)
+      return &desc;
+    if (code->custom_code() && !strcmp(code->custom_code()->c_str(), desc.custom))
+      return &desc;
+  }
+  return nullptr;
+}
+
+void append_unique(std::vector<std::string>* list, const char* words)
+{
+  std::string w;
+  for (const char* p = words;; p++) {
+    if (*p && *p != ' ') {
+      w += *p;
+      continue;
+    }
+    bool found = false;
+    for (const std::string& s : *list)
+      found |= s == w;
+    if (!w.empty() && !found)
+      list->push_back(w);
+    w.clear();
+    if (!*p)
+      break;
+  }
+}
+
+const char* base_name(const char* path)
+{
+  const char* p = strrchr(path, '/');
+  return p ? p + 1 : path;
+}
+
+bool write_header(const char* path, const char* model, const std::vector<const OpDesc*>& ops)
+{
+  std::string s;
+  s += "/**\n";
+  s += " ******************************************************************************\n";
+  s += " * @file    tflm_network_ops.h\n";
+  s += " * @brief   Operators of the embedded model (MicroMutableOpResolver)\n";
+  s += " ******************************************************************************\n";
+  s += " *\n";
+  s += " * Generated by ml_model/tools/tflm_gen_resolver from " + std::string(model) + "\n";
+  s += " * Do not edit.\n";
+  s += " */\n\n";
+  s += "#ifndef __TFLM_NETWORK_OPS_H__\n";
+  s += "#define __TFLM_NETWORK_OPS_H__\n\n";
+  s += "#define TFLM_NETWORK_OPS_COUNT " + std::to_string(ops.size()) + "\n\n";
+  s += "/* X(op) is expanded for each MicroMutableOpResolver::Add<op>() method */\n";
+  s += "#define TFLM_NETWORK_OPS(X) \\\n";
+  for (const OpDesc* op : ops)
+    s += "  X(" + std::string(op->method) + ") \\\n";
+  s += "\n#endif /* __TFLM_NETWORK_OPS_H__ */\n";
+  return tflm_host::save_file(path, (const uint8_t*)s.data(), s.size());
+}
+
+bool write_cmake(const char* path, const char* model, const std::vector<const OpDesc*>& ops)
+{
+  std::vector<std::string> kernels, groups;
+  append_unique(&kernels, kBaseKernels);
+  append_unique(&groups, kBaseCmsis);
+  for (const OpDesc* op : ops) {
+    append_unique(&kernels, op->kernels);
+    append_unique(&groups, op->cmsis);
+  }
+
+  std::string s;
+  s += "#\n";
+  s += "# Kernels of the embedded model (TFLM_RUNTIME_USE_ALL_OPERATORS=OFF)\n";
+  s += "#\n";
+  s += "# Generated by ml_model/tools/tflm_gen_resolver from " + std::string(model) + "\n";
+  s += "# Do not edit.\n";
+  s += "#\n\n";
+  s += "set(tflm_network_kernels_SRCS\n";
+  for (const std::string& k : kernels)
+    s += "    ${TFLM_KERNELS_PATH}/" + k + "\n";
+  for (const std::string& g : groups)
+    s += "    ${cmsis_nn_" + g + "_SRCS}\n";
+  s += ")\n";
+  return tflm_host::save_file(path, (const uint8_t*)s.data(), s.size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc != 4) {
+    fprintf(stderr, "usage: %s <model.tflite> <ops.h> <kernels.cmake>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(argv[1]);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", argv[1]);
+    return 1;
+  }
+  flatbuffers::Verifier verifier(data.data(), data.size());
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    fprintf(stderr, "E: %s is not a valid TFLite model\n", argv[1]);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(data.data());
+
+  /* one registration per method, in the order of the operator codes */
+  std::vector<const OpDesc*> ops;
+  int n_unsupported = 0;
+  for (const tflite::OperatorCode* code : *model->operator_codes()) {
+    const OpDesc* desc = find_op(code);
+    if (!desc) {
+      const tflite::BuiltinOperator op = tflite::GetBuiltinCode(code);
+      fprintf(stderr, "E: operator not supported by TFLM: %s\n",
+          op == tflite::BuiltinOperator_CUSTOM && code->custom_code()
+              ? code->custom_code()->c_str() : tflite::EnumNameBuiltinOperator(op));
+      n_unsupported++;
+      continue;
+    }
+    bool found = false;
+    for (const OpDesc* op : ops)
+      found |= !strcmp(op->method, desc->method);
+    if (!found)
+      ops.push_back(desc);
+  }
+  if (n_unsupported)
+    return 1;
+
+  const char* model_name = base_name(argv[1]);
+  if (!write_header(argv[2], model_name, ops) || !write_cmake(argv[3], model_name, ops)) {
+    fprintf(stderr, "E: unable to write the output files\n");
+    return 1;
+  }
+
+  printf("model              : %s\n", argv[1]);
+  printf("operators          : %d\n", (int)ops.size());
+  for (const OpDesc* op : ops)
+    printf("  Add%s()\n", op->method);
+  return 0;
+}
@@ -0,0 +1,15 @@
+/**
+ ******************************************************************************
+ * @file    tflm_host_io.c
+ * @brief   Host implementation of the tflm_io_write() log callback
+ ******************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* see app_x-cube-ai.c for the target implementation */
+int tflm_io_write(const void *buff, uint16_t count)
+{
+  return (int)fwrite(buff, 1, count, stderr);
+}
@@ -0,0 +1,136 @@
+/**
+ ******************************************************************************
+ * @file    tflm_host_utils.h
+ * @brief   Common helpers for the host TFLM tools
+ ******************************************************************************
+ */
+
+#ifndef __TFLM_HOST_UTILS_H__
+#define __TFLM_HOST_UTILS_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+
+namespace tflm_host {
+
+/* Host arena: larger than the target one, persistent structures are
+ * bigger with 64-bit pointers.
+ */
+constexpr size_t kHostArenaSize = 512 * 1024;
+
+/* Alignment of the buffers in the arena, see MicroArenaBufferAlignment() */
+constexpr int kArenaAlignment = 16;
+
+/* Returns the content of a file, an empty vector if it can not be read */
+inline std::vector<uint8_t> load_file(const char* path)
+{
+  std::vector<uint8_t> data;
+  FILE* f = fopen(path, "rb");
+  if (!f)
+    return data;
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (size > 0) {
+    data.resize((size_t)size);
+    if (fread(data.data(), 1, data.size(), f) != data.size())
+      data.clear();
+  }
+  fclose(f);
+  return data;
+}
+
+inline bool save_file(const char* path, const uint8_t* data, size_t size)
+{
+  FILE* f = fopen(path, "wb");
+  if (!f)
+    return false;
+  bool ok = fwrite(data, 1, size, f) == size;
+  return (fclose(f) == 0) && ok;
+}
+
+/* Buffer requirement as provided by the MicroAllocator to the memory planner */
+struct BufferRequirement {
+  int size;
+  int first;
+  int last;
+  int offline_offset;
+};
+
+/*
+ * Memory planner wrapping a GreedyMemoryPlanner, the requirements of all
+ * buffers (tensors and scratch buffers, in the AddBuffer() order) are recorded.
+ */
+class RecordingMemoryPlanner : public tflite::MicroMemoryPlanner {
+public:
+  TfLiteStatus Init(unsigned char* scratch_buffer, int scratch_buffer_size) override {
+    requirements.clear();
+    return planner_.Init(scratch_buffer, scratch_buffer_size);
+  }
+
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used) override {
+    requirements.push_back({size, first_time_used, last_time_used, tflite::kOnlinePlannedBuffer});
+    return planner_.AddBuffer(size, first_time_used, last_time_used);
+  }
+
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
+      int offline_offset) override {
+    requirements.push_back({size, first_time_used, last_time_used, offline_offset});
+    return planner_.AddBuffer(size, first_time_used, last_time_used, offline_offset);
+  }
+
+  size_t GetMaximumMemorySize() override { return planner_.GetMaximumMemorySize(); }
+
+  int GetBufferCount() override { return planner_.GetBufferCount(); }
+
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override {
+    return planner_.GetOffsetForBuffer(buffer_index, offset);
+  }
+
+  std::vector<BufferRequirement> requirements;
+
+private:
+  tflite::GreedyMemoryPlanner planner_;
+};
+
+/* Monotonic time in us */
+inline double now_us()
+{
+  using namespace std::chrono;
+  return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+/* random strokes (2 to 4 segments, 2 pixels wide) at the maximum value on a
+ * background at the minimum one, H x W x C input */
+inline void draw_strokes(const std::vector<int>& shape, std::vector<int8_t>* image)
+{
+  const int h = shape.size() == 4 ? shape[1] : 1;
+  const int w = shape.size() == 4 ? shape[2] : (int)image->size();
+  const int c = shape.size() == 4 ? shape[3] : 1;
+  std::fill(image->begin(), image->end(), (int8_t)-128);
+  const int n = 2 + rand() % 3;
+  for (int s = 0; s < n; s++) {
+    const float y0 = (float)(rand() % h), x0 = (float)(rand() % w);
+    const float y1 = (float)(rand() % h), x1 = (float)(rand() % w);
+    for (int k = 0; k <= 32; k++) {
+      const int y = (int)(y0 + (y1 - y0) * k / 32.0f);
+      const int x = (int)(x0 + (x1 - x0) * k / 32.0f);
+      for (int dy = 0; dy < 2 && y + dy < h; dy++)
+        for (int dx = 0; dx < 2 && x + dx < w; dx++)
+          for (int ch = 0; ch < c; ch++)
+            (*image)[((y + dy) * w + x + dx) * c + ch] = 127;
+    }
+  }
+}
+
+}  // namespace tflm_host
+
+#endif /* __TFLM_HOST_UTILS_H__ */
@@ -0,0 +1,228 @@
+/**
+ ******************************************************************************
+ * @file    tflm_int4_bench.cc
+ * @brief   Host check and timing of the CMSIS-NN kernels with int4 weights
+ ******************************************************************************
+ *
+ * usage: tflm_int4_bench [-n runs]
+ *
+ * The CMSIS-NN FULLY_CONNECTED and CONV_2D operators run the int4 filters
+ * (TensorType_INT4, two values per byte) packed: arm_fully_connected_s4()
+ * and arm_convolve_s4() unpack the nibbles in registers instead of copying
+ * the filter to an int8 scratch buffer at each Eval. For a set of shapes
+ * (MNIST layers, odd accumulation depths, so that rows start on a high
+ * nibble, padding, stride, dilation, batches), random int4 filters are run
+ * packed by the s4 kernels and unpacked by arm_fully_connected_s8() and
+ * arm_convolve_s8(): the outputs must be identical, and the median durations
+ * are reported.
+ *
+ * The tool is built three times: tflm_int4_bench with the x86 SIMD inner
+ * loops of the host library, tflm_int4_bench_scalar with the portable C path,
+ * tflm_int4_bench_dsp with the DSP path of the kernels (ARM_MATH_DSP,
+ * intrinsics emulated by tflm_dsp_emulation.h: the durations do not
+ * represent the Cortex-M33 ones).
+ *
+ * Exit code 1 if an output differs.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Include/arm_nnfunctions.h"
+#include "Include/arm_nnsupportfunctions.h"
+
+#include "tflm_host_utils.h"
+
+namespace {
+
+struct FcCase {
+  const char* name;
+  int batches, cols, rows;
+};
+
+const FcCase kFcCases[] = {
+  {"MNIST dense 4732 -> 10", 1, 4732, 10},
+  {"784 -> 128", 1, 784, 128},
+  {"odd depth 37 -> 5", 3, 37, 5},
+  {"odd depth 9 -> 16", 1, 9, 16},
+  {"256 -> 33, 2 batches", 2, 256, 33},
+};
+
+struct ConvCase {
+  const char* name;
+  int n, h, w, c_in;
+  int kh, kw, c_out;
+  int stride, pad, dilation;
+};
+
+const ConvCase kConvCases[] = {
+  {"MNIST conv 28x28x1, 3x3x28", 1, 28, 28, 1, 3, 3, 28, 1, 0, 1},
+  {"14x14x8, 3x3x16, pad 1", 1, 14, 14, 8, 3, 3, 16, 1, 1, 1},
+  {"15x15x3, 3x3x15, stride 2", 1, 15, 15, 3, 3, 3, 15, 2, 0, 1},
+  {"12x12x6, 5x5x9, pad 2", 1, 12, 12, 6, 5, 5, 9, 1, 2, 1},
+  {"16x16x4, 3x3x8, dilation 2", 1, 16, 16, 4, 3, 3, 8, 1, 2, 2},
+  {"2 x 9x9x5, 3x3x7", 2, 9, 9, 5, 3, 3, 7, 1, 1, 1},
+};
+
+/* random int4 values stored one per byte, and packed as TensorType_INT4 */
+void random_int4(size_t n, std::vector<int8_t>* unpacked, std::vector<int8_t>* packed)
+{
+  unpacked->resize(n);
+  packed->assign((n + 1) / 2, 0);
+  for (size_t i = 0; i < n; i++) {
+    (*unpacked)[i] = (int8_t)(rand() % 16 - 8);
+    (*packed)[i / 2] |= (int8_t)(((*unpacked)[i] & 0x0F) << ((i & 1) * 4));
+  }
+}
+
+/* median duration (us) of n calls, status of the last one */
+template <typename F>
+double median_us(int runs, F call, arm_cmsis_nn_status* status)
+{
+  std::vector<double> t;
+  for (int i = 0; i < runs; i++) {
+    const double t0 = tflm_host::now_us();
+    *status = call();
+    t.push_back(tflm_host::now_us() - t0);
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+bool check(const char* name, double t_s8, double t_s4, bool ok)
+{
+  printf("  %-28s : %8.2f us s8 -> %8.2f us s4 (%+.1f%%)%s\n", name, t_s8, t_s4,
+      100.0 * (t_s4 - t_s8) / t_s8, ok ? "" : " FAILED");
+  return ok;
+}
+
+bool run_fc(const FcCase& c, int runs)
+{
+  cmsis_nn_fc_params params;
+  params.input_offset = 1 + rand() % 127;
+  params.filter_offset = 0;
+  params.output_offset = -(rand() % 128);
+  params.activation.min = -128;
+  params.activation.max = 127;
+  cmsis_nn_per_tensor_quant_params quant = {(1 << 30) + rand() % (1 << 30), -(5 + rand() % 4)};
+
+  const cmsis_nn_dims input_dims = {c.batches, 1, 1, c.cols};
+  const cmsis_nn_dims filter_dims = {c.cols, 1, 1, c.rows};
+  const cmsis_nn_dims bias_dims = {1, 1, 1, c.rows};
+  const cmsis_nn_dims output_dims = {c.batches, 1, 1, c.rows};
+
+  std::vector<int8_t> input(c.batches * c.cols), filter, packed;
+  for (auto& v : input)
+    v = (int8_t)rand();
+  random_int4((size_t)c.cols * c.rows, &filter, &packed);
+  std::vector<int32_t> bias(c.rows);
+  for (auto& v : bias)
+    v = rand() % 20001 - 10000;
+
+  std::vector<int16_t> buf_s8(arm_fully_connected_s8_get_buffer_size(&filter_dims) / 2 + 1);
+  std::vector<int16_t> buf_s4(arm_fully_connected_s4_get_buffer_size(&filter_dims) / 2 + 1);
+  cmsis_nn_context ctx_s8 = {buf_s8.data(), (int32_t)(buf_s8.size() * sizeof(int16_t))};
+  cmsis_nn_context ctx_s4 = {buf_s4.data(), (int32_t)(buf_s4.size() * sizeof(int16_t))};
+  std::vector<int8_t> out_s8(c.batches * c.rows), out_s4(c.batches * c.rows, 0);
+
+  arm_cmsis_nn_status st_s8 = ARM_CMSIS_NN_ARG_ERROR;
+  arm_cmsis_nn_status st_s4 = ARM_CMSIS_NN_ARG_ERROR;
+  const double t_s8 = median_us(runs, [&] {
+    return arm_fully_connected_s8(&ctx_s8, &params, &quant, &input_dims, input.data(), &filter_dims,
+        filter.data(), &bias_dims, bias.data(), &output_dims, out_s8.data());
+  }, &st_s8);
+  const double t_s4 = median_us(runs, [&] {
+    return arm_fully_connected_s4(&ctx_s4, &params, &quant, &input_dims, input.data(), &filter_dims,
+        packed.data(), &bias_dims, bias.data(), &output_dims, out_s4.data());
+  }, &st_s4);
+  return check(c.name, t_s8, t_s4,
+      st_s8 == ARM_CMSIS_NN_SUCCESS && st_s4 == ARM_CMSIS_NN_SUCCESS && out_s8 == out_s4);
+}
+
+bool run_conv(const ConvCase& c, int runs)
+{
+  cmsis_nn_conv_params params;
+  params.input_offset = 1 + rand() % 127;
+  params.output_offset = -(rand() % 128);
+  params.stride.h = params.stride.w = c.stride;
+  params.padding.h = params.padding.w = c.pad;
+  params.dilation.h = params.dilation.w = c.dilation;
+  params.activation.min = -128;
+  params.activation.max = 127;
+
+  const int eff_k = (c.kh - 1) * c.dilation + 1;
+  const cmsis_nn_dims input_dims = {c.n, c.h, c.w, c.c_in};
+  const cmsis_nn_dims filter_dims = {c.c_out, c.kh, c.kw, c.c_in};
+  const cmsis_nn_dims bias_dims = {1, 1, 1, c.c_out};
+  const cmsis_nn_dims output_dims = {c.n, (c.h + 2 * c.pad - eff_k) / c.stride + 1,
+      (c.w + 2 * c.pad - eff_k) / c.stride + 1, c.c_out};
+
+  std::vector<int8_t> input(c.n * c.h * c.w * c.c_in), filter, packed;
+  for (auto& v : input)
+    v = (int8_t)rand();
+  random_int4((size_t)c.c_out * c.kh * c.kw * c.c_in, &filter, &packed);
+  std::vector<int32_t> bias(c.c_out), multiplier(c.c_out), shift(c.c_out);
+  for (int i = 0; i < c.c_out; i++) {
+    bias[i] = rand() % 20001 - 10000;
+    multiplier[i] = (1 << 30) + rand() % (1 << 30);
+    shift[i] = -(5 + rand() % 4);
+  }
+  cmsis_nn_per_channel_quant_params quant = {multiplier.data(), shift.data()};
+
+  std::vector<int16_t> buf_s8(arm_convolve_s8_get_buffer_size(&input_dims, &filter_dims) / 2 + 1);
+  std::vector<int16_t> buf_s4(arm_convolve_s4_get_buffer_size(&input_dims, &filter_dims) / 2 + 1);
+  cmsis_nn_context ctx_s8 = {buf_s8.data(), (int32_t)(buf_s8.size() * sizeof(int16_t))};
+  cmsis_nn_context ctx_s4 = {buf_s4.data(), (int32_t)(buf_s4.size() * sizeof(int16_t))};
+  const size_t out_size = output_dims.n * output_dims.h * output_dims.w * output_dims.c;
+  std::vector<int8_t> out_s8(out_size), out_s4(out_size, 0);
+
+  arm_cmsis_nn_status st_s8 = ARM_CMSIS_NN_ARG_ERROR;
+  arm_cmsis_nn_status st_s4 = ARM_CMSIS_NN_ARG_ERROR;
+  const double t_s8 = median_us(runs, [&] {
+    return arm_convolve_s8(&ctx_s8, &params, &quant, &input_dims, input.data(), &filter_dims,
+        filter.data(), &bias_dims, bias.data(), &output_dims, out_s8.data());
+  }, &st_s8);
+  const double t_s4 = median_us(runs, [&] {
+    return arm_convolve_s4(&ctx_s4, &params, &quant, &input_dims, input.data(), &filter_dims,
+        packed.data(), &bias_dims, bias.data(), &output_dims, out_s4.data());
+  }, &st_s4);
+  return check(c.name, t_s8, t_s4,
+      st_s8 == ARM_CMSIS_NN_SUCCESS && st_s4 == ARM_CMSIS_NN_SUCCESS && out_s8 == out_s4);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 200;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else {
+      fprintf(stderr, "usage: %s [-n runs]\n", argv[0]);
+      return 2;
+    }
+  }
+
+#if defined(ARM_MATH_DSP)
+  printf("DSP path (emulated intrinsics)\n");
+#elif defined(CMSIS_NN_HOST_SIMD)
+  printf("x86 SIMD inner loops\n");
+#else
+  printf("portable C path\n");
+#endif
+
+  int res = 0;
+  srand(1);
+  printf("fully connected (arm_fully_connected_s8 -> arm_fully_connected_s4)\n");
+  for (const FcCase& c : kFcCases)
+    res |= !run_fc(c, runs);
+  printf("conv (arm_convolve_s8 -> arm_convolve_s4)\n");
+  for (const ConvCase& c : kConvCases)
+    res |= !run_conv(c, runs);
+  return res;
+}
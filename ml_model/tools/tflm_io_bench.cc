@@ -0,0 +1,188 @@
+/**
+ ******************************************************************************
+ * @file    tflm_io_bench.cc
+ * @brief   Host benchmark of the zero-copy binding of the IO tensors
+ ******************************************************************************
+ *
+ * usage: tflm_io_bench [-n runs] [-s samples] <model.tflite>
+ *
+ * The samples are held in buffers owned by the application (as filled by a
+ * DMA). Two loops are compared over the same samples:
+ * - copy: sample copied in the input tensor, tflm_c_invoke(), output tensor
+ *   copied in the application buffer,
+ * - bound: input tensor bound to the sample (tflm_c_bind_input()) and output
+ *   tensor bound to the application buffer, tflm_c_invoke().
+ * The outputs must be identical (exit code 1 otherwise). Reports the median
+ * time per inference of each loop and of the copies alone.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+/* buffer owned by the application, aligned as requested by tflm_c_bind_x() */
+struct AppBuffer {
+  std::vector<uint8_t> storage;
+  uint8_t* data;
+
+  explicit AppBuffer(size_t size) : storage(size + tflm_host::kArenaAlignment) {
+    uintptr_t p = (uintptr_t)storage.data();
+    data = storage.data() + ((tflm_host::kArenaAlignment - p % tflm_host::kArenaAlignment)
+        % tflm_host::kArenaAlignment);
+  }
+};
+
+double median(std::vector<double>& v)
+{
+  std::sort(v.begin(), v.end());
+  return v[v.size() / 2];
+}
+
+/* checks of the binding API itself, 0 if ok */
+int check_binding(uint32_t hdl, AppBuffer& in)
+{
+  struct tflm_c_tensor_info info;
+  tflm_c_input(hdl, 0, &info);
+  void* planned = info.data;
+
+  if ((tflm_c_bind_input(hdl, 0, in.data + 1) == kTfLiteOk) ||
+      (tflm_c_bind_input(hdl, tflm_c_inputs_size(hdl), in.data) == kTfLiteOk) ||
+      (tflm_c_bind_output(hdl, -1, in.data) == kTfLiteOk)) {
+    fprintf(stderr, "E: invalid binding accepted\n");
+    return 1;
+  }
+  tflm_c_bind_input(hdl, 0, in.data);
+  tflm_c_input(hdl, 0, &info);
+  if (info.data != in.data) {
+    fprintf(stderr, "E: bound buffer not reported by tflm_c_input()\n");
+    return 1;
+  }
+  tflm_c_bind_input(hdl, 0, NULL);
+  tflm_c_input(hdl, 0, &info);
+  if (info.data != planned) {
+    fprintf(stderr, "E: planned location not restored\n");
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 200;
+  int n_samples = 8;
+  const char* path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      n_samples = atoi(argv[++i]);
+    else if (!path && argv[i][0] != '-')
+      path = argv[i];
+    else {
+      path = nullptr;
+      break;
+    }
+  }
+  if (!path || runs < 1 || n_samples < 1) {
+    fprintf(stderr, "usage: %s [-n runs] [-s samples] <model.tflite>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(path);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", path);
+    return 1;
+  }
+
+  uint32_t hdl;
+  if (tflm_c_create(data.data(), arena, sizeof(arena), &hdl) != kTfLiteOk) {
+    fprintf(stderr, "E: tflm_c_create() fails\n");
+    return 1;
+  }
+  if ((tflm_c_inputs_size(hdl) != 1) || (tflm_c_outputs_size(hdl) != 1)) {
+    fprintf(stderr, "E: single input/output models only\n");
+    return 1;
+  }
+
+  struct tflm_c_tensor_info in_info, out_info;
+  tflm_c_input(hdl, 0, &in_info);
+  tflm_c_output(hdl, 0, &out_info);
+
+  std::vector<AppBuffer> samples;
+  for (int s = 0; s < n_samples; s++) {
+    samples.emplace_back(in_info.bytes);
+    srand(s + 1);
+    for (uint32_t i = 0; i < in_info.bytes; i++)
+      samples.back().data[i] = (uint8_t)rand();
+  }
+  /* one aligned output slot per sample */
+  const size_t out_stride = (out_info.bytes + tflm_host::kArenaAlignment - 1)
+      & ~(size_t)(tflm_host::kArenaAlignment - 1);
+  AppBuffer out_copy(out_stride * n_samples);
+  AppBuffer out_bound(out_stride * n_samples);
+
+  if (check_binding(hdl, samples[0]))
+    return 1;
+
+  /* copy: as MX_X_CUBE_AI_Process() with a producer writing its own buffer */
+  std::vector<double> t_copy, t_memcpy;
+  for (int r = 0; r < runs; r++) {
+    double copy = 0;
+    double t0 = tflm_host::now_us();
+    for (int s = 0; s < n_samples; s++) {
+      double c0 = tflm_host::now_us();
+      memcpy(in_info.data, samples[s].data, in_info.bytes);
+      copy += tflm_host::now_us() - c0;
+      if (tflm_c_invoke(hdl) != kTfLiteOk) {
+        fprintf(stderr, "E: tflm_c_invoke() fails\n");
+        return 1;
+      }
+      c0 = tflm_host::now_us();
+      memcpy(out_copy.data + s * out_stride, out_info.data, out_info.bytes);
+      copy += tflm_host::now_us() - c0;
+    }
+    t_copy.push_back((tflm_host::now_us() - t0) / n_samples);
+    t_memcpy.push_back(copy / n_samples);
+  }
+
+  /* bound: the tensors point to the application buffers */
+  std::vector<double> t_bound;
+  for (int r = 0; r < runs; r++) {
+    double t0 = tflm_host::now_us();
+    for (int s = 0; s < n_samples; s++) {
+      if ((tflm_c_bind_input(hdl, 0, samples[s].data) != kTfLiteOk) ||
+          (tflm_c_bind_output(hdl, 0, out_bound.data + s * out_stride) != kTfLiteOk) ||
+          (tflm_c_invoke(hdl) != kTfLiteOk)) {
+        fprintf(stderr, "E: bound invoke fails\n");
+        return 1;
+      }
+    }
+    t_bound.push_back((tflm_host::now_us() - t0) / n_samples);
+  }
+
+  bool same = true;
+  for (int s = 0; s < n_samples; s++)
+    same &= memcmp(out_copy.data + s * out_stride, out_bound.data + s * out_stride,
+        out_info.bytes) == 0;
+  const double copy_us = median(t_copy);
+  const double bound_us = median(t_bound);
+
+  printf("model              : %s\n", path);
+  printf("io bytes           : %d in, %d out\n", (int)in_info.bytes, (int)out_info.bytes);
+  printf("inference (copy)   : %.2f us (copies %.3f us)\n", copy_us, median(t_memcpy));
+  printf("inference (bound)  : %.2f us (%+.2f us)\n", bound_us, bound_us - copy_us);
+  printf("outputs            : %s\n", same ? "identical" : "MISMATCH");
+  tflm_c_destroy(hdl);
+  return same ? 0 : 1;
+}
@@ -0,0 +1,345 @@
+/**
+ ******************************************************************************
+ * @file    tflm_kernel_diff.cc
+ * @brief   Differential test of the CMSIS-NN operators against the reference
+ ******************************************************************************
+ *
+ * usage: tflm_kernel_diff [-n runs] [-s seed] [-o op] [-v]
+ *
+ * For a sweep of single operator int8 models (CONV_2D, DEPTHWISE_CONV_2D,
+ * FULLY_CONNECTED, MAX_POOL_2D, AVERAGE_POOL_2D, SOFTMAX, ADD, MUL: shapes,
+ * kernel sizes, strides, paddings, dilations, depth multipliers, batches,
+ * broadcasts, fused activations, per channel weights quantization), the
+ * model is run with the CMSIS-NN operators of the runtime and with the TFLM
+ * reference int8 operators (tflm_reference_kernels.h), on the same random
+ * inputs. The outputs must be identical.
+ *
+ * Per configuration (-v) or per operator: the median invoke durations of the
+ * two implementations and the speed-up of CMSIS-NN. -o restricts the sweep
+ * to one operator (e.g. -o CONV_2D).
+ *
+ * Exit code 1 if an output differs or if a model cannot be run.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+#include "tflm_host_utils.h"
+#include "tflm_model_builder.h"
+#include "tflm_reference_kernels.h"
+
+namespace {
+
+using tflite::ActivationFunctionType;
+using tflite::BuiltinOperator;
+
+uint8_t arena[2][tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+constexpr int kInputSets = 4;  /* random inputs compared per configuration */
+
+struct Config {
+  BuiltinOperator op;
+  std::string name;
+  std::function<void(tflm_host::ModelBuilder&)> build;
+};
+
+const char* act_name(ActivationFunctionType act)
+{
+  return act == tflite::ActivationFunctionType_RELU ? " relu"
+      : act == tflite::ActivationFunctionType_RELU6 ? " relu6" : "";
+}
+
+ActivationFunctionType nth_act(int i)
+{
+  static const ActivationFunctionType acts[] = {tflite::ActivationFunctionType_NONE,
+      tflite::ActivationFunctionType_RELU, tflite::ActivationFunctionType_RELU6};
+  return acts[i % 3];
+}
+
+std::string shape_name(const std::vector<int32_t>& shape)
+{
+  std::string s;
+  for (int32_t d : shape)
+    s += (s.empty() ? "" : "x") + std::to_string(d);
+  return s;
+}
+
+/* random activation quantization */
+float rand_scale() { return 0.01f + 0.09f * (float)rand() / RAND_MAX; }
+int rand_zero_point() { return rand() % 41 - 20; }
+
+std::vector<Config> sweep()
+{
+  std::vector<Config> configs;
+  int i = 0;
+
+  const std::vector<std::vector<int32_t>> conv_inputs = {
+      {1, 10, 10, 3}, {1, 9, 9, 8}, {2, 7, 7, 16}, {1, 1, 32, 8}};
+  const int conv_kernels[][2] = {{1, 1}, {3, 3}, {5, 5}, {1, 3}};
+  for (const auto& in : conv_inputs)
+    for (const auto& k : conv_kernels)
+      for (int stride = 1; stride <= 2; stride++)
+        for (int dilation = 1; dilation <= 2; dilation++)
+          for (int same = 0; same <= 1; same++) {
+            const int kh = k[0], kw = k[1];
+            if ((kh == 1 && kw == 1 && dilation > 1) ||
+                (!same && ((kh - 1) * dilation >= in[1] || (kw - 1) * dilation >= in[2])) ||
+                (in[1] == 1 && kh > 1))
+              continue;
+            const int channels = i % 2 ? 7 : 16;
+            const ActivationFunctionType act = nth_act(i++);
+            configs.push_back({tflite::BuiltinOperator_CONV_2D,
+                shape_name(in) + " k" + std::to_string(kh) + "x" + std::to_string(kw) + " s" +
+                    std::to_string(stride) + " d" + std::to_string(dilation) +
+                    (same ? " same" : " valid") + act_name(act) + " -> " + std::to_string(channels),
+                [=](tflm_host::ModelBuilder& b) {
+                  const float scale = rand_scale();
+                  int32_t x = b.input(in, scale, rand_zero_point());
+                  const float out_scale = scale * 0.4f * sqrtf((float)(kh * kw * in[3]));
+                  b.output(b.conv2d(x, channels, kh, kw, stride, dilation, same, act, out_scale,
+                      rand_zero_point()));
+                }});
+          }
+
+  const std::vector<std::vector<int32_t>> dw_inputs = {
+      {1, 10, 10, 8}, {1, 9, 9, 7}, {1, 12, 12, 16}};
+  const int dw_kernels[] = {2, 3, 5};
+  for (const auto& in : dw_inputs)
+    for (int k : dw_kernels)
+      for (int multiplier = 1; multiplier <= 2; multiplier++)
+        for (int stride = 1; stride <= 2; stride++)
+          for (int dilation = 1; dilation <= 2; dilation++)
+            for (int same = 0; same <= 1; same++) {
+              const ActivationFunctionType act = nth_act(i++);
+              configs.push_back({tflite::BuiltinOperator_DEPTHWISE_CONV_2D,
+                  shape_name(in) + " k" + std::to_string(k) + "x" + std::to_string(k) + " m" +
+                      std::to_string(multiplier) + " s" + std::to_string(stride) + " d" +
+                      std::to_string(dilation) + (same ? " same" : " valid") + act_name(act),
+                  [=](tflm_host::ModelBuilder& b) {
+                    const float scale = rand_scale();
+                    int32_t x = b.input(in, scale, rand_zero_point());
+                    const float out_scale = scale * 0.4f * (float)k;
+                    b.output(b.depthwise_conv2d(x, multiplier, k, k, stride, dilation, same, act,
+                        out_scale, rand_zero_point()));
+                  }});
+            }
+
+  const int fc_shapes[][3] = {{1, 256, 10}, {2, 100, 37}, {1, 1352, 128}, {4, 64, 16}, {1, 7, 3}};
+  for (const auto& s : fc_shapes)
+    for (int relu = 0; relu <= 1; relu++) {
+      const int batches = s[0], depth = s[1], units = s[2];
+      configs.push_back({tflite::BuiltinOperator_FULLY_CONNECTED,
+          std::to_string(batches) + "x" + std::to_string(depth) + " -> " + std::to_string(units) +
+              (relu ? " relu" : ""),
+          [=](tflm_host::ModelBuilder& b) {
+            const float scale = rand_scale();
+            int32_t x = b.input({batches, depth}, scale, rand_zero_point());
+            const float out_scale = scale * 0.5f * sqrtf((float)depth);
+            b.output(b.dense(x, units, relu, out_scale, rand_zero_point()));
+          }});
+    }
+
+  const std::vector<std::vector<int32_t>> pool_inputs = {{1, 12, 12, 8}, {2, 9, 9, 5}};
+  const int pools[][3] = {{2, 2, 0}, {3, 2, 1}, {3, 1, 1}, {2, 1, 0}};  /* size, stride, same */
+  for (BuiltinOperator op : {tflite::BuiltinOperator_MAX_POOL_2D,
+           tflite::BuiltinOperator_AVERAGE_POOL_2D})
+    for (const auto& in : pool_inputs)
+      for (const auto& p : pools) {
+        const int size = p[0], stride = p[1];
+        const bool same = p[2];
+        const ActivationFunctionType act = nth_act(i++);
+        configs.push_back({op,
+            shape_name(in) + " k" + std::to_string(size) + "x" + std::to_string(size) + " s" +
+                std::to_string(stride) + (same ? " same" : " valid") + act_name(act),
+            [=](tflm_host::ModelBuilder& b) {
+              int32_t x = b.input(in, rand_scale(), rand_zero_point());
+              b.output(b.pool2d(x, op, size, size, stride, same, act));
+            }});
+      }
+
+  const std::vector<std::vector<int32_t>> softmax_inputs = {{1, 10}, {2, 37}, {1, 1001}, {4, 16}};
+  for (const auto& in : softmax_inputs)
+    for (float input_scale : {0.02f, 0.1f, 0.25f}) {
+      char name[64];
+      snprintf(name, sizeof(name), "%s, input scale %.2f", shape_name(in).c_str(), input_scale);
+      configs.push_back({tflite::BuiltinOperator_SOFTMAX, name,
+          [=](tflm_host::ModelBuilder& b) {
+            b.softmax(b.input(in, input_scale, rand_zero_point()));
+          }});
+    }
+
+  const std::vector<std::vector<int32_t>> binary_inputs[] = {
+      {{1, 8, 8, 16}, {1, 8, 8, 16}},
+      {{1, 8, 8, 16}, {1, 1, 1, 16}},
+      {{1, 8, 8, 16}, {1, 8, 8, 1}},
+      {{2, 4, 4, 3}, {1, 4, 4, 3}},
+      {{1, 1, 1, 1001}, {1, 1, 1, 1001}}};
+  for (BuiltinOperator op : {tflite::BuiltinOperator_ADD, tflite::BuiltinOperator_MUL})
+    for (const auto& in : binary_inputs) {
+      const ActivationFunctionType act = nth_act(i++);
+      configs.push_back({op, shape_name(in[0]) + " . " + shape_name(in[1]) + act_name(act),
+          [=](tflm_host::ModelBuilder& b) {
+            const float scale_a = rand_scale(), scale_b = rand_scale();
+            int32_t x = b.input(in[0], scale_a, rand_zero_point());
+            int32_t y = b.input(in[1], scale_b, rand_zero_point());
+            const float out_scale = op == tflite::BuiltinOperator_ADD ? (scale_a + scale_b)
+                : scale_a * scale_b * 128.0f;
+            b.output(b.binary(op, x, y, act, out_scale, rand_zero_point()));
+          }});
+    }
+
+  return configs;
+}
+
+template <typename Resolver>
+void add_ops(Resolver* resolver, bool reference)
+{
+  if (reference) {
+    resolver->AddConv2D(tflm_host::Register_CONV_2D_REF());
+    resolver->AddDepthwiseConv2D(tflm_host::Register_DEPTHWISE_CONV_2D_REF());
+    resolver->AddFullyConnected(tflm_host::Register_FULLY_CONNECTED_REF());
+    resolver->AddMaxPool2D(tflm_host::Register_MAX_POOL_2D_REF());
+    resolver->AddAveragePool2D(tflm_host::Register_AVERAGE_POOL_2D_REF());
+    resolver->AddSoftmax(tflm_host::Register_SOFTMAX_REF());
+    resolver->AddAdd(tflm_host::Register_ADD_REF());
+    resolver->AddMul(tflm_host::Register_MUL_REF());
+  } else {
+    resolver->AddConv2D();
+    resolver->AddDepthwiseConv2D();
+    resolver->AddFullyConnected();
+    resolver->AddMaxPool2D();
+    resolver->AddAveragePool2D();
+    resolver->AddSoftmax();
+    resolver->AddAdd();
+    resolver->AddMul();
+  }
+}
+
+void fill_inputs(tflite::MicroInterpreter& interpreter, unsigned seed)
+{
+  srand(seed);
+  for (size_t k = 0; k < interpreter.inputs_size(); k++) {
+    TfLiteTensor* t = interpreter.input(k);
+    for (size_t j = 0; j < t->bytes; j++)
+      t->data.int8[j] = (int8_t)rand();
+  }
+}
+
+double median_invoke(tflite::MicroInterpreter& interpreter, int runs)
+{
+  std::vector<double> t;
+  for (int i = 0; i < runs; i++) {
+    const double t0 = tflm_host::now_us();
+    if (interpreter.Invoke() != kTfLiteOk)
+      return -1.0;
+    t.push_back(tflm_host::now_us() - t0);
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+struct Summary {
+  int configs = 0;
+  int failed = 0;
+  double log_speedup = 0.0;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 20;
+  unsigned seed = 1;
+  const char* only = nullptr;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      seed = (unsigned)strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+      only = argv[++i];
+    else if (!strcmp(argv[i], "-v"))
+      verbose = true;
+    else {
+      fprintf(stderr, "usage: %s [-n runs] [-s seed] [-o op] [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  static tflite::MicroMutableOpResolver<8> resolvers[2];
+  add_ops(&resolvers[0], false);
+  add_ops(&resolvers[1], true);
+
+  const std::vector<Config> configs = sweep();
+  std::vector<BuiltinOperator> ops;
+  std::vector<Summary> summaries;
+  int res = 0;
+  srand(seed);
+
+  for (size_t c = 0; c < configs.size(); c++) {
+    const Config& config = configs[c];
+    const char* op_name = tflite::EnumNameBuiltinOperator(config.op);
+    if (only && strcmp(only, op_name))
+      continue;
+
+    tflm_host::ModelBuilder b;
+    srand(seed + (unsigned)c);
+    config.build(b);
+    const std::vector<uint8_t> data = b.pack();
+    const tflite::Model* model = tflite::GetModel(data.data());
+
+    /* 0: CMSIS-NN, 1: reference */
+    tflite::MicroInterpreter cmsis(model, resolvers[0], arena[0], sizeof(arena[0]));
+    tflite::MicroInterpreter reference(model, resolvers[1], arena[1], sizeof(arena[1]));
+    bool ok = cmsis.AllocateTensors() == kTfLiteOk && reference.AllocateTensors() == kTfLiteOk;
+    for (int k = 0; k < kInputSets && ok; k++) {
+      fill_inputs(cmsis, seed + (unsigned)(c * kInputSets + k));
+      fill_inputs(reference, seed + (unsigned)(c * kInputSets + k));
+      ok = cmsis.Invoke() == kTfLiteOk && reference.Invoke() == kTfLiteOk &&
+          !memcmp(cmsis.output(0)->data.raw, reference.output(0)->data.raw,
+              cmsis.output(0)->bytes);
+    }
+    const double t_cmsis = ok ? median_invoke(cmsis, runs) : -1.0;
+    const double t_reference = ok ? median_invoke(reference, runs) : -1.0;
+    ok = ok && t_cmsis >= 0.0 && t_reference >= 0.0;
+
+    size_t s = std::find(ops.begin(), ops.end(), config.op) - ops.begin();
+    if (s == ops.size()) {
+      ops.push_back(config.op);
+      summaries.emplace_back();
+    }
+    summaries[s].configs++;
+    if (!ok) {
+      summaries[s].failed++;
+      res = 1;
+      printf("  %-18s %-44s : FAILED\n", op_name, config.name.c_str());
+      continue;
+    }
+    const double speedup = t_reference / std::max(t_cmsis, 0.01);
+    summaries[s].log_speedup += log(speedup);
+    if (verbose)
+      printf("  %-18s %-44s : %9.2f us %9.2f us  x%.2f\n", op_name, config.name.c_str(), t_cmsis,
+          t_reference, speedup);
+  }
+
+  printf("\n  %-18s %7s %7s   %s\n", "operator", "configs", "failed",
+      "CMSIS-NN speed-up vs reference (geometric mean)");
+  for (size_t s = 0; s < ops.size(); s++) {
+    const int passed = summaries[s].configs - summaries[s].failed;
+    printf("  %-18s %7d %7d   x%.2f\n", tflite::EnumNameBuiltinOperator(ops[s]),
+        summaries[s].configs, summaries[s].failed,
+        passed ? exp(summaries[s].log_speedup / passed) : 0.0);
+  }
+  return res;
+}
@@ -0,0 +1,232 @@
+/**
+ ******************************************************************************
+ * @file    tflm_mnist_eval.cc
+ * @brief   Host accuracy/latency regression runner over the MNIST test set
+ ******************************************************************************
+ *
+ * usage: tflm_mnist_eval <model.tflite> <images-idx3> <labels-idx1>
+ *                        [-p predictions-idx1] [-j threads] [-t tolerance_pct]
+ *
+ * The test set (IDX files, exported by train_mnist_model.py in ml_model/data)
+ * is classified with the int8 TFLM kernels of the firmware: one instance of
+ * the model (tflm_c_create(), own arena) per worker thread, the images are
+ * shared between the workers. Each image is quantized by the pre-processor
+ * of the firmware (tflm_preproc.h) and the class is selected by the top-k
+ * head (tflm_c_topk()).
+ *
+ * Reports the accuracy, the confusion matrix, the throughput and the
+ * percentiles of the per image latency (quantization + invoke). With the
+ * classes predicted by the TFLite interpreter (-p), the agreement is
+ * reported and the exit code is 1 if the accuracy differs from the TFLite
+ * accuracy by more than tolerance_pct (default 0.2).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+#include "tflm_preproc.h"
+
+namespace {
+
+/* the handle table of tflm_c has TFLM_C_MAX_INSTANCES (16) entries */
+constexpr int kMaxWorkers = 16;
+
+struct Idx {
+  std::vector<uint32_t> dims;
+  std::vector<uint8_t> data;
+};
+
+/* IDX file of unsigned bytes (MNIST format) */
+bool load_idx(const char* path, uint32_t n_dims, Idx* idx)
+{
+  std::vector<uint8_t> raw = tflm_host::load_file(path);
+  if (raw.size() < 4 || raw[0] || raw[1] || raw[2] != 0x08 || raw[3] != n_dims ||
+      raw.size() < 4 + 4 * n_dims)
+    return false;
+  size_t count = 1;
+  idx->dims.clear();
+  for (uint32_t i = 0; i < n_dims; i++) {
+    const uint8_t* p = &raw[4 + 4 * i];
+    idx->dims.push_back((uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]);
+    count *= idx->dims.back();
+  }
+  const size_t offset = 4 + 4 * n_dims;
+  if (raw.size() != offset + count)
+    return false;
+  idx->data.assign(raw.begin() + offset, raw.end());
+  return true;
+}
+
+/* instance of the model owned by a worker */
+struct Worker {
+  std::vector<uint8_t> storage;
+  uint32_t hdl = 0;
+  struct tflm_c_tensor_info input;
+  struct tflm_pp_quant quant;
+};
+
+bool create(const std::vector<uint8_t>& model, Worker* w)
+{
+  w->storage.resize(tflm_host::kHostArenaSize + tflm_host::kArenaAlignment);
+  uint8_t* arena = w->storage.data() + ((tflm_host::kArenaAlignment
+      - (uintptr_t)w->storage.data() % tflm_host::kArenaAlignment) % tflm_host::kArenaAlignment);
+  if (tflm_c_create(model.data(), arena, tflm_host::kHostArenaSize, &w->hdl) != kTfLiteOk ||
+      tflm_c_topk_enable(w->hdl, 1) != kTfLiteOk)
+    return false;
+  tflm_c_input(w->hdl, 0, &w->input);
+  if (w->input.type != kTfLiteInt8)
+    return false;
+  /* as the application: raw pixels if the normalisation is folded in the model */
+  if (w->input.scale == 1.0f && w->input.zero_point == -128)
+    return tflm_pp_quant_init(&w->quant, 1.0f, 1.0f, -128, 0) == 0;
+  return tflm_pp_quant_init(&w->quant, 1.0f / 255.0f, w->input.scale, w->input.zero_point,
+      0) == 0;
+}
+
+void work(Worker* w, const Idx* images, std::atomic<uint32_t>* next, std::vector<int32_t>* classes,
+    std::vector<double>* latency, std::atomic<bool>* ok)
+{
+  const uint32_t n = images->dims[0];
+  const uint32_t size = images->dims[1] * images->dims[2];
+  for (uint32_t i = (*next)++; i < n && *ok; i = (*next)++) {
+    struct tflm_c_topk_result topk;
+    double t0 = tflm_host::now_us();
+    tflm_pp_quantize(&w->quant, &images->data[(size_t)i * size], (int8_t*)w->input.data, size);
+    if (tflm_c_invoke(w->hdl) != kTfLiteOk || tflm_c_topk(w->hdl, &topk) != kTfLiteOk) {
+      *ok = false;
+      break;
+    }
+    (*latency)[i] = tflm_host::now_us() - t0;
+    (*classes)[i] = topk.index[0];
+  }
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+  return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int n_workers = (int)std::thread::hardware_concurrency();
+  double tolerance = 0.2;
+  const char* predictions = nullptr;
+  const char* paths[3] = {nullptr, nullptr, nullptr};
+  int n_paths = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-j") && i + 1 < argc)
+      n_workers = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      tolerance = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+      predictions = argv[++i];
+    else if (n_paths < 3 && argv[i][0] != '-')
+      paths[n_paths++] = argv[i];
+    else {
+      n_paths = 0;
+      break;
+    }
+  }
+  if (n_paths != 3) {
+    fprintf(stderr, "usage: %s <model.tflite> <images-idx3> <labels-idx1> [-p predictions-idx1]"
+        " [-j threads] [-t tolerance_pct]\n", argv[0]);
+    return 2;
+  }
+  n_workers = std::min(std::max(n_workers, 1), kMaxWorkers);
+
+  std::vector<uint8_t> model = tflm_host::load_file(paths[0]);
+  Idx images, labels, ref;
+  if (model.empty() || !load_idx(paths[1], 3, &images) || !load_idx(paths[2], 1, &labels) ||
+      labels.dims[0] != images.dims[0] || !images.dims[0] ||
+      (predictions && (!load_idx(predictions, 1, &ref) || ref.dims[0] != labels.dims[0]))) {
+    fprintf(stderr, "E: unable to read the model or the IDX files\n");
+    return 1;
+  }
+  const uint32_t n = images.dims[0];
+
+  /* the instances are created before the workers start */
+  std::vector<Worker> workers(n_workers);
+  for (auto& w : workers) {
+    if (!create(model, &w) || w.input.bytes != images.dims[1] * images.dims[2]) {
+      fprintf(stderr, "E: unable to create a %dx%d int8 classifier from %s\n",
+          (int)images.dims[1], (int)images.dims[2], paths[0]);
+      return 1;
+    }
+  }
+  struct tflm_c_tensor_info output;
+  tflm_c_output(workers[0].hdl, 0, &output);
+  const int n_classes = (int)output.shape.data[output.shape.size - 1];
+
+  std::vector<int32_t> classes(n, -1);
+  std::vector<double> latency(n, 0.0);
+  std::atomic<uint32_t> next(0);
+  std::atomic<bool> ok(true);
+  std::vector<std::thread> threads;
+  double t0 = tflm_host::now_us();
+  for (auto& w : workers)
+    threads.emplace_back(work, &w, &images, &next, &classes, &latency, &ok);
+  for (auto& t : threads)
+    t.join();
+  const double wall_us = tflm_host::now_us() - t0;
+  for (auto& w : workers)
+    tflm_c_destroy(w.hdl);
+  if (!ok) {
+    fprintf(stderr, "E: inference fails\n");
+    return 1;
+  }
+
+  std::vector<uint32_t> confusion(n_classes * n_classes, 0);
+  uint32_t correct = 0, ref_correct = 0, agree = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    const int label = labels.data[i];
+    if (label < n_classes)
+      confusion[label * n_classes + classes[i]]++;
+    correct += classes[i] == label;
+    if (predictions) {
+      ref_correct += ref.data[i] == label;
+      agree += ref.data[i] == classes[i];
+    }
+  }
+  std::sort(latency.begin(), latency.end());
+  const double accuracy = 100.0 * correct / n;
+
+  printf("model              : %s\n", paths[0]);
+  printf("images             : %d (%dx%d), %d worker(s)\n", (int)n, (int)images.dims[1],
+      (int)images.dims[2], n_workers);
+  printf("accuracy (TFLM)    : %.2f%% (%d/%d)\n", accuracy, (int)correct, (int)n);
+  printf("throughput         : %.0f images/s\n", n / (wall_us / 1e6));
+  printf("latency (us)       : p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n",
+      percentile(latency, 0.5), percentile(latency, 0.9), percentile(latency, 0.99),
+      latency.back());
+  printf("\nconfusion (rows: label, columns: predicted)\n      ");
+  for (int c = 0; c < n_classes; c++)
+    printf(" %5d", c);
+  printf("\n");
+  for (int l = 0; l < n_classes; l++) {
+    printf("  %2d: ", l);
+    for (int c = 0; c < n_classes; c++)
+      printf(" %5d", (int)confusion[l * n_classes + c]);
+    printf("\n");
+  }
+  printf("\n");
+
+  if (predictions) {
+    const double ref_accuracy = 100.0 * ref_correct / n;
+    const bool drift = std::abs(accuracy - ref_accuracy) > tolerance;
+    printf("accuracy (TFLite)  : %.2f%%, agreement %.2f%%\n", ref_accuracy, 100.0 * agree / n);
+    printf("drift              : %+.2f%% (tolerance %.2f%%)%s\n", accuracy - ref_accuracy,
+        tolerance, drift ? " FAILED" : "");
+    if (drift)
+      return 1;
+  }
+  return 0;
+}
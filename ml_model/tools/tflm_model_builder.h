@@ -0,0 +1,309 @@
+/**
+ ******************************************************************************
+ * @file    tflm_model_builder.h
+ * @brief   Generation of int8 test models for the host TFLM tools
+ ******************************************************************************
+ *
+ * The models are built with the object API of the TFLite schema: layers of
+ * the selected_model variants of train_mnist_model.py, random weights (the
+ * memory plan and the kernels used depend only on the graph).
+ */
+
+#ifndef __TFLM_MODEL_BUILDER_H__
+#define __TFLM_MODEL_BUILDER_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflm_host {
+
+class ModelBuilder {
+public:
+  ModelBuilder() {
+    model_.version = TFLITE_SCHEMA_VERSION;
+    model_.buffers.emplace_back(new tflite::BufferT());  /* empty buffer 0 */
+    model_.subgraphs.emplace_back(new tflite::SubGraphT());
+  }
+
+  /* int8 activation tensor */
+  int32_t activation(const std::vector<int32_t>& shape, float scale, int zero_point) {
+    return tensor(shape, tflite::TensorType_INT8, {scale}, {zero_point}, 0);
+  }
+
+  int32_t input(const std::vector<int32_t>& shape, float scale, int zero_point) {
+    int32_t t = activation(shape, scale, zero_point);
+    sg().inputs.push_back(t);
+    return t;
+  }
+
+  /* 3x3 conv, VALID (or SAME) padding */
+  int32_t conv(int32_t in, int channels, int stride, float scale, int zero_point,
+      bool same = false) {
+    return conv2d(in, channels, 3, 3, stride, 1, same, tflite::ActivationFunctionType_NONE, scale,
+        zero_point);
+  }
+
+  /* conv of any size, stride and dilation, per channel weights scales */
+  int32_t conv2d(int32_t in, int channels, int kh, int kw, int stride, int dilation, bool same,
+      tflite::ActivationFunctionType act, float scale, int zero_point) {
+    const tflite::TensorT& x = *sg().tensors[in];
+    const int h = out_size(x.shape[1], kh, stride, dilation, same);
+    const int w = out_size(x.shape[2], kw, stride, dilation, same);
+    std::vector<float> w_scales(channels), b_scales(channels);
+    for (int c = 0; c < channels; c++) {
+      w_scales[c] = 0.002f + 0.001f * (c % 4);
+      b_scales[c] = w_scales[c] * x.quantization->scale[0];
+    }
+    const int depth = x.shape[3];
+    int32_t filter = tensor({channels, kh, kw, depth}, tflite::TensorType_INT8, w_scales,
+        std::vector<int64_t>(channels, 0), random_buffer(channels * kh * kw * depth, 1));
+    int32_t bias = tensor({channels}, tflite::TensorType_INT32, b_scales,
+        std::vector<int64_t>(channels, 0), random_buffer(channels, 4));
+    int32_t out = activation({x.shape[0], h, w, channels}, scale, zero_point);
+    tflite::Conv2DOptionsT options;
+    options.padding = same ? tflite::Padding_SAME : tflite::Padding_VALID;
+    options.stride_w = options.stride_h = stride;
+    options.dilation_w_factor = options.dilation_h_factor = dilation;
+    options.fused_activation_function = act;
+    op(tflite::BuiltinOperator_CONV_2D, {in, filter, bias}, out).builtin_options.Set(options);
+    return out;
+  }
+
+  /* depthwise conv, per channel weights scales */
+  int32_t depthwise_conv2d(int32_t in, int multiplier, int kh, int kw, int stride, int dilation,
+      bool same, tflite::ActivationFunctionType act, float scale, int zero_point) {
+    const tflite::TensorT& x = *sg().tensors[in];
+    const int h = out_size(x.shape[1], kh, stride, dilation, same);
+    const int w = out_size(x.shape[2], kw, stride, dilation, same);
+    const int channels = x.shape[3] * multiplier;
+    std::vector<float> w_scales(channels), b_scales(channels);
+    for (int c = 0; c < channels; c++) {
+      w_scales[c] = 0.002f + 0.001f * (c % 4);
+      b_scales[c] = w_scales[c] * x.quantization->scale[0];
+    }
+    int32_t filter = tensor({1, kh, kw, channels}, tflite::TensorType_INT8, w_scales,
+        std::vector<int64_t>(channels, 0), random_buffer(kh * kw * channels, 1));
+    sg().tensors[filter]->quantization->quantized_dimension = 3;
+    int32_t bias = tensor({channels}, tflite::TensorType_INT32, b_scales,
+        std::vector<int64_t>(channels, 0), random_buffer(channels, 4));
+    int32_t out = activation({x.shape[0], h, w, channels}, scale, zero_point);
+    tflite::DepthwiseConv2DOptionsT options;
+    options.padding = same ? tflite::Padding_SAME : tflite::Padding_VALID;
+    options.stride_w = options.stride_h = stride;
+    options.dilation_w_factor = options.dilation_h_factor = dilation;
+    options.depth_multiplier = multiplier;
+    options.fused_activation_function = act;
+    op(tflite::BuiltinOperator_DEPTHWISE_CONV_2D, {in, filter, bias}, out).builtin_options.Set(
+        options);
+    return out;
+  }
+
+  int32_t relu(int32_t in) {
+    const tflite::TensorT& x = *sg().tensors[in];
+    int32_t out = activation(x.shape, x.quantization->scale[0], (int)x.quantization->zero_point[0]);
+    op(tflite::BuiltinOperator_RELU, {in}, out);
+    return out;
+  }
+
+  int32_t max_pool(int32_t in, int fh, int fw) {
+    const tflite::TensorT& x = *sg().tensors[in];
+    int32_t out = activation({1, x.shape[1] / fh, x.shape[2] / fw, x.shape[3]},
+        x.quantization->scale[0], (int)x.quantization->zero_point[0]);
+    tflite::Pool2DOptionsT options;
+    options.padding = tflite::Padding_VALID;
+    options.stride_h = options.filter_height = fh;
+    options.stride_w = options.filter_width = fw;
+    op(tflite::BuiltinOperator_MAX_POOL_2D, {in}, out).builtin_options.Set(options);
+    return out;
+  }
+
+  /* MAX_POOL_2D or AVERAGE_POOL_2D, same quantization as the input */
+  int32_t pool2d(int32_t in, tflite::BuiltinOperator code, int fh, int fw, int stride, bool same,
+      tflite::ActivationFunctionType act) {
+    const tflite::TensorT& x = *sg().tensors[in];
+    int32_t out = activation({x.shape[0], out_size(x.shape[1], fh, stride, 1, same),
+        out_size(x.shape[2], fw, stride, 1, same), x.shape[3]}, x.quantization->scale[0],
+        (int)x.quantization->zero_point[0]);
+    tflite::Pool2DOptionsT options;
+    options.padding = same ? tflite::Padding_SAME : tflite::Padding_VALID;
+    options.stride_h = options.stride_w = stride;
+    options.filter_height = fh;
+    options.filter_width = fw;
+    options.fused_activation_function = act;
+    op(code, {in}, out).builtin_options.Set(options);
+    return out;
+  }
+
+  /* ADD or MUL, same rank inputs (broadcast on the dimensions of size 1) */
+  int32_t binary(tflite::BuiltinOperator code, int32_t a, int32_t b,
+      tflite::ActivationFunctionType act, float scale, int zero_point) {
+    const std::vector<int32_t>& shape_a = sg().tensors[a]->shape;
+    const std::vector<int32_t>& shape_b = sg().tensors[b]->shape;
+    std::vector<int32_t> shape(shape_a.size());
+    for (size_t i = 0; i < shape.size(); i++)
+      shape[i] = std::max(shape_a[i], shape_b[i]);
+    int32_t out = activation(shape, scale, zero_point);
+    tflite::OperatorT& o = op(code, {a, b}, out);
+    if (code == tflite::BuiltinOperator_ADD) {
+      tflite::AddOptionsT options;
+      options.fused_activation_function = act;
+      o.builtin_options.Set(options);
+    } else {
+      tflite::MulOptionsT options;
+      options.fused_activation_function = act;
+      o.builtin_options.Set(options);
+    }
+    return out;
+  }
+
+  int32_t reshape(int32_t in, const std::vector<int32_t>& shape) {
+    const tflite::TensorT& x = *sg().tensors[in];
+    int32_t out = activation(shape, x.quantization->scale[0], (int)x.quantization->zero_point[0]);
+    tflite::ReshapeOptionsT options;
+    options.new_shape = shape;
+    op(tflite::BuiltinOperator_RESHAPE, {in}, out).builtin_options.Set(options);
+    return out;
+  }
+
+  int32_t dense(int32_t in, int units, bool relu, float scale, int zero_point) {
+    const tflite::TensorT& x = *sg().tensors[in];
+    const int depth = x.shape.back();
+    const float w_scale = 0.004f;
+    int32_t filter = tensor({units, depth}, tflite::TensorType_INT8, {w_scale}, {0},
+        random_buffer(units * depth, 1));
+    int32_t bias = tensor({units}, tflite::TensorType_INT32, {w_scale * x.quantization->scale[0]},
+        {0}, random_buffer(units, 4));
+    int rows = 1;
+    for (int32_t d : x.shape)
+      rows *= d;
+    int32_t out = activation({rows / depth, units}, scale, zero_point);
+    tflite::FullyConnectedOptionsT options;
+    options.fused_activation_function = relu ? tflite::ActivationFunctionType_RELU
+        : tflite::ActivationFunctionType_NONE;
+    op(tflite::BuiltinOperator_FULLY_CONNECTED, {in, filter, bias}, out).builtin_options.Set(
+        options);
+    return out;
+  }
+
+  int32_t softmax(int32_t in) {
+    const tflite::TensorT& x = *sg().tensors[in];
+    int32_t out = activation(x.shape, 1.0f / 256.0f, -128);
+    tflite::SoftmaxOptionsT options;
+    options.beta = 1.0f;
+    op(tflite::BuiltinOperator_SOFTMAX, {in}, out).builtin_options.Set(options);
+    sg().outputs.push_back(out);
+    return out;
+  }
+
+  void output(int32_t t) { sg().outputs.push_back(t); }
+
+  std::vector<uint8_t> pack() {
+    /* the TFLM copy of flatbuffers has no implicit default allocator */
+    flatbuffers::DefaultAllocator allocator;
+    flatbuffers::FlatBufferBuilder fbb(16 * 1024, &allocator);
+    tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, &model_));
+    return std::vector<uint8_t>(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+  }
+
+private:
+  tflite::SubGraphT& sg() { return *model_.subgraphs[0]; }
+
+  static int out_size(int in, int k, int stride, int dilation, bool same) {
+    return same ? (in + stride - 1) / stride : (in - (k - 1) * dilation - 1) / stride + 1;
+  }
+
+  uint32_t random_buffer(int count, int elem_size) {
+    std::unique_ptr<tflite::BufferT> buffer(new tflite::BufferT());
+    buffer->data.resize((size_t)count * elem_size);
+    for (int i = 0; i < count; i++) {
+      /* int8 weights, small int32 biases */
+      int32_t v = (elem_size == 1) ? (int8_t)rand() : (rand() % 512) - 256;
+      memcpy(&buffer->data[(size_t)i * elem_size], &v, elem_size);
+    }
+    model_.buffers.push_back(std::move(buffer));
+    return (uint32_t)model_.buffers.size() - 1;
+  }
+
+  int32_t tensor(const std::vector<int32_t>& shape, tflite::TensorType type,
+      const std::vector<float>& scales, const std::vector<int64_t>& zero_points, uint32_t buffer) {
+    std::unique_ptr<tflite::TensorT> t(new tflite::TensorT());
+    t->shape = shape;
+    t->type = type;
+    t->buffer = buffer;
+    t->name = "t" + std::to_string(sg().tensors.size());
+    t->quantization.reset(new tflite::QuantizationParametersT());
+    t->quantization->scale = scales;
+    t->quantization->zero_point = zero_points;
+    t->quantization->quantized_dimension = 0;
+    sg().tensors.push_back(std::move(t));
+    return (int32_t)sg().tensors.size() - 1;
+  }
+
+  tflite::OperatorT& op(tflite::BuiltinOperator code, const std::vector<int32_t>& inputs,
+      int32_t output) {
+    uint32_t index = 0;
+    while (index < model_.operator_codes.size() && model_.operator_codes[index]->builtin_code != code)
+      index++;
+    if (index == model_.operator_codes.size()) {
+      std::unique_ptr<tflite::OperatorCodeT> c(new tflite::OperatorCodeT());
+      c->builtin_code = code;
+      c->deprecated_builtin_code = (int8_t)std::min((int)code, 127);
+      c->version = 1;
+      model_.operator_codes.push_back(std::move(c));
+    }
+    std::unique_ptr<tflite::OperatorT> o(new tflite::OperatorT());
+    o->opcode_index = index;
+    o->inputs = inputs;
+    o->outputs = {output};
+    sg().operators.push_back(std::move(o));
+    return *sg().operators.back();
+  }
+
+  tflite::ModelT model_;
+};
+
+/* selected_model variant of train_mnist_model.py, empty if not supported */
+inline std::vector<uint8_t> generate_mnist_model(int variant)
+{
+  ModelBuilder b;
+  srand(variant + 1);
+  int32_t x = b.input({1, 28, 28, 1}, 1.0f / 255.0f, -128);
+  switch (variant) {
+  case 0:
+    x = b.max_pool(b.conv(x, 28, 1, 0.05f, -10), 2, 2);
+    x = b.reshape(x, {1, 13 * 13 * 28});
+    x = b.dense(b.dense(x, 128, true, 0.1f, -128), 10, false, 0.17f, 29);
+    break;
+  case 1:
+    x = b.max_pool(b.conv(x, 12, 1, 0.05f, -10), 2, 2);
+    x = b.dense(b.reshape(x, {1, 13 * 13 * 12}), 10, false, 0.17f, 29);
+    break;
+  case 2:
+    x = b.max_pool(b.conv(x, 12, 2, 0.05f, -10), 3, 3);
+    x = b.max_pool(b.reshape(x, {1, 16, 12, 1}), 3, 3);
+    x = b.dense(b.reshape(x, {1, 5 * 4}), 10, false, 0.17f, 29);
+    break;
+  case 4:
+    x = b.reshape(b.conv(x, 12, 2, 0.05f, -10), {1, 338, 6, 1});
+    x = b.max_pool(x, 26, 3);
+    x = b.dense(b.reshape(x, {1, 13 * 2}), 10, false, 0.17f, 29);
+    break;
+  default:
+    return {};
+  }
+  b.softmax(x);
+  return b.pack();
+}
+
+}  // namespace tflm_host
+
+#endif /* __TFLM_MODEL_BUILDER_H__ */
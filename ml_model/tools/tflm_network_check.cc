@@ -0,0 +1,57 @@
+/**
+ ******************************************************************************
+ * @file    tflm_network_check.cc
+ * @brief   Host check of the model specific op resolver and kernel list
+ ******************************************************************************
+ *
+ * usage: tflm_network_check <model.tflite>
+ *
+ * Linked with the tflm_network library (TFLM_RUNTIME_USE_ALL_OPERATORS=0,
+ * tflm_network_kernels.cmake), as the firmware. The model is created and
+ * invoked once through tflm_c: a missing registration makes tflm_c_create()
+ * fail, a missing kernel source breaks the link.
+ */
+
+#include <string.h>
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <model.tflite>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(argv[1]);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", argv[1]);
+    return 1;
+  }
+
+  uint32_t hdl;
+  if (tflm_c_create(data.data(), arena, sizeof(arena), &hdl) != kTfLiteOk) {
+    fprintf(stderr, "E: tflm_c_create() fails\n");
+    return 1;
+  }
+
+  struct tflm_c_tensor_info info;
+  for (int i = 0; i < tflm_c_inputs_size(hdl); i++) {
+    tflm_c_input(hdl, i, &info);
+    memset(info.data, 0, info.bytes);
+  }
+  TfLiteStatus status = tflm_c_invoke(hdl);
+
+  printf("model              : %s\n", argv[1]);
+  printf("operators          : %d\n", (int)tflm_c_operator_codes_size(hdl));
+  printf("invoke             : %s\n", status == kTfLiteOk ? "ok" : "failed");
+  tflm_c_destroy(hdl);
+  return status == kTfLiteOk ? 0 : 1;
+}
@@ -0,0 +1,481 @@
+/**
+ ******************************************************************************
+ * @file    tflm_offline_plan.cc
+ * @brief   Host pass adding an offline memory plan to a TFLite model
+ ******************************************************************************
+ *
+ * usage: tflm_offline_plan <model.tflite> <output.tflite> [-i iterations] [-s seed]
+ *
+ * The lifetimes of the tensors and the scratch buffer requests of the kernels
+ * are captured by running AllocateTensors() with the host TFLM runtime. The
+ * tool searches a tensor layout which is smaller (or equal) than the one of
+ * the GreedyMemoryPlanner and stores it in the "OfflineMemoryAllocation"
+ * metadata of the model (see micro/docs/memory_management.md):
+ *
+ *   int32 [version(=1), subgraph(=0), nb_tensors, offset_0, .., offset_n-1]
+ *
+ * with -1 for the tensors which are not placed in the arena (weights,
+ * variables). The output of a RESHAPE/SQUEEZE/EXPAND_DIMS gets the offset of
+ * its input (buffer shared, as done by the MicroAllocator without plan). At init time, the MicroAllocator uses these offsets as-is and
+ * the GreedyMemoryPlanner has only to place the scratch buffers (their size
+ * depends on the kernel implementation) in the remaining gaps. The search
+ * replays this placement, so the reported size is the one used on target.
+ *
+ * Search:
+ * - exhaustive over the placement orders if the number of tensors is <= 8,
+ * - else seeded heuristic orders + local search (swaps/moves),
+ * each order being placed with the lowest-fit rule of the GreedyMemoryPlanner.
+ * It stops as soon as the lower bound (max. sum of the sizes of the
+ * simultaneously live buffers) is reached.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+#include "tflm_host_utils.h"
+
+using tflm_host::BufferRequirement;
+
+namespace {
+
+const char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
+constexpr int kMaxExhaustiveTensors = 8;
+
+struct Placed {
+  int offset;
+  int idx;
+};
+
+bool overlap_in_time(const BufferRequirement& a, const BufferRequirement& b)
+{
+  return (a.first <= b.last) && (b.first <= a.last);
+}
+
+/*
+ * Lowest offset where the buffer fits between the placed buffers which are
+ * simultaneously live. Same rule as the GreedyMemoryPlanner for the online
+ * buffers. 'placed' is ordered by offset.
+ */
+int lowest_fit(const std::vector<BufferRequirement>& bufs,
+    const std::vector<Placed>& placed, const BufferRequirement& b)
+{
+  int candidate = 0;
+  for (const Placed& p : placed) {
+    const BufferRequirement& o = bufs[p.idx];
+    if (!overlap_in_time(o, b))
+      continue;
+    if (p.offset - candidate >= b.size)
+      break;
+    candidate = std::max(candidate, p.offset + o.size);
+  }
+  return candidate;
+}
+
+void insert_placed(std::vector<Placed>& placed, int offset, int idx)
+{
+  auto it = std::upper_bound(placed.begin(), placed.end(), offset,
+      [](int off, const Placed& p) { return off < p.offset; });
+  placed.insert(it, {offset, idx});
+}
+
+class Layout {
+public:
+  Layout(const std::vector<BufferRequirement>& bufs, int n_tensors)
+    : bufs_(bufs), n_tensors_(n_tensors) {
+    /* online buffers are placed by decreasing size, the GreedyMemoryPlanner
+     * collects them in the reverse order before a stable sort */
+    for (int i = (int)bufs.size() - 1; i >= n_tensors; i--)
+      scratch_order_.push_back(i);
+    std::stable_sort(scratch_order_.begin(), scratch_order_.end(),
+        [&](int a, int b) { return bufs[a].size > bufs[b].size; });
+  }
+
+  /* Places the tensors in the given order then the scratch buffers,
+   * returns the arena size. */
+  int place(const std::vector<int>& order, std::vector<int>* offsets) {
+    placed_.clear();
+    int peak = 0;
+    if (offsets)
+      offsets->assign(bufs_.size(), -1);
+    for (int idx : order) {
+      int off = lowest_fit(bufs_, placed_, bufs_[idx]);
+      insert_placed(placed_, off, idx);
+      peak = std::max(peak, off + bufs_[idx].size);
+      if (offsets)
+        (*offsets)[idx] = off;
+    }
+    for (int idx : scratch_order_) {
+      int off = lowest_fit(bufs_, placed_, bufs_[idx]);
+      insert_placed(placed_, off, idx);
+      peak = std::max(peak, off + bufs_[idx].size);
+      if (offsets)
+        (*offsets)[idx] = off;
+    }
+    return peak;
+  }
+
+  /* GreedyMemoryPlanner result without offline plan (all buffers online) */
+  int greedy() {
+    std::vector<int> order;
+    for (int i = (int)bufs_.size() - 1; i >= 0; i--)
+      order.push_back(i);
+    std::stable_sort(order.begin(), order.end(),
+        [&](int a, int b) { return bufs_[a].size > bufs_[b].size; });
+    placed_.clear();
+    int peak = 0;
+    for (int idx : order) {
+      int off = lowest_fit(bufs_, placed_, bufs_[idx]);
+      insert_placed(placed_, off, idx);
+      peak = std::max(peak, off + bufs_[idx].size);
+    }
+    return peak;
+  }
+
+  int lower_bound() const {
+    int bound = 0;
+    int t_max = 0;
+    for (const auto& b : bufs_)
+      t_max = std::max(t_max, b.last);
+    for (int t = 0; t <= t_max; t++) {
+      int live = 0;
+      for (const auto& b : bufs_)
+        if (b.first <= t && t <= b.last)
+          live += b.size;
+      bound = std::max(bound, live);
+    }
+    return bound;
+  }
+
+private:
+  const std::vector<BufferRequirement>& bufs_;
+  int n_tensors_;
+  std::vector<int> scratch_order_;
+  std::vector<Placed> placed_;
+};
+
+struct SearchResult {
+  int size;
+  std::vector<int> order;
+  long evaluated;
+  bool exhaustive;
+};
+
+SearchResult search(Layout& layout, const std::vector<BufferRequirement>& bufs,
+    int n_tensors, int lower_bound, long iterations, unsigned seed)
+{
+  SearchResult res;
+  res.evaluated = 0;
+  res.exhaustive = n_tensors <= kMaxExhaustiveTensors;
+
+  std::vector<int> order(n_tensors);
+  for (int i = 0; i < n_tensors; i++)
+    order[i] = i;
+
+  res.order = order;
+  res.size = layout.place(order, nullptr);
+
+  auto try_order = [&](const std::vector<int>& o) {
+    int size = layout.place(o, nullptr);
+    res.evaluated++;
+    if (size < res.size) {
+      res.size = size;
+      res.order = o;
+    }
+    return size;
+  };
+
+  if (res.exhaustive) {
+    while (std::next_permutation(order.begin(), order.end()) && res.size > lower_bound)
+      try_order(order);
+    return res;
+  }
+
+  /* seeds: by size, by creation time, by lifetime, by size x lifetime */
+  std::vector<std::vector<int>> seeds;
+  auto by = [&](auto key) {
+    std::vector<int> o = order;
+    std::stable_sort(o.begin(), o.end(), [&](int a, int b) { return key(a) > key(b); });
+    seeds.push_back(o);
+  };
+  by([&](int i) { return (long)bufs[i].size; });
+  by([&](int i) { return -(long)bufs[i].first; });
+  by([&](int i) { return (long)(bufs[i].last - bufs[i].first); });
+  by([&](int i) { return (long)bufs[i].size * (bufs[i].last - bufs[i].first + 1); });
+  for (const auto& s : seeds)
+    try_order(s);
+
+  /* local search from the best seed, equal-size moves are accepted */
+  std::mt19937 rng(seed);
+  std::vector<int> current = res.order;
+  int current_size = res.size;
+  for (long it = 0; it < iterations && res.size > lower_bound; it++) {
+    std::vector<int> cand = current;
+    int a = (int)(rng() % n_tensors);
+    int b = (int)(rng() % n_tensors);
+    if (rng() & 1) {
+      std::swap(cand[a], cand[b]);
+    } else {
+      int v = cand[a];
+      cand.erase(cand.begin() + a);
+      cand.insert(cand.begin() + b, v);
+    }
+    int size = try_order(cand);
+    if (size <= current_size) {
+      current = cand;
+      current_size = size;
+    }
+  }
+  return res;
+}
+
+/* Runs AllocateTensors() and returns the buffer requirements seen by the planner */
+bool capture_requirements(const uint8_t* model_data, std::vector<BufferRequirement>* reqs,
+    size_t* planner_size, std::vector<int>* offsets)
+{
+  static uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+  static tflite::AllOpsResolver resolver;
+
+  const tflite::Model* model = tflite::GetModel(model_data);
+  tflm_host::RecordingMemoryPlanner planner;
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(arena, sizeof(arena), &planner);
+  tflite::MicroInterpreter interpreter(model, resolver, allocator);
+  if (interpreter.AllocateTensors() != kTfLiteOk)
+    return false;
+
+  *reqs = planner.requirements;
+  if (planner_size)
+    *planner_size = planner.GetMaximumMemorySize();
+  if (offsets) {
+    offsets->resize(reqs->size());
+    for (size_t i = 0; i < reqs->size(); i++)
+      planner.GetOffsetForBuffer((int)i, &(*offsets)[i]);
+  }
+  return true;
+}
+
+/* Indexes of the tensors placed in the arena, in the MicroAllocator order.
+ * As the MicroAllocator (AllocationInfoBuilder::MarkAliasedAllocations()), the
+ * output of a RESHAPE/SQUEEZE/EXPAND_DIMS shares the buffer of its input: it
+ * is not placed, aliases[output] is the placed tensor (-1 if not aliased). */
+bool planned_tensors(const tflite::Model* model, std::vector<int>* tensors,
+    std::vector<int>* sizes, std::vector<int>* aliases)
+{
+  const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+  std::vector<int> planned(subgraph->tensors()->size(), 0);  /* aligned size */
+  aliases->assign(subgraph->tensors()->size(), -1);
+  for (size_t i = 0; i < subgraph->tensors()->size(); i++) {
+    const tflite::Tensor* tensor = subgraph->tensors()->Get(i);
+    const tflite::Buffer* buffer = model->buffers()->Get(tensor->buffer());
+    if (buffer->data() && buffer->data()->size())
+      continue;  // weights
+    if (tensor->is_variable())
+      continue;
+    size_t bytes, type_size;
+    if (tflite::BytesRequiredForTensor(*tensor, &bytes, &type_size) != kTfLiteOk)
+      return false;
+    if (bytes == 0)
+      continue;
+    planned[i] = (int)tflite::AlignSizeUp(bytes, tflm_host::kArenaAlignment);
+  }
+
+  for (size_t i = 0; subgraph->operators() && i < subgraph->operators()->size(); i++) {
+    const tflite::Operator* op = subgraph->operators()->Get(i);
+    const tflite::BuiltinOperator code =
+        tflite::GetBuiltinCode(model->operator_codes()->Get(op->opcode_index()));
+    if ((code != tflite::BuiltinOperator_RESHAPE && code != tflite::BuiltinOperator_SQUEEZE &&
+        code != tflite::BuiltinOperator_EXPAND_DIMS) || !op->inputs() || !op->inputs()->size() ||
+        !op->outputs() || op->outputs()->size() != 1)
+      continue;
+    int input = op->inputs()->Get(0);
+    const int output = op->outputs()->Get(0);
+    if (input < 0)
+      continue;
+    if ((*aliases)[input] >= 0)
+      input = (*aliases)[input];
+    if (planned[input] && planned[output] == planned[input] && (*aliases)[output] < 0)
+      (*aliases)[output] = input;
+  }
+
+  for (size_t i = 0; i < planned.size(); i++) {
+    if (planned[i] && (*aliases)[i] < 0) {
+      tensors->push_back((int)i);
+      sizes->push_back(planned[i]);
+    }
+  }
+  return true;
+}
+
+std::vector<uint8_t> add_plan_metadata(const uint8_t* model_data, const std::vector<int32_t>& plan)
+{
+  std::unique_ptr<tflite::ModelT> model = tflite::UnPackModel(model_data);
+
+  int buffer_idx = -1;
+  for (const auto& md : model->metadata) {
+    if (md->name == kOfflineMemAllocMetadata)
+      buffer_idx = (int)md->buffer;
+  }
+  if (buffer_idx < 0) {
+    model->buffers.push_back(std::unique_ptr<tflite::BufferT>(new tflite::BufferT()));
+    buffer_idx = (int)model->buffers.size() - 1;
+    std::unique_ptr<tflite::MetadataT> md(new tflite::MetadataT());
+    md->name = kOfflineMemAllocMetadata;
+    md->buffer = (uint32_t)buffer_idx;
+    model->metadata.push_back(std::move(md));
+  }
+  std::vector<uint8_t>& data = model->buffers[buffer_idx]->data;
+  data.resize(plan.size() * sizeof(int32_t));
+  memcpy(data.data(), plan.data(), data.size());
+
+  /* the TFLM copy of flatbuffers has no implicit default allocator */
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder fbb(16 * 1024, &allocator);
+  tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, model.get()));
+  return std::vector<uint8_t>(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+bool check_no_overlap(const std::vector<BufferRequirement>& bufs, const std::vector<int>& offsets)
+{
+  for (size_t i = 0; i < bufs.size(); i++) {
+    for (size_t j = i + 1; j < bufs.size(); j++) {
+      if (!overlap_in_time(bufs[i], bufs[j]))
+        continue;
+      if (offsets[i] < offsets[j] + bufs[j].size && offsets[j] < offsets[i] + bufs[i].size)
+        return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  long iterations = 20000;
+  unsigned seed = 1;
+  const char* paths[2] = {nullptr, nullptr};
+  int n_paths = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-i") && i + 1 < argc)
+      iterations = atol(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      seed = (unsigned)atol(argv[++i]);
+    else if (n_paths < 2)
+      paths[n_paths++] = argv[i];
+  }
+  if (n_paths != 2) {
+    fprintf(stderr, "usage: %s <model.tflite> <output.tflite> [-i iterations] [-s seed]\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(paths[0]);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", paths[0]);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(data.data());
+  if (model->subgraphs()->size() != 1) {
+    fprintf(stderr, "E: only single subgraph models are supported\n");
+    return 1;
+  }
+
+  /* a previous plan is ignored, the tensors are re-planned from scratch */
+  std::vector<int> tensors, sizes, aliases;
+  if (!planned_tensors(model, &tensors, &sizes, &aliases)) {
+    fprintf(stderr, "E: unsupported tensor type\n");
+    return 1;
+  }
+
+  std::vector<BufferRequirement> bufs;
+  size_t runtime_size = 0;
+  if (!capture_requirements(data.data(), &bufs, &runtime_size, nullptr)) {
+    fprintf(stderr, "E: AllocateTensors() fails\n");
+    return 1;
+  }
+  const int n_tensors = (int)tensors.size();
+  if ((int)bufs.size() < n_tensors) {
+    fprintf(stderr, "E: unexpected number of planned buffers\n");
+    return 1;
+  }
+  for (int i = 0; i < n_tensors; i++) {
+    if (bufs[i].size != sizes[i]) {
+      fprintf(stderr, "E: unexpected size for tensor %d\n", tensors[i]);
+      return 1;
+    }
+  }
+
+  Layout layout(bufs, n_tensors);
+  const int greedy_size = layout.greedy();
+  const int bound = layout.lower_bound();
+  SearchResult res = search(layout, bufs, n_tensors, bound, iterations, seed);
+
+  printf("model              : %s\n", paths[0]);
+  printf("planned tensors    : %d / %d (+%d scratch buffer(s))\n", n_tensors,
+      (int)model->subgraphs()->Get(0)->tensors()->size(), (int)bufs.size() - n_tensors);
+  printf("aliased tensors    : %d (outputs of shape-only operators)\n",
+      (int)std::count_if(aliases.begin(), aliases.end(), [](int a) { return a >= 0; }));
+  printf("lower bound        : %d bytes\n", bound);
+  printf("greedy plan        : %d bytes\n", greedy_size);
+  printf("offline plan       : %d bytes (%s, %ld orders)\n", res.size,
+      res.exhaustive ? "exhaustive" : "local search", res.evaluated + 1);
+
+  if (greedy_size != (int)runtime_size && bufs[0].offline_offset == tflite::kOnlinePlannedBuffer)
+    printf("W: greedy replay differs from the runtime plan (%d bytes)\n", (int)runtime_size);
+
+  std::vector<uint8_t> out;
+  if (res.size > greedy_size) {
+    /* scratch buffers placed after the offline plan do not fit, keep the model as-is */
+    printf("offline plan larger than the greedy plan, model not updated\n");
+    out = data;
+  } else {
+    std::vector<int> offsets;
+    layout.place(res.order, &offsets);
+    std::vector<int32_t> plan;
+    const int32_t nb_tensors = (int32_t)model->subgraphs()->Get(0)->tensors()->size();
+    plan.push_back(1);  // version
+    plan.push_back(0);  // subgraph
+    plan.push_back(nb_tensors);
+    plan.resize(3 + nb_tensors, tflite::kOnlinePlannedBuffer);
+    for (int i = 0; i < n_tensors; i++)
+      plan[3 + tensors[i]] = offsets[i];
+    for (size_t i = 0; i < aliases.size(); i++) {
+      if (aliases[i] >= 0)
+        plan[3 + i] = plan[3 + aliases[i]];
+    }
+    out = add_plan_metadata(data.data(), plan);
+
+    /* check the result with the runtime */
+    std::vector<BufferRequirement> check;
+    std::vector<int> check_offsets;
+    size_t check_size = 0;
+    if (!capture_requirements(out.data(), &check, &check_size, &check_offsets)) {
+      fprintf(stderr, "E: AllocateTensors() fails with the offline plan\n");
+      return 1;
+    }
+    if ((int)check_size != res.size || !check_no_overlap(check, check_offsets)) {
+      fprintf(stderr, "E: invalid offline plan (runtime size %d bytes)\n", (int)check_size);
+      return 1;
+    }
+    printf("runtime check      : %d bytes, no overlap\n", (int)check_size);
+  }
+
+  if (!tflm_host::save_file(paths[1], out.data(), out.size())) {
+    fprintf(stderr, "E: unable to write %s\n", paths[1]);
+    return 1;
+  }
+  printf("output             : %s (%d bytes)\n", paths[1], (int)out.size());
+  return 0;
+}
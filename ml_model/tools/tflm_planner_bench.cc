@@ -0,0 +1,254 @@
+/**
+ ******************************************************************************
+ * @file    tflm_planner_bench.cc
+ * @brief   Host comparison of the memory planners of the tensor arena
+ ******************************************************************************
+ *
+ * usage: tflm_planner_bench [-n runs] [-g] [-r] [<model.tflite> ..]
+ *
+ * The buffer requirements of each model (tensors and scratch buffers, as
+ * provided by the MicroAllocator) are recorded and replayed with:
+ * - greedy:   tflite::GreedyMemoryPlanner (TFLM_C_PLANNER_GREEDY),
+ * - best-fit: tflite::BestFitMemoryPlanner (TFLM_C_PLANNER_BEST_FIT),
+ * - search:   best-fit, TFLM_C_PLANNER_ORDERINGS placement orders
+ *             (TFLM_C_PLANNER_SEARCH).
+ * For each planner, the size of the plan and the median duration of the
+ * planning step are reported (+%: plan smaller than the greedy one), the plans
+ * are checked (no overlapping buffers).
+ * Each model is also created with tflm_c_create_with_planner(): arena used
+ * bytes and outputs (random inputs) identical to the greedy planner.
+ *
+ * Corpus:
+ * - -g: int8 models generated with the layers of the selected_model variants
+ *   of train_mnist_model.py (random weights, the plan depends only on the
+ *   graph). Variant 3 (MaxPooling3D) has no TFLM operator, it is skipped.
+ * - -r: random requirement sets (64, 256, 1024 buffers), planners only, to
+ *   show how the planning time scales with the number of buffers.
+ *
+ * Exit code 1 if a plan is not valid, if a search plan is larger than the
+ * best-fit plan or if the outputs differ.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/memory_planner/best_fit_memory_planner.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "tflm_c.h"
+#include "tflm_host_utils.h"
+#include "tflm_model_builder.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+constexpr int kPlanners = 3;
+const char* const kPlannerNames[kPlanners] = {"greedy", "best-fit", "search"};
+
+/* -----------------------------------------------------------------------------
+ *  Replay of the requirements
+ * -----------------------------------------------------------------------------
+ */
+
+struct Plan {
+  size_t size;
+  double us;   /* median */
+  bool valid;
+};
+
+/* plan of the requirements with the planner kind (TFLM_C_PLANNER_xx) */
+Plan plan(const std::vector<tflm_host::BufferRequirement>& reqs, uint32_t kind, int runs)
+{
+  const size_t per_buffer = std::max(tflite::GreedyMemoryPlanner::per_buffer_size(),
+      tflite::BestFitMemoryPlanner::per_buffer_size());
+  std::vector<uint8_t> scratch(per_buffer * reqs.size() + 16);
+  std::vector<double> t;
+  Plan res = {0, 0.0, true};
+  for (int i = 0; i < runs; i++) {
+    tflite::GreedyMemoryPlanner greedy;
+    tflite::BestFitMemoryPlanner best_fit(
+        (kind == TFLM_C_PLANNER_SEARCH) ? TFLM_C_PLANNER_ORDERINGS : 1);
+    tflite::MicroMemoryPlanner* planner = (kind == TFLM_C_PLANNER_GREEDY)
+        ? (tflite::MicroMemoryPlanner*)&greedy : (tflite::MicroMemoryPlanner*)&best_fit;
+    double t0 = tflm_host::now_us();
+    planner->Init(scratch.data(), (int)scratch.size());
+    for (const auto& r : reqs) {
+      if (r.offline_offset == tflite::kOnlinePlannedBuffer)
+        planner->AddBuffer(r.size, r.first, r.last);
+      else
+        planner->AddBuffer(r.size, r.first, r.last, r.offline_offset);
+    }
+    res.size = planner->GetMaximumMemorySize();
+    t.push_back(tflm_host::now_us() - t0);
+    if (i)
+      continue;
+    res.valid = (kind == TFLM_C_PLANNER_GREEDY) ? !greedy.DoAnyBuffersOverlap()
+        : !best_fit.DoAnyBuffersOverlap();
+    for (size_t b = 0; b < reqs.size() && res.valid; b++) {
+      int offset;
+      res.valid = planner->GetOffsetForBuffer((int)b, &offset) == kTfLiteOk &&
+          offset >= 0 && (size_t)(offset + reqs[b].size) <= res.size;
+    }
+  }
+  std::sort(t.begin(), t.end());
+  res.us = t[t.size() / 2];
+  return res;
+}
+
+bool report_plans(const std::vector<tflm_host::BufferRequirement>& reqs, int runs)
+{
+  Plan plans[kPlanners];
+  bool ok = true;
+  for (uint32_t k = 0; k < kPlanners; k++) {
+    plans[k] = plan(reqs, k, runs);
+    ok &= plans[k].valid;
+  }
+  /* the first order of the search is the best-fit one */
+  ok &= plans[TFLM_C_PLANNER_SEARCH].size <= plans[TFLM_C_PLANNER_BEST_FIT].size;
+  for (int k = 0; k < kPlanners; k++) {
+    const double gain = 100.0 * ((double)plans[0].size - (double)plans[k].size) / plans[0].size;
+    printf("  %-16s : plan %8d bytes (%+6.2f%%), planning %9.2f us%s\n", kPlannerNames[k],
+        (int)plans[k].size, gain, plans[k].us, plans[k].valid ? "" : " INVALID");
+  }
+  return ok;
+}
+
+/* -----------------------------------------------------------------------------
+ *  Models
+ * -----------------------------------------------------------------------------
+ */
+
+/* requirements recorded while the tensors are allocated */
+bool record(const std::vector<uint8_t>& data, std::vector<tflm_host::BufferRequirement>* reqs)
+{
+  static tflite::AllOpsResolver resolver;
+  tflm_host::RecordingMemoryPlanner planner;
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(arena, sizeof(arena), &planner);
+  tflite::MicroInterpreter interpreter(tflite::GetModel(data.data()), resolver, allocator);
+  if (interpreter.AllocateTensors() != kTfLiteOk)
+    return false;
+  *reqs = planner.requirements;
+  return true;
+}
+
+/* instance created with the planner, outputs for fixed random inputs */
+bool run(const std::vector<uint8_t>& data, uint32_t kind, int32_t* used,
+    std::vector<uint8_t>* outputs)
+{
+  uint32_t hdl;
+  if (tflm_c_create_with_planner(data.data(), arena, sizeof(arena), kind, &hdl) != kTfLiteOk)
+    return false;
+  *used = tflm_c_arena_used_bytes(hdl);
+  struct tflm_c_tensor_info info;
+  srand(1);
+  for (int i = 0; i < tflm_c_inputs_size(hdl); i++) {
+    tflm_c_input(hdl, i, &info);
+    for (size_t j = 0; j < info.bytes; j++)
+      ((uint8_t*)info.data)[j] = (uint8_t)rand();
+  }
+  bool ok = tflm_c_invoke(hdl) == kTfLiteOk;
+  outputs->clear();
+  for (int i = 0; i < tflm_c_outputs_size(hdl) && ok; i++) {
+    tflm_c_output(hdl, i, &info);
+    outputs->insert(outputs->end(), (uint8_t*)info.data, (uint8_t*)info.data + info.bytes);
+  }
+  tflm_c_destroy(hdl);
+  return ok;
+}
+
+int bench(const std::string& name, const std::vector<uint8_t>& data, int runs)
+{
+  std::vector<tflm_host::BufferRequirement> reqs;
+  if (data.empty() || !record(data, &reqs)) {
+    fprintf(stderr, "E: unable to load %s\n", name.c_str());
+    return 1;
+  }
+  int n_offline = 0;
+  for (const auto& r : reqs)
+    n_offline += r.offline_offset != tflite::kOnlinePlannedBuffer;
+
+  printf("%s\n", name.c_str());
+  printf("  buffers          : %d (%d offline planned)\n", (int)reqs.size(), n_offline);
+  bool ok = report_plans(reqs, runs);
+
+  std::vector<uint8_t> ref, outputs;
+  printf("  arena used       :");
+  for (uint32_t k = 0; k < kPlanners; k++) {
+    int32_t used = 0;
+    const bool res = run(data, k, &used, k ? &outputs : &ref);
+    ok &= res && (!k || outputs == ref);
+    printf(" %s %d%s", kPlannerNames[k], (int)used, (res && (!k || outputs == ref)) ? "" : " FAILED");
+  }
+  printf(" bytes (host)\n");
+  return ok ? 0 : 1;
+}
+
+/* random requirement set, lifetimes of 1 to 8 steps */
+std::vector<tflm_host::BufferRequirement> random_requirements(int n)
+{
+  std::vector<tflm_host::BufferRequirement> reqs(n);
+  srand(n);
+  for (auto& r : reqs) {
+    r.size = 16 * (1 + rand() % 256);
+    r.first = rand() % (n / 2);
+    r.last = r.first + rand() % 8;
+    r.offline_offset = tflite::kOnlinePlannedBuffer;
+  }
+  return reqs;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 100;
+  bool generated = false;
+  bool random_sets = false;
+  std::vector<const char*> paths;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-g"))
+      generated = true;
+    else if (!strcmp(argv[i], "-r"))
+      random_sets = true;
+    else if (argv[i][0] != '-')
+      paths.push_back(argv[i]);
+    else {
+      paths.clear();
+      generated = random_sets = false;
+      break;
+    }
+  }
+  if (paths.empty() && !generated && !random_sets) {
+    fprintf(stderr, "usage: %s [-n runs] [-g] [-r] [<model.tflite> ..]\n", argv[0]);
+    return 2;
+  }
+
+  printf("search             : %d placement orders\n\n", TFLM_C_PLANNER_ORDERINGS);
+  int res = 0;
+  for (const char* path : paths)
+    res |= bench(path, tflm_host::load_file(path), runs);
+  for (int v = 0; v < 5 && generated; v++) {
+    const std::string name = "selected_model " + std::to_string(v) + " (generated)";
+    std::vector<uint8_t> data = tflm_host::generate_mnist_model(v);
+    if (data.empty()) {
+      printf("%s\n  skipped          : MaxPooling3D has no TFLM operator\n", name.c_str());
+      continue;
+    }
+    res |= bench(name, data, runs);
+  }
+  for (int n = 64; n <= 1024 && random_sets; n *= 4) {
+    printf("random set (%d buffers)\n", n);
+    res |= report_plans(random_requirements(n), std::max(1, runs / 10)) ? 0 : 1;
+  }
+  return res;
+}
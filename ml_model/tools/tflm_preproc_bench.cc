@@ -0,0 +1,294 @@
+/**
+ ******************************************************************************
+ * @file    tflm_preproc_bench.cc
+ * @brief   Host benchmark/check of the image pre-processing (tflm_preproc.c)
+ ******************************************************************************
+ *
+ * usage: tflm_preproc_bench [-n runs] [-s frame_size] <model.tflite>
+ *
+ * A digit is drawn (anti-aliased strokes) on a frame_size x frame_size
+ * frame (240 by default, touch screen of the board). For each kernel,
+ * reports the median time per frame in us and in host cycles (TSC on x86),
+ * and checks the int8 values against a float reference (two passes: float
+ * image, then quantization), max difference 1. The MNIST pipeline writes
+ * in the input tensor of the model which is then invoked.
+ * Exit code 1 if a check fails.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+#include "tflm_preproc.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+inline uint64_t cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+struct Timing {
+  double us;
+  double cycles;
+};
+
+template <typename F>
+Timing measure(int runs, F f)
+{
+  std::vector<double> t, c;
+  for (int r = 0; r < runs; r++) {
+    const double t0 = tflm_host::now_us();
+    const uint64_t c0 = cycles();
+    f();
+    c.push_back((double)(cycles() - c0));
+    t.push_back(tflm_host::now_us() - t0);
+  }
+  std::sort(t.begin(), t.end());
+  std::sort(c.begin(), c.end());
+  return {t[t.size() / 2], c[c.size() / 2]};
+}
+
+/* stroke of width w from (x0, y0) to (x1, y1), anti-aliased */
+void draw_line(std::vector<uint8_t>& img, int size, float x0, float y0, float x1, float y1,
+    float w)
+{
+  const float dx = x1 - x0, dy = y1 - y0;
+  const float len2 = dx * dx + dy * dy;
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      float t = ((x - x0) * dx + (y - y0) * dy) / len2;
+      t = t < 0 ? 0 : (t > 1 ? 1 : t);
+      const float d = hypotf(x - (x0 + t * dx), y - (y0 + t * dy));
+      const float v = std::min(1.0f, std::max(0.0f, w / 2 + 0.5f - d)) * 255.0f;
+      img[y * size + x] = std::max(img[y * size + x], (uint8_t)v);
+    }
+  }
+}
+
+/* float reference of tflm_pp_resize_quantize() */
+std::vector<int8_t> reference(const tflm_pp_image& img, const tflm_pp_rect& sr,
+    const tflm_pp_rect& dr, int dst_w, int dst_h, float pixel_scale, float scale, int zp,
+    int invert)
+{
+  std::vector<float> real(dst_w * dst_h, (float)(invert ? 255 : 0));
+  const bool area = (sr.width >= 2 * dr.width) || (sr.height >= 2 * dr.height);
+  for (int i = 0; i < dr.height; i++) {
+    for (int j = 0; j < dr.width; j++) {
+      float v = 0;
+      if (area) {
+        const int x0 = sr.x + j * sr.width / dr.width;
+        const int x1 = std::max(x0 + 1, sr.x + (j + 1) * sr.width / dr.width);
+        const int y0 = sr.y + i * sr.height / dr.height;
+        const int y1 = std::max(y0 + 1, sr.y + (i + 1) * sr.height / dr.height);
+        for (int y = y0; y < y1; y++)
+          for (int x = x0; x < x1; x++)
+            v += img.data[y * img.stride + x];
+        v /= (float)((x1 - x0) * (y1 - y0));
+      } else {
+        const float fx = std::min(std::max((j + 0.5f) * sr.width / dr.width - 0.5f, 0.0f),
+            (float)(sr.width - 1));
+        const float fy = std::min(std::max((i + 0.5f) * sr.height / dr.height - 0.5f, 0.0f),
+            (float)(sr.height - 1));
+        const int x0 = (int)fx, y0 = (int)fy;
+        const int x1 = std::min(x0 + 1, sr.width - 1), y1 = std::min(y0 + 1, sr.height - 1);
+        auto p = [&](int x, int y) { return (float)img.data[(sr.y + y) * img.stride + sr.x + x]; };
+        const float ax = fx - x0, ay = fy - y0;
+        v = (p(x0, y0) * (1 - ax) + p(x1, y0) * ax) * (1 - ay) +
+            (p(x0, y1) * (1 - ax) + p(x1, y1) * ax) * ay;
+      }
+      real[(dr.y + i) * dst_w + dr.x + j] = v;
+    }
+  }
+  std::vector<int8_t> out(real.size());
+  for (size_t k = 0; k < real.size(); k++) {
+    const float v = invert ? 255.0f - real[k] : real[k];
+    const long q = lroundf(v * pixel_scale / scale) + zp;
+    out[k] = (int8_t)std::min(127L, std::max(-128L, q));
+  }
+  return out;
+}
+
+int max_diff(const int8_t* a, const std::vector<int8_t>& b)
+{
+  int d = 0;
+  for (size_t k = 0; k < b.size(); k++)
+    d = std::max(d, abs((int)a[k] - (int)b[k]));
+  return d;
+}
+
+int failures = 0;
+
+void report(const char* name, const Timing& t, int diff)
+{
+  printf("%-28s: %8.2f us %10.0f cycles  max diff %d%s\n", name, t.us, t.cycles, diff,
+      diff > 1 ? "  FAILED" : "");
+  failures += diff > 1;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 200;
+  int size = 240;
+  const char* path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      size = atoi(argv[++i]);
+    else if (!path && argv[i][0] != '-')
+      path = argv[i];
+    else {
+      path = nullptr;
+      break;
+    }
+  }
+  if (!path || runs < 1 || size < 32 || size > 1024) {
+    fprintf(stderr, "usage: %s [-n runs] [-s frame_size] <model.tflite>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(path);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", path);
+    return 1;
+  }
+  uint32_t hdl;
+  if (tflm_c_create(data.data(), arena, sizeof(arena), &hdl) != kTfLiteOk) {
+    fprintf(stderr, "E: tflm_c_create() fails\n");
+    return 1;
+  }
+  struct tflm_c_tensor_info info;
+  tflm_c_input(hdl, 0, &info);
+  if ((info.type != kTfLiteInt8) || (info.channels != 1)) {
+    fprintf(stderr, "E: int8 single channel input expected\n");
+    return 1;
+  }
+  const int dst_w = info.width, dst_h = info.height;
+  int8_t* tensor = (int8_t*)info.data;
+
+  /* digit "7", anti-aliased strokes */
+  std::vector<uint8_t> frame(size * size, 0);
+  const float s = size / 240.0f;
+  draw_line(frame, size, 70 * s, 50 * s, 170 * s, 50 * s, 18 * s);
+  draw_line(frame, size, 170 * s, 50 * s, 110 * s, 200 * s, 18 * s);
+  std::vector<uint8_t> inverted(frame.size());
+  for (size_t k = 0; k < frame.size(); k++)
+    inverted[k] = 255 - frame[k];
+  const tflm_pp_image img = {frame.data(), (uint16_t)size, (uint16_t)size, (uint16_t)size};
+  const tflm_pp_image img_inv = {inverted.data(), (uint16_t)size, (uint16_t)size,
+      (uint16_t)size};
+
+  const float pixel_scale = 1.0f / 255.0f;
+  tflm_pp_quant q, q_inv, q_lut;
+  tflm_pp_quant_init(&q, pixel_scale, info.scale, info.zero_point, 0);
+  tflm_pp_quant_init(&q_inv, pixel_scale, info.scale, info.zero_point, 1);
+  tflm_pp_quant_init(&q_lut, pixel_scale, info.scale * 1.5f, info.zero_point + 3, 0);
+
+  printf("model              : %s\n", path);
+  printf("input              : %dx%d int8, scale=%f zp=%d (%s)\n", dst_w, dst_h,
+      (double)info.scale, (int)info.zero_point, q.xor_mask ? "xor" : "lut");
+  printf("frame              : %dx%d\n", size, size);
+
+  std::vector<int8_t> out(dst_w * dst_h);
+  const tflm_pp_rect full_dst = {0, 0, (uint16_t)dst_w, (uint16_t)dst_h};
+
+  /* 1 - quantization only, image already at the size of the tensor */
+  {
+    std::vector<uint8_t> src(dst_w * dst_h);
+    for (int y = 0; y < dst_h; y++)
+      memcpy(&src[y * dst_w], &frame[(y + 60) * size + 100], dst_w);
+    const tflm_pp_image packed = {src.data(), (uint16_t)dst_w, (uint16_t)dst_h,
+        (uint16_t)dst_w};
+    Timing t = measure(runs, [&] { tflm_pp_quantize(&q, src.data(), tensor, src.size()); });
+    report("quantize (xor)", t, max_diff(tensor,
+        reference(packed, full_dst, full_dst, dst_w, dst_h, pixel_scale, info.scale,
+            info.zero_point, 0)));
+    t = measure(runs, [&] { tflm_pp_quantize(&q_lut, src.data(), out.data(), src.size()); });
+    report("quantize (lut)", t, max_diff(out.data(),
+        reference(packed, full_dst, full_dst, dst_w, dst_h, pixel_scale, info.scale * 1.5f,
+            info.zero_point + 3, 0)));
+  }
+
+  /* 2 - full frame resized to the tensor (area averaging) */
+  {
+    const tflm_pp_rect sr = {0, 0, (uint16_t)size, (uint16_t)size};
+    Timing t = measure(runs, [&] {
+      tflm_pp_resize_quantize(&q, &img, &sr, tensor, dst_w, dst_h, &full_dst);
+    });
+    report("resize (area) + quantize", t, max_diff(tensor,
+        reference(img, sr, full_dst, dst_w, dst_h, pixel_scale, info.scale, info.zero_point, 0)));
+  }
+
+  /* 3 - small crop enlarged (bilinear) */
+  {
+    const tflm_pp_rect sr = {90, 90, (uint16_t)(dst_w * 3 / 4), (uint16_t)(dst_h * 3 / 4)};
+    Timing t = measure(runs, [&] {
+      tflm_pp_resize_quantize(&q, &img, &sr, tensor, dst_w, dst_h, &full_dst);
+    });
+    report("resize (bilinear) + quant.", t, max_diff(tensor,
+        reference(img, sr, full_dst, dst_w, dst_h, pixel_scale, info.scale, info.zero_point, 0)));
+  }
+
+  /* 4 - MNIST pipeline: bounding box, centered in 20x20, quantized */
+  for (int invert = 0; invert < 2; invert++) {
+    const tflm_pp_image* src = invert ? &img_inv : &img;
+    const tflm_pp_quant* qq = invert ? &q_inv : &q;
+    tflm_pp_rect box, dr;
+    if (tflm_pp_bounding_box(src, qq, 32, &box) != 0) {
+      fprintf(stderr, "E: digit not found\n");
+      return 1;
+    }
+    tflm_pp_center(&box, dst_w, dst_h, 20, &dr);
+    Timing t = measure(runs, [&] { tflm_pp_mnist(qq, src, 32, tensor, dst_w, dst_h, 20); });
+    report(invert ? "mnist (inverted)" : "mnist", t, max_diff(tensor,
+        reference(*src, box, dr, dst_w, dst_h, pixel_scale, info.scale, info.zero_point,
+            invert)));
+  }
+
+  /* 5 - float reference of the MNIST pipeline, for comparison */
+  {
+    tflm_pp_rect box, dr;
+    tflm_pp_bounding_box(&img, &q, 32, &box);
+    tflm_pp_center(&box, dst_w, dst_h, 20, &dr);
+    std::vector<int8_t> ref;
+    Timing t = measure(runs, [&] {
+      ref = reference(img, box, dr, dst_w, dst_h, pixel_scale, info.scale, info.zero_point, 0);
+    });
+    printf("%-28s: %8.2f us %10.0f cycles\n", "mnist (float reference)", t.us, t.cycles);
+  }
+
+  /* the tensor holds the pre-processed digit */
+  tflm_pp_mnist(&q, &img, 32, tensor, dst_w, dst_h, 20);
+  if (tflm_c_invoke(hdl) != kTfLiteOk) {
+    fprintf(stderr, "E: tflm_c_invoke() fails\n");
+    return 1;
+  }
+  struct tflm_c_tensor_info out_info;
+  tflm_c_output(hdl, 0, &out_info);
+  int best = 0;
+  for (uint32_t k = 1; k < out_info.bytes; k++)
+    best = ((int8_t*)out_info.data)[k] > ((int8_t*)out_info.data)[best] ? k : best;
+  printf("prediction         : %d\n", best);
+
+  tflm_c_destroy(hdl);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+/**
+ ******************************************************************************
+ * @file    tflm_profiler_bench.cc
+ * @brief   Host check and cost of the ring-buffer profiler (MicroRingProfiler)
+ ******************************************************************************
+ *
+ * usage: tflm_profiler_bench [-n runs] [<model.tflite> ..]
+ *
+ * For the given models and a generated chain of 256 RELU operators
+ * (tflm_model_builder.h), the interpreter is created with a
+ * MicroRingProfiler<64> (ns ticks):
+ *
+ *  - drained after each inference (Drain() in a memory sink, as over the
+ *    UART): one event per operator, indexes 0..n-1, sum of the durations
+ *    within the duration of the inference, no dropped event (models with 64
+ *    operators at most).
+ *  - not drained: the buffer keeps the 64 last events, the others are
+ *    counted as dropped, the indexes stay in sequence.
+ *
+ * The median inference time without profiler and with the profiler (drained
+ * after each inference, drain not timed) gives the cost per operator. The
+ * memory of the profiler is compared to MicroProfiler built with
+ * TF_LITE_PROFILER_WITH_BUFFER (32-bit target).
+ *
+ * Exit code 1 if a check fails.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_ring_profiler.h"
+
+#include "tflm_host_utils.h"
+#include "tflm_model_builder.h"
+
+namespace {
+
+constexpr uint32_t kCapacity = 64;
+typedef tflite::MicroRingProfiler<kCapacity> RingProfiler;
+
+/* MicroProfiler with TF_LITE_PROFILER_WITH_BUFFER on a 32-bit target:
+ * kMaxEvents x (tag, start, end) + kMaxEvents x TicksPerTag */
+constexpr size_t kMicroProfilerBytes = 4096 * (4 + 4 + 4) + 4096 * (4 + 4);
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+std::vector<uint8_t> sink;  /* drained records */
+
+int write_sink(const void* data, uint16_t count)
+{
+  sink.insert(sink.end(), (const uint8_t*)data, (const uint8_t*)data + count);
+  return count;
+}
+
+uint32_t host_ticks()
+{
+  return (uint32_t)(uint64_t)(tflm_host::now_us() * 1000.0);
+}
+
+void fill_inputs(tflite::MicroInterpreter& interpreter)
+{
+  srand(1);
+  for (size_t i = 0; i < interpreter.inputs_size(); i++) {
+    TfLiteTensor* t = interpreter.input(i);
+    for (size_t j = 0; j < t->bytes; j++)
+      t->data.uint8[j] = (uint8_t)rand();
+  }
+}
+
+/* median duration of Invoke() (us), the profiler drained after each one */
+double median_invoke(tflite::MicroInterpreter& interpreter, RingProfiler* profiler, int runs)
+{
+  std::vector<double> t;
+  for (int i = 0; i < runs; i++) {
+    if (profiler)
+      profiler->StartInference();
+    double t0 = tflm_host::now_us();
+    if (interpreter.Invoke() != kTfLiteOk)
+      return -1.0;
+    t.push_back(tflm_host::now_us() - t0);
+    if (profiler) {
+      sink.clear();
+      profiler->Drain(write_sink);
+    }
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+/* one inference drained: one event per operator */
+bool check_drained(tflite::MicroInterpreter& interpreter, RingProfiler& profiler, uint32_t n_ops)
+{
+  profiler.ClearEvents();
+  profiler.StartInference();
+  const double t0 = tflm_host::now_us();
+  if (interpreter.Invoke() != kTfLiteOk)
+    return false;
+  const double us = tflm_host::now_us() - t0;
+  sink.clear();
+  const uint32_t drained = profiler.Drain(write_sink);
+  if (n_ops > kCapacity)
+    return drained == kCapacity && profiler.Dropped() == n_ops - kCapacity;
+
+  const RingProfiler::Event* events = (const RingProfiler::Event*)sink.data();
+  uint64_t ticks = 0;
+  bool ok = drained == n_ops && sink.size() == n_ops * sizeof(RingProfiler::Event) &&
+      profiler.Size() == 0 && profiler.Dropped() == 0;
+  for (uint32_t i = 0; i < drained && ok; i++) {
+    ok = events[i].op == i;
+    ticks += events[i].ticks;
+  }
+  return ok && ticks <= (uint64_t)(us * 1000.0) + 1000;
+}
+
+/* inferences not drained: the last kCapacity events are kept */
+bool check_overwrite(tflite::MicroInterpreter& interpreter, RingProfiler& profiler, uint32_t n_ops)
+{
+  const int runs = (int)(2 * kCapacity / n_ops) + 2;
+  profiler.ClearEvents();
+  for (int i = 0; i < runs; i++) {
+    profiler.StartInference();
+    if (interpreter.Invoke() != kTfLiteOk)
+      return false;
+  }
+  const uint32_t total = runs * n_ops;
+  if (profiler.Size() != kCapacity || profiler.Dropped() != total - kCapacity)
+    return false;
+  RingProfiler::Event event;
+  uint32_t expected = (total - kCapacity) % n_ops;
+  while (profiler.ReadEvent(&event)) {
+    if (event.op != expected)
+      return false;
+    expected = (expected + 1) % n_ops;
+  }
+  return profiler.Size() == 0;
+}
+
+int bench(const std::string& name, const std::vector<uint8_t>& data, int runs)
+{
+  static tflite::AllOpsResolver resolver;
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to load %s\n", name.c_str());
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(data.data());
+  RingProfiler profiler(host_ticks);
+  tflite::MicroInterpreter interpreter(model, resolver, arena, sizeof(arena));
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    fprintf(stderr, "E: unable to create %s\n", name.c_str());
+    return 1;
+  }
+  fill_inputs(interpreter);
+  const uint32_t n_ops = model->subgraphs()->Get(0)->operators()->size();
+
+  median_invoke(interpreter, nullptr, runs / 10 + 1);  /* warm-up */
+  const double plain = median_invoke(interpreter, nullptr, runs);
+  interpreter.SetProfiler(&profiler);
+  const double profiled = median_invoke(interpreter, &profiler, runs);
+  const bool drained = check_drained(interpreter, profiler, n_ops);
+  const bool overwrite = check_overwrite(interpreter, profiler, n_ops);
+  if (plain < 0.0 || profiled < 0.0) {
+    fprintf(stderr, "E: %s fails\n", name.c_str());
+    return 1;
+  }
+
+  printf("%s (%d ops)\n", name.c_str(), (int)n_ops);
+  printf("  invoke           : %.2f us -> %.2f us with the profiler (%+.1f ns/op)\n", plain,
+      profiled, 1000.0 * (profiled - plain) / n_ops);
+  printf("  drained events   : %s\n", drained ? "ok" : "FAILED");
+  printf("  overwritten      : %s\n", overwrite ? "ok" : "FAILED");
+  return (drained && overwrite) ? 0 : 1;
+}
+
+/* n RELU operators on a 1x1x1x8 int8 tensor */
+std::vector<uint8_t> generate_chain(int n)
+{
+  tflm_host::ModelBuilder b;
+  int32_t x = b.input({1, 1, 1, 8}, 0.1f, 0);
+  for (int i = 0; i < n; i++)
+    x = b.relu(x);
+  b.output(x);
+  return b.pack();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 1000;
+  std::vector<const char*> paths;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (argv[i][0] != '-')
+      paths.push_back(argv[i]);
+    else {
+      fprintf(stderr, "usage: %s [-n runs] [<model.tflite> ..]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  printf("profiler memory (events)\n");
+  printf("  MicroProfiler    : %d bytes (TF_LITE_PROFILER_WITH_BUFFER, 32-bit target)\n",
+      (int)kMicroProfilerBytes);
+  printf("  ring, 64 x u32   : %d bytes\n",
+      (int)(64 * sizeof(tflite::MicroRingProfiler<64, uint32_t>::Event)));
+  printf("  ring, 256 x u16  : %d bytes\n",
+      (int)(256 * sizeof(tflite::MicroRingProfiler<256, uint16_t>::Event)));
+
+  int res = 0;
+  for (const char* path : paths)
+    res |= bench(path, tflm_host::load_file(path), runs);
+  res |= bench("RELU chain (generated)", generate_chain(256), runs);
+  return res;
+}
@@ -0,0 +1,325 @@
+/**
+ ******************************************************************************
+ * @file    tflm_quantize_int4.cc
+ * @brief   Host re-quantization of the model weights to packed int4
+ ******************************************************************************
+ *
+ * usage: tflm_quantize_int4 <model.tflite> <output.tflite> [-n runs]
+ *
+ * The int8 filters of the CONV_2D and FULLY_CONNECTED operators with int8
+ * inputs are re-quantized to int4 (symmetric, [-7, 7]), per output channel
+ * for CONV_2D, per tensor for FULLY_CONNECTED (the kernel only applies the
+ * first scale of the filter, one ratio keeps the scales consistent with it):
+ *
+ *   r[c]      = max(|w[c]|) / 7       (over the tensor for FULLY_CONNECTED)
+ *   scale'[c] = scale[c] * r[c]
+ *   w'        = round(w / r[c])
+ *   bias'[c]  = round(bias[c] / r[c])
+ *
+ * and stored as TensorType_INT4 (two values per byte, low nibble first),
+ * read packed by arm_convolve_s4()/arm_fully_connected_s4(). A filter is
+ * only converted if it is not compressed (run it before tflm_compress) and
+ * not shared with another tensor/operator.
+ *
+ * Three models are run with the host TFLM runtime with the same inputs
+ * (random strokes on a dark background, a uniform noise saturates the
+ * classifier):
+ *  - the original int8 model,
+ *  - the int4 model,
+ *  - the int4 values stored as int8 (same scales): its outputs must be
+ *    identical to the int4 ones (the packed kernels are exact).
+ * The weight/model sizes, the output difference and the top-1 agreement of
+ * the int4 model with the int8 one, and the invoke durations are reported.
+ * The accuracy over the MNIST test set is given by tflm_mnist_eval run on the
+ * output model. Exit code 1 if the int4 outputs differ from the int8 ones of
+ * the same values.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "tensorflow/lite/micro/kernels/weight_compression.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+constexpr int kSamples = 32;
+constexpr int kInt4Max = 7;
+
+tflite::BuiltinOperator op_code(const tflite::ModelT& model, const tflite::OperatorT& op)
+{
+  const tflite::OperatorCodeT& code = *model.operator_codes[op.opcode_index];
+  return std::max(code.builtin_code, (tflite::BuiltinOperator)code.deprecated_builtin_code);
+}
+
+/* number of operator inputs referencing the tensor */
+int tensor_uses(const tflite::SubGraphT& sg, int tensor)
+{
+  int uses = 0;
+  for (const auto& op : sg.operators)
+    uses += (int)std::count(op->inputs.begin(), op->inputs.end(), tensor);
+  return uses;
+}
+
+int buffer_uses(const tflite::ModelT& model, uint32_t buffer)
+{
+  int uses = 0;
+  for (const auto& s : model.subgraphs)
+    for (const auto& t : s->tensors)
+      uses += t->buffer == buffer;
+  return uses;
+}
+
+struct Converted {
+  std::string name;
+  size_t bytes_int8;
+  size_t bytes_int4;
+  int groups;
+};
+
+/* Re-quantizes the filter (and bias) of the operator, the values are stored
+ * one per byte (int8 tensors) if !pack. Returns false if the operator is
+ * skipped. */
+bool quantize_op(tflite::ModelT* model, const tflite::OperatorT& op, bool pack, Converted* info)
+{
+  tflite::SubGraphT& sg = *model->subgraphs[0];
+  const tflite::BuiltinOperator code = op_code(*model, op);
+  if ((code != tflite::BuiltinOperator_CONV_2D &&
+       code != tflite::BuiltinOperator_FULLY_CONNECTED) || op.inputs.size() < 2)
+    return false;
+  if (sg.tensors[op.inputs[0]]->type != tflite::TensorType_INT8)
+    return false;
+
+  tflite::TensorT& filter = *sg.tensors[op.inputs[1]];
+  std::vector<uint8_t>& w = model->buffers[filter.buffer]->data;
+  if (filter.type != tflite::TensorType_INT8 || w.empty() || !filter.quantization ||
+      filter.quantization->scale.empty() || tensor_uses(sg, op.inputs[1]) != 1 ||
+      buffer_uses(*model, filter.buffer) != 1)
+    return false;
+  size_t n_w = 1;
+  for (int d : filter.shape)
+    n_w *= (size_t)d;
+  if (w.size() != n_w || tflite::micro::IsCompressedWeights(w.data(), w.size(), n_w))
+    return false;
+
+  tflite::TensorT* bias = nullptr;
+  if (op.inputs.size() > 2 && op.inputs[2] >= 0) {
+    bias = sg.tensors[op.inputs[2]].get();
+    if (bias->type != tflite::TensorType_INT32 ||
+        model->buffers[bias->buffer]->data.empty() || tensor_uses(sg, op.inputs[2]) != 1 ||
+        buffer_uses(*model, bias->buffer) != 1)
+      return false;
+  }
+
+  /* output channels: first dimension, one scale per channel or per tensor */
+  std::vector<float>& scale = filter.quantization->scale;
+  const size_t n_out = (size_t)filter.shape[0];
+  if (n_out == 0 || n_w % n_out || (scale.size() != 1 && scale.size() != n_out))
+    return false;
+  const size_t n_groups =
+      code == tflite::BuiltinOperator_CONV_2D && scale.size() == n_out ? n_out : 1;
+  const size_t group_size = n_w / n_groups;
+
+  std::vector<double> ratio(n_groups);
+  std::vector<int8_t> q(n_w);
+  for (size_t g = 0; g < n_groups; g++) {
+    int max_abs = 0;
+    for (size_t k = g * group_size; k < (g + 1) * group_size; k++)
+      max_abs = std::max(max_abs, abs((int8_t)w[k]));
+    ratio[g] = max_abs ? (double)max_abs / kInt4Max : 1.0;
+    for (size_t k = g * group_size; k < (g + 1) * group_size; k++)
+      q[k] = (int8_t)std::min(kInt4Max, std::max(-kInt4Max, (int)lround((int8_t)w[k] / ratio[g])));
+  }
+
+  if (bias) {
+    std::vector<uint8_t>& b = model->buffers[bias->buffer]->data;
+    for (size_t c = 0; c < b.size() / sizeof(int32_t); c++) {
+      int32_t v;
+      memcpy(&v, &b[c * sizeof(v)], sizeof(v));
+      const double rescaled = v / ratio[n_groups == 1 ? 0 : c];
+      if (fabs(rescaled) > 2147483647.0)
+        return false;
+      v = (int32_t)lround(rescaled);
+      memcpy(&b[c * sizeof(v)], &v, sizeof(v));
+    }
+    if (bias->quantization)
+      for (size_t c = 0; c < bias->quantization->scale.size(); c++)
+        bias->quantization->scale[c] *= (float)ratio[n_groups == 1 ? 0 : c];
+  }
+
+  for (size_t c = 0; c < scale.size(); c++)
+    scale[c] *= (float)ratio[n_groups == 1 ? 0 : c];
+  info->name = filter.name;
+  info->bytes_int8 = w.size();
+  info->groups = (int)n_groups;
+  if (pack) {
+    /* TensorType_INT4: element 2i in the low nibble, 2i + 1 in the high one */
+    w.assign((n_w + 1) / 2, 0);
+    for (size_t k = 0; k < n_w; k++)
+      w[k / 2] |= (uint8_t)((q[k] & 0x0F) << ((k & 1) * 4));
+    filter.type = tflite::TensorType_INT4;
+  } else {
+    w.assign(q.begin(), q.end());
+  }
+  info->bytes_int4 = w.size();
+  return true;
+}
+
+std::vector<Converted> quantize(tflite::ModelT* model, bool pack)
+{
+  std::vector<Converted> res;
+  for (const auto& op : model->subgraphs[0]->operators) {
+    Converted info;
+    if (quantize_op(model, *op, pack, &info))
+      res.push_back(info);
+  }
+  return res;
+}
+
+std::vector<uint8_t> pack(const tflite::ModelT& model)
+{
+  /* the TFLM copy of flatbuffers has no implicit default allocator */
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder fbb(16 * 1024, &allocator);
+  tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, &model));
+  return std::vector<uint8_t>(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+/* Runs the model on each input (first input tensor), returns the int8
+ * outputs (first output tensor) and the median invoke duration */
+bool run(const std::vector<uint8_t>& model, const std::vector<std::vector<int8_t>>& inputs,
+    int runs, std::vector<std::vector<int8_t>>* outputs, double* t_invoke)
+{
+  uint32_t hdl;
+  if (tflm_c_create(model.data(), arena, sizeof(arena), &hdl) != kTfLiteOk)
+    return false;
+
+  struct tflm_c_tensor_info in, out;
+  tflm_c_input(hdl, 0, &in);
+  std::vector<double> t;
+  bool ok = true;
+  outputs->clear();
+  for (int r = 0; r < runs && ok; r++) {
+    for (const auto& input : inputs) {
+      memcpy(in.data, input.data(), std::min(in.bytes, input.size()));
+      const double t0 = tflm_host::now_us();
+      ok &= tflm_c_invoke(hdl) == kTfLiteOk;
+      t.push_back(tflm_host::now_us() - t0);
+      if (r == 0) {
+        tflm_c_output(hdl, 0, &out);
+        outputs->emplace_back((int8_t*)out.data, (int8_t*)out.data + out.bytes);
+      }
+    }
+  }
+  std::sort(t.begin(), t.end());
+  *t_invoke = t[t.size() / 2];
+  tflm_c_destroy(hdl);
+  return ok;
+}
+
+int argmax(const std::vector<int8_t>& v)
+{
+  return (int)(std::max_element(v.begin(), v.end()) - v.begin());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 5;
+  const char* paths[2] = {nullptr, nullptr};
+  int n_paths = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (n_paths < 2)
+      paths[n_paths++] = argv[i];
+  }
+  if (n_paths != 2) {
+    fprintf(stderr, "usage: %s <model.tflite> <output.tflite> [-n runs]\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(paths[0]);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", paths[0]);
+    return 1;
+  }
+  std::unique_ptr<tflite::ModelT> model = tflite::UnPackModel(data.data());
+  std::unique_ptr<tflite::ModelT> model_int8 = tflite::UnPackModel(data.data());
+  if (model->subgraphs.size() != 1) {
+    fprintf(stderr, "E: only single subgraph models are supported\n");
+    return 1;
+  }
+
+  const std::vector<Converted> converted = quantize(model.get(), true);
+  quantize(model_int8.get(), false);
+  if (converted.empty()) {
+    fprintf(stderr, "E: no int8 CONV_2D/FULLY_CONNECTED filter to convert\n");
+    return 1;
+  }
+  std::vector<uint8_t> out = pack(*model);
+  std::vector<uint8_t> out_int8 = pack(*model_int8);
+
+  const tflite::SubGraphT& sg = *model->subgraphs[0];
+  const std::vector<int>& in_shape = sg.tensors[sg.inputs[0]]->shape;
+  size_t in_bytes = 1;
+  for (int d : in_shape)
+    in_bytes *= (size_t)d;
+  std::vector<std::vector<int8_t>> inputs(kSamples, std::vector<int8_t>(in_bytes));
+  srand(1);
+  for (auto& input : inputs)
+    tflm_host::draw_strokes(in_shape, &input);
+
+  std::vector<std::vector<int8_t>> ref, res, res_int8;
+  double t_ref, t_int4, t_int8;
+  if (!run(data, inputs, runs, &ref, &t_ref) || !run(out, inputs, runs, &res, &t_int4) ||
+      !run(out_int8, inputs, runs, &res_int8, &t_int8)) {
+    fprintf(stderr, "E: unable to run the models\n");
+    return 1;
+  }
+
+  int max_diff = 0, agree = 0;
+  for (size_t s = 0; s < res.size(); s++) {
+    for (size_t i = 0; i < res[s].size(); i++)
+      max_diff = std::max(max_diff, abs(res[s][i] - ref[s][i]));
+    agree += argmax(res[s]) == argmax(ref[s]);
+  }
+
+  printf("model              : %s\n", paths[0]);
+  size_t bytes_int8 = 0, bytes_int4 = 0;
+  for (const Converted& c : converted) {
+    printf("  %-16s: %6d -> %6d bytes (%s)\n", c.name.c_str(), (int)c.bytes_int8,
+        (int)c.bytes_int4, c.groups > 1 ? "per channel" : "per tensor");
+    bytes_int8 += c.bytes_int8;
+    bytes_int4 += c.bytes_int4;
+  }
+  printf("weights            : %d -> %d bytes\n", (int)bytes_int8, (int)bytes_int4);
+  printf("model              : %d -> %d bytes (%d bytes saved)\n", (int)data.size(),
+      (int)out.size(), (int)data.size() - (int)out.size());
+  printf("invoke (host)      : median %.2f us int8 -> %.2f us int4 (%.2f us int4 values as int8)\n",
+      t_ref, t_int4, t_int8);
+  printf("outputs vs int8    : max. difference %d, top-1 agreement %d/%d\n",
+      max_diff, agree, (int)res.size());
+  if (res != res_int8) {
+    fprintf(stderr, "E: outputs of the packed int4 model differ from the int8 ones\n");
+    return 1;
+  }
+
+  if (!tflm_host::save_file(paths[1], out.data(), out.size())) {
+    fprintf(stderr, "E: unable to write %s\n", paths[1]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,262 @@
+/**
+ ******************************************************************************
+ * @file    tflm_reference_kernels.h
+ * @brief   TFLM reference int8 kernels, for comparison with the CMSIS-NN ones
+ ******************************************************************************
+ *
+ * The runtime is built with the CMSIS-NN operators (kernels/cmsis_nn), the
+ * reference operators (kernels/<op>.cc) are not part of the tree. These
+ * registrations are the int8 path of the reference operators: Prepare is the
+ * shared one (kernels/<op>_common.cc, the one the reference operators use),
+ * Eval calls the reference functions (kernels/internal/reference). They are
+ * registered under the builtin codes in place of the CMSIS-NN operators, see
+ * tflm_kernel_diff.
+ */
+
+#ifndef __TFLM_REFERENCE_KERNELS_H__
+#define __TFLM_REFERENCE_KERNELS_H__
+
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/add.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/depthwise_conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/reference/process_broadcast_shapes.h"
+#include "tensorflow/lite/kernels/internal/reference/softmax.h"
+#include "tensorflow/lite/micro/kernels/add.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/depthwise_conv.h"
+#include "tensorflow/lite/micro/kernels/fully_connected.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/mul.h"
+#include "tensorflow/lite/micro/kernels/pooling.h"
+#include "tensorflow/lite/micro/kernels/softmax.h"
+#include "tensorflow/lite/micro/micro_context.h"
+
+namespace tflm_host {
+namespace reference {
+
+template <typename OpData>
+void* Init(TfLiteContext* context, const char* buffer, size_t length)
+{
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+inline TfLiteStatus ConvEval(TfLiteContext* context, TfLiteNode* node)
+{
+  const auto& params = *static_cast<const TfLiteConvParams*>(node->builtin_data);
+  const auto& data = *static_cast<const tflite::OpDataConv*>(node->user_data);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, tflite::kConvInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, tflite::kConvWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      tflite::micro::GetEvalInput(context, node, tflite::kConvBiasTensor);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, tflite::kConvOutputTensor);
+  TF_LITE_ENSURE_EQ(context, input->type, kTfLiteInt8);
+  tflite::reference_integer_ops::ConvPerChannel(tflite::ConvParamsQuantized(params, data),
+      data.per_channel_output_multiplier, data.per_channel_output_shift,
+      tflite::micro::GetTensorShape(input), tflite::micro::GetTensorData<int8_t>(input),
+      tflite::micro::GetTensorShape(filter), tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias), tflite::micro::GetOptionalTensorData<int32_t>(bias),
+      tflite::micro::GetTensorShape(output), tflite::micro::GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
+inline TfLiteStatus DepthwiseConvEval(TfLiteContext* context, TfLiteNode* node)
+{
+  const auto& params = *static_cast<const TfLiteDepthwiseConvParams*>(node->builtin_data);
+  const auto& data = *static_cast<const tflite::OpDataConv*>(node->user_data);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, tflite::kDepthwiseConvInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, tflite::kDepthwiseConvWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      tflite::micro::GetEvalInput(context, node, tflite::kDepthwiseConvBiasTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, tflite::kDepthwiseConvOutputTensor);
+  TF_LITE_ENSURE_EQ(context, input->type, kTfLiteInt8);
+  tflite::reference_integer_ops::DepthwiseConvPerChannel(
+      tflite::DepthwiseConvParamsQuantized(params, data), data.per_channel_output_multiplier,
+      data.per_channel_output_shift, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int8_t>(input), tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<int8_t>(filter), tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetOptionalTensorData<int32_t>(bias), tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
+/* no shared Prepare for FULLY_CONNECTED, same as the reference operator */
+inline TfLiteStatus FullyConnectedPrepare(TfLiteContext* context, TfLiteNode* node)
+{
+  tflite::MicroContext* micro_context = tflite::GetMicroContext(context);
+  auto* data = static_cast<tflite::OpDataFullyConnected*>(node->user_data);
+  const auto* params = static_cast<const TfLiteFullyConnectedParams*>(node->builtin_data);
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, tflite::kFullyConnectedInputTensor);
+  TfLiteTensor* filter =
+      micro_context->AllocateTempInputTensor(node, tflite::kFullyConnectedWeightsTensor);
+  TfLiteTensor* bias =
+      micro_context->AllocateTempInputTensor(node, tflite::kFullyConnectedBiasTensor);
+  TfLiteTensor* output =
+      micro_context->AllocateTempOutputTensor(node, tflite::kFullyConnectedOutputTensor);
+  TF_LITE_ENSURE(context, input != nullptr && filter != nullptr && output != nullptr);
+  TF_LITE_ENSURE_EQ(context, input->type, kTfLiteInt8);
+  TF_LITE_ENSURE_OK(context, tflite::CalculateOpDataFullyConnected(context, params->activation,
+      input->type, input, filter, bias, output, data));
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(filter);
+  if (bias != nullptr)
+    micro_context->DeallocateTempTfLiteTensor(bias);
+  micro_context->DeallocateTempTfLiteTensor(output);
+  return kTfLiteOk;
+}
+
+inline TfLiteStatus FullyConnectedEval(TfLiteContext* context, TfLiteNode* node)
+{
+  const auto& data = *static_cast<const tflite::OpDataFullyConnected*>(node->user_data);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, tflite::kFullyConnectedInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, tflite::kFullyConnectedWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      tflite::micro::GetEvalInput(context, node, tflite::kFullyConnectedBiasTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, tflite::kFullyConnectedOutputTensor);
+  tflite::reference_integer_ops::FullyConnected(tflite::FullyConnectedParamsQuantized(data),
+      tflite::micro::GetTensorShape(input), tflite::micro::GetTensorData<int8_t>(input),
+      tflite::micro::GetTensorShape(filter), tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias), tflite::micro::GetOptionalTensorData<int32_t>(bias),
+      tflite::micro::GetTensorShape(output), tflite::micro::GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
+template <bool kMax>
+TfLiteStatus PoolingEval(TfLiteContext* context, TfLiteNode* node)
+{
+  auto* params = static_cast<TfLitePoolParams*>(node->builtin_data);
+  const auto* data = static_cast<const tflite::OpDataPooling*>(node->user_data);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, tflite::kPoolingInputTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, tflite::kPoolingOutputTensor);
+  TF_LITE_ENSURE_EQ(context, input->type, kTfLiteInt8);
+  if (kMax)
+    tflite::MaxPoolingEvalQuantized<int8_t>(context, node, params, data, input, output);
+  else
+    tflite::AveragePoolingEvalQuantized<int8_t>(context, node, params, data, input, output);
+  return kTfLiteOk;
+}
+
+inline TfLiteStatus SoftmaxEval(TfLiteContext* context, TfLiteNode* node)
+{
+  const auto& op_data = *static_cast<const tflite::SoftmaxParams*>(node->user_data);
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+  TF_LITE_ENSURE(context, input->type == kTfLiteInt8 && output->type == kTfLiteInt8);
+  tflite::reference_ops::Softmax(op_data, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int8_t>(input), tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
+inline TfLiteStatus AddEval(TfLiteContext* context, TfLiteNode* node)
+{
+  const auto* data = static_cast<const tflite::OpDataAdd*>(node->user_data);
+  const TfLiteEvalTensor* input1 =
+      tflite::micro::GetEvalInput(context, node, tflite::kAddInputTensor1);
+  const TfLiteEvalTensor* input2 =
+      tflite::micro::GetEvalInput(context, node, tflite::kAddInputTensor2);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, tflite::kAddOutputTensor);
+  TF_LITE_ENSURE_EQ(context, output->type, kTfLiteInt8);
+
+  tflite::ArithmeticParams op_params;
+  op_params.left_shift = data->left_shift;
+  op_params.input1_offset = data->input1_offset;
+  op_params.input1_multiplier = data->input1_multiplier;
+  op_params.input1_shift = data->input1_shift;
+  op_params.input2_offset = data->input2_offset;
+  op_params.input2_multiplier = data->input2_multiplier;
+  op_params.input2_shift = data->input2_shift;
+  op_params.output_offset = data->output_offset;
+  op_params.output_multiplier = data->output_multiplier;
+  op_params.output_shift = data->output_shift;
+  tflite::SetActivationParams(data->output_activation_min, data->output_activation_max,
+      &op_params);
+  if (tflite::reference_ops::ProcessBroadcastShapes(tflite::micro::GetTensorShape(input1),
+          tflite::micro::GetTensorShape(input2), &op_params))
+    tflite::reference_integer_ops::BroadcastAdd4DSlow(op_params,
+        tflite::micro::GetTensorShape(input1), tflite::micro::GetTensorData<int8_t>(input1),
+        tflite::micro::GetTensorShape(input2), tflite::micro::GetTensorData<int8_t>(input2),
+        tflite::micro::GetTensorShape(output), tflite::micro::GetTensorData<int8_t>(output));
+  else
+    tflite::reference_integer_ops::Add(op_params, tflite::micro::GetTensorShape(input1),
+        tflite::micro::GetTensorData<int8_t>(input1), tflite::micro::GetTensorShape(input2),
+        tflite::micro::GetTensorData<int8_t>(input2), tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
+inline TfLiteStatus MulEval(TfLiteContext* context, TfLiteNode* node)
+{
+  const auto* data = static_cast<const tflite::OpDataMul*>(node->user_data);
+  const TfLiteEvalTensor* input1 =
+      tflite::micro::GetEvalInput(context, node, tflite::kMulInput1Tensor);
+  const TfLiteEvalTensor* input2 =
+      tflite::micro::GetEvalInput(context, node, tflite::kMulInput2Tensor);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, tflite::kMulOutputTensor);
+  TF_LITE_ENSURE_EQ(context, output->type, kTfLiteInt8);
+  return tflite::EvalMulQuantizedReference(context, node, data, input1, input2, output);
+}
+
+}  // namespace reference
+
+inline TfLiteRegistration_V1 Register_CONV_2D_REF()
+{
+  return tflite::micro::RegisterOp(reference::Init<tflite::OpDataConv>, tflite::ConvPrepare,
+      reference::ConvEval);
+}
+
+inline TfLiteRegistration_V1 Register_DEPTHWISE_CONV_2D_REF()
+{
+  return tflite::micro::RegisterOp(reference::Init<tflite::OpDataConv>,
+      tflite::DepthwiseConvPrepare, reference::DepthwiseConvEval);
+}
+
+inline TfLiteRegistration_V1 Register_FULLY_CONNECTED_REF()
+{
+  return tflite::micro::RegisterOp(reference::Init<tflite::OpDataFullyConnected>,
+      reference::FullyConnectedPrepare, reference::FullyConnectedEval);
+}
+
+inline TfLiteRegistration_V1 Register_AVERAGE_POOL_2D_REF()
+{
+  return tflite::micro::RegisterOp(reference::Init<tflite::OpDataPooling>, tflite::PoolingPrepare,
+      reference::PoolingEval<false>);
+}
+
+inline TfLiteRegistration_V1 Register_MAX_POOL_2D_REF()
+{
+  return tflite::micro::RegisterOp(reference::Init<tflite::OpDataPooling>, tflite::PoolingPrepare,
+      reference::PoolingEval<true>);
+}
+
+inline TfLiteRegistration_V1 Register_SOFTMAX_REF()
+{
+  return tflite::micro::RegisterOp(tflite::SoftmaxInit, tflite::SoftmaxPrepare,
+      reference::SoftmaxEval);
+}
+
+inline TfLiteRegistration_V1 Register_ADD_REF()
+{
+  return tflite::micro::RegisterOp(reference::Init<tflite::OpDataAdd>, tflite::AddPrepare,
+      reference::AddEval);
+}
+
+inline TfLiteRegistration_V1 Register_MUL_REF()
+{
+  return tflite::micro::RegisterOp(tflite::MulInit, tflite::MulPrepare, reference::MulEval);
+}
+
+}  // namespace tflm_host
+
+#endif /* __TFLM_REFERENCE_KERNELS_H__ */
@@ -0,0 +1,161 @@
+/**
+ ******************************************************************************
+ * @file    tflm_scratch_bench.cc
+ * @brief   Host comparison of the planned and pooled scratch buffers
+ ******************************************************************************
+ *
+ * usage: tflm_scratch_bench [-g] [<model.tflite> ..]
+ *
+ * The scratch buffers requested by the kernels (RequestScratchBufferInArena(),
+ * im2col and other temporaries of the CMSIS-NN kernels) are planned with the
+ * tensors by default, each with the lifetime of its node. With
+ * TFLM_C_PLANNER_SCRATCH_POOL they are placed in one pool shared by all the
+ * nodes, above the tensors (MicroAllocator::SetScratchPool()).
+ *
+ * Reported for each model: number and total size of the scratch buffers, size
+ * of the pool (largest scratch memory of a node), and the arena used bytes
+ * without and with the pool for the greedy and best-fit planners, without and
+ * with the operator fusion (TFLM_C_PLANNER_FUSE_OPS). The host build checks
+ * each committed plan (TF_LITE_CHECK_MEMORY_PLAN: no overlapping buffers alive
+ * at the same time, tflm_c_create_with_planner() fails otherwise) and the
+ * outputs must be identical.
+ *
+ * -g: int8 models generated with the layers of the selected_model variants of
+ * train_mnist_model.py (tflm_model_builder.h).
+ *
+ * Exit code 1 if an instance can not be created or if the outputs differ.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+
+#include "tflm_c.h"
+#include "tflm_host_utils.h"
+#include "tflm_model_builder.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+struct Planned {
+  int buffers;
+  size_t bytes;  /* sum of the buffer sizes */
+};
+
+/* buffers given to the planner */
+bool record(const std::vector<uint8_t>& data, bool pool, Planned* res)
+{
+  static tflite::AllOpsResolver resolver;
+  tflm_host::RecordingMemoryPlanner planner;
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(arena, sizeof(arena), &planner);
+  allocator->SetScratchPool(pool);
+  tflite::MicroInterpreter interpreter(tflite::GetModel(data.data()), resolver, allocator);
+  if (interpreter.AllocateTensors() != kTfLiteOk)
+    return false;
+  res->buffers = (int)planner.requirements.size();
+  res->bytes = 0;
+  for (const auto& r : planner.requirements)
+    res->bytes += r.size;
+  return true;
+}
+
+/* instance created with the planner, outputs for fixed random inputs */
+bool run(const std::vector<uint8_t>& data, uint32_t planner, int32_t* used,
+    std::vector<uint8_t>* outputs)
+{
+  uint32_t hdl;
+  if (tflm_c_create_with_planner(data.data(), arena, sizeof(arena), planner, &hdl) != kTfLiteOk)
+    return false;
+  *used = tflm_c_arena_used_bytes(hdl);
+  struct tflm_c_tensor_info info;
+  srand(1);
+  for (int i = 0; i < tflm_c_inputs_size(hdl); i++) {
+    tflm_c_input(hdl, i, &info);
+    for (size_t j = 0; j < info.bytes; j++)
+      ((uint8_t*)info.data)[j] = (uint8_t)rand();
+  }
+  bool ok = tflm_c_invoke(hdl) == kTfLiteOk;
+  outputs->clear();
+  for (int i = 0; i < tflm_c_outputs_size(hdl) && ok; i++) {
+    tflm_c_output(hdl, i, &info);
+    outputs->insert(outputs->end(), (uint8_t*)info.data, (uint8_t*)info.data + info.bytes);
+  }
+  tflm_c_destroy(hdl);
+  return ok;
+}
+
+int bench(const std::string& name, const std::vector<uint8_t>& data)
+{
+  Planned planned, pooled;
+  if (data.empty() || !record(data, false, &planned) || !record(data, true, &pooled)) {
+    fprintf(stderr, "E: unable to load %s\n", name.c_str());
+    return 1;
+  }
+  printf("%s\n", name.c_str());
+  printf("  scratch buffers  : %d, %d bytes\n", planned.buffers - pooled.buffers,
+      (int)(planned.bytes - pooled.bytes));
+
+  static const struct {
+    const char* name;
+    uint32_t planner;
+  } kModes[] = {
+    {"greedy", TFLM_C_PLANNER_GREEDY},
+    {"best-fit", TFLM_C_PLANNER_BEST_FIT},
+    {"greedy, fused", TFLM_C_PLANNER_GREEDY | TFLM_C_PLANNER_FUSE_OPS},
+    {"best-fit, fused", TFLM_C_PLANNER_BEST_FIT | TFLM_C_PLANNER_FUSE_OPS},
+  };
+  std::vector<uint8_t> ref, outputs;
+  bool ok = true;
+  for (const auto& mode : kModes) {
+    int32_t used = 0, used_pool = 0;
+    bool res = run(data, mode.planner, &used, &ref) &&
+        run(data, mode.planner | TFLM_C_PLANNER_SCRATCH_POOL, &used_pool, &outputs);
+    res = res && outputs == ref;
+    ok &= res;
+    printf("  %-16s : %d -> %d bytes with the pool (%+.1f%%)%s\n", mode.name, (int)used,
+        (int)used_pool, used ? 100.0 * ((double)used_pool - used) / used : 0.0,
+        res ? "" : " FAILED");
+  }
+  return ok ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  bool generated = false;
+  std::vector<const char*> paths;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-g"))
+      generated = true;
+    else if (argv[i][0] != '-')
+      paths.push_back(argv[i]);
+    else {
+      paths.clear();
+      generated = false;
+      break;
+    }
+  }
+  if (paths.empty() && !generated) {
+    fprintf(stderr, "usage: %s [-g] [<model.tflite> ..]\n", argv[0]);
+    return 2;
+  }
+
+  int res = 0;
+  for (const char* path : paths)
+    res |= bench(path, tflm_host::load_file(path));
+  for (int v = 0; v < 5 && generated; v++) {
+    std::vector<uint8_t> data = tflm_host::generate_mnist_model(v);
+    if (!data.empty())
+      res |= bench("selected_model " + std::to_string(v) + " (generated)", data);
+  }
+  return res;
+}
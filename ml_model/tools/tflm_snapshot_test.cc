@@ -0,0 +1,148 @@
+/**
+ ******************************************************************************
+ * @file    tflm_snapshot_test.cc
+ * @brief   Host test of the warm-start snapshot (tflm_c_snapshot_save() and
+ *          tflm_c_create_from_snapshot())
+ ******************************************************************************
+ *
+ * usage: tflm_snapshot_test <model.tflite>
+ *
+ * - the instance is still usable after tflm_c_snapshot_save(),
+ * - an instance restored in another arena buffer (other address, other
+ *   alignment) gives bit-identical outputs,
+ * - a snapshot with another key, another model address, from another image
+ *   (GNU build-id), a corrupted content or a too small arena is rejected.
+ */
+
+#include <string.h>
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+
+namespace {
+
+uint8_t arena_a[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+uint8_t arena_b[tflm_host::kHostArenaSize + 64] __attribute__((aligned(16)));
+uint8_t snapshot[tflm_host::kHostArenaSize];
+
+int n_errors = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "E: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      n_errors++; \
+    } \
+  } while (0)
+
+/* Fills the inputs with a fixed pattern, runs the model and returns the outputs */
+std::vector<uint8_t> run(uint32_t hdl)
+{
+  std::vector<uint8_t> res;
+  struct tflm_c_tensor_info info;
+
+  for (int i = 0; i < tflm_c_inputs_size(hdl); i++) {
+    tflm_c_input(hdl, i, &info);
+    for (size_t j = 0; j < info.bytes; j++)
+      ((uint8_t*)info.data)[j] = (uint8_t)(j * 31 + i * 7);
+  }
+  if (tflm_c_invoke(hdl) != kTfLiteOk)
+    return res;
+  for (int i = 0; i < tflm_c_outputs_size(hdl); i++) {
+    tflm_c_output(hdl, i, &info);
+    res.insert(res.end(), (uint8_t*)info.data, (uint8_t*)info.data + info.bytes);
+  }
+  return res;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <model.tflite>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(argv[1]);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", argv[1]);
+    return 1;
+  }
+
+  uint8_t key[TFLM_C_SNAPSHOT_KEY_SIZE];
+  for (size_t i = 0; i < sizeof(key); i++)
+    key[i] = (uint8_t)i;
+
+  /* reference */
+  uint32_t hdl;
+  if (tflm_c_create(data.data(), arena_a, sizeof(arena_a), &hdl) != kTfLiteOk) {
+    fprintf(stderr, "E: tflm_c_create() fails\n");
+    return 1;
+  }
+  const std::vector<uint8_t> ref = run(hdl);
+  CHECK(!ref.empty());
+
+  /* save */
+  uint32_t size = 0;
+  const int32_t expected = tflm_c_snapshot_size(hdl);
+  CHECK(tflm_c_snapshot_save(hdl, key, snapshot, 16, &size) == kTfLiteError);
+  CHECK((int32_t)size == expected);
+  CHECK(tflm_c_snapshot_save(hdl, key, snapshot, sizeof(snapshot), &size) == kTfLiteOk);
+  CHECK((int32_t)size == expected);
+  CHECK(run(hdl) == ref);
+  tflm_c_destroy(hdl);
+
+  /* restore in another buffer, not aligned on 16 bytes */
+  uint8_t* arena = arena_b + 40;
+  const uint32_t arena_size = sizeof(arena_a);
+  memset(arena_b, 0xA5, sizeof(arena_b));
+  CHECK(tflm_c_create_from_snapshot(data.data(), arena, arena_size, key, snapshot, size,
+      &hdl) == kTfLiteOk);
+  if (hdl) {
+    CHECK(run(hdl) == ref);
+    CHECK(run(hdl) == ref);
+    CHECK(tflm_c_snapshot_size(hdl) == expected);
+    tflm_c_destroy(hdl);
+  }
+
+  /* rejected snapshots */
+  uint8_t other_key[TFLM_C_SNAPSHOT_KEY_SIZE];
+  memcpy(other_key, key, sizeof(key));
+  other_key[0] ^= 1;
+  CHECK(tflm_c_create_from_snapshot(data.data(), arena, arena_size, other_key, snapshot,
+      size, &hdl) == kTfLiteError);
+  CHECK(hdl == 0);
+
+  std::vector<uint8_t> other_model(data);
+  CHECK(tflm_c_create_from_snapshot(other_model.data(), arena, arena_size, key, snapshot,
+      size, &hdl) == kTfLiteError);
+
+  CHECK(tflm_c_create_from_snapshot(data.data(), arena, arena_size, key, snapshot,
+      size - 1, &hdl) == kTfLiteError);
+
+  CHECK(tflm_c_create_from_snapshot(data.data(), arena, 1024, key, snapshot,
+      size, &hdl) == kTfLiteError);
+
+  snapshot[size / 2] ^= 0x10;
+  CHECK(tflm_c_create_from_snapshot(data.data(), arena, arena_size, key, snapshot,
+      size, &hdl) == kTfLiteError);
+  snapshot[size / 2] ^= 0x10;
+
+  /* other image: build id, third word of the header */
+  snapshot[2 * sizeof(uint32_t)] ^= 0x10;
+  CHECK(tflm_c_create_from_snapshot(data.data(), arena, arena_size, key, snapshot,
+      size, &hdl) == kTfLiteError);
+  snapshot[2 * sizeof(uint32_t)] ^= 0x10;
+
+  /* still valid */
+  CHECK(tflm_c_create_from_snapshot(data.data(), arena, arena_size, key, snapshot,
+      size, &hdl) == kTfLiteOk);
+  if (hdl)
+    tflm_c_destroy(hdl);
+
+  printf("model              : %s\n", argv[1]);
+  printf("snapshot           : %d bytes\n", (int)size);
+  printf("errors             : %d\n", n_errors);
+  return n_errors ? 1 : 0;
+}
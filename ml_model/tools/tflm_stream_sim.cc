@@ -0,0 +1,342 @@
+/**
+ ******************************************************************************
+ * @file    tflm_stream_sim.cc
+ * @brief   Host simulation of the weight streaming from an external memory
+ ******************************************************************************
+ *
+ * usage: tflm_stream_sim <model.tflite> [-b size[,size..]] [-m min_size]
+ *                        [-l ns_per_byte] [-s setup_ns] [-k compute_scale]
+ *                        [-n runs] [-v]
+ *
+ * The model is placed in a buffer simulating the memory-mapped external
+ * memory (OSPI NOR) and run with the weight streaming of tflm_c (see
+ * tflm_c_stream_register()) for each size of the SRAM double buffer (-b).
+ * The constant tensors smaller than min_size (-m) are read in place.
+ *
+ * The copies are simulated on a virtual timeline:
+ *   - a copy of n bytes takes setup_ns + n * ns_per_byte (-s, -l), the copies
+ *     started before an operator are serialized (one channel),
+ *   - an operator takes its duration measured with the model in internal
+ *     memory, multiplied by compute_scale (-k, ratio target/host invoke
+ *     durations, to model the target CPU),
+ *   - the wait of the weights before an operator is a stall.
+ * The latency of one invoke is compared with the model in internal memory
+ * and with synchronous copies (no prefetch).
+ *
+ * The outputs must be identical to the outputs of the model in internal
+ * memory. The streamed data is cleared in the simulated external memory
+ * after the first invoke (the copies are made from a shadow image): an
+ * operator reading streamed weights in place would give different outputs.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+struct Params {
+  uint32_t min_size = 64;
+  double ns_per_byte = 10.0;  /* ~100 MB/s, OSPI NOR memory-mapped read */
+  double setup_ns = 500.0;
+  double compute_scale = 1.0;
+  int runs = 20;
+  bool verbose = false;
+};
+
+/* Simulated external memory and copy channel (virtual time in ns) */
+struct SlowMemory {
+  const Params* params;
+  std::vector<uint8_t>* ext;      /* model, as seen by the runtime */
+  std::vector<uint8_t> shadow;    /* source of the copies */
+  const std::vector<double>* compute;
+
+  size_t node;                    /* next operator */
+  double t;                       /* current time */
+  double t_ready;                 /* end of the copies in progress */
+  double stall;
+  double copy_time;
+  uint64_t bytes;
+  std::vector<double> node_stall;
+  bool record;
+  std::vector<std::pair<size_t, size_t>> ranges;  /* copied [offset, size) */
+
+  void reset() {
+    t = t_ready = stall = copy_time = 0.0;
+    bytes = 0;
+    node = 0;
+    std::fill(node_stall.begin(), node_stall.end(), 0.0);
+  }
+};
+
+int sim_start(const void* cookie, const struct tflm_c_stream_copy* copies, uint32_t n_copies)
+{
+  SlowMemory* mem = (SlowMemory*)cookie;
+  double duration = 0.0;
+  for (uint32_t i = 0; i < n_copies; i++) {
+    const uint8_t* src = (const uint8_t*)copies[i].src;
+    if (src < mem->ext->data() || src + copies[i].size > mem->ext->data() + mem->ext->size())
+      return -1;
+    size_t offset = src - mem->ext->data();
+    memcpy(copies[i].dst, mem->shadow.data() + offset, copies[i].size);
+    duration += mem->params->setup_ns + copies[i].size * mem->params->ns_per_byte;
+    mem->bytes += copies[i].size;
+    if (mem->record)
+      mem->ranges.push_back({offset, copies[i].size});
+  }
+  mem->t_ready = std::max(mem->t, mem->t_ready) + duration;
+  mem->copy_time += duration;
+  return 0;
+}
+
+int sim_wait(const void* cookie)
+{
+  SlowMemory* mem = (SlowMemory*)cookie;
+  if (mem->t_ready > mem->t) {
+    /* called before the operator mem->node */
+    if (mem->node < mem->node_stall.size())
+      mem->node_stall[mem->node] += mem->t_ready - mem->t;
+    mem->stall += mem->t_ready - mem->t;
+    mem->t = mem->t_ready;
+  }
+  return 0;
+}
+
+/* end of an operator (observer callback): compute time on the timeline */
+int sim_node(const void* cookie, const uint32_t flags, const struct tflm_c_node* node)
+{
+  SlowMemory* mem = (SlowMemory*)cookie;
+  mem->t += (*mem->compute)[node->node_info.idx] * mem->params->compute_scale;
+  mem->node = node->node_info.idx + 1;
+  return 0;
+}
+
+uint64_t host_time_ns(int mode)
+{
+  return (uint64_t)(tflm_host::now_us() * 1000.0);
+}
+
+uint64_t virtual_time(int mode)
+{
+  return 0;
+}
+
+void fill_inputs(uint32_t hdl)
+{
+  struct tflm_c_tensor_info info;
+  for (int i = 0; i < tflm_c_inputs_size(hdl); i++) {
+    tflm_c_input(hdl, i, &info);
+    for (size_t j = 0; j < info.bytes; j++)
+      ((uint8_t*)info.data)[j] = (uint8_t)(j * 37 + 11);
+  }
+}
+
+std::vector<uint8_t> outputs(uint32_t hdl)
+{
+  std::vector<uint8_t> out;
+  struct tflm_c_tensor_info info;
+  for (int i = 0; i < tflm_c_outputs_size(hdl); i++) {
+    tflm_c_output(hdl, i, &info);
+    out.insert(out.end(), (uint8_t*)info.data, (uint8_t*)info.data + info.bytes);
+  }
+  return out;
+}
+
+/* Model in internal memory: per operator duration (ns, median) and outputs */
+struct NodeTimes {
+  std::vector<std::vector<double>> samples;
+};
+
+int record_node(const void* cookie, const uint32_t flags, const struct tflm_c_node* node)
+{
+  NodeTimes* times = (NodeTimes*)cookie;
+  if (node->node_info.idx >= times->samples.size())
+    times->samples.resize(node->node_info.idx + 1);
+  times->samples[node->node_info.idx].push_back((double)node->node_info.dur);
+  return 0;
+}
+
+bool run_reference(const std::vector<uint8_t>& model, int runs, std::vector<double>* compute,
+    std::vector<uint8_t>* ref)
+{
+  uint32_t hdl;
+  if (tflm_c_create(model.data(), arena, sizeof(arena), &hdl) != kTfLiteOk)
+    return false;
+  NodeTimes times;
+  struct tflm_c_observer_options options = {record_node, host_time_ns, &times,
+      OBSERVER_FLAGS_TIME_ONLY};
+  bool ok = tflm_c_observer_register(hdl, &options) == kTfLiteOk;
+  fill_inputs(hdl);
+  for (int r = 0; r < runs + 1 && ok; r++) {
+    if (r == 1)
+      times.samples.clear();  /* first run: warm-up */
+    ok = tflm_c_invoke(hdl) == kTfLiteOk;
+  }
+  compute->clear();
+  for (auto& s : times.samples) {
+    std::sort(s.begin(), s.end());
+    compute->push_back(s.empty() ? 0.0 : s[s.size() / 2]);
+  }
+  *ref = outputs(hdl);
+  tflm_c_destroy(hdl);
+  return ok;
+}
+
+std::vector<uint32_t> parse_sizes(const char* arg)
+{
+  std::vector<uint32_t> sizes;
+  std::string s(arg);
+  size_t pos = 0;
+  while (pos < s.size()) {
+    size_t next = s.find(',', pos);
+    if (next == std::string::npos)
+      next = s.size();
+    sizes.push_back((uint32_t)strtoul(s.substr(pos, next - pos).c_str(), nullptr, 0));
+    pos = next + 1;
+  }
+  return sizes;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  Params params;
+  std::vector<uint32_t> sizes = {4096, 8192, 16384, 32768, 65536};
+  const char* path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-b") && i + 1 < argc)
+      sizes = parse_sizes(argv[++i]);
+    else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+      params.min_size = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+      params.ns_per_byte = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      params.setup_ns = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-k") && i + 1 < argc)
+      params.compute_scale = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      params.runs = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-v"))
+      params.verbose = true;
+    else if (!path)
+      path = argv[i];
+    else {
+      path = nullptr;
+      break;
+    }
+  }
+  if (!path || sizes.empty() || params.ns_per_byte < 0 || params.setup_ns < 0 ||
+      params.compute_scale <= 0) {
+    fprintf(stderr, "usage: %s <model.tflite> [-b size[,size..]] [-m min_size] "
+        "[-l ns_per_byte] [-s setup_ns] [-k compute_scale] [-n runs] [-v]\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(path);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", path);
+    return 1;
+  }
+
+  std::vector<double> compute;
+  std::vector<uint8_t> ref;
+  if (!run_reference(data, params.runs, &compute, &ref)) {
+    fprintf(stderr, "E: unable to run the model\n");
+    return 1;
+  }
+  double t_internal = 0.0;
+  for (double c : compute)
+    t_internal += c * params.compute_scale;
+
+  printf("model              : %s (%d bytes, %d operators)\n", path, (int)data.size(),
+      (int)compute.size());
+  printf("external memory    : %.2f ns/byte, %.0f ns per copy\n", params.ns_per_byte,
+      params.setup_ns);
+  printf("compute scale      : x%.2f\n", params.compute_scale);
+  printf("internal memory    : %.2f us\n", t_internal / 1000.0);
+
+  int errors = 0;
+  for (uint32_t size : sizes) {
+    std::vector<uint8_t> ext = data;
+    SlowMemory mem;
+    mem.params = &params;
+    mem.ext = &ext;
+    mem.shadow = data;
+    mem.compute = &compute;
+    mem.node_stall.resize(compute.size());
+    mem.record = true;
+    mem.reset();
+
+    uint32_t hdl;
+    if (tflm_c_create(ext.data(), arena, sizeof(arena), &hdl) != kTfLiteOk) {
+      fprintf(stderr, "E: unable to create the instance\n");
+      return 1;
+    }
+
+    std::vector<uint8_t> buffer(size + 16);
+    struct tflm_c_stream_options stream = {ext.data(), (uint32_t)ext.size(), params.min_size,
+        buffer.data(), size, sim_start, sim_wait, &mem};
+    struct tflm_c_observer_options observer = {sim_node, virtual_time, &mem,
+        OBSERVER_FLAGS_TIME_ONLY};
+    struct tflm_c_stream_info info;
+    if ((tflm_c_stream_register(hdl, &stream) != kTfLiteOk) ||
+        (tflm_c_stream_info(hdl, &info) != kTfLiteOk) ||
+        (tflm_c_observer_register(hdl, &observer) != kTfLiteOk)) {
+      fprintf(stderr, "E: unable to register the weight streaming (%d bytes)\n", (int)size);
+      tflm_c_destroy(hdl);
+      return 1;
+    }
+
+    /* first invoke: streamed ranges, cleared in the external memory */
+    fill_inputs(hdl);
+    bool ok = tflm_c_invoke(hdl) == kTfLiteOk;
+    mem.record = false;
+    for (auto& r : mem.ranges)
+      memset(ext.data() + r.first, 0, r.second);
+
+    std::vector<double> t_invoke, t_stall;
+    for (int r = 0; r < params.runs && ok; r++) {
+      mem.reset();
+      ok = tflm_c_invoke(hdl) == kTfLiteOk;
+      t_invoke.push_back(mem.t);
+      t_stall.push_back(mem.stall);
+    }
+    if (!ok || (outputs(hdl) != ref)) {
+      fprintf(stderr, "E: %d bytes: outputs differ from the model in internal memory\n",
+          (int)size);
+      errors++;
+    }
+    tflm_c_destroy(hdl);
+    if (!ok)
+      continue;
+
+    std::sort(t_invoke.begin(), t_invoke.end());
+    std::sort(t_stall.begin(), t_stall.end());
+    const double t = t_invoke[t_invoke.size() / 2];
+    const double stall = t_stall[t_stall.size() / 2];
+    const double t_sync = t_internal + mem.copy_time;
+    printf("buffer %6d bytes : slot %d bytes, %d streamed / %d in place (+%d small),"
+        " max. slot %d bytes, %d bytes/invoke\n", (int)size, (int)info.slot_size,
+        (int)info.n_streamed, (int)info.n_in_place, (int)info.n_small,
+        (int)info.max_slot_used, (int)info.bytes_per_invoke);
+    printf("  invoke           : %.2f us (stall %.2f us), no prefetch %.2f us,"
+        " copies hidden %.0f%%\n", t / 1000.0, stall / 1000.0, t_sync / 1000.0,
+        mem.copy_time > 0 ? 100.0 * (mem.copy_time - stall) / mem.copy_time : 100.0);
+    for (size_t i = 0; params.verbose && i < compute.size(); i++)
+      printf("  %3d              : compute %.2f us, stall %.2f us\n", (int)i,
+          compute[i] * params.compute_scale / 1000.0, mem.node_stall[i] / 1000.0);
+    if (info.n_in_place + info.n_small)
+      printf("  note             : latency of the reads in place not modelled\n");
+  }
+
+  return errors ? 1 : 0;
+}
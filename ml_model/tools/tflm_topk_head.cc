@@ -0,0 +1,269 @@
+/**
+ ******************************************************************************
+ * @file    tflm_topk_head.cc
+ * @brief   Host rewrite removing the trailing softmax of a classifier
+ ******************************************************************************
+ *
+ * usage: tflm_topk_head <model.tflite> <output.tflite> [-k k] [-n runs]
+ *
+ * The int8 SOFTMAX producing the output of the model is removed: the output
+ * of the rewritten model is the int8 logits (input of the softmax). The
+ * softmax is monotonic, the classes are selected on the logits by the top-k
+ * head of the runtime (tflm_c_topk_enable()/tflm_c_topk()). The operator code
+ * and the output tensor of the softmax are removed if they are not used
+ * elsewhere ("OfflineMemoryAllocation" metadata updated).
+ *
+ * Three configurations are run on the same random inputs:
+ * - original model, classes taken from the softmax output (reference),
+ * - original model with the head enabled (softmax replaced at runtime),
+ * - rewritten model with the head enabled (head on the logits output).
+ * The two heads must report the same classes/logits and the first class must
+ * have the largest softmax probability of the reference (exit code 1
+ * otherwise). The median time per inference of each configuration is
+ * reported.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "tflm_host_utils.h"
+#include "tflm_c.h"
+
+namespace {
+
+uint8_t arena[tflm_host::kHostArenaSize] __attribute__((aligned(16)));
+
+const char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
+constexpr int kSamples = 16;
+
+bool fail(const char* msg)
+{
+  fprintf(stderr, "E: %s\n", msg);
+  return false;
+}
+
+tflite::BuiltinOperator op_code(const tflite::ModelT& model, const tflite::OperatorT& op)
+{
+  const tflite::OperatorCodeT& code = *model.operator_codes[op.opcode_index];
+  return std::max(code.builtin_code, (tflite::BuiltinOperator)code.deprecated_builtin_code);
+}
+
+/* removes the tensor idx (not referenced by an operator) */
+void remove_tensor(tflite::ModelT* model, int32_t idx)
+{
+  tflite::SubGraphT& sg = *model->subgraphs[0];
+  auto remap = [idx](std::vector<int32_t>& v) {
+    for (int32_t& t : v)
+      t -= t > idx;
+  };
+  for (auto& op : sg.operators) {
+    remap(op->inputs);
+    remap(op->outputs);
+    remap(op->intermediates);
+  }
+  remap(sg.inputs);
+  remap(sg.outputs);
+  sg.tensors.erase(sg.tensors.begin() + idx);
+
+  /* int32 [version, subgraph, nb_tensors, offset_0, .., offset_n-1] */
+  for (const auto& md : model->metadata) {
+    if (md->name != kOfflineMemAllocMetadata)
+      continue;
+    std::vector<uint8_t>& data = model->buffers[md->buffer]->data;
+    const size_t pos = (3 + idx) * sizeof(int32_t);
+    int32_t n;
+    memcpy(&n, &data[2 * sizeof(int32_t)], sizeof(n));
+    if (data.size() < pos + sizeof(int32_t) || idx >= n)
+      continue;
+    n--;
+    memcpy(&data[2 * sizeof(int32_t)], &n, sizeof(n));
+    data.erase(data.begin() + pos, data.begin() + pos + sizeof(int32_t));
+  }
+}
+
+bool strip_softmax(tflite::ModelT* model)
+{
+  tflite::SubGraphT& sg = *model->subgraphs[0];
+  if (sg.outputs.size() != 1 || sg.operators.empty())
+    return fail("single output models only");
+  tflite::OperatorT& op = *sg.operators.back();
+  const int32_t output = sg.outputs[0];
+  if (op_code(*model, op) != tflite::BuiltinOperator_SOFTMAX || op.outputs.size() != 1 ||
+      op.outputs[0] != output)
+    return fail("the output is not produced by the last operator, a SOFTMAX");
+  const int32_t logits = op.inputs[0];
+  if (sg.tensors[logits]->type != tflite::TensorType_INT8)
+    return fail("int8 softmax input expected");
+
+  const uint32_t opcode = op.opcode_index;
+  sg.operators.pop_back();
+  sg.outputs[0] = logits;
+
+  bool used = false;
+  for (const auto& o : sg.operators)
+    used |= std::count(o->inputs.begin(), o->inputs.end(), output) > 0;
+  if (!used)
+    remove_tensor(model, output);
+
+  used = false;
+  for (const auto& s : model->subgraphs)
+    for (const auto& o : s->operators)
+      used |= o->opcode_index == opcode;
+  if (!used) {
+    model->operator_codes.erase(model->operator_codes.begin() + opcode);
+    for (const auto& s : model->subgraphs)
+      for (auto& o : s->operators)
+        o->opcode_index -= o->opcode_index > opcode;
+  }
+  return true;
+}
+
+std::vector<uint8_t> pack(const tflite::ModelT& model)
+{
+  /* the TFLM copy of flatbuffers has no implicit default allocator */
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder fbb(16 * 1024, &allocator);
+  tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, &model));
+  return std::vector<uint8_t>(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+struct Run {
+  std::vector<tflm_c_topk_result> results;  /* head */
+  std::vector<std::vector<int8_t>> outputs;   /* output 0 */
+  double us;                                  /* median per inference */
+};
+
+/* k = 0: head not enabled */
+bool run(const std::vector<uint8_t>& model, uint32_t k,
+    const std::vector<std::vector<int8_t>>& samples, int runs, Run* res)
+{
+  uint32_t hdl;
+  if (tflm_c_create(model.data(), arena, sizeof(arena), &hdl) != kTfLiteOk)
+    return false;
+  if (k && tflm_c_topk_enable(hdl, k) != kTfLiteOk) {
+    tflm_c_destroy(hdl);
+    return fail("tflm_c_topk_enable() fails");
+  }
+
+  struct tflm_c_tensor_info in, out;
+  tflm_c_input(hdl, 0, &in);
+  tflm_c_output(hdl, 0, &out);
+  std::vector<double> t;
+  bool ok = true;
+  for (int r = 0; r < runs && ok; r++) {
+    for (const auto& sample : samples) {
+      memcpy(in.data, sample.data(), in.bytes);
+      double t0 = tflm_host::now_us();
+      ok &= tflm_c_invoke(hdl) == kTfLiteOk;
+      t.push_back(tflm_host::now_us() - t0);
+      if (r || !ok)
+        continue;
+      tflm_c_topk_result topk;
+      memset(&topk, 0, sizeof(topk));
+      if (k)
+        ok &= tflm_c_topk(hdl, &topk) == kTfLiteOk;
+      res->results.push_back(topk);
+      res->outputs.emplace_back((int8_t*)out.data, (int8_t*)out.data + out.bytes);
+    }
+  }
+  std::sort(t.begin(), t.end());
+  res->us = t[t.size() / 2];
+  tflm_c_destroy(hdl);
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int k = 3;
+  int runs = 20;
+  const char* paths[2] = {nullptr, nullptr};
+  int n_paths = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-k") && i + 1 < argc)
+      k = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else if (n_paths < 2)
+      paths[n_paths++] = argv[i];
+  }
+  if (n_paths != 2 || k < 1 || k > TFLM_C_TOPK_MAX) {
+    fprintf(stderr, "usage: %s <model.tflite> <output.tflite> [-k k (1..%d)] [-n runs]\n",
+        argv[0], TFLM_C_TOPK_MAX);
+    return 2;
+  }
+
+  std::vector<uint8_t> data = tflm_host::load_file(paths[0]);
+  if (data.empty()) {
+    fprintf(stderr, "E: unable to read %s\n", paths[0]);
+    return 1;
+  }
+  std::unique_ptr<tflite::ModelT> model = tflite::UnPackModel(data.data());
+  if (model->subgraphs.size() != 1) {
+    fprintf(stderr, "E: only single subgraph models are supported\n");
+    return 1;
+  }
+  const size_t n_ops = model->subgraphs[0]->operators.size();
+  if (!strip_softmax(model.get()))
+    return 1;
+  std::vector<uint8_t> out = pack(*model);
+
+  const tflite::TensorT& in = *model->subgraphs[0]->tensors[model->subgraphs[0]->inputs[0]];
+  size_t in_bytes = 1;
+  for (int d : in.shape)
+    in_bytes *= (size_t)d;
+  std::vector<std::vector<int8_t>> samples(kSamples, std::vector<int8_t>(in_bytes));
+  srand(1);
+  for (auto& sample : samples)
+    for (auto& v : sample)
+      v = (int8_t)rand();
+
+  Run ref, fused, head;
+  if (!run(data, 0, samples, runs, &ref) || !run(data, k, samples, runs, &fused) ||
+      !run(out, k, samples, runs, &head)) {
+    fprintf(stderr, "E: unable to run the models\n");
+    return 1;
+  }
+
+  bool ok = true;
+  for (size_t s = 0; s < samples.size(); s++) {
+    const tflm_c_topk_result& a = fused.results[s];
+    const tflm_c_topk_result& b = head.results[s];
+    ok &= a.fused == 1 && b.fused == 0 && a.k == b.k && a.scale == b.scale &&
+        a.zero_point == b.zero_point &&
+        !memcmp(a.index, b.index, a.k * sizeof(a.index[0])) &&
+        !memcmp(a.logit, b.logit, a.k * sizeof(a.logit[0]));
+    /* logits output of the rewritten model */
+    ok &= b.logit[0] == *std::max_element(head.outputs[s].begin(), head.outputs[s].end());
+    /* the first class has the largest probability */
+    const std::vector<int8_t>& prob = ref.outputs[s];
+    ok &= prob[b.index[0]] == *std::max_element(prob.begin(), prob.end());
+  }
+
+  const tflm_c_topk_result& r = head.results[0];
+  printf("model              : %s\n", paths[0]);
+  printf("operators          : %d -> %d\n", (int)n_ops, (int)model->subgraphs[0]->operators.size());
+  printf("logits             : scale=%g zp=%d\n", (double)r.scale, r.zero_point);
+  printf("top-%d (sample 0)   :", (int)r.k);
+  for (uint32_t i = 0; i < r.k; i++)
+    printf(" %d (%d)", (int)r.index[i], (int)r.logit[i]);
+  printf("\n");
+  printf("inference (host)   : softmax %.2f us, fused head %.2f us, rewritten %.2f us\n",
+      ref.us, fused.us, head.us);
+  printf("classes            : %s\n", ok ? "identical" : "MISMATCH");
+  if (!ok)
+    return 1;
+
+  if (!tflm_host::save_file(paths[1], out.data(), out.size())) {
+    fprintf(stderr, "E: unable to write %s\n", paths[1]);
+    return 1;
+  }
+  return 0;
+}
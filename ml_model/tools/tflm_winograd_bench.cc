@@ -0,0 +1,244 @@
+/**
+ ******************************************************************************
+ * @file    tflm_winograd_bench.cc
+ * @brief   Host check and timing of the Winograd F(2x2, 3x3) s8 convolution
+ ******************************************************************************
+ *
+ * usage: tflm_winograd_bench [-n runs]
+ *
+ * The CMSIS-NN conv kernel (CONV_2D) runs the 3x3 stride 1 convs with enough
+ * input channels in the Winograd domain (arm_convolve_winograd_3x3_s8(),
+ * filter transformed at Prepare by
+ * arm_convolve_winograd_3x3_s8_transform_filter()). For a set of 3x3 stride 1
+ * shapes (1 to 64 input channels, padding, odd output sizes which leave
+ * partial tiles, batches), the outputs of the path taken without it
+ * (arm_convolve_s8_reordered() when the filter is reordered at Prepare,
+ * arm_convolve_s8() otherwise) and of the Winograd path must be identical to
+ * a naive reference. The median durations are reported, also for the shapes
+ * which fall back (too few input channels). The shapes the Winograd path does
+ * not support (stride, dilation, filter size) must be rejected.
+ *
+ * The tool is built twice: tflm_winograd_bench with the x86 SIMD inner loops
+ * of the host library, tflm_winograd_bench_dsp with the DSP path of the
+ * kernels (ARM_MATH_DSP, intrinsics emulated by tflm_dsp_emulation.h: the
+ * durations do not represent the Cortex-M33 ones).
+ *
+ * Exit code 1 if an output differs or a shape is wrongly accepted.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Include/arm_nnfunctions.h"
+#include "Include/arm_nnsupportfunctions.h"
+
+#include "tflm_host_utils.h"
+
+namespace {
+
+struct ConvCase {
+  const char* name;
+  int n, h, w, c_in;
+  int kh, kw, c_out;
+  int stride, pad, dilation;
+};
+
+const ConvCase kCases[] = {
+  {"MNIST conv 28x28x1, 3x3x28", 1, 28, 28, 1, 3, 3, 28, 1, 0, 1},
+  {"16x16x2, 3x3x16, pad 1", 1, 16, 16, 2, 3, 3, 16, 1, 1, 1},
+  {"16x16x4, 3x3x16, pad 1", 1, 16, 16, 4, 3, 3, 16, 1, 1, 1},
+  {"16x16x8, 3x3x16, pad 1", 1, 16, 16, 8, 3, 3, 16, 1, 1, 1},
+  {"16x16x16, 3x3x16, pad 1", 1, 16, 16, 16, 3, 3, 16, 1, 1, 1},
+  {"16x16x32, 3x3x32, pad 1", 1, 16, 16, 32, 3, 3, 32, 1, 1, 1},
+  {"8x8x64, 3x3x64, pad 1", 1, 8, 8, 64, 3, 3, 64, 1, 1, 1},
+  {"15x15x12, 3x3x9 (odd output)", 1, 15, 15, 12, 3, 3, 9, 1, 0, 1},
+  {"2 x 9x9x24, 3x3x7, pad 1", 2, 9, 9, 24, 3, 3, 7, 1, 1, 1},
+};
+
+/* shapes arm_convolve_winograd_3x3_s8_get_filter_size() must reject */
+const ConvCase kRejected[] = {
+  {"15x15x16, 3x3x16, stride 2", 1, 15, 15, 16, 3, 3, 16, 2, 0, 1},
+  {"16x16x16, 3x3x16, dilation 2", 1, 16, 16, 16, 3, 3, 16, 1, 2, 2},
+  {"12x12x16, 5x5x16, pad 2", 1, 12, 12, 16, 5, 5, 16, 1, 2, 1},
+  {"8x8x2048, 3x3x4 (accumulator)", 1, 8, 8, 2048, 3, 3, 4, 1, 1, 1},
+};
+
+struct ConvData {
+  cmsis_nn_conv_params params;
+  cmsis_nn_dims input_dims, filter_dims, bias_dims, output_dims;
+  std::vector<int8_t> input, filter, reordered;
+  std::vector<int16_t> transformed;
+  std::vector<int32_t> bias, multiplier, shift;
+  std::vector<int16_t> buffer, winograd_buffer;
+};
+
+void setup_params(const ConvCase& c, ConvData* d)
+{
+  d->params.input_offset = 1 + rand() % 127;
+  d->params.output_offset = -(rand() % 128);
+  d->params.stride.h = d->params.stride.w = c.stride;
+  d->params.padding.h = d->params.padding.w = c.pad;
+  d->params.dilation.h = d->params.dilation.w = c.dilation;
+  d->params.activation.min = -128;
+  d->params.activation.max = 127;
+
+  const int eff_k = (c.kh - 1) * c.dilation + 1;
+  d->input_dims = {c.n, c.h, c.w, c.c_in};
+  d->filter_dims = {c.c_out, c.kh, c.kw, c.c_in};
+  d->bias_dims = {1, 1, 1, c.c_out};
+  d->output_dims = {c.n, (c.h + 2 * c.pad - eff_k) / c.stride + 1,
+      (c.w + 2 * c.pad - eff_k) / c.stride + 1, c.c_out};
+}
+
+void setup(const ConvCase& c, ConvData* d)
+{
+  setup_params(c, d);
+  d->input.resize(c.n * c.h * c.w * c.c_in);
+  d->filter.resize(c.c_out * c.kh * c.kw * c.c_in);
+  for (auto& v : d->input)
+    v = (int8_t)rand();
+  for (auto& v : d->filter)
+    v = (int8_t)rand();
+  d->bias.resize(c.c_out);
+  d->multiplier.resize(c.c_out);
+  d->shift.resize(c.c_out);
+  for (int i = 0; i < c.c_out; i++) {
+    d->bias[i] = rand() % 20001 - 10000;
+    d->multiplier[i] = (1 << 30) + rand() % (1 << 30);
+    d->shift[i] = -(7 + rand() % 4);
+  }
+
+  d->reordered.resize(arm_convolve_s8_get_reordered_filter_size(&d->filter_dims));
+  if (!d->reordered.empty())
+    arm_convolve_s8_reorder_filter(&d->filter_dims, d->filter.data(), d->reordered.data());
+  d->buffer.resize(arm_convolve_s8_get_buffer_size(&d->input_dims, &d->filter_dims) / 2 + 1);
+
+  const int32_t size = arm_convolve_winograd_3x3_s8_get_filter_size(&d->params, &d->filter_dims);
+  d->transformed.resize(size / sizeof(int16_t));
+  if (size > 0)
+    arm_convolve_winograd_3x3_s8_transform_filter(&d->filter_dims, d->filter.data(),
+        d->transformed.data());
+  d->winograd_buffer.resize(arm_convolve_winograd_3x3_s8_get_buffer_size(&d->input_dims) / 2);
+}
+
+/* direct computation with the same requantization */
+std::vector<int8_t> reference(const ConvData& d)
+{
+  const cmsis_nn_dims& in = d.input_dims;
+  const cmsis_nn_dims& f = d.filter_dims;
+  const cmsis_nn_dims& out = d.output_dims;
+  std::vector<int8_t> res;
+  for (int b = 0; b < out.n; b++)
+    for (int oy = 0; oy < out.h; oy++)
+      for (int ox = 0; ox < out.w; ox++)
+        for (int oc = 0; oc < out.c; oc++) {
+          int32_t acc = d.bias[oc];
+          for (int ky = 0; ky < f.h; ky++)
+            for (int kx = 0; kx < f.w; kx++) {
+              const int iy = oy - d.params.padding.h + ky;
+              const int ix = ox - d.params.padding.w + kx;
+              if (iy < 0 || iy >= in.h || ix < 0 || ix >= in.w)
+                continue;
+              for (int ic = 0; ic < in.c; ic++)
+                acc += (d.input[((b * in.h + iy) * in.w + ix) * in.c + ic] + d.params.input_offset) *
+                    d.filter[((oc * f.h + ky) * f.w + kx) * f.c + ic];
+            }
+          acc = arm_nn_requantize(acc, d.multiplier[oc], d.shift[oc]) + d.params.output_offset;
+          acc = std::min(std::max(acc, d.params.activation.min), d.params.activation.max);
+          res.push_back((int8_t)acc);
+        }
+  return res;
+}
+
+/* median duration (us) of n calls, output of the last one */
+double run(ConvData& d, bool winograd, int runs, std::vector<int8_t>* output)
+{
+  std::vector<int16_t>& buffer = winograd ? d.winograd_buffer : d.buffer;
+  cmsis_nn_context ctx = {buffer.data(), (int32_t)(buffer.size() * sizeof(int16_t))};
+  cmsis_nn_per_channel_quant_params quant = {d.multiplier.data(), d.shift.data()};
+  output->assign(d.output_dims.n * d.output_dims.h * d.output_dims.w * d.output_dims.c, 0);
+  std::vector<double> t;
+  for (int i = 0; i < runs; i++) {
+    arm_cmsis_nn_status status;
+    const double t0 = tflm_host::now_us();
+    if (winograd)
+      status = arm_convolve_winograd_3x3_s8(&ctx, &d.params, &quant, &d.input_dims,
+          d.input.data(), &d.filter_dims, d.transformed.data(), &d.bias_dims, d.bias.data(),
+          &d.output_dims, output->data());
+    else if (!d.reordered.empty())
+      status = arm_convolve_s8_reordered(&ctx, &d.params, &quant, &d.input_dims, d.input.data(),
+          &d.filter_dims, d.reordered.data(), &d.bias_dims, d.bias.data(), &d.output_dims,
+          output->data());
+    else
+      status = arm_convolve_s8(&ctx, &d.params, &quant, &d.input_dims, d.input.data(),
+          &d.filter_dims, d.filter.data(), &d.bias_dims, d.bias.data(), &d.output_dims,
+          output->data());
+    t.push_back(tflm_host::now_us() - t0);
+    if (status != ARM_CMSIS_NN_SUCCESS)
+      return -1.0;
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int runs = 200;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      runs = std::max(1, atoi(argv[++i]));
+    else {
+      fprintf(stderr, "usage: %s [-n runs]\n", argv[0]);
+      return 2;
+    }
+  }
+
+#if defined(ARM_MATH_DSP)
+  printf("DSP path (emulated intrinsics)\n");
+#elif defined(CMSIS_NN_HOST_SIMD)
+  printf("x86 SIMD inner loops\n");
+#else
+  printf("portable C path\n");
+#endif
+
+  int res = 0;
+  srand(1);
+  printf("3x3 stride 1 conv (im2col -> Winograd F(2x2, 3x3))\n");
+  for (const ConvCase& c : kCases) {
+    ConvData d;
+    setup(c, &d);
+    const bool taken = !d.transformed.empty();
+    const std::vector<int8_t> ref = reference(d);
+    std::vector<int8_t> im2col, winograd;
+    const double t_im2col = run(d, false, runs, &im2col);
+    bool ok = t_im2col >= 0.0 && im2col == ref;
+    if (taken) {
+      const double t_winograd = run(d, true, runs, &winograd);
+      ok &= t_winograd >= 0.0 && winograd == ref;
+      printf("  %-30s : %8.2f us -> %8.2f us (x%.2f)%s\n", c.name, t_im2col, t_winograd,
+          t_im2col / t_winograd, ok ? "" : " FAILED");
+    } else {
+      printf("  %-30s : %8.2f us, falls back (too few input channels)%s\n", c.name, t_im2col,
+          ok ? "" : " FAILED");
+    }
+    if (!ok)
+      res = 1;
+  }
+
+  printf("rejected shapes\n");
+  for (const ConvCase& c : kRejected) {
+    ConvData d;
+    setup_params(c, &d);
+    const bool ok = arm_convolve_winograd_3x3_s8_get_filter_size(&d.params, &d.filter_dims) == 0;
+    printf("  %-30s : %s\n", c.name, ok ? "falls back" : "accepted FAILED");
+    if (!ok)
+      res = 1;
+  }
+  return res;
+}
@@ -4,6 +4,9 @@ import tensorflow_model_optimization as tfmot
 import numpy as np
 import random
 import hashlib
+import os
+import struct
+import subprocess
 from ecdsa import SECP256k1
 from ecdsa.ellipticcurve import int_to_bytes
 
@@ -39,7 +42,117 @@ def populate_template(byte_array, template_path, output_path):
     with open(output_path, 'w') as output_file:
         output_file.write(populated_template)
 
+def add_offline_memory_plan(model_path):
+    # Store a pre-computed memory plan in the model metadata ("OfflineMemoryAllocation").
+    # The TFLM runtime uses it instead of planning the tensors at init time.
+    if not os.path.isfile(offline_plan_tool):
+        print("\nWARNING: {} not found, model without offline memory plan".format(offline_plan_tool))
+        return
+    subprocess.run([offline_plan_tool, model_path, model_path], check=True)
+
+def write_idx(path, array):
+    # IDX file (unsigned bytes), format of the original MNIST files
+    with open(path, 'wb') as f:
+        f.write(struct.pack('>BBBB', 0, 0, 0x08, array.ndim))
+        f.write(struct.pack('>{}I'.format(array.ndim), *array.shape))
+        f.write(array.astype(np.uint8).tobytes())
+
+def export_test_set(model_path, images, labels):
+    # MNIST test set and the classes predicted by the TFLite interpreter, used
+    # by the host regression runner (tools/build/tflm_mnist_eval) to check the
+    # int8 TFLM kernels of the firmware against the TFLite reference.
+    os.makedirs(data_path, exist_ok=True)
+    pixels = np.round(images * 255).astype(np.uint8).reshape(images.shape[0], images.shape[1], images.shape[2])
+    interpreter = tf.lite.Interpreter(model_path=model_path)
+    interpreter.allocate_tensors()
+    input_details = interpreter.get_input_details()[0]
+    output_details = interpreter.get_output_details()[0]
+    predictions = np.zeros(labels.shape[0], dtype=np.uint8)
+    for i in range(images.shape[0]):
+        x = images[i:i + 1]
+        if input_details['dtype'] == np.int8:
+            scale, zero_point = input_details['quantization']
+            x = np.clip(np.round(x / scale) + zero_point, -128, 127).astype(np.int8)
+        interpreter.set_tensor(input_details['index'], x)
+        interpreter.invoke()
+        predictions[i] = np.argmax(interpreter.get_tensor(output_details['index'])[0])
+    write_idx(os.path.join(data_path, 't10k-images-idx3-ubyte'), pixels)
+    write_idx(os.path.join(data_path, 't10k-labels-idx1-ubyte'), labels)
+    write_idx(os.path.join(data_path, 't10k-tflite-predictions-idx1-ubyte'), predictions)
+    print("\nTFLite model has an accuracy of {0:.2f}%".format(np.mean(predictions == labels) * 100))
+
+def remove_softmax(model_path):
+    # Remove the trailing softmax, the firmware selects the classes on the
+    # logits (top-k head of the runtime, see tflm_c_topk_enable()).
+    if not topk_head:
+        return
+    if not os.path.isfile(topk_head_tool):
+        print("\nWARNING: {} not found, softmax not removed".format(topk_head_tool))
+        return
+    subprocess.run([topk_head_tool, model_path, model_path], check=True)
+
+def fold_input_normalisation(model_path):
+    # Fold the input normalisation (pixel - mean) / std in the first convolution,
+    # the model then takes the raw pixels (int8, or uint8 ^ 0x80) as input.
+    if fold_input is None:
+        return
+    if not os.path.isfile(fold_input_tool):
+        print("\nWARNING: {} not found, input normalisation not folded".format(fold_input_tool))
+        return
+    mean, std = fold_input
+    subprocess.run([fold_input_tool, model_path, model_path, '-m', str(mean), '-d', str(std)],
+                   check=True)
+
+def compress_weights(model_path):
+    # Compress the CONV_2D/FULLY_CONNECTED weights (decompressed by the kernels
+    # before use). The arena must hold the largest decompressed filter.
+    if weight_clusters is None:
+        return
+    if not os.path.isfile(compress_tool):
+        print("\nWARNING: {} not found, weights not compressed".format(compress_tool))
+        return
+    args = [compress_tool, model_path, model_path]
+    if weight_clusters:
+        args += ['-c', str(weight_clusters)]
+    subprocess.run(args, check=True)
+
+def convert_block_sparse(model_path):
+    # Replace the fully connected layers pruned by blocks (see dense_block_sparsity)
+    # by the BLOCK_SPARSE_FULLY_CONNECTED operator, only the non-zero blocks are
+    # stored and computed. Lossless, before the op resolver is generated.
+    if dense_block_sparsity is None:
+        return
+    if not os.path.isfile(block_sparse_tool):
+        print("\nWARNING: {} not found, fully connected layers kept dense".format(block_sparse_tool))
+        return
+    subprocess.run([block_sparse_tool, model_path, model_path,
+                    '-b', '{}x{}'.format(dense_block_size[1], dense_block_size[0])], check=True)
+
+def generate_op_resolver(model_path):
+    # Generate the op resolver (tflm_network_ops.h) and the kernel source list
+    # (tflm_network_kernels.cmake) of the firmware from the operators of the model.
+    if not os.path.isfile(gen_resolver_tool):
+        print("\nWARNING: {} not found, op resolver not updated".format(gen_resolver_tool))
+        return
+    result = subprocess.run([gen_resolver_tool, model_path,
+                             '../Utilities/X-CUBE-AI/App/tflm_network_ops.h',
+                             '../Utilities/X-CUBE-AI/App/tflm_network_kernels.cmake'])
+    if result.returncode != 0:
+        raise SystemExit("Model {} uses operators not supported by TFLM".format(model_path))
+
 template_path = 'ml_model.template'  # Path to your template file
+offline_plan_tool = 'tools/build/tflm_offline_plan'  # host tool, see tools/CMakeLists.txt
+gen_resolver_tool = 'tools/build/tflm_gen_resolver'  # host tool, see tools/CMakeLists.txt
+compress_tool = 'tools/build/tflm_compress'  # host tool, see tools/CMakeLists.txt
+fold_input_tool = 'tools/build/tflm_fold_input'  # host tool, see tools/CMakeLists.txt
+data_path = 'data'  # exported MNIST test set, see export_test_set()
+topk_head_tool = 'tools/build/tflm_topk_head'  # host tool, see tools/CMakeLists.txt
+topk_head = False # True: trailing softmax removed, outputs are the logits
+fold_input = None # None: input quantized at runtime, (mean, std): normalisation folded in the first conv, (0, 255) for this script
+block_sparse_tool = 'tools/build/tflm_block_sparse'  # host tool, see tools/CMakeLists.txt
+dense_block_sparsity = None # None: dense layers not pruned, S: fraction of the Dense kernel blocks pruned at training time (ex. 0.75)
+dense_block_size = (16, 1) # pruned blocks of the Keras [inputs, outputs] kernel, 16 inputs x 1 output = 1x16 blocks of the TFLite filter
+weight_clusters = None # None: weights not compressed, 0: lossless compression, N: at most N values per buffer (lossy)
 selected_model = 1 # 0: CNN, 1: CNN with less layers, 2: CNN with strides, 3: CNN with 3D pooling, 4: CNN with 2D pooling
 model_qat = False # quantized aware training
 tflite_type = 3 # 0: no optimizations, 1: optimize for size, 2: default optimizations, 3: full quantization
@@ -102,6 +215,22 @@ if __name__ == '__main__':
         model.add(keras.layers.Flatten()) # Flattening the 2D arrays for fully connected layers
         model.add(keras.layers.Dense(10,activation=tf.nn.softmax))
 
+    pruning_callbacks = []
+    if dense_block_sparsity is not None:
+        if model_qat:
+            raise SystemExit("dense_block_sparsity and model_qat can not be combined")
+        # Block magnitude pruning of the Dense kernels, the zero blocks are then
+        # skipped by the firmware (convert_block_sparse())
+        def prune_dense(layer):
+            if isinstance(layer, keras.layers.Dense):
+                return tfmot.sparsity.keras.prune_low_magnitude(
+                    layer,
+                    pruning_schedule=tfmot.sparsity.keras.ConstantSparsity(dense_block_sparsity, begin_step=0),
+                    block_size=dense_block_size)
+            return layer
+        model = keras.models.clone_model(model, clone_function=prune_dense)
+        pruning_callbacks = [tfmot.sparsity.keras.UpdatePruningStep()]
+
     if model_qat:
         quantize_model = tfmot.quantization.keras.quantize_model
         model = quantize_model(model)
@@ -113,7 +242,11 @@ if __name__ == '__main__':
 
 
 
-    history = model.fit(x=images_train,y=labels_train, epochs=epochs, batch_size=batch_size)
+    history = model.fit(x=images_train,y=labels_train, epochs=epochs, batch_size=batch_size,
+                        callbacks=pruning_callbacks)
+    if dense_block_sparsity is not None:
+        model = tfmot.sparsity.keras.strip_pruning(model)
+        model.compile(optimizer='adam', loss='sparse_categorical_crossentropy', metrics=['accuracy'])
     model.summary()
 
     res = model.evaluate(images_test, labels_test)
@@ -155,6 +288,30 @@ if __name__ == '__main__':
         # read the tflite model and convert it to a byte array for the template
         tflite_model_bytes = open(model_name, "rb").read()
 
+    # Test set and reference predictions of the converted model, before the
+    # host rewrites (a compressed model can not be run by the TFLite interpreter)
+    export_test_set(model_name, images_test, labels_test)
+
+    # Optional softmax removal, before the op resolver is generated
+    remove_softmax(model_name)
+
+    # Optional block sparse fully connected layers, before the op resolver is
+    # generated and the weights are compressed
+    convert_block_sparse(model_name)
+
+    # Model specific op resolver and kernel list of the firmware
+    generate_op_resolver(model_name)
+
+    # Optional input normalisation folding, before the weights are compressed
+    fold_input_normalisation(model_name)
+
+    # Optional weight compression, before the memory plan (decompression buffers)
+    compress_weights(model_name)
+
+    # Add the offline memory plan before the model is embedded and hashed
+    add_offline_memory_plan(model_name)
+    tflite_model_bytes = open(model_name, "rb").read()
+
     populate_template(tflite_model_bytes, template_path, 'tflm_network.c')
 
     # Compute SHA256 hash of the generated model file